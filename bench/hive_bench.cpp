@@ -0,0 +1,607 @@
+// Microbenchmarks for the list containers and Playlist.
+//
+//     hive_bench [--min N] [--max N] [--filter text] [--out file.csv]
+//                [--baseline file.csv] [--tolerance 0.25]
+//
+// Runs every benchmark at N = min, 10*min, ... max (default 1e3 .. 1e7) and
+// prints one CSV row per run:   benchmark,n,ns_per_op,ops
+// Each run is repeated for a quarter of a second (at least once) and the
+// fastest repetition is kept; set-up such as filling the list isn't timed.
+// With --baseline, rows are matched against the baseline file by
+// (benchmark, n) and the exit code is 1 if any is more than 'tolerance' slower.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "DoublyLinkedList.h"
+#include "Dsp.h"
+#include "Fft.h"
+#include "Fingerprint.h"
+#include "IndexedDoublyLinkedList.h"
+#include "LatencyHistogram.h"
+#include "LoudnessMeter.h"
+#include "Playlist.h"
+#include "PlaylistManager.h"
+#include "RcuCell.h"
+#include "SpscRing.h"
+
+using namespace std;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    const double MinSecondsPerRun = 0.25; // Wall time, set-up included
+    const int MaxRepetitions = 1000;
+
+    // One repetition: how long the timed part took and how many operations it did
+    struct Timing {
+        double seconds;
+        long long ops;
+    };
+
+    struct Result {
+        string benchmark;
+        long long n;
+        double nsPerOp;
+        long long ops;
+    };
+
+    volatile long long sink; // Keeps traversal results alive
+
+    double secondsSince(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Operations for the O(n)-per-op benchmarks: enough to time, few enough to finish
+    long long middleOps(long long n) {
+        return clamp(100000000LL / n, 10LL, 1000LL);
+    }
+
+    // --- Lists: DoublyLinkedList<int> and IndexedDoublyLinkedList<int> ---
+
+    template <typename List>
+    void fill(List& list, long long n) {
+        for (long long i = 0; i < n; i++) list.insertAtEnd(static_cast<int>(i));
+    }
+
+    template <typename List>
+    Timing insertHead(long long n) {
+        List list;
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) list.insertAtBeginning(static_cast<int>(i));
+        return { secondsSince(start), n };
+    }
+
+    template <typename List>
+    Timing insertTail(long long n) {
+        List list;
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) list.insertAtEnd(static_cast<int>(i));
+        return { secondsSince(start), n };
+    }
+
+    template <typename List>
+    Timing insertMiddle(long long n) {
+        List list;
+        fill(list, n);
+        long long ops = middleOps(n);
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) list.insertAtAnyPos(list.nodeCount() / 2 + 1, static_cast<int>(i));
+        return { secondsSince(start), ops };
+    }
+
+    template <typename List>
+    Timing deleteMiddle(long long n) {
+        List list;
+        long long ops = middleOps(n);
+        fill(list, n + ops);
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) list.deleteAtAnyPos(list.nodeCount() / 2 + 1);
+        return { secondsSince(start), ops };
+    }
+
+    template <typename List>
+    Timing traverse(long long n) {
+        List list;
+        fill(list, n);
+        long long sum = 0;
+        auto start = Clock::now();
+        for (node<int>* p = list.getHead(); p != nullptr; p = p->next) sum += p->data;
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    // Merge sort by relinking, on one thread; ns/op per element
+    template <typename List>
+    Timing sortList(long long n) {
+        List list;
+        for (long long i = 0; i < n; i++) list.insertAtEnd(static_cast<int>((i * 2654435761LL) % 1000003));
+        auto start = Clock::now();
+        list.sort([](int a, int b) { return a < b; });
+        double seconds = secondsSince(start);
+        sink = list.getHead()->data;
+        return { seconds, n };
+    }
+
+    // A block of n/10 nodes, spliced from the middle to the front and back
+    // again: O(1) per splice for the plain list, O(log n) for the indexed one
+    template <typename List>
+    Timing spliceBlock(long long n) {
+        List list;
+        fill(list, n);
+        int count = static_cast<int>(max(n / 10, 1LL));
+        node<int>* first = list.nodeAt(static_cast<int>(n / 2) + 1);
+        node<int>* last = list.nodeAt(static_cast<int>(n / 2) + count);
+        long long ops = 100000;
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i += 2) {
+            list.splice(list.getHead(), list, first, last, count);
+            list.splice(nullptr, list, first, last, count);
+        }
+        double seconds = secondsSince(start);
+        sink = list.getHead()->data;
+        return { seconds, ops };
+    }
+
+    // --- Playlist ---
+
+    // Scanner-like tracks, added in batches so the temporary Tracks stay small.
+    // Returns the time spent inside addTracks.
+    double fillPlaylist(Playlist& playlist, long long n) {
+        const long long Batch = 100000;
+        double seconds = 0.0;
+        for (long long first = 0; first < n; first += Batch) {
+            vector<Track> tracks;
+            for (long long i = first; i < min(n, first + Batch); i++) {
+                string artist = "Artist " + to_string(i / 200);
+                string title = "Track " + to_string(i);
+                tracks.push_back(Track{ 0, title, artist, static_cast<int>(120 + i % 300),
+                                        "/music/" + artist + "/" + title + ".mp3" });
+            }
+            auto start = Clock::now();
+            playlist.addTracks(std::move(tracks));
+            seconds += secondsSince(start);
+        }
+        return seconds;
+    }
+
+    Timing playlistAdd(long long n) {
+        Playlist playlist;
+        return { fillPlaylist(playlist, n), n };
+    }
+
+    Timing playlistRemoveById(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        long long ops = min(n, 100000LL);
+        long long stride = n / ops;
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) playlist.removeTrack(static_cast<int>(1 + i * stride));
+        return { secondsSince(start), ops };
+    }
+
+    // Drop whole artists (200 tracks each) with one removeIf pass per call
+    Timing playlistRemoveArtist(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        long long ops = clamp(n / 200, 1LL, 20LL);
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) playlist.removeArtist("Artist " + to_string(i * (n / 200) / ops));
+        return { secondsSince(start), ops };
+    }
+
+    // A tenth of the playlist moved as one block
+    Timing playlistMoveBlock(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        int count = static_cast<int>(max(n / 10, 1LL));
+        long long ops = 10000;
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) {
+            playlist.moveTracks(1, count, static_cast<int>(n / 2));
+        }
+        double seconds = secondsSince(start);
+        sink = playlist.getTrackPosition(1);
+        return { seconds, ops };
+    }
+
+    Timing playlistTraverse(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        long long sum = 0;
+        auto start = Clock::now();
+        playlist.forEachTrack([&](TrackRef t) { sum += t.duration(); });
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    // The whole playlist by title, then by duration (on every core); ns/op per track
+    Timing playlistSortTitle(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        auto start = Clock::now();
+        playlist.sortTracks(SortKey::Title);
+        double seconds = secondsSince(start);
+        sink = playlist.getCurrentPosition();
+        return { seconds, n };
+    }
+
+    Timing playlistSortDuration(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        auto start = Clock::now();
+        playlist.sortTracks(SortKey::Duration);
+        double seconds = secondsSince(start);
+        sink = playlist.getCurrentPosition();
+        return { seconds, n };
+    }
+
+    Timing playlistMoveNext(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) playlist.moveNext();
+        double seconds = secondsSince(start);
+        sink = playlist.getCurrentTrack().id();
+        return { seconds, n };
+    }
+
+    Timing playlistShuffleNext(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        long long ops = min(n, 1000000LL);
+        auto start = Clock::now();
+        playlist.setShuffle(true);
+        for (long long i = 0; i < ops; i++) playlist.moveNext();
+        double seconds = secondsSince(start);
+        sink = playlist.getCurrentTrack().id();
+        return { seconds, ops };
+    }
+
+    // --- PlaylistManager: persistent lists sharing one library ---
+
+    // A copy of the whole library plus one edit in it: O(log n) either way
+    Timing managerCloneEdit(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        PlaylistManager manager(playlist, "Shown");
+        manager.clone("Shown", "Library");
+        long long ops = 10000;
+        vector<PlaylistManager::List> copies;
+        copies.reserve(static_cast<size_t>(ops));
+        const PlaylistManager::List& library = *manager.find("Library");
+        auto start = Clock::now();
+        for (long long i = 0; i < ops; i++) {
+            PlaylistManager::List& copy = copies.emplace_back(library);
+            copy.eraseAt(static_cast<int>((i * 7919) % n));
+        }
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(manager.nodeCount());
+        copies.clear();
+        return { seconds, ops };
+    }
+
+    Timing managerTraverse(long long n) {
+        Playlist playlist;
+        fillPlaylist(playlist, n);
+        PlaylistManager manager(playlist, "Shown");
+        manager.clone("Shown", "Library");
+        const PlaylistManager::List& list = *manager.find("Library");
+        const TrackStore& store = manager.getStore();
+        long long sum = 0;
+        auto start = Clock::now();
+        list.forEach([&](const PlaylistManager::SharedTrack& t) { sum += store.duration(t.handle()); });
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    // --- Instrumentation: what one probe costs on the hot path ---
+
+    Timing histogramRecord(long long n) {
+        auto histogram = make_unique<LatencyHistogram>();
+        uint64_t ns = 1;
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) {
+            ns = ns * 6364136223846793005ull + 1442695040888963407ull;
+            histogram->record(ns >> 40); // 0 .. ~16 ms
+        }
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(histogram->count());
+        return { seconds, n };
+    }
+
+    Timing scopedTimer(long long n) {
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) {
+            ScopedTimer timer(Probe::Render);
+        }
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(Latency::of(Probe::Render).count());
+        return { seconds, n };
+    }
+
+    // --- UI <-> playback thread hand-off, uncontended ---
+
+    Timing spscPushPop(long long n) {
+        auto ring = make_unique<SpscRing<long long, 64>>();
+        long long value = 0, sum = 0;
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) {
+            long long v = i;
+            ring->tryPush(std::move(v));
+            ring->tryPop(value);
+            sum += value;
+        }
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    Timing rcuRead(long long n) {
+        RcuCell<long long> cell(make_unique<long long>(1));
+        auto reader = cell.registerReader();
+        long long sum = 0;
+        auto start = Clock::now();
+        for (long long i = 0; i < n; i++) sum += *cell.read(reader);
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    // --- DSP stage: a crossfade block, the most work GaplessStream does per sample ---
+    // ns/op is per interleaved sample; 48 kHz stereo is 96k samples a second.
+
+    Timing dspChain(const DspKernels& dsp, long long n) {
+        constexpr size_t Block = 2048; // One GaplessStream chunk
+        vector<int16_t> outgoing(Block), incoming(Block), pcm(Block);
+        vector<float> a(Block), b(Block);
+        for (size_t i = 0; i < Block; i++) {
+            outgoing[i] = static_cast<int16_t>((i * 7919) % 60000 - 30000);
+            incoming[i] = static_cast<int16_t>((i * 104729) % 60000 - 30000);
+        }
+        long long sum = 0;
+        auto start = Clock::now();
+        for (long long done = 0; done < n; done += Block) {
+            size_t count = static_cast<size_t>(min<long long>(Block, n - done));
+            dsp.toFloat(outgoing.data(), a.data(), count);
+            dsp.toFloat(incoming.data(), b.data(), count);
+            dsp.gainRamp(b.data(), count, 1.4f, 1.4f); // ReplayGain boost
+            dsp.crossfade(a.data(), b.data(), b.data(), count, 0.9f, 0.8f, 0.4f, 0.6f);
+            dsp.gainRamp(b.data(), count, 0.5f, 0.75f); // Volume change
+            dsp.softClip(b.data(), count);
+            dsp.toInt16(b.data(), pcm.data(), count);
+            sum += pcm[count / 2];
+        }
+        double seconds = secondsSince(start);
+        sink = sum;
+        return { seconds, n };
+    }
+
+    // K-weighting, gating bookkeeping and 4x true-peak interpolation; ns/op per stereo frame
+    Timing loudnessMeter(long long n) {
+        constexpr size_t Block = 16384; // Frames per add(), as the analyzer feeds it
+        vector<int16_t> pcm(Block * 2);
+        for (size_t i = 0; i < pcm.size(); i++) pcm[i] = static_cast<int16_t>((i * 7919) % 60000 - 30000);
+        LoudnessMeter meter(48000, 2);
+        auto start = Clock::now();
+        for (long long done = 0; done < n; done += Block) {
+            meter.add(pcm.data(), static_cast<size_t>(min<long long>(Block, n - done)));
+        }
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(meter.truePeak() * 1000.0);
+        return { seconds, n };
+    }
+
+    // Visualizer spectrum: 2048-point real power spectra back to back; ns/op per input sample
+    Timing fftPower(long long n) {
+        constexpr size_t Size = 2048;
+        vector<float> in(Size), power(Size / 2 + 1);
+        for (size_t i = 0; i < Size; i++) in[i] = static_cast<float>((i * 7919) % 2000) / 1000.0f - 1.0f;
+        RealFft fft(Size);
+        long long transforms = max(n / static_cast<long long>(Size), 1LL);
+        auto start = Clock::now();
+        for (long long t = 0; t < transforms; t++) fft.powerSpectrum(in.data(), power.data());
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(power[Size / 8]);
+        return { seconds, transforms * static_cast<long long>(Size) };
+    }
+
+    // Resampling, chroma and codes for 44.1 kHz stereo; ns/op per input frame.
+    // A fresh fingerprinter every MaxSeconds, as each track gets one.
+    Timing fingerprint(long long n) {
+        constexpr size_t Block = 16384; // Frames per add(), as the finder feeds it
+        vector<int16_t> pcm(Block * 2);
+        for (size_t i = 0; i < pcm.size(); i++) pcm[i] = static_cast<int16_t>((i * 7919) % 60000 - 30000);
+        long long perTrack = static_cast<long long>(Fingerprinter::MaxSeconds * 44100.0);
+        size_t codes = 0;
+        auto start = Clock::now();
+        for (long long done = 0; done < n;) {
+            Fingerprinter fingerprinter(44100, 2);
+            for (long long end = min(n, done + perTrack); done < end; done += Block) {
+                fingerprinter.add(pcm.data(), static_cast<size_t>(min<long long>(Block, end - done)));
+            }
+            codes += fingerprinter.finish().codes.size();
+        }
+        double seconds = secondsSince(start);
+        sink = static_cast<long long>(codes);
+        return { seconds, n };
+    }
+
+    Timing dspChainScalar(long long n) { return dspChain(Dsp::scalar(), n); }
+    Timing dspChainBest(long long n) { return dspChain(Dsp::best(), n); }
+
+    struct Benchmark {
+        string name;
+        function<Timing(long long)> run;
+    };
+
+    vector<Benchmark> allBenchmarks() {
+        using DLL = DoublyLinkedList<int>;
+        using IDLL = IndexedDoublyLinkedList<int>;
+        return {
+            { "dll_insert_head", insertHead<DLL> },
+            { "dll_insert_tail", insertTail<DLL> },
+            { "dll_insert_middle", insertMiddle<DLL> },
+            { "dll_delete_middle", deleteMiddle<DLL> },
+            { "dll_traverse", traverse<DLL> },
+            { "dll_splice_block", spliceBlock<DLL> },
+            { "dll_sort", sortList<DLL> },
+            { "indexed_insert_head", insertHead<IDLL> },
+            { "indexed_insert_tail", insertTail<IDLL> },
+            { "indexed_insert_middle", insertMiddle<IDLL> },
+            { "indexed_delete_middle", deleteMiddle<IDLL> },
+            { "indexed_traverse", traverse<IDLL> },
+            { "indexed_splice_block", spliceBlock<IDLL> },
+            { "indexed_sort", sortList<IDLL> },
+            { "playlist_add", playlistAdd },
+            { "playlist_remove_by_id", playlistRemoveById },
+            { "playlist_remove_artist", playlistRemoveArtist },
+            { "playlist_move_block", playlistMoveBlock },
+            { "playlist_traverse", playlistTraverse },
+            { "playlist_sort_title", playlistSortTitle },
+            { "playlist_sort_duration", playlistSortDuration },
+            { "playlist_move_next", playlistMoveNext },
+            { "playlist_shuffle_next", playlistShuffleNext },
+            { "manager_clone_edit", managerCloneEdit },
+            { "manager_traverse", managerTraverse },
+            { "histogram_record", histogramRecord },
+            { "scoped_timer", scopedTimer },
+            { "spsc_push_pop", spscPushPop },
+            { "rcu_read", rcuRead },
+            { "dsp_chain_scalar", dspChainScalar },
+            { "dsp_chain_simd", dspChainBest },
+            { "loudness_meter", loudnessMeter },
+            { "fft_power_2048", fftPower },
+            { "fingerprint", fingerprint },
+        };
+    }
+
+    Result measure(const Benchmark& benchmark, long long n) {
+        double best = 0.0;
+        long long ops = 0;
+        auto start = Clock::now();
+        for (int rep = 0; rep < MaxRepetitions && (rep == 0 || secondsSince(start) < MinSecondsPerRun); rep++) {
+            Timing t = benchmark.run(n);
+            double nsPerOp = t.seconds * 1e9 / static_cast<double>(max(t.ops, 1LL));
+            if (rep == 0 || nsPerOp < best) best = nsPerOp;
+            ops = t.ops;
+        }
+        return { benchmark.name, n, best, ops };
+    }
+
+    void writeCsv(ostream& out, const vector<Result>& results) {
+        out << "benchmark,n,ns_per_op,ops\n";
+        for (const Result& r : results) {
+            out << r.benchmark << "," << r.n << "," << fixed << setprecision(3) << r.nsPerOp << "," << r.ops << "\n";
+        }
+    }
+
+    // "benchmark,n" -> ns/op
+    bool readCsv(const string& path, map<string, double>& rows) {
+        ifstream in(path);
+        if (!in) return false;
+        string line;
+        getline(in, line); // Header
+        while (getline(in, line)) {
+            stringstream fields(line);
+            string name, n, ns;
+            if (getline(fields, name, ',') && getline(fields, n, ',') && getline(fields, ns, ',')) {
+                rows[name + "," + n] = atof(ns.c_str());
+            }
+        }
+        return true;
+    }
+
+    // Prints every matched row, returns how many regressed
+    int compare(const vector<Result>& results, const map<string, double>& baseline, double tolerance) {
+        int regressions = 0;
+        for (const Result& r : results) {
+            auto found = baseline.find(r.benchmark + "," + to_string(r.n));
+            if (found == baseline.end() || found->second <= 0.0) continue;
+
+            double change = r.nsPerOp / found->second - 1.0;
+            bool regressed = change > tolerance;
+            if (regressed) regressions++;
+            cerr << (regressed ? "SLOWER " : "       ") << left << setw(24) << r.benchmark << right << setw(10) << r.n
+                 << fixed << setprecision(2) << setw(12) << found->second << " -> " << setw(10) << r.nsPerOp
+                 << " ns/op (" << showpos << setprecision(1) << change * 100.0 << noshowpos << "%)\n";
+        }
+        return regressions;
+    }
+
+    void usage() {
+        cerr << "usage: hive_bench [--min N] [--max N] [--filter text] [--out file.csv]\n"
+                "                  [--baseline file.csv] [--tolerance 0.25]\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long long minN = 1000;
+    long long maxN = 10000000;
+    string filter, outPath, baselinePath;
+    double tolerance = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--min" && hasValue) minN = atoll(argv[++i]);
+        else if (arg == "--max" && hasValue) maxN = atoll(argv[++i]);
+        else if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue) tolerance = atof(argv[++i]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (minN < 1 || maxN < minN) {
+        usage();
+        return 2;
+    }
+
+    map<string, double> baseline;
+    if (!baselinePath.empty() && !readCsv(baselinePath, baseline)) {
+        cerr << "No baseline at " << baselinePath << " (build the bench_baseline target to make one)\n";
+        return 2;
+    }
+
+    vector<Result> results;
+    cout << "benchmark,n,ns_per_op,ops\n";
+    for (const Benchmark& benchmark : allBenchmarks()) {
+        if (!filter.empty() && benchmark.name.find(filter) == string::npos) continue;
+        for (long long n = minN; n <= maxN; n *= 10) {
+            Result r = measure(benchmark, n);
+            cout << r.benchmark << "," << r.n << "," << fixed << setprecision(3) << r.nsPerOp << "," << r.ops << endl;
+            results.push_back(r);
+        }
+    }
+
+    if (!outPath.empty()) {
+        ofstream out(outPath, ios::trunc);
+        writeCsv(out, results);
+        if (!out) {
+            cerr << "Cannot write " << outPath << "\n";
+            return 2;
+        }
+    }
+
+    if (!baselinePath.empty()) {
+        int regressions = compare(results, baseline, tolerance);
+        cerr << regressions << " regression(s) beyond " << tolerance * 100.0 << "%\n";
+        return regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SFML/Audio.hpp>
+
+// What an AudioOutput plays. Called on the output's own thread.
+class AudioFeed {
+public:
+    virtual ~AudioFeed() = default;
+
+    // Next chunk of interleaved 16-bit samples; false if this is the last one
+    // (the chunk itself may still hold samples)
+    virtual bool nextChunk(const std::int16_t*& samples, std::size_t& count) = 0;
+
+    // Playback goes back to 'offset' (stop() rewinds to zero)
+    virtual void seekTo(std::chrono::microseconds offset) = 0;
+};
+
+// The device end of playback: pulls chunks from a feed on a thread of its own
+// and sends them somewhere. The control calls follow sf::SoundStream: play()
+// resumes a paused output or starts pulling from the top, stop() waits for
+// the thread and rewinds the feed, and the output stops by itself after the
+// feed's last chunk.
+class AudioOutput {
+public:
+    enum class Status { Stopped, Paused, Playing };
+
+    virtual ~AudioOutput() = default;
+
+    // Where the samples come from. Set once, before the first play().
+    virtual void attach(AudioFeed& feed) = 0;
+
+    // Sample format of what follows; only while stopped
+    virtual void initialize(unsigned channels, unsigned sampleRate, const std::vector<sf::SoundChannel>& channelMap) = 0;
+
+    virtual void play() = 0;
+    virtual void pause() = 0;
+    virtual void stop() = 0;
+    virtual Status status() const = 0;
+
+    // Short label for the dashboard ("sfml", "null", ...)
+    virtual const char* name() const = 0;
+};
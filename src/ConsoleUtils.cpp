@@ -1,15 +1,26 @@
 #include "ConsoleUtils.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h> // Add this include to resolve the undefined identifier error
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 //----------------------------------------------------
 void ConsoleUtils::enableVirtualTerminal() {
+#ifdef _WIN32
 	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 	DWORD dwMode = 0;
 	GetConsoleMode(hConsole, &dwMode);
 	SetConsoleMode(hConsole, dwMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	SetConsoleOutputCP(CP_UTF8);	// ScreenBuffer writes UTF-8 (the visualizer's block characters)
+#endif
+	// Other terminals understand ANSI escape sequences out of the box
 }
 
 //----------------------------------------------------
@@ -28,6 +39,9 @@ void ConsoleUtils::setDefaultColor() {
 }
 
 void ConsoleUtils::setConsoleBackgroundColor(int backgroundColor, int foregroundColor) {
+#ifndef _WIN32
+	setColor(foregroundColor & 0x0F, backgroundColor & 0x0F);
+#else
 	HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 	if (hConsole == INVALID_HANDLE_VALUE) return;
 
@@ -36,9 +50,28 @@ void ConsoleUtils::setConsoleBackgroundColor(int backgroundColor, int foreground
 
 	WORD colorAttribute = (static_cast<WORD>(backgroundColor) << 4) | (static_cast<WORD>(foregroundColor) & 0x0F);
 	SetConsoleTextAttribute(hConsole, colorAttribute);
+#endif
 }
 void ConsoleUtils::clearConsole() {
-	system("cls");
+	cout << "\033[2J\033[H" << flush;	// Erase screen, cursor home (no "cls" child process)
+}
+
+void ConsoleUtils::getConsoleSize(int& width, int& height) {
+	width = 80;
+	height = 25;
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+		width = info.srWindow.Right - info.srWindow.Left + 1;
+		height = info.srWindow.Bottom - info.srWindow.Top + 1;
+	}
+#else
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0) {
+		width = size.ws_col;
+		height = size.ws_row;
+	}
+#endif
 }
 
 //----------------------------------------------------
@@ -143,6 +176,287 @@ void ConsoleUtils::showCredits()
 
 
 
+//----------------------------------------------------
+namespace {
+	struct CodeRange {
+		char32_t first, last;
+	};
+
+	// Code points a terminal shows two cells wide: East Asian Wide/Fullwidth
+	// (CJK, Hangul, kana, fullwidth forms) and the emoji drawn as pictures
+	const CodeRange WideRanges[] = {
+		{ 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC }, { 0x23F0, 0x23F0 },
+		{ 0x23F3, 0x23F3 }, { 0x25FD, 0x25FE }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 }, { 0x267F, 0x267F },
+		{ 0x2693, 0x2693 }, { 0x26A1, 0x26A1 }, { 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 },
+		{ 0x26CE, 0x26CE }, { 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA }, { 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 },
+		{ 0x26FA, 0x26FA }, { 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B }, { 0x2728, 0x2728 },
+		{ 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 }, { 0x2757, 0x2757 }, { 0x2795, 0x2797 },
+		{ 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF }, { 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 },
+		{ 0x2E80, 0x303E }, { 0x3041, 0x33FF }, { 0x3400, 0x4DBF }, { 0x4E00, 0x9FFF }, { 0xA000, 0xA4CF },
+		{ 0xA960, 0xA97F }, { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6F },
+		{ 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x16FE0, 0x16FE4 }, { 0x17000, 0x18CFF }, { 0x1B000, 0x1B2FF },
+		{ 0x1F004, 0x1F004 }, { 0x1F0CF, 0x1F0CF }, { 0x1F18E, 0x1F18E }, { 0x1F191, 0x1F19A }, { 0x1F200, 0x1F202 },
+		{ 0x1F210, 0x1F23B }, { 0x1F240, 0x1F248 }, { 0x1F250, 0x1F251 }, { 0x1F260, 0x1F265 }, { 0x1F300, 0x1F320 },
+		{ 0x1F32D, 0x1F335 }, { 0x1F337, 0x1F37C }, { 0x1F37E, 0x1F393 }, { 0x1F3A0, 0x1F3CA }, { 0x1F3CF, 0x1F3D3 },
+		{ 0x1F3E0, 0x1F3F0 }, { 0x1F3F4, 0x1F3F4 }, { 0x1F3F8, 0x1F43E }, { 0x1F440, 0x1F440 }, { 0x1F442, 0x1F4FC },
+		{ 0x1F4FF, 0x1F53D }, { 0x1F54B, 0x1F54E }, { 0x1F550, 0x1F567 }, { 0x1F57A, 0x1F57A }, { 0x1F595, 0x1F596 },
+		{ 0x1F5A4, 0x1F5A4 }, { 0x1F5FB, 0x1F64F }, { 0x1F680, 0x1F6C5 }, { 0x1F6CC, 0x1F6CC }, { 0x1F6D0, 0x1F6D2 },
+		{ 0x1F6D5, 0x1F6D7 }, { 0x1F6DC, 0x1F6DF }, { 0x1F6EB, 0x1F6EC }, { 0x1F6F4, 0x1F6FC }, { 0x1F7E0, 0x1F7EB },
+		{ 0x1F7F0, 0x1F7F0 }, { 0x1F90C, 0x1F93A }, { 0x1F93C, 0x1F945 }, { 0x1F947, 0x1F9FF }, { 0x1FA70, 0x1FAFF },
+		{ 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD },
+	};
+
+	// Code points that take no cell of their own: combining marks, zero-width
+	// spaces and joiners, direction marks, variation selectors and tags
+	const CodeRange ZeroWidthRanges[] = {
+		{ 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x0610, 0x061A }, { 0x064B, 0x065F },
+		{ 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF }, { 0x200B, 0x200F }, { 0x2028, 0x202E }, { 0x2060, 0x2064 },
+		{ 0x20D0, 0x20FF }, { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }, { 0xFEFF, 0xFEFF }, { 0xE0000, 0xE0FFF },
+	};
+
+	template <size_t N>
+	bool inRanges(const CodeRange (&ranges)[N], char32_t ch) {
+		auto it = upper_bound(begin(ranges), end(ranges), ch, [](char32_t c, const CodeRange& r) { return c < r.first; });
+		return it != begin(ranges) && ch <= prev(it)->last;
+	}
+
+	// Cells the terminal advances for this code point (a wcwidth() that
+	// doesn't depend on the C locale)
+	int displayWidth(char32_t ch) {
+		if (ch < 0x300) return 1;	// Latin, and the fast path for nearly all text
+		if (inRanges(ZeroWidthRanges, ch)) return 0;
+		return (ch >= 0x1100 && inRanges(WideRanges, ch)) ? 2 : 1;
+	}
+}
+
+//----------------------------------------------------
+ScreenBuffer::ScreenBuffer()
+	: cols(0), rows(0), penX(0), penY(0), penFg(DefaultColor), penBg(DefaultColor), fullRepaint(true),
+	  termX(-1), termY(-1), termFg(DefaultColor), termBg(DefaultColor),
+	  frameBytes(0), frameMs(0.0), fps(0.0), framesInWindow(0), windowStart(chrono::steady_clock::now()) {
+	// Build every color sequence once; present() only appends them
+	fgCodes.push_back("\x1b[39m");
+	bgCodes.push_back("\x1b[49m");
+	for (int color = 0; color < 256; ++color) {
+		fgCodes.push_back("\x1b[38;5;" + to_string(color) + "m");
+		bgCodes.push_back("\x1b[48;5;" + to_string(color) + "m");
+	}
+	out.reserve(16 * 1024);
+}
+
+void ScreenBuffer::resize(int width, int height) {
+	if (width == cols && height == rows) return;
+	cols = width > 0 ? width : 1;
+	rows = height > 0 ? height : 1;
+	front.assign(static_cast<size_t>(cols) * rows, Cell{ U' ', DefaultColor, DefaultColor });
+	back = front;
+	fullRepaint = true;
+}
+
+void ScreenBuffer::clear() {
+	for (Cell& cell : back) cell = Cell{ U' ', DefaultColor, DefaultColor };
+	penX = penY = 0;
+	penFg = penBg = DefaultColor;
+}
+
+void ScreenBuffer::setCursor(int x, int y) {
+	penX = x;
+	penY = y;
+}
+
+void ScreenBuffer::setColor(int foreground, int background) {
+	// Anything outside the 256-color palette falls back to the terminal's default
+	penFg = static_cast<int16_t>(foreground >= DefaultColor && foreground <= 255 ? foreground : DefaultColor);
+	penBg = static_cast<int16_t>(background >= DefaultColor && background <= 255 ? background : DefaultColor);
+}
+
+void ScreenBuffer::put(char32_t ch) {
+	int width = displayWidth(ch);
+	if (width == 0) return;	// Dropped: a cell holds one code point
+	if (penY >= 0 && penY < rows) {
+		Cell* row = &back[static_cast<size_t>(penY) * cols];
+		if (width == 2 && penX >= 0 && penX + 1 < cols) {
+			detach(penX);
+			detach(penX + 1);
+			row[penX] = Cell{ ch, penFg, penBg };
+			row[penX + 1] = Cell{ WideTail, penFg, penBg };
+		} else {
+			// Half of a wide character can't be shown: the visible half becomes a blank
+			if (width == 2) ch = U' ';
+			for (int x = max(penX, 0); x < min(penX + width, cols); ++x) {
+				detach(x);
+				row[x] = Cell{ ch, penFg, penBg };
+			}
+		}
+	}
+	penX += width;
+}
+
+// About to overwrite cell x of the pen's row: if it holds either half of a
+// wide character, blank the other half so no orphan is ever sent
+void ScreenBuffer::detach(int x) {
+	Cell* row = &back[static_cast<size_t>(penY) * cols];
+	if (row[x].ch == WideTail && x > 0) row[x - 1].ch = U' ';
+	if (x + 1 < cols && row[x + 1].ch == WideTail) row[x + 1].ch = U' ';
+}
+
+void ScreenBuffer::write(string_view text) {
+	for (size_t i = 0; i < text.size();) {
+		unsigned char lead = static_cast<unsigned char>(text[i]);
+		if (lead == '\n') {
+			penX = 0;
+			++penY;
+			++i;
+			continue;
+		}
+
+		// Decode one UTF-8 sequence (anything malformed becomes '?')
+		char32_t ch = lead;
+		size_t length = 1;
+		if (lead >= 0xF0) { ch = lead & 0x07; length = 4; }
+		else if (lead >= 0xE0) { ch = lead & 0x0F; length = 3; }
+		else if (lead >= 0xC0) { ch = lead & 0x1F; length = 2; }
+		else if (lead >= 0x80) { ch = U'?'; }
+
+		if (i + length > text.size()) {
+			ch = U'?';
+			length = text.size() - i;
+		} else {
+			for (size_t k = 1; k < length; ++k) {
+				unsigned char next = static_cast<unsigned char>(text[i + k]);
+				if ((next & 0xC0) != 0x80) { ch = U'?'; length = k; break; }
+				ch = (ch << 6) | (next & 0x3F);
+			}
+		}
+		if (ch < 0x20 || (ch >= 0x7F && ch < 0xA0)) ch = U' ';	// Control characters would move the real cursor
+		put(ch);
+		i += length;
+	}
+}
+
+void ScreenBuffer::emitMove(int x, int y) {
+	if (x == termX && y == termY) return;
+
+	char buffer[32] = "\x1b[";
+	char* end = buffer + 2;
+	end = to_chars(end, buffer + sizeof(buffer), y + 1).ptr;
+	*end++ = ';';
+	end = to_chars(end, buffer + sizeof(buffer), x + 1).ptr;
+	*end++ = 'H';
+	out.append(buffer, end);
+	termX = x;
+	termY = y;
+}
+
+void ScreenBuffer::emitCell(const Cell& cell) {
+	if (cell.ch == WideTail) return;	// Drawn along with the character before it
+
+	if (cell.fg != termFg) {
+		out += fgCodes[static_cast<size_t>(cell.fg + 1)];
+		termFg = cell.fg;
+	}
+	if (cell.bg != termBg) {
+		out += bgCodes[static_cast<size_t>(cell.bg + 1)];
+		termBg = cell.bg;
+	}
+
+	char32_t ch = cell.ch;
+	if (ch < 0x80) {
+		out += static_cast<char>(ch);
+	} else if (ch < 0x800) {
+		out += static_cast<char>(0xC0 | (ch >> 6));
+		out += static_cast<char>(0x80 | (ch & 0x3F));
+	} else if (ch < 0x10000) {
+		out += static_cast<char>(0xE0 | (ch >> 12));
+		out += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (ch & 0x3F));
+	} else {
+		out += static_cast<char>(0xF0 | (ch >> 18));
+		out += static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+		out += static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (ch & 0x3F));
+	}
+
+	// Writing the last column leaves the cursor in a terminal-specific state
+	int advance = displayWidth(ch);
+	termX = (termX + advance < cols) ? termX + advance : -1;
+}
+
+size_t ScreenBuffer::present() {
+	auto start = chrono::steady_clock::now();
+	out.clear();
+
+	if (fullRepaint) {
+		out += "\x1b[0m\x1b[2J";
+		termFg = termBg = DefaultColor;
+		termX = termY = -1;
+		for (Cell& cell : front) cell = Cell{ U' ', DefaultColor, DefaultColor };
+		fullRepaint = false;
+	}
+
+	// Rewriting a few unchanged cells is cheaper than a cursor move (4+ bytes)
+	const int MaxGap = 4;
+	for (int y = 0; y < rows; ++y) {
+		Cell* now = &back[static_cast<size_t>(y) * cols];
+		Cell* shown = &front[static_cast<size_t>(y) * cols];
+		for (int x = 0; x < cols; ++x) {
+			if (now[x] == shown[x]) continue;
+			if (now[x].ch == WideTail) {
+				shown[x] = now[x];	// Its character changed too, and was just sent
+				continue;
+			}
+
+			if (termY == y && termX >= 0 && termX < x && x - termX <= MaxGap) {
+				for (int gap = termX; gap < x; ++gap) emitCell(now[gap]);
+			} else {
+				emitMove(x, y);
+			}
+			emitCell(now[x]);
+			shown[x] = now[x];
+		}
+	}
+
+	// Park the real cursor where the pen stopped (e.g. after a prompt)
+	emitMove(min(max(penX, 0), cols - 1), min(max(penY, 0), rows - 1));
+	if (termFg != DefaultColor || termBg != DefaultColor) {
+		out += "\x1b[0m";	// Leave the terminal in default colors for anything printed after us
+		termFg = termBg = DefaultColor;
+	}
+
+	flushOut();
+
+	// Counters
+	auto end = chrono::steady_clock::now();
+	frameBytes = out.size();
+	frameMs = chrono::duration<double, milli>(end - start).count();
+	++framesInWindow;
+	double windowSeconds = chrono::duration<double>(end - windowStart).count();
+	if (windowSeconds >= 1.0) {
+		fps = framesInWindow / windowSeconds;
+		framesInWindow = 0;
+		windowStart = end;
+	}
+	return frameBytes;
+}
+
+void ScreenBuffer::flushOut() {
+	cout.flush();	// Anything already sent through cout goes first
+	if (out.empty()) return;
+#ifdef _WIN32
+	DWORD written = 0;
+	WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), out.data(), static_cast<DWORD>(out.size()), &written, nullptr);
+#else
+	size_t done = 0;
+	while (done < out.size()) {
+		ssize_t n = ::write(STDOUT_FILENO, out.data() + done, out.size() - done);
+		if (n <= 0) break;
+		done += static_cast<size_t>(n);
+	}
+#endif
+}
+
+
+
 //===========================================
 #pragma region Classic Colors (16) : Just incl here for info / reference
 /*
@@ -1,4 +1,11 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // Note: Don't forget to do following in startup project: -
 //		 (1) Reference this static library
@@ -90,6 +97,9 @@ public:
 	static void setConsoleBackgroundColor(int backgroundColor, int foregroundColor = 7);
 	static void clearConsole();
 
+	// Visible size of the console window in character cells (80x25 if unknown)
+	static void getConsoleSize(int& width, int& height);
+
 	// Function to move the cursor to a specific position
 	static void moveCursor(int x, int y);
 
@@ -107,4 +117,105 @@ public:
 	//---
 	// show credits function, with default implementation
 	void virtual showCredits();
-};
\ No newline at end of file
+};
+
+
+/*
+	ScreenBuffer
+	---
+	Double-buffered, diffing console renderer.
+	A frame is drawn into the back buffer (a grid of cells: character + colors) with
+	setCursor / setColor / write or operator<<, exactly like writing to cout.
+	present() then compares it with the front buffer (what the terminal shows now)
+	and sends only the cells that changed, as a single write() to the terminal:
+	*	Runs of changed cells become one cursor move followed by the characters
+	*	Short gaps between runs are re-sent instead of paying for another cursor move
+	*	Color escape sequences are built once and only sent when the color changes
+	No screen clear, no flicker, and an unchanged frame costs zero bytes.
+
+	Text is UTF-8. Wide characters (CJK, most emoji) take two cells, as the terminal
+	draws them; combining marks and other zero-width code points are dropped.
+	Colors outside -1..255 fall back to the default.
+*/
+class ScreenBuffer {
+public:
+	static const int DefaultColor = -1;	// The terminal's own foreground/background
+
+	ScreenBuffer();
+
+	// Match the terminal size; a real change forces a full repaint
+	void resize(int width, int height);
+	int width() const { return cols; }
+	int height() const { return rows; }
+
+	// Start a new frame: back buffer to blanks, pen to (0,0) in default colors
+	void clear();
+
+	// Pen position (0-based) and colors for the following writes
+	void setCursor(int x, int y);
+	int cursorX() const { return penX; }
+	int cursorY() const { return penY; }
+	void setColor(int foreground, int background = DefaultColor);
+	void setDefaultColor() { setColor(DefaultColor, DefaultColor); }
+
+	// '\n' moves the pen to the start of the next row; text past the edges is dropped
+	void write(std::string_view text);
+
+	template <typename T>
+	ScreenBuffer& operator<<(const T& value) {
+		formatter << value;	// Manipulators (setprecision, fixed, ...) stick, as with cout
+		write(formatter.str());
+		formatter.str(std::string());
+		return *this;
+	}
+
+	// Send the differences to the terminal and leave its cursor where the pen is.
+	// Returns the number of bytes written.
+	std::size_t present();
+
+	// Someone else wrote to the terminal: repaint everything on the next present()
+	void invalidate() { fullRepaint = true; }
+
+	// Counters for the last frames
+	double framesPerSecond() const { return fps; }
+	std::size_t lastFrameBytes() const { return frameBytes; }
+	double lastFrameMilliseconds() const { return frameMs; }
+
+private:
+	static const char32_t WideTail = 0;	// The cell covered by the right half of a wide character
+
+	struct Cell {
+		char32_t ch;
+		std::int16_t fg;
+		std::int16_t bg;
+
+		bool operator==(const Cell& other) const { return ch == other.ch && fg == other.fg && bg == other.bg; }
+		bool operator!=(const Cell& other) const { return !(*this == other); }
+	};
+
+	int cols, rows;
+	std::vector<Cell> front, back;
+	int penX, penY;
+	std::int16_t penFg, penBg;
+	bool fullRepaint;
+	std::ostringstream formatter;
+
+	// Terminal state as of the last bytes we queued
+	int termX, termY;	// -1 = unknown
+	std::int16_t termFg, termBg;
+	std::string out;
+	std::vector<std::string> fgCodes, bgCodes;	// Cached SGR sequences, index = color + 1
+
+	// Counters
+	std::size_t frameBytes;
+	double frameMs;
+	double fps;
+	int framesInWindow;
+	std::chrono::steady_clock::time_point windowStart;
+
+	void put(char32_t ch);
+	void detach(int x);
+	void emitMove(int x, int y);
+	void emitCell(const Cell& cell);
+	void flushOut();
+};
@@ -0,0 +1,125 @@
+#include "DecodeBenchmark.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "GaplessStream.h"
+#include "NullOutput.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    string codecOf(const string& path) {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("/\\");
+        if (dot == string::npos || (slash != string::npos && dot < slash)) return "(none)";
+        string ext = path.substr(dot + 1);
+        for (char& c : ext) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return ext;
+    }
+
+    void add(DecodeThroughput& into, const DecodeThroughput& from) {
+        into.files += from.files;
+        into.failed += from.failed;
+        into.samples += from.samples;
+        into.audioSeconds += from.audioSeconds;
+        into.decodeSeconds += from.decodeSeconds;
+    }
+
+    // Open + play one file to its end through a GaplessStream on an unpaced NullOutput
+    void decodeFile(const string& path, DecodeThroughput& stats) {
+        auto start = Clock::now();
+        stats.files++;
+
+        auto source = make_shared<PcmSource>();
+        if (!source->open(path)) {
+            stats.failed++;
+            return;
+        }
+        double perSecond = static_cast<double>(source->sampleRate()) * source->channelCount();
+
+        mutex doneLock;
+        condition_variable doneSignal;
+        bool done = false;
+
+        auto output = make_unique<NullOutput>(NullOutput::Pacing::Unpaced);
+        NullOutput& sink = *output;
+        GaplessStream stream(std::move(output));
+        stream.setTrackEndCallback([&] {
+            lock_guard<mutex> guard(doneLock);
+            done = true;
+            doneSignal.notify_one();
+        });
+        stream.start(source);
+        {
+            unique_lock<mutex> guard(doneLock);
+            doneSignal.wait(guard, [&] { return done; });
+        }
+        stream.clear(); // Joins the output's thread, so every pulled sample is counted
+
+        uint64_t samples = sink.samplesPulled();
+        stats.samples += samples;
+        stats.audioSeconds += static_cast<double>(samples) / perSecond;
+        stats.decodeSeconds += chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+//----------------------------------------------------
+DecodeReport DecodeBenchmark::run(const vector<string>& paths, unsigned threads) {
+    ThreadPool pool(threads);
+    // One bucket per worker (+1 for the calling thread), merged at the end
+    vector<map<string, DecodeThroughput>> buckets(pool.size() + 1);
+
+    auto start = Clock::now();
+    for (const string& path : paths) {
+        pool.submit([&buckets, &pool, &path] {
+            int worker = ThreadPool::currentWorker();
+            auto& bucket = buckets[worker < 0 ? pool.size() : static_cast<size_t>(worker)];
+            string codec = codecOf(path);
+            DecodeThroughput& stats = bucket[codec];
+            stats.codec = codec;
+            decodeFile(path, stats);
+        });
+    }
+    pool.wait();
+
+    DecodeReport report;
+    report.threads = pool.size();
+    report.wallSeconds = chrono::duration<double>(Clock::now() - start).count();
+    report.total.codec = "total";
+
+    map<string, DecodeThroughput> merged;
+    for (const auto& bucket : buckets) {
+        for (const auto& [codec, stats] : bucket) {
+            merged[codec].codec = codec;
+            add(merged[codec], stats);
+            add(report.total, stats);
+        }
+    }
+    for (auto& entry : merged) report.codecs.push_back(std::move(entry.second));
+    return report;
+}
+
+void DecodeBenchmark::print(ostream& out, const DecodeReport& report) {
+    out << "Decoded " << report.total.files - report.total.failed << " of " << report.total.files << " files on "
+        << report.threads << " thread(s) in " << fixed << setprecision(2) << report.wallSeconds << " s: "
+        << setprecision(1) << report.samplesPerWallSecond() / 1e6 << " M samples/s overall\n\n";
+
+    out << left << setw(8) << "codec" << right << setw(8) << "files" << setw(8) << "failed" << setw(12) << "audio min"
+        << setw(18) << "M samples/s/core" << setw(16) << "x realtime/core" << "\n";
+    auto row = [&](const DecodeThroughput& t) {
+        out << left << setw(8) << t.codec << right << setw(8) << t.files << setw(8) << t.failed
+            << setw(12) << setprecision(1) << t.audioSeconds / 60.0
+            << setw(18) << setprecision(2) << t.samplesPerSecond() / 1e6
+            << setw(16) << setprecision(1) << t.realtimeFactor() << "\n";
+    };
+    for (const DecodeThroughput& t : report.codecs) row(t);
+    row(report.total);
+}
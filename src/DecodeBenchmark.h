@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Decode figures for one codec (file extension), or for everything
+struct DecodeThroughput {
+    std::string codec;
+    std::size_t files = 0;
+    std::size_t failed = 0;       // Files that wouldn't open
+    std::uint64_t samples = 0;    // Interleaved samples, all channels
+    double audioSeconds = 0.0;    // How long they play
+    double decodeSeconds = 0.0;   // Time spent decoding them, summed over threads
+
+    // Per core: what one thread decodes per second of its time
+    double samplesPerSecond() const { return decodeSeconds > 0.0 ? static_cast<double>(samples) / decodeSeconds : 0.0; }
+    double realtimeFactor() const { return decodeSeconds > 0.0 ? audioSeconds / decodeSeconds : 0.0; }
+};
+
+struct DecodeReport {
+    std::vector<DecodeThroughput> codecs; // Sorted by name
+    DecodeThroughput total;
+    unsigned threads = 0;
+    double wallSeconds = 0.0;
+
+    // All threads together
+    double samplesPerWallSecond() const { return wallSeconds > 0.0 ? static_cast<double>(total.samples) / wallSeconds : 0.0; }
+};
+
+// Offline decode throughput: plays every file through the real playback path
+// (PcmSource -> GaplessStream) into an unpaced NullOutput, so nothing waits on
+// a sound card, with 'threads' files in flight at once.
+class DecodeBenchmark {
+public:
+    // 0 threads = one per hardware core
+    static DecodeReport run(const std::vector<std::string>& paths, unsigned threads = 0);
+
+    static void print(std::ostream& out, const DecodeReport& report);
+};
@@ -1,35 +1,113 @@
 #pragma once
 #include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "ListSort.h"
+#include "NodePool.h"
 
 template <typename T>
 struct node {
     T data;
     node<T>* next;
     node<T>* prev;
+
+    // Build 'data' straight from the constructor arguments (no temporary T)
+    template <typename... Args>
+    explicit node(std::in_place_t, Args&&... args)
+        : data(std::forward<Args>(args)...), next(nullptr), prev(nullptr) {}
 };
 
-template <typename T>
+// Allocator is a node allocator template (see NodePool.h). The default pool
+// hands out nodes from slabs, so inserts stop hitting the heap once per node.
+template <typename T, template <typename> class Allocator = NodePool>
 class DoublyLinkedList {
+public:
+    using NodeAllocator = Allocator<node<T>>;
+
 private:
     node<T>* head;
     node<T>* tail;
     int listSize; // The O(1) secret weapon
+    NodeAllocator alloc;
 
-    node<T>* getNewNode(T val) {
-        node<T>* newNode = new node<T>;
-        newNode->data = val;
-        newNode->next = nullptr;
-        newNode->prev = nullptr;
-        return newNode;
+    template <typename... Args>
+    node<T>* getNewNode(Args&&... args) {
+        return alloc.create(std::in_place, std::forward<Args>(args)...);
+    }
+
+    void releaseNode(node<T>* target) {
+        alloc.destroy(target);
+    }
+
+    void linkAtBeginning(node<T>* newNode) {
+        if(head == nullptr) {
+            head = tail = newNode;
+        } else {
+            newNode->next = head;
+            head->prev = newNode;
+            head = newNode;
+        }
+        listSize++;
+    }
+
+    void linkAtEnd(node<T>* newNode) {
+        if(head == nullptr) {
+            head = tail = newNode;
+        } else {
+            tail->next = newNode;
+            newNode->prev = tail;
+            tail = newNode;
+        }
+        listSize++;
+    }
+
+    // Link newNode right after 'temp' (temp is never the tail here)
+    void linkAfter(node<T>* temp, node<T>* newNode) {
+        newNode->next = temp->next;
+        newNode->prev = temp;
+
+        if(temp->next != nullptr) {
+            temp->next->prev = newNode;
+        }
+
+        temp->next = newNode;
+        listSize++;
+    }
+
+    // Link the chain first..last ('count' nodes, already linked to each other)
+    // in front of 'position' (nullptr = at the end)
+    void linkChainBefore(node<T>* position, node<T>* first, node<T>* last, int count) {
+        node<T>* before = (position == nullptr) ? tail : position->prev;
+        first->prev = before;
+        last->next = position;
+        if(before != nullptr) before->next = first;
+        else head = first;
+        if(position != nullptr) position->prev = last;
+        else tail = last;
+        listSize += count;
+    }
+
+    // The reverse: take first..last out, leaving their outer links dangling
+    void unlinkChain(node<T>* first, node<T>* last, int count) {
+        if(first->prev != nullptr) first->prev->next = last->next;
+        else head = last->next;
+        if(last->next != nullptr) last->next->prev = first->prev;
+        else tail = first->prev;
+        listSize -= count;
     }
 
 public:
-    DoublyLinkedList() {
+    explicit DoublyLinkedList(const NodeAllocator& allocator = NodeAllocator()) : alloc(allocator) {
         head = nullptr;
         tail = nullptr;
         listSize = 0;
     }
 
+    // Nodes are owned by exactly one list, so no shallow copies
+    DoublyLinkedList(const DoublyLinkedList&) = delete;
+    DoublyLinkedList& operator=(const DoublyLinkedList&) = delete;
+
     ~DoublyLinkedList() {
         freeMemory();
     }
@@ -39,93 +117,124 @@ public:
         return head;
     }
 
-    void insertAtBeginning(T val) {
-        node<T>* newNode = getNewNode(val);
-        
-        if(head == nullptr) { 
-            head = tail = newNode;
+    node<T>* getTail() const {
+        return tail;
+    }
+
+    // 1-based; walks from whichever end is closer. nullptr if out of range.
+    node<T>* nodeAt(int position) const {
+        if(position <= 0 || position > listSize) return nullptr;
+
+        node<T>* temp;
+        if(position <= listSize / 2 + 1) {
+            temp = head;
+            for(int i = 1; i < position; i++) {
+                temp = temp->next;
+            }
         } else {
-            newNode->next = head;
-            head->prev = newNode;
-            head = newNode;
+            temp = tail;
+            for(int i = listSize; i > position; i--) {
+                temp = temp->prev;
+            }
         }
-        listSize++;
+        return temp;
     }
 
-    void insertAtEnd(T val) {
-        node<T>* newNode = getNewNode(val);
-        
-        if(head == nullptr) {  
-            head = tail = newNode;
-        } else {
-            tail->next = newNode;
-            newNode->prev = tail;
-            tail = newNode;
+    // 1-based position of a node (0 for nullptr). O(n) here; see IndexedDoublyLinkedList.
+    int positionOf(const node<T>* target) const {
+        if(target == nullptr) return 0;
+        int position = 1;
+        for(const node<T>* temp = target->prev; temp != nullptr; temp = temp->prev) {
+            position++;
         }
-        listSize++;
+        return position;
     }
 
-    void insertAtAnyPos(int position, T val) {
+    NodeAllocator getAllocator() const {
+        return alloc;
+    }
+
+    // Pre-allocate room for 'count' more nodes (one slab at a time)
+    void reserve(int count) {
+        if(count > 0) alloc.reserve(static_cast<std::size_t>(count));
+    }
+
+    // --- Emplace: construct T in place inside the new node ---
+
+    template <typename... Args>
+    node<T>* emplaceAtBeginning(Args&&... args) {
+        node<T>* newNode = getNewNode(std::forward<Args>(args)...);
+        linkAtBeginning(newNode);
+        return newNode;
+    }
+
+    template <typename... Args>
+    node<T>* emplaceAtEnd(Args&&... args) {
+        node<T>* newNode = getNewNode(std::forward<Args>(args)...);
+        linkAtEnd(newNode);
+        return newNode;
+    }
+
+    // Returns nullptr (and builds nothing) if the position is invalid
+    template <typename... Args>
+    node<T>* emplaceAt(int position, Args&&... args) {
         if(position <= 0 || position > listSize + 1) {
             std::cout << "Invalid position!\n";
-            return;
+            return nullptr;
         }
-        
+
         if(position == 1) {
-            insertAtBeginning(val);
-            return;
+            return emplaceAtBeginning(std::forward<Args>(args)...);
         }
-        
+
         if(position == listSize + 1) {
-            insertAtEnd(val);
-            return;
+            return emplaceAtEnd(std::forward<Args>(args)...);
         }
-        
-        node<T>* newNode = getNewNode(val);
-        node<T>* temp = head;
-        
-        for(int i = 1; i < position - 1; i++) {
-            temp = temp->next;
-        }
-        
-        newNode->next = temp->next;
-        newNode->prev = temp;
-        
-        if(temp->next != nullptr) {
-            temp->next->prev = newNode;
-        }
-        
-        temp->next = newNode;
-        listSize++;
+
+        node<T>* temp = nodeAt(position - 1);
+        node<T>* newNode = getNewNode(std::forward<Args>(args)...);
+        linkAfter(temp, newNode);
+        return newNode;
     }
 
+    // --- Insert: copy or move an existing T ---
+
+    void insertAtBeginning(const T& val) { emplaceAtBeginning(val); }
+    void insertAtBeginning(T&& val) { emplaceAtBeginning(std::move(val)); }
+
+    void insertAtEnd(const T& val) { emplaceAtEnd(val); }
+    void insertAtEnd(T&& val) { emplaceAtEnd(std::move(val)); }
+
+    void insertAtAnyPos(int position, const T& val) { emplaceAt(position, val); }
+    void insertAtAnyPos(int position, T&& val) { emplaceAt(position, std::move(val)); }
+
     void deleteFromStart() {
         if(isEmpty()) return;
-        
+
         node<T>* temp = head;
-        if(head == tail) {  
+        if(head == tail) {
             head = tail = nullptr;
         } else {
             head = head->next;
             head->prev = nullptr;
         }
-        
-        delete temp;
+
+        releaseNode(temp);
         listSize--;
     }
 
     void deleteFromEnd() {
         if(isEmpty()) return;
-        
+
         node<T>* temp = tail;
-        if(head == tail) { 
+        if(head == tail) {
             head = tail = nullptr;
         } else {
             tail = tail->prev;
             tail->next = nullptr;
         }
-        
-        delete temp;
+
+        releaseNode(temp);
         listSize--;
     }
 
@@ -134,34 +243,203 @@ public:
             std::cout << "List is empty!\n";
             return;
         }
-        
+
         if(position <= 0 || position > listSize) {
             std::cout << "Invalid position!\n";
             return;
         }
-        
+
         if(position == 1) {
             deleteFromStart();
             return;
         }
-        
+
         if(position == listSize) {
             deleteFromEnd();
             return;
         }
-        
-        node<T>* temp = head;
-        for(int i = 1; i < position; i++) {
-            temp = temp->next;
-        }
-        
+
+        node<T>* temp = nodeAt(position);
         temp->prev->next = temp->next;
         temp->next->prev = temp->prev;
-        
-        delete temp;
+
+        releaseNode(temp);
+        listSize--;
+    }
+
+    // --- Node handles: O(1) when the caller already holds the node ---
+
+    // Detach a node from the list without freeing it. The node can be put back
+    // with insertNodeBefore (e.g. to move a track) or freed with erase.
+    node<T>* unlink(node<T>* target) {
+        if(target == nullptr) return nullptr;
+
+        if(target->prev != nullptr) {
+            target->prev->next = target->next;
+        } else {
+            head = target->next;
+        }
+
+        if(target->next != nullptr) {
+            target->next->prev = target->prev;
+        } else {
+            tail = target->prev;
+        }
+
+        target->next = nullptr;
+        target->prev = nullptr;
         listSize--;
+        return target;
     }
 
+    // Re-link a detached node in front of 'position' (nullptr = at the end)
+    void insertNodeBefore(node<T>* position, node<T>* detached) {
+        if(detached == nullptr) return;
+
+        if(position == nullptr) {
+            linkAtEnd(detached);
+        } else if(position == head) {
+            linkAtBeginning(detached);
+        } else {
+            linkAfter(position->prev, detached);
+        }
+    }
+
+    // Unlink and free in one step. Returns the node that followed it.
+    node<T>* erase(node<T>* target) {
+        if(target == nullptr) return nullptr;
+
+        node<T>* following = target->next;
+        unlink(target);
+        releaseNode(target);
+        return following;
+    }
+
+    // Append 'count' elements, make(i) returning each T
+    template <typename Make>
+    void appendBulk(int count, Make&& make) {
+        reserve(count);
+        for(int i = 0; i < count; i++) {
+            emplaceAtEnd(make(i));
+        }
+    }
+
+    // --- Bulk operations ---
+
+    // Move the run first..last (inclusive, 'count' nodes, in list order) out of
+    // 'other' and link it in front of 'position' (nullptr = at the end). O(1):
+    // nothing is walked, so the caller supplies the count. 'other' may be this
+    // list, as long as 'position' isn't inside the run. The lists must share an
+    // allocator (build one from the other's getAllocator()), or a node could
+    // later be freed into the wrong pool; otherwise nothing happens and it
+    // returns false.
+    bool splice(node<T>* position, DoublyLinkedList& other, node<T>* first, node<T>* last, int count) {
+        if(first == nullptr || last == nullptr || count <= 0 || alloc != other.alloc) return false;
+        other.unlinkChain(first, last, count);
+        linkChainBefore(position, first, last, count);
+        return true;
+    }
+
+    // All of 'other' in front of 'position'. O(1).
+    bool splice(node<T>* position, DoublyLinkedList& other) {
+        if(&other == this) return false;
+        if(other.isEmpty()) return true;
+        return splice(position, other, other.head, other.tail, other.listSize);
+    }
+
+    // Take over every element of 'other' at the end: an O(1) splice when the
+    // lists share an allocator, one move per element when they don't
+    void append(DoublyLinkedList&& other) {
+        if(&other == this || other.isEmpty()) return;
+        if(splice(nullptr, other)) return;
+
+        reserve(other.listSize);
+        for(node<T>* temp = other.head; temp != nullptr; temp = temp->next) {
+            emplaceAtEnd(std::move(temp->data));
+        }
+        other.freeMemory();
+    }
+
+    // Insert copies of [first, last) in front of 'position' (nullptr = at the
+    // end). The nodes are reserved in one go when the range can be measured,
+    // chained up, then linked in at once. Returns the first new node (nullptr
+    // for an empty range).
+    template <typename InputIt>
+    node<T>* insertRange(node<T>* position, InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            reserve(static_cast<int>(std::distance(first, last)));
+        }
+
+        node<T>* chainHead = nullptr;
+        node<T>* chainTail = nullptr;
+        int count = 0;
+        try {
+            for(; first != last; ++first) {
+                node<T>* newNode = getNewNode(*first);
+                newNode->prev = chainTail;
+                if(chainTail != nullptr) chainTail->next = newNode;
+                else chainHead = newNode;
+                chainTail = newNode;
+                count++;
+            }
+        } catch(...) {
+            while(chainHead != nullptr) {
+                node<T>* temp = chainHead;
+                chainHead = chainHead->next;
+                releaseNode(temp);
+            }
+            throw;
+        }
+
+        if(chainHead == nullptr) return nullptr;
+        linkChainBefore(position, chainHead, chainTail, count);
+        return chainHead;
+    }
+
+    // Erase every element for which pred(data) is true, in one pass.
+    // Returns how many went.
+    template <typename Pred>
+    int removeIf(Pred&& pred) {
+        int removed = 0;
+        node<T>* temp = head;
+        while(temp != nullptr) {
+            if(pred(temp->data)) {
+                temp = erase(temp);
+                removed++;
+            } else {
+                temp = temp->next;
+            }
+        }
+        return removed;
+    }
+
+    // Stable sort by less(a, b), O(n log n), done by relinking the nodes: none
+    // is copied or reallocated, so node pointers held elsewhere stay valid.
+    // With threads > 1, a long list is cut into runs sorted side by side (see
+    // ListSort.h); 'less' must then be safe to call from several threads.
+    template <typename Less>
+    void sort(Less less, unsigned threads = 1) {
+        if(listSize < 2) return;
+        ListSort::Chain<T> sorted = ListSort::sort(head, listSize, less, threads);
+        head = sorted.first;
+        tail = sorted.last;
+    }
+
+    // The same, ordered by less(keyOf(a), keyOf(b)), with each key taken out
+    // once. Needs memory for a key and a pointer per node, but is much faster
+    // on long lists, whose nodes are scattered in memory.
+    template <typename KeyOf, typename Less>
+    void sortByKey(KeyOf keyOf, Less less, unsigned threads = 1) {
+        if(listSize < 2) return;
+        ListSort::Chain<T> sorted = ListSort::sortByKey(head, listSize, keyOf, less, threads);
+        head = sorted.first;
+        tail = sorted.last;
+    }
+
+    // Nothing to rebuild here; kept so both list types share one API
+    void rebuildIndex() {}
+
     // O(1) Complexity - No more loops!
     int nodeCount() const {
         return listSize;
@@ -184,9 +462,9 @@ public:
         while(head != nullptr) {
             temp = head;
             head = head->next;
-            delete temp;
+            releaseNode(temp);
         }
         tail = nullptr;
         listSize = 0;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,286 @@
+#include "Dsp.h"
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of x86-64. AVX2 kernels are built with a target attribute on
+// GCC/Clang and picked at run time; MSVC gets them with /arch:AVX2.
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define HIVE_DSP_SSE2 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define HIVE_DSP_AVX2 1
+#define HIVE_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define HIVE_DSP_AVX2 1
+#define HIVE_TARGET_AVX2
+#endif
+#endif
+
+using namespace std;
+
+namespace {
+    const float ToFloatScale = 1.0f / 32768.0f;
+    const float ToIntScale = 32768.0f;
+    const float ClipKnee = 0.891251f; // -1 dBFS
+
+    //----------------------------------------------------
+    // Scalar
+    //----------------------------------------------------
+    void toFloatScalar(const int16_t* in, float* out, size_t count) {
+        for (size_t i = 0; i < count; i++) out[i] = static_cast<float>(in[i]) * ToFloatScale;
+    }
+
+    void toInt16Scalar(const float* in, int16_t* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            float v = min(max(in[i] * ToIntScale, -32768.0f), 32767.0f);
+            out[i] = static_cast<int16_t>(lrintf(v));
+        }
+    }
+
+    void gainRampScalar(float* samples, size_t count, float from, float to) {
+        float step = count > 0 ? (to - from) / static_cast<float>(count) : 0.0f;
+        for (size_t i = 0; i < count; i++) samples[i] *= from + step * static_cast<float>(i);
+    }
+
+    void crossfadeScalar(const float* outgoing, const float* incoming, float* out, size_t count,
+                         float outFrom, float outTo, float inFrom, float inTo) {
+        float n = count > 0 ? static_cast<float>(count) : 1.0f;
+        float outStep = (outTo - outFrom) / n;
+        float inStep = (inTo - inFrom) / n;
+        for (size_t i = 0; i < count; i++) {
+            float t = static_cast<float>(i);
+            out[i] = outgoing[i] * (outFrom + outStep * t) + incoming[i] * (inFrom + inStep * t);
+        }
+    }
+
+    // Above the knee: knee + headroom * u / (1 + u), u being how far past the
+    // knee the sample is in units of headroom. Slope 1 at the knee, limit 1.0.
+    void softClipScalar(float* samples, size_t count) {
+        const float headroom = 1.0f - ClipKnee;
+        for (size_t i = 0; i < count; i++) {
+            float a = fabsf(samples[i]);
+            if (a <= ClipKnee) continue;
+            float u = (a - ClipKnee) / headroom;
+            samples[i] = copysignf(ClipKnee + headroom * u / (1.0f + u), samples[i]);
+        }
+    }
+
+#ifdef HIVE_DSP_SSE2
+    //----------------------------------------------------
+    // SSE2: 4 floats / 8 int16 at a time, scalar tails
+    //----------------------------------------------------
+    void toFloatSse2(const int16_t* in, float* out, size_t count) {
+        const __m128 scale = _mm_set1_ps(ToFloatScale);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            // Sign-extend: put each int16 in the top half of an int32, shift back down
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+        toFloatScalar(in + i, out + i, count - i);
+    }
+
+    void toInt16Sse2(const float* in, int16_t* out, size_t count) {
+        const __m128 scale = _mm_set1_ps(ToIntScale);
+        const __m128 low = _mm_set1_ps(-32768.0f);
+        const __m128 high = _mm_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), low), high);
+            __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), low), high);
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+        }
+        toInt16Scalar(in + i, out + i, count - i);
+    }
+
+    void gainRampSse2(float* samples, size_t count, float from, float to) {
+        float step = count > 0 ? (to - from) / static_cast<float>(count) : 0.0f;
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 vstep = _mm_set1_ps(step);
+        const __m128 vfrom = _mm_set1_ps(from);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+            __m128 gain = _mm_add_ps(vfrom, _mm_mul_ps(vstep, index));
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        }
+        for (; i < count; i++) samples[i] *= from + step * static_cast<float>(i);
+    }
+
+    void crossfadeSse2(const float* outgoing, const float* incoming, float* out, size_t count,
+                       float outFrom, float outTo, float inFrom, float inTo) {
+        float n = count > 0 ? static_cast<float>(count) : 1.0f;
+        float outStep = (outTo - outFrom) / n;
+        float inStep = (inTo - inFrom) / n;
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 t = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+            __m128 gOut = _mm_add_ps(_mm_set1_ps(outFrom), _mm_mul_ps(_mm_set1_ps(outStep), t));
+            __m128 gIn = _mm_add_ps(_mm_set1_ps(inFrom), _mm_mul_ps(_mm_set1_ps(inStep), t));
+            __m128 mixed = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(outgoing + i), gOut), _mm_mul_ps(_mm_loadu_ps(incoming + i), gIn));
+            _mm_storeu_ps(out + i, mixed);
+        }
+        for (; i < count; i++) {
+            float t = static_cast<float>(i);
+            out[i] = outgoing[i] * (outFrom + outStep * t) + incoming[i] * (inFrom + inStep * t);
+        }
+    }
+
+    void softClipSse2(float* samples, size_t count) {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 knee = _mm_set1_ps(ClipKnee);
+        const __m128 headroom = _mm_set1_ps(1.0f - ClipKnee);
+        const __m128 invHeadroom = _mm_set1_ps(1.0f / (1.0f - ClipKnee));
+        const __m128 one = _mm_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(samples + i);
+            __m128 sign = _mm_and_ps(x, signMask);
+            __m128 a = _mm_andnot_ps(signMask, x);
+            __m128 u = _mm_mul_ps(_mm_sub_ps(a, knee), invHeadroom);
+            __m128 bent = _mm_add_ps(knee, _mm_div_ps(_mm_mul_ps(headroom, u), _mm_add_ps(one, u)));
+            __m128 over = _mm_cmpgt_ps(a, knee);
+            __m128 y = _mm_or_ps(_mm_and_ps(over, _mm_or_ps(bent, sign)), _mm_andnot_ps(over, x));
+            _mm_storeu_ps(samples + i, y);
+        }
+        softClipScalar(samples + i, count - i);
+    }
+#endif
+
+#ifdef HIVE_DSP_AVX2
+    //----------------------------------------------------
+    // AVX2: 8 floats / 16 int16 at a time, SSE2/scalar tails
+    //----------------------------------------------------
+    HIVE_TARGET_AVX2 void toFloatAvx2(const int16_t* in, float* out, size_t count) {
+        const __m256 scale = _mm256_set1_ps(ToFloatScale);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i wide = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale));
+        }
+        toFloatScalar(in + i, out + i, count - i);
+    }
+
+    HIVE_TARGET_AVX2 void toInt16Avx2(const float* in, int16_t* out, size_t count) {
+        const __m256 scale = _mm256_set1_ps(ToIntScale);
+        const __m256 low = _mm256_set1_ps(-32768.0f);
+        const __m256 high = _mm256_set1_ps(32767.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), low), high);
+            __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale), low), high);
+            // packs works per 128-bit lane; the permute puts the four quarters back in order
+            __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        toInt16Scalar(in + i, out + i, count - i);
+    }
+
+    HIVE_TARGET_AVX2 void gainRampAvx2(float* samples, size_t count, float from, float to) {
+        float step = count > 0 ? (to - from) / static_cast<float>(count) : 0.0f;
+        const __m256 lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+        const __m256 vstep = _mm256_set1_ps(step);
+        const __m256 vfrom = _mm256_set1_ps(from);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+            __m256 gain = _mm256_add_ps(vfrom, _mm256_mul_ps(vstep, index));
+            _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), gain));
+        }
+        for (; i < count; i++) samples[i] *= from + step * static_cast<float>(i);
+    }
+
+    HIVE_TARGET_AVX2 void crossfadeAvx2(const float* outgoing, const float* incoming, float* out, size_t count,
+                                        float outFrom, float outTo, float inFrom, float inTo) {
+        float n = count > 0 ? static_cast<float>(count) : 1.0f;
+        float outStep = (outTo - outFrom) / n;
+        float inStep = (inTo - inFrom) / n;
+        const __m256 lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 t = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+            __m256 gOut = _mm256_add_ps(_mm256_set1_ps(outFrom), _mm256_mul_ps(_mm256_set1_ps(outStep), t));
+            __m256 gIn = _mm256_add_ps(_mm256_set1_ps(inFrom), _mm256_mul_ps(_mm256_set1_ps(inStep), t));
+            __m256 mixed = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(outgoing + i), gOut),
+                                         _mm256_mul_ps(_mm256_loadu_ps(incoming + i), gIn));
+            _mm256_storeu_ps(out + i, mixed);
+        }
+        for (; i < count; i++) {
+            float t = static_cast<float>(i);
+            out[i] = outgoing[i] * (outFrom + outStep * t) + incoming[i] * (inFrom + inStep * t);
+        }
+    }
+
+    HIVE_TARGET_AVX2 void softClipAvx2(float* samples, size_t count) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 knee = _mm256_set1_ps(ClipKnee);
+        const __m256 headroom = _mm256_set1_ps(1.0f - ClipKnee);
+        const __m256 invHeadroom = _mm256_set1_ps(1.0f / (1.0f - ClipKnee));
+        const __m256 one = _mm256_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_loadu_ps(samples + i);
+            __m256 sign = _mm256_and_ps(x, signMask);
+            __m256 a = _mm256_andnot_ps(signMask, x);
+            __m256 u = _mm256_mul_ps(_mm256_sub_ps(a, knee), invHeadroom);
+            __m256 bent = _mm256_add_ps(knee, _mm256_div_ps(_mm256_mul_ps(headroom, u), _mm256_add_ps(one, u)));
+            __m256 over = _mm256_cmp_ps(a, knee, _CMP_GT_OQ);
+            _mm256_storeu_ps(samples + i, _mm256_blendv_ps(x, _mm256_or_ps(bent, sign), over));
+        }
+        softClipScalar(samples + i, count - i);
+    }
+
+    bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_cpu_supports("avx2");
+#else
+        return true; // Built with /arch:AVX2
+#endif
+    }
+#endif
+
+    const DspKernels ScalarKernels = { "scalar", toFloatScalar, toInt16Scalar, gainRampScalar, crossfadeScalar, softClipScalar };
+#ifdef HIVE_DSP_SSE2
+    const DspKernels Sse2Kernels = { "sse2", toFloatSse2, toInt16Sse2, gainRampSse2, crossfadeSse2, softClipSse2 };
+#endif
+#ifdef HIVE_DSP_AVX2
+    const DspKernels Avx2Kernels = { "avx2", toFloatAvx2, toInt16Avx2, gainRampAvx2, crossfadeAvx2, softClipAvx2 };
+#endif
+
+    const DspKernels& pickKernels() {
+#ifdef HIVE_DSP_AVX2
+        if (cpuHasAvx2()) return Avx2Kernels;
+#endif
+#ifdef HIVE_DSP_SSE2
+        return Sse2Kernels;
+#else
+        return ScalarKernels;
+#endif
+    }
+}
+
+//----------------------------------------------------
+const DspKernels& Dsp::best() {
+    static const DspKernels& kernels = pickKernels();
+    return kernels;
+}
+
+const DspKernels& Dsp::scalar() {
+    return ScalarKernels;
+}
+
+float Dsp::dbToGain(float db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+void Dsp::equalPowerGains(double position, float& outgoing, float& incoming) {
+    double angle = min(max(position, 0.0), 1.0) * 1.5707963267948966; // pi / 2
+    outgoing = static_cast<float>(cos(angle));
+    incoming = static_cast<float>(sin(angle));
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// The sample-processing kernels behind GaplessStream's volume, ReplayGain and
+// crossfade stage. Samples are interleaved; floats are full scale at +-1.0.
+// Every instruction set gives the same results up to float rounding.
+struct DspKernels {
+    const char* name; // "scalar", "sse2", "avx2"
+
+    // int16 -> float (x / 32768)
+    void (*toFloat)(const std::int16_t* in, float* out, std::size_t count);
+
+    // float -> int16, rounded to nearest and saturated at full scale
+    void (*toInt16)(const float* in, std::int16_t* out, std::size_t count);
+
+    // samples[i] *= a gain going linearly from 'from' (first sample) towards 'to'
+    void (*gainRamp)(float* samples, std::size_t count, float from, float to);
+
+    // out[i] = outgoing[i] * gOut + incoming[i] * gIn, each gain ramping
+    // linearly over the block. 'out' may be 'incoming'.
+    void (*crossfade)(const float* outgoing, const float* incoming, float* out, std::size_t count,
+                      float outFrom, float outTo, float inFrom, float inTo);
+
+    // Identity below -1 dBFS; above it, bends smoothly towards (never past) full scale
+    void (*softClip)(float* samples, std::size_t count);
+};
+
+class Dsp {
+public:
+    // Fastest kernels this CPU runs (chosen once, on first use)
+    static const DspKernels& best();
+
+    // Plain C++, for reference and comparison
+    static const DspKernels& scalar();
+
+    static float dbToGain(float db);
+
+    // Equal-power crossfade gains at 'position' (0 = all outgoing, 1 = all incoming)
+    static void equalPowerGains(double position, float& outgoing, float& incoming);
+};
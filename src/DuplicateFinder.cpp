@@ -0,0 +1,188 @@
+#include "DuplicateFinder.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "PcmSource.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    const size_t FilesPerTask = 4;
+    const size_t ChunkFrames = 16384; // Between stop checks
+    const int64_t ReportIntervalNs = 250'000'000;
+
+    int64_t nowNs() {
+        return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+}
+
+//----------------------------------------------------
+DuplicateFinder::DuplicateFinder(unsigned threads) {
+    pool = make_unique<ThreadPool>(threads);
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    stopping = true;
+    pool.reset(); // Queued batches return at once; a file mid-decode stops at its next chunk
+}
+
+void DuplicateFinder::setProgressCallback(function<void()> callback) {
+    onProgress = std::move(callback);
+}
+
+bool DuplicateFinder::find(vector<pair<int, string>> tracks) {
+    if (progress().running()) return false;
+
+    // One fingerprint per file, however many IDs list it
+    paths.clear();
+    idsOfPath.clear();
+    unordered_map<string, size_t> slots;
+    for (pair<int, string>& track : tracks) {
+        auto [slot, added] = slots.try_emplace(track.second, paths.size());
+        if (added) {
+            paths.push_back(std::move(track.second));
+            idsOfPath.emplace_back();
+        }
+        idsOfPath[slot->second].push_back(track.first);
+    }
+
+    index = DuplicateIndex();
+    result.clear();
+    fingerprinted = 0;
+    tooShort = 0;
+    failed = 0;
+    busyNs = 0;
+    groupCount = 0;
+    duplicateCount = 0;
+    grouped = false;
+    unfinished = paths.size();
+    queued = paths.size(); // Last: progress() reports a pass from here on
+    if (paths.empty()) {
+        group();
+        return true;
+    }
+
+    for (size_t first = 0; first < paths.size(); first += FilesPerTask) {
+        size_t last = min(first + FilesPerTask, paths.size());
+        pool->submit([this, first, last] { fingerprintFiles(first, last); });
+    }
+    return true;
+}
+
+DuplicateFinder::Progress DuplicateFinder::progress() const {
+    Progress p;
+    p.grouped = grouped.load();
+    p.fingerprinted = fingerprinted.load();
+    p.tooShort = tooShort.load();
+    p.failed = failed.load();
+    p.queued = queued.load();
+    p.busySeconds = static_cast<double>(busyNs.load()) / 1e9;
+    p.groups = groupCount.load();
+    p.duplicates = duplicateCount.load();
+    return p;
+}
+
+vector<vector<int>> DuplicateFinder::takeGroups() {
+    if (!grouped) return {};
+    lock_guard<mutex> guard(indexLock);
+    vector<vector<int>> groups = std::move(result);
+    result.clear();
+    queued = 0;
+    grouped = false;
+    return groups;
+}
+
+//----------------------------------------------------
+void DuplicateFinder::fingerprintFiles(size_t first, size_t last) {
+    thread_local bool lowered = false;
+    if (!lowered) {
+        ThreadPool::lowerCurrentPriority();
+        lowered = true;
+    }
+
+    for (size_t i = first; i < last; i++) {
+        if (stopping) return;
+
+        auto start = Clock::now();
+        bool opened = false;
+        Fingerprint print = fingerprint(paths[i], opened);
+        if (stopping) return;
+        busyNs.fetch_add(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count(), memory_order_relaxed);
+
+        if (!opened) {
+            failed++;
+        } else if (print.empty()) {
+            tooShort++;
+        } else {
+            {
+                lock_guard<mutex> guard(indexLock);
+                index.add(static_cast<int>(i), std::move(print));
+            }
+            fingerprinted++;
+        }
+        fileDone();
+    }
+}
+
+Fingerprint DuplicateFinder::fingerprint(const string& path, bool& opened) {
+    PcmSource source;
+    opened = source.open(path, 0);
+    if (!opened) return Fingerprint();
+
+    unsigned channels = source.channelCount();
+    Fingerprinter fingerprinter(source.sampleRate(), channels);
+    vector<int16_t> chunk(ChunkFrames * channels);
+    while (!stopping && !fingerprinter.full()) {
+        size_t got = source.read(chunk.data(), chunk.size());
+        if (got == 0) break;
+        fingerprinter.add(chunk.data(), got / channels);
+    }
+    return fingerprinter.finish();
+}
+
+void DuplicateFinder::fileDone() {
+    if (unfinished.fetch_sub(1) == 1) {
+        group();
+        return;
+    }
+
+    if (!onProgress) return;
+    int64_t now = nowNs();
+    int64_t previous = lastReportNs.load(memory_order_relaxed);
+    if (now - previous >= ReportIntervalNs && lastReportNs.compare_exchange_strong(previous, now)) onProgress();
+}
+
+void DuplicateFinder::group() {
+    vector<vector<int>> groups;
+    {
+        lock_guard<mutex> guard(indexLock);
+        vector<char> inGroup(paths.size(), 0);
+        for (const vector<int>& files : index.groups()) {
+            vector<int>& ids = groups.emplace_back();
+            for (int file : files) {
+                const vector<int>& listed = idsOfPath[static_cast<size_t>(file)];
+                ids.insert(ids.end(), listed.begin(), listed.end());
+                inGroup[static_cast<size_t>(file)] = 1;
+            }
+        }
+        // The same file under several IDs, with no other copy
+        for (size_t file = 0; file < paths.size(); file++) {
+            if (!inGroup[file] && idsOfPath[file].size() > 1) groups.push_back(idsOfPath[file]);
+        }
+        index = DuplicateIndex(); // The fingerprints aren't needed any more
+
+        size_t extra = 0;
+        for (vector<int>& ids : groups) {
+            sort(ids.begin(), ids.end());
+            extra += ids.size() - 1;
+        }
+        result = std::move(groups);
+        groupCount = result.size();
+        duplicateCount = extra;
+    }
+    grouped = true;
+    if (onProgress) onProgress();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DuplicateIndex.h"
+
+class ThreadPool;
+
+// Finds tracks that are the same recording, whatever their tags and paths
+// say, by listening to them.
+//
+// A pass decodes the first minute of every distinct file on a thread pool of
+// its own, one thread per core at low OS priority, and fingerprints it
+// (Fingerprinter). When the last file is done, the DuplicateIndex groups the
+// fingerprints and the groups are turned back into track IDs; a file listed
+// under several IDs is a group by itself. Nothing is kept between passes.
+class DuplicateFinder {
+public:
+    struct Progress {
+        std::size_t queued = 0;        // Distinct files in this pass (0 = no pass)
+        std::size_t fingerprinted = 0;
+        std::size_t tooShort = 0;      // Under Fingerprinter::MinCodes of sound: left out
+        std::size_t failed = 0;        // Couldn't be opened
+        double busySeconds = 0.0;      // Decoding and fingerprinting, summed over threads
+        bool grouped = false;          // Over: takeGroups() has the result
+        std::size_t groups = 0;        // Recordings found under more than one ID
+        std::size_t duplicates = 0;    // IDs beyond the first of each
+
+        std::size_t done() const { return fingerprinted + tooShort + failed; }
+        bool running() const { return queued > 0 && !grouped; }
+    };
+
+    // 0 threads = one per core
+    explicit DuplicateFinder(unsigned threads = 0);
+
+    // Abandons a pass that is under way
+    ~DuplicateFinder();
+
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // Called on a pool thread a few times a second while a pass runs, and
+    // once when its groups are ready. Set before the first find().
+    void setProgressCallback(std::function<void()> callback);
+
+    // Start a pass over these (track ID, file) pairs and return at once.
+    // False, and nothing done, while the last pass is still running.
+    bool find(std::vector<std::pair<int, std::string>> tracks);
+
+    Progress progress() const;
+
+    // The finished pass's groups of track IDs, each in ID order, and back to
+    // no pass at all (empty while one is running)
+    std::vector<std::vector<int>> takeGroups();
+
+private:
+    std::function<void()> onProgress;
+
+    // The pass; set up by find() while no task runs
+    std::vector<std::string> paths;           // Distinct files
+    std::vector<std::vector<int>> idsOfPath;  // Track IDs listing each one
+    DuplicateIndex index;                     // Keys are indexes into 'paths'
+    std::mutex indexLock;                     // Guards 'index' and 'result'
+    std::vector<std::vector<int>> result;
+
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::size_t> queued{ 0 };
+    std::atomic<std::size_t> fingerprinted{ 0 };
+    std::atomic<std::size_t> tooShort{ 0 };
+    std::atomic<std::size_t> failed{ 0 };
+    std::atomic<std::size_t> unfinished{ 0 }; // Files left; whoever takes it to 0 groups
+    std::atomic<std::int64_t> busyNs{ 0 };
+    std::atomic<bool> grouped{ false };
+    std::atomic<std::size_t> groupCount{ 0 };
+    std::atomic<std::size_t> duplicateCount{ 0 };
+    std::atomic<std::int64_t> lastReportNs{ 0 };
+
+    std::unique_ptr<ThreadPool> pool; // Last: its threads use everything above
+
+    void fingerprintFiles(std::size_t first, std::size_t last);
+    Fingerprint fingerprint(const std::string& path, bool& opened);
+    void fileDone();
+    void group(); // On whichever thread finished the last file
+};
@@ -0,0 +1,113 @@
+#include "DuplicateIndex.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+    using BandPositions = array<array<uint8_t, DuplicateIndex::BandBits>, DuplicateIndex::Bands>;
+
+    // Which sketch bits each band reads: BandBits distinct positions per band,
+    // the same in every run (splitmix64 driving a partial Fisher-Yates shuffle)
+    const BandPositions& bandBits() {
+        static_assert(Fingerprinter::SketchBits == 256, "positions are stored in a byte");
+        static const BandPositions positions = [] {
+            BandPositions result{};
+            uint64_t state = 0x2545F4914F6CDD1Dull;
+            for (auto& band : result) {
+                uint8_t all[Fingerprinter::SketchBits];
+                for (size_t i = 0; i < Fingerprinter::SketchBits; i++) all[i] = static_cast<uint8_t>(i);
+                for (size_t k = 0; k < band.size(); k++) {
+                    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                    z ^= z >> 31;
+                    size_t pick = k + static_cast<size_t>(z % (Fingerprinter::SketchBits - k));
+                    swap(all[k], all[pick]);
+                    band[k] = all[k];
+                }
+            }
+            return result;
+        }();
+        return positions;
+    }
+}
+
+void DuplicateIndex::add(int key, Fingerprint fingerprint) {
+    if (fingerprint.empty()) return;
+    entries.push_back(Entry{ key, std::move(fingerprint) });
+}
+
+vector<vector<int>> DuplicateIndex::groups(double threshold, Stats* stats) const {
+    Stats counts;
+
+    vector<uint32_t> parent(entries.size());
+    iota(parent.begin(), parent.end(), 0u);
+    auto find = [&](uint32_t i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]]; // Path halving
+        return i;
+    };
+
+    // One band at a time: a counting sort of the entries by the band's value
+    // (in entry order within a value), then each run of equal values is a bucket
+    vector<uint32_t> value(entries.size());
+    vector<uint32_t> order(entries.size());
+    vector<uint32_t> start((size_t(1) << BandBits) + 1);
+    for (int band = 0; band < Bands; band++) {
+        fill(start.begin(), start.end(), 0u);
+        for (size_t i = 0; i < entries.size(); i++) {
+            value[i] = slice(entries[i].fingerprint, band);
+            start[value[i] + 1]++;
+        }
+        partial_sum(start.begin(), start.end(), start.begin());
+        for (uint32_t i = 0; i < entries.size(); i++) order[start[value[i]]++] = i;
+
+        for (size_t begin = 0; begin < order.size();) {
+            size_t end = begin + 1;
+            while (end < order.size() && value[order[end]] == value[order[begin]]) end++;
+            for (size_t i = begin; i < end; i++) {
+                for (size_t j = i + 1; j < end && j - i <= BucketReach; j++) {
+                    counts.candidates++;
+                    uint32_t a = find(order[i]), b = find(order[j]);
+                    if (a == b) continue;
+                    const Fingerprint& fa = entries[order[i]].fingerprint;
+                    const Fingerprint& fb = entries[order[j]].fingerprint;
+                    if (Fingerprinter::sketchDistance(fa, fb) > MaxSketchDistance) continue;
+                    counts.compared++;
+                    if (Fingerprinter::similarity(fa, fb) < threshold) continue;
+                    counts.matched++;
+                    parent[max(a, b)] = min(a, b);
+                }
+            }
+            begin = end;
+        }
+    }
+
+    // Members by root, in entry order; then each group by key
+    vector<vector<int>> found;
+    vector<int> groupOf(entries.size(), -1);
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        uint32_t root = find(i);
+        if (root == i) continue;
+        if (groupOf[root] < 0) {
+            groupOf[root] = static_cast<int>(found.size());
+            found.push_back({ entries[root].key });
+        }
+        found[static_cast<size_t>(groupOf[root])].push_back(entries[i].key);
+    }
+    for (vector<int>& group : found) sort(group.begin(), group.end());
+    sort(found.begin(), found.end(), [](const vector<int>& a, const vector<int>& b) { return a.front() < b.front(); });
+
+    if (stats != nullptr) *stats = counts;
+    return found;
+}
+
+uint32_t DuplicateIndex::slice(const Fingerprint& fingerprint, int band) {
+    const uint8_t* bits = bandBits()[static_cast<size_t>(band)].data();
+    uint32_t value = 0;
+    for (int k = 0; k < BandBits; k++) {
+        value |= static_cast<uint32_t>((fingerprint.sketch[bits[k] / 64] >> (bits[k] % 64)) & 1) << k;
+    }
+    return value;
+}
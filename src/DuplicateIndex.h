@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Fingerprint.h"
+
+// Groups fingerprints of the same recording, without comparing every pair.
+//
+// A locality-sensitive hash index over the fingerprints' sketches: each of
+// Bands bands reads BandBits of the sketch's bits (positions drawn at random
+// once, the same in every run), and two fingerprints become candidates if
+// they agree on all the bits of some band. A copy with 15% of its bits
+// differing shares a band all but surely, with a fifth differing 97% of the
+// time (a quarter, 78%); unrelated tracks, about half differing, share a
+// given band in one pair of 65536 and any band in one of ~340. Candidates
+// are weeded out by sketch distance, then confirmed by comparing their codes
+// (Fingerprinter::similarity), and the confirmed pairs are joined into groups
+// with a union-find, so A~B and B~C put all three together.
+//
+// Each band is bucketed by a counting sort on its value, so a bucket is a
+// run of neighbours rather than a hash table of lists. Within a bucket each
+// member is compared with the next BucketReach at most: a crowd of
+// near-identical sketches costs linear time, not quadratic, and the
+// union-find still chains its copies into one group.
+// Not thread-safe; fill it from one thread (or under a lock).
+class DuplicateIndex {
+public:
+    static constexpr double DefaultThreshold = 0.75; // Least similarity of a match
+    static constexpr int BandBits = 16;
+    static constexpr int Bands = 192;
+    static constexpr std::size_t BucketReach = 32;
+    static constexpr int MaxSketchDistance = 100; // Of 256 bits; copies are well under, others well over
+
+    struct Stats {
+        std::size_t candidates = 0; // Pairs that shared a band (a pair may count once per band)
+        std::size_t compared = 0;   // Of those, close enough by sketch to compare codes
+        std::size_t matched = 0;    // And similar enough: joined
+    };
+
+    // Under the caller's key (e.g. a position in its own list). Empty
+    // fingerprints, from tracks too short or silent, are left out.
+    void add(int key, Fingerprint fingerprint);
+
+    std::size_t size() const { return entries.size(); }
+
+    // Every set of two or more keys whose fingerprints match, each in key
+    // order, the sets in order of their first key
+    std::vector<std::vector<int>> groups(double threshold = DefaultThreshold, Stats* stats = nullptr) const;
+
+private:
+    struct Entry {
+        int key;
+        Fingerprint fingerprint;
+    };
+
+    std::vector<Entry> entries;
+
+    static std::uint32_t slice(const Fingerprint& fingerprint, int band);
+};
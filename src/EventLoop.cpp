@@ -0,0 +1,261 @@
+#include "EventLoop.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+//----------------------------------------------------
+void EventLoop::setTimer(chrono::milliseconds interval) {
+    if (interval == timerInterval) return;
+    timerInterval = interval;
+    timerDue = Clock::now() + interval;
+}
+
+int EventLoop::msUntilTimer() const {
+    if (timerInterval.count() <= 0) return -1;
+    auto left = chrono::duration_cast<chrono::milliseconds>(timerDue - Clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+#ifdef _WIN32
+//----------------------------------------------------
+EventLoop::EventLoop() {
+    inputHandle = GetStdHandle(STD_INPUT_HANDLE);
+    wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr); // Auto-reset
+    enterRawMode();
+}
+
+EventLoop::~EventLoop() {
+    leaveRawMode();
+    if (wakeEvent) CloseHandle(wakeEvent);
+}
+
+void EventLoop::enterRawMode() {
+    DWORD mode = 0;
+    if (!GetConsoleMode(inputHandle, &mode)) return;
+    savedMode = mode;
+    SetConsoleMode(inputHandle, mode & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT));
+}
+
+void EventLoop::leaveRawMode() {
+    if (savedMode != 0) SetConsoleMode(inputHandle, savedMode);
+}
+
+void EventLoop::notify() {
+    SetEvent(wakeEvent);
+}
+
+EventLoop::Event EventLoop::next() {
+    HANDLE handles[2] = { wakeEvent, inputHandle };
+    while (true) {
+        int timeout = msUntilTimer();
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeout < 0 ? INFINITE : static_cast<DWORD>(timeout));
+
+        if (result == WAIT_OBJECT_0) return Event{ EventType::Wake };
+        if (result == WAIT_TIMEOUT) {
+            timerDue = Clock::now() + timerInterval;
+            return Event{ EventType::Timer };
+        }
+        if (result != WAIT_OBJECT_0 + 1) return Event{ EventType::Closed };
+
+        // The input handle also signals mouse/focus/resize records: skip those
+        INPUT_RECORD record;
+        DWORD count = 0;
+        if (!ReadConsoleInputA(inputHandle, &record, 1, &count) || count == 0) return Event{ EventType::Closed };
+        if (record.EventType != KEY_EVENT || !record.Event.KeyEvent.bKeyDown) continue;
+
+        switch (record.Event.KeyEvent.wVirtualKeyCode) {
+            case VK_UP: return Event{ EventType::Key, KeyUp };
+            case VK_DOWN: return Event{ EventType::Key, KeyDown };
+            case VK_PRIOR: return Event{ EventType::Key, KeyPageUp };
+            case VK_NEXT: return Event{ EventType::Key, KeyPageDown };
+            case VK_HOME: return Event{ EventType::Key, KeyHome };
+            case VK_END: return Event{ EventType::Key, KeyEnd };
+            case VK_RETURN: return Event{ EventType::Key, KeyEnter };
+            default: break;
+        }
+        char ascii = record.Event.KeyEvent.uChar.AsciiChar;
+        if (ascii != 0) return Event{ EventType::Key, static_cast<unsigned char>(ascii) };
+    }
+}
+
+bool EventLoop::readLine(string& line) {
+    leaveRawMode();
+    FlushConsoleInputBuffer(inputHandle);
+    bool ok = static_cast<bool>(getline(cin, line));
+    enterRawMode();
+    return ok;
+}
+
+#else
+//----------------------------------------------------
+EventLoop::EventLoop() {
+    if (pipe(wakePipe) == 0) {
+        for (int fd : wakePipe) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    enterRawMode();
+}
+
+EventLoop::~EventLoop() {
+    leaveRawMode();
+    for (int fd : wakePipe) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void EventLoop::enterRawMode() {
+    // Not a terminal (e.g. piped input): bytes arrive as they are anyway
+    if (tcgetattr(STDIN_FILENO, &savedTermios) != 0) return;
+
+    termios raw = savedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0) rawActive = true;
+}
+
+void EventLoop::leaveRawMode() {
+    if (!rawActive) return;
+    tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+    rawActive = false;
+}
+
+void EventLoop::notify() {
+    // A full pipe already holds a pending wake-up, so EAGAIN is fine
+    char byte = 1;
+    ssize_t ignored = write(wakePipe[1], &byte, 1);
+    (void)ignored;
+}
+
+int EventLoop::decodeKey(bool complete) {
+    if (pendingInput.empty()) return 0;
+
+    unsigned char first = static_cast<unsigned char>(pendingInput[0]);
+    if (first != KeyEscape) {
+        pendingInput.erase(0, 1);
+        return first == '\r' ? static_cast<int>(KeyEnter) : first;
+    }
+
+    bool introducer = pendingInput.size() >= 2 && (pendingInput[1] == '[' || pendingInput[1] == 'O');
+    if (pendingInput.size() < 2 || (introducer && pendingInput.size() < 3)) {
+        if (!complete) return 0; // Wait for the rest of the sequence
+        pendingInput.erase(0, 1);
+        return KeyEscape;
+    }
+    if (!introducer) {
+        pendingInput.erase(0, 1); // ESC followed by an ordinary key
+        return KeyEscape;
+    }
+
+    // ESC [ <letter>  or  ESC [ <digit> ~   (xterm / VT220 style)
+    char code = pendingInput[2];
+    int key = 0;
+    size_t length = 3;
+    if (code >= '0' && code <= '9') {
+        if (pendingInput.size() < 4 && !complete) return 0;
+        if (pendingInput.size() >= 4 && pendingInput[3] == '~') {
+            length = 4;
+            if (code == '1' || code == '7') key = KeyHome;
+            else if (code == '4' || code == '8') key = KeyEnd;
+            else if (code == '5') key = KeyPageUp;
+            else if (code == '6') key = KeyPageDown;
+        }
+    } else if (code == 'A') {
+        key = KeyUp;
+    } else if (code == 'B') {
+        key = KeyDown;
+    } else if (code == 'H') {
+        key = KeyHome;
+    } else if (code == 'F') {
+        key = KeyEnd;
+    }
+
+    // Sequences we don't use (e.g. left/right arrows) are swallowed whole
+    pendingInput.erase(0, length);
+    return key != 0 ? key : decodeKey(complete);
+}
+
+EventLoop::Event EventLoop::next() {
+    while (true) {
+        if (int key = decodeKey(false)) return Event{ EventType::Key, key };
+
+        // The tail of an escape sequence arrives right behind its head;
+        // if it doesn't within a few ms, it was a plain ESC key
+        bool partial = !pendingInput.empty();
+        int timeout = partial ? 25 : msUntilTimer();
+
+        pollfd fds[2] = {
+            { wakePipe[0], POLLIN, 0 },
+            { STDIN_FILENO, POLLIN, 0 }
+        };
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return Event{ EventType::Closed };
+        }
+        if (ready == 0 && partial) {
+            return Event{ EventType::Key, decodeKey(true) };
+        }
+        if (ready == 0) {
+            timerDue = Clock::now() + timerInterval;
+            return Event{ EventType::Timer };
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            return Event{ EventType::Wake };
+        }
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            char bytes[32];
+            ssize_t got = read(STDIN_FILENO, bytes, sizeof(bytes));
+            if (got > 0) {
+                pendingInput.append(bytes, static_cast<size_t>(got));
+                continue;
+            }
+            if (got < 0 && errno == EINTR) continue;
+            if (partial) return Event{ EventType::Key, decodeKey(true) };
+            return Event{ EventType::Closed };
+        }
+    }
+}
+
+bool EventLoop::readLine(string& line) {
+    // Byte-wise read() rather than getline(cin): cin could buffer keys past the
+    // newline, and poll() would never see them
+    bool wasRaw = rawActive;
+    leaveRawMode();
+
+    // Keys typed ahead of the prompt belong to the line
+    line.clear();
+    bool ok = false;
+    bool done = false;
+    while (!pendingInput.empty() && !done) {
+        char c = pendingInput[0];
+        pendingInput.erase(0, 1);
+        ok = true;
+        if (c == '\n' || c == '\r') done = true;
+        else line.push_back(c);
+    }
+    char c;
+    while (!done && read(STDIN_FILENO, &c, 1) == 1) {
+        ok = true;
+        if (c == '\n') break;
+        if (c != '\r') line.push_back(c);
+    }
+
+    if (wasRaw) enterRawMode();
+    return ok;
+}
+#endif
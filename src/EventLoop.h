@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <string>
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+// Single-threaded event loop for the console front end. One blocking wait
+// covers everything the UI reacts to:
+//     - a key press (stdin switched to raw, unbuffered, no-echo input)
+//     - notify() from any other thread (e.g. the audio thread at end of track)
+//     - an optional repeating timer
+// POSIX waits in poll() on stdin and a self-pipe; Windows waits in
+// WaitForMultipleObjects on the console input handle and an event. Either
+// way an idle player sleeps in the kernel and uses no CPU.
+class EventLoop {
+public:
+    // Event::key is the character itself for ordinary keys, or one of these
+    enum Key : int {
+        KeyEnter = '\n',
+        KeyEscape = 27,
+        KeyUp = 0x100,
+        KeyDown,
+        KeyPageUp,
+        KeyPageDown,
+        KeyHome,
+        KeyEnd
+    };
+
+    enum class EventType {
+        Key,    // 'key' holds the character or a Key code
+        Wake,   // notify() was called
+        Timer,  // The repeating timer fired
+        Closed  // stdin reached end of file
+    };
+
+    struct Event {
+        EventType type;
+        int key = 0;
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Block until the next event
+    Event next();
+
+    // Thread-safe; calls that pile up before next() mostly collapse into one Wake
+    void notify();
+
+    // Fire a Timer event every 'interval' (zero turns it off)
+    void setTimer(std::chrono::milliseconds interval);
+
+    // Read a whole line with normal echo and editing (for prompts), then go back to raw keys
+    bool readLine(std::string& line);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::chrono::milliseconds timerInterval{ 0 };
+    Clock::time_point timerDue;
+
+    void enterRawMode();
+    void leaveRawMode();
+    int msUntilTimer() const; // -1 = no timer
+
+#ifdef _WIN32
+    void* inputHandle = nullptr;
+    void* wakeEvent = nullptr;
+    unsigned long savedMode = 0;
+#else
+    int wakePipe[2] = { -1, -1 };
+    bool rawActive = false;
+    termios savedTermios{};
+    std::string pendingInput; // Bytes read but not yet turned into keys
+
+    // Next key from pendingInput (0 if it holds only the start of an escape sequence)
+    int decodeKey(bool complete);
+#endif
+};
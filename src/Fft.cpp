@@ -0,0 +1,106 @@
+#include "Fft.h"
+#include <cmath>
+
+// SSE is part of x86-64, so no run-time check is needed
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define HIVE_FFT_SSE 1
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+RealFft::RealFft(size_t size) : n(size), half(size / 2), bitReverse(half), re(half), im(half) {
+    const double pi = 3.14159265358979323846;
+
+    unsigned bits = 0;
+    while ((size_t{ 1 } << bits) < half) bits++;
+    for (size_t i = 0; i < half; i++) {
+        uint32_t reversed = 0;
+        for (unsigned b = 0; b < bits; b++) {
+            if (i & (size_t{ 1 } << b)) reversed |= 1u << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+
+    // 1 + 2 + ... + half/2 = half - 1 twiddles over all stages
+    twiddleRe.reserve(half);
+    twiddleIm.reserve(half);
+    for (size_t length = 2; length <= half; length <<= 1) {
+        for (size_t j = 0; j < length / 2; j++) {
+            double angle = -2.0 * pi * static_cast<double>(j) / static_cast<double>(length);
+            twiddleRe.push_back(static_cast<float>(cos(angle)));
+            twiddleIm.push_back(static_cast<float>(sin(angle)));
+        }
+    }
+
+    splitRe.resize(half + 1);
+    splitIm.resize(half + 1);
+    for (size_t k = 0; k <= half; k++) {
+        double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(n);
+        splitRe[k] = static_cast<float>(cos(angle));
+        splitIm[k] = static_cast<float>(sin(angle));
+    }
+}
+
+void RealFft::transform() {
+    for (size_t length = 2; length <= half; length <<= 1) {
+        size_t span = length / 2;
+        const float* wr = twiddleRe.data() + span - 1;
+        const float* wi = twiddleIm.data() + span - 1;
+        for (size_t start = 0; start < half; start += length) {
+            float* ar = re.data() + start;
+            float* ai = im.data() + start;
+            float* br = ar + span;
+            float* bi = ai + span;
+            size_t j = 0;
+#ifdef HIVE_FFT_SSE
+            for (; j + 4 <= span; j += 4) {
+                __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+                __m128 cr = _mm_loadu_ps(wr + j), ci = _mm_loadu_ps(wi + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                __m128 ur = _mm_loadu_ps(ar + j), ui = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(ar + j, _mm_add_ps(ur, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(ui, ti));
+                _mm_storeu_ps(br + j, _mm_sub_ps(ur, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(ui, ti));
+            }
+#endif
+            // The first two stages (and anything without SSE)
+            for (; j < span; j++) {
+                float tr = br[j] * wr[j] - bi[j] * wi[j];
+                float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+void RealFft::powerSpectrum(const float* in, float* power) {
+    // Even samples as real parts, odd ones as imaginary, in bit-reversed order
+    for (size_t i = 0; i < half; i++) {
+        uint32_t from = bitReverse[i];
+        re[i] = in[2 * from];
+        im[i] = in[2 * from + 1];
+    }
+    transform();
+
+    // X[k] = E[k] + W^k O[k], where E and O (the spectra of the even and odd
+    // samples) come from Z[k] and conj(Z[half - k]). At DC and Nyquist both are Z[0].
+    power[0] = (re[0] + im[0]) * (re[0] + im[0]);
+    power[half] = (re[0] - im[0]) * (re[0] - im[0]);
+    for (size_t k = 1; k < half; k++) {
+        size_t a = k;
+        size_t b = half - k;
+        float evenRe = 0.5f * (re[a] + re[b]);
+        float evenIm = 0.5f * (im[a] - im[b]);
+        float oddRe = 0.5f * (im[a] + im[b]);
+        float oddIm = -0.5f * (re[a] - re[b]);
+        float xr = evenRe + splitRe[k] * oddRe - splitIm[k] * oddIm;
+        float xi = evenIm + splitRe[k] * oddIm + splitIm[k] * oddRe;
+        power[k] = xr * xr + xi * xi;
+    }
+}
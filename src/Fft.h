@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward FFT of real input, for one fixed power-of-two size.
+//
+// The N real samples are packed into N/2 complex ones, transformed with an
+// iterative radix-2 FFT, and split back into the N/2 + 1 bins of the real
+// spectrum. Real and imaginary parts live in separate arrays, so each stage's
+// butterflies run four at a time in SSE registers (scalar elsewhere).
+// Twiddles and the bit-reversal order are computed once, in the constructor.
+// Not thread-safe: it keeps its work buffers between calls.
+class RealFft {
+public:
+    // 'size' is a power of two, at least 8
+    explicit RealFft(std::size_t size);
+
+    std::size_t size() const { return n; }
+    std::size_t bins() const { return n / 2 + 1; }
+
+    // 'in': size() samples. 'power': bins() values of |X[k]|^2, DC first.
+    void powerSpectrum(const float* in, float* power);
+
+private:
+    std::size_t n;
+    std::size_t half; // Length of the complex transform
+    std::vector<std::uint32_t> bitReverse;
+    std::vector<float> twiddleRe, twiddleIm; // Stage of length L starts at L/2 - 1
+    std::vector<float> splitRe, splitIm;     // exp(-2 pi i k / n), k = 0 .. half
+    std::vector<float> re, im;
+
+    void transform(); // In place on re/im, input in bit-reversed order
+};
@@ -0,0 +1,241 @@
+#include "Fingerprint.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// SSE is part of x86-64, so no run-time check is needed
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define HIVE_FINGERPRINT_SSE 1
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    const double Pi = 3.14159265358979323846;
+    const double MinHz = 65.0;   // C2
+    const double MaxHz = 3520.0; // A7
+    const float SilenceEnergy = 1e-6f; // Mean square of a frame, about -60 dBFS
+
+    // sum a[i] * b[i]; 'count' is a multiple of 4
+    float dot(const float* a, const float* b, size_t count) {
+#ifdef HIVE_FINGERPRINT_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (size_t i = 0; i < count; i += 4) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        __m128 pairs = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+#else
+        float sum = 0.0f;
+        for (size_t i = 0; i < count; i++) sum += a[i] * b[i];
+        return sum;
+#endif
+    }
+
+    // out[i] = a[i] * b[i]; 'count' is a multiple of 4
+    void multiply(const float* a, const float* b, float* out, size_t count) {
+#ifdef HIVE_FINGERPRINT_SSE
+        for (size_t i = 0; i < count; i += 4) _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+#else
+        for (size_t i = 0; i < count; i++) out[i] = a[i] * b[i];
+#endif
+    }
+
+    // Power to magnitude, in place
+    void magnitudes(float* values, size_t count) {
+        size_t i = 0;
+#ifdef HIVE_FINGERPRINT_SSE
+        for (; i + 4 <= count; i += 4) _mm_storeu_ps(values + i, _mm_sqrt_ps(_mm_loadu_ps(values + i)));
+#endif
+        for (; i < count; i++) values[i] = sqrtf(values[i]);
+    }
+
+    // The sketch's random directions, the same in every run: SketchBits rows
+    // of Segments * 12 values of +-1 (as good as Gaussian ones for this)
+    const vector<float>& sketchPlanes() {
+        static const vector<float> planes = [] {
+            const size_t count = Fingerprinter::SketchBits * Fingerprinter::SketchInputs;
+            vector<float> values(count);
+            uint64_t state = 0x9E3779B97F4A7C15ull;
+            for (size_t i = 0; i < count; i++) {
+                // splitmix64
+                uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                values[i] = ((z ^ (z >> 31)) & 1) != 0 ? 1.0f : -1.0f;
+            }
+            return values;
+        }();
+        return planes;
+    }
+}
+
+//----------------------------------------------------
+Fingerprinter::Fingerprinter(unsigned sampleRate, unsigned channelCount)
+    : channels(max(channelCount, 1u)), step(static_cast<double>(max(sampleRate, 1u)) / Rate), fft(FrameSize),
+      window(FrameSize), frame(FrameSize), windowed(FrameSize), power(fft.bins()),
+      maxCodes(static_cast<size_t>(MaxSeconds * Rate / Hop)), perSegment((maxCodes + Segments - 1) / Segments) {
+    // Cut off just below the new Nyquist frequency (or the old one, if that is lower)
+    double cutoff = 0.45 / max(step, 1.0); // Cycles per input sample
+    size_t length = static_cast<size_t>(16.0 * ceil(step));
+    taps.resize(length);
+    double center = (static_cast<double>(length) - 1.0) / 2.0, sum = 0.0;
+    for (size_t k = 0; k < length; k++) {
+        double x = static_cast<double>(k) - center;
+        double sinc = x == 0.0 ? 1.0 : sin(2.0 * Pi * cutoff * x) / (2.0 * Pi * cutoff * x);
+        double hann = 0.5 + 0.5 * cos(2.0 * Pi * x / static_cast<double>(length));
+        taps[k] = static_cast<float>(sinc * hann);
+        sum += sinc * hann;
+    }
+    for (float& t : taps) t = static_cast<float>(t / sum);
+
+    for (size_t i = 0; i < FrameSize; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * cos(2.0 * Pi * static_cast<double>(i) / FrameSize));
+    }
+
+    double binHz = static_cast<double>(Rate) / FrameSize;
+    firstBin = static_cast<size_t>(ceil(MinHz / binHz));
+    size_t lastBin = static_cast<size_t>(MaxHz / binHz);
+    for (size_t b = firstBin; b <= lastBin; b++) {
+        double hz = static_cast<double>(b) * binHz;
+        long midi = lround(69.0 + 12.0 * log2(hz / 440.0));
+        pitchClass.push_back(static_cast<int8_t>(midi % 12)); // 0 = C
+        int slot = static_cast<int>(Bands * log(hz / MinHz) / log(MaxHz / MinHz));
+        band.push_back(static_cast<int8_t>(clamp(slot, 0, Bands - 1)));
+    }
+}
+
+void Fingerprinter::add(const int16_t* interleaved, size_t count) {
+    if (full()) return;
+    size_t start = mono.size();
+    mono.resize(start + count);
+    const float scale = 1.0f / (32768.0f * static_cast<float>(channels));
+    for (size_t i = 0; i < count; i++) {
+        int sum = 0;
+        for (unsigned c = 0; c < channels; c++) sum += interleaved[i * channels + c];
+        mono[start + i] = static_cast<float>(sum) * scale;
+    }
+    resample();
+}
+
+bool Fingerprinter::full() const {
+    return codes.size() >= maxCodes;
+}
+
+Fingerprint Fingerprinter::finish() const {
+    Fingerprint result;
+    if (codes.size() < MinCodes) return result;
+    result.codes = codes;
+
+    // Mean chroma of each segment with sound in it, then less their average
+    size_t used = min((codes.size() + perSegment - 1) / perSegment, Segments);
+    float centered[SketchInputs] = {};
+    for (int p = 0; p < 12; p++) {
+        double mean = 0.0;
+        for (size_t s = 0; s < used; s++) {
+            size_t count = min(perSegment, codes.size() - s * perSegment);
+            centered[s * 12 + p] = static_cast<float>(outline[s][p] / static_cast<double>(count));
+            mean += centered[s * 12 + p];
+        }
+        mean /= static_cast<double>(used);
+        for (size_t s = 0; s < used; s++) centered[s * 12 + p] -= static_cast<float>(mean);
+    }
+
+    const vector<float>& planes = sketchPlanes();
+    for (size_t bit = 0; bit < SketchBits; bit++) {
+        if (dot(planes.data() + bit * SketchInputs, centered, SketchInputs) > 0.0f) {
+            result.sketch[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+    return result;
+}
+
+int Fingerprinter::sketchDistance(const Fingerprint& a, const Fingerprint& b) {
+    int distance = 0;
+    for (size_t w = 0; w < a.sketch.size(); w++) distance += popcount(a.sketch[w] ^ b.sketch[w]);
+    return distance;
+}
+
+double Fingerprinter::similarity(const Fingerprint& fa, const Fingerprint& fb) {
+    const vector<uint32_t>& a = fa.codes;
+    const vector<uint32_t>& b = fb.codes;
+    size_t shorter = min(a.size(), b.size());
+    if (shorter < MinCodes) return 0.0;
+
+    double best = 0.0;
+    for (int shift = -MaxShift; shift <= MaxShift; shift++) {
+        // a[i] against b[i + shift]
+        size_t begin = static_cast<size_t>(max(-shift, 0));
+        long long endB = static_cast<long long>(b.size()) - shift;
+        size_t end = static_cast<size_t>(min<long long>(static_cast<long long>(a.size()), endB));
+        if (end <= begin || 2 * (end - begin) < shorter) continue;
+
+        size_t differing = 0;
+        for (size_t i = begin; i < end; i++) differing += static_cast<size_t>(popcount(a[i] ^ b[i + shift]));
+        best = max(best, 1.0 - static_cast<double>(differing) / (32.0 * static_cast<double>(end - begin)));
+    }
+    return best;
+}
+
+//----------------------------------------------------
+// Evaluates the low pass at each output instant, interpolating linearly
+// between the two input positions on either side of it
+void Fingerprinter::resample() {
+    size_t length = taps.size();
+    while (!full()) {
+        size_t at = static_cast<size_t>(position);
+        if (at + 1 + length > mono.size()) break;
+        float frac = static_cast<float>(position - static_cast<double>(at));
+        float before = dot(taps.data(), mono.data() + at, length);
+        float after = dot(taps.data(), mono.data() + at + 1, length);
+        position += step;
+
+        frame[frameFill++] = before + (after - before) * frac;
+        if (frameFill == FrameSize) {
+            analyzeFrame();
+            copy(frame.begin() + Hop, frame.end(), frame.begin());
+            frameFill = FrameSize - Hop;
+        }
+    }
+
+    size_t used = min(static_cast<size_t>(position), mono.size());
+    mono.erase(mono.begin(), mono.begin() + static_cast<ptrdiff_t>(used));
+    position -= static_cast<double>(used);
+}
+
+void Fingerprinter::analyzeFrame() {
+    if (codes.empty() && dot(frame.data(), frame.data(), FrameSize) < SilenceEnergy * FrameSize) return;
+
+    multiply(frame.data(), window.data(), windowed.data(), FrameSize);
+    fft.powerSpectrum(windowed.data(), power.data());
+
+    double bands[Bands] = {};
+    for (size_t i = 0; i < band.size(); i++) bands[band[i]] += power[firstBin + i];
+
+    magnitudes(power.data() + firstBin, pitchClass.size());
+    float* chroma = recent[codes.size() % 3];
+    fill(chroma, chroma + 12, 0.0f);
+    float total = 0.0f;
+    for (size_t i = 0; i < pitchClass.size(); i++) {
+        chroma[pitchClass[i]] += power[firstBin + i];
+        total += power[firstBin + i];
+    }
+    if (total > 0.0f) {
+        for (int p = 0; p < 12; p++) chroma[p] /= total;
+    }
+
+    float smooth[12];
+    for (int p = 0; p < 12; p++) smooth[p] = recent[0][p] + recent[1][p] + recent[2][p];
+    double* segment = outline[codes.size() / perSegment];
+    for (int p = 0; p < 12; p++) segment[p] += chroma[p];
+
+    uint32_t code = 0;
+    for (int p = 0; p < 12; p++) {
+        if (smooth[p] > smooth[(p + 1) % 12]) code |= 1u << p;
+        if (smooth[p] > smooth[(p + 7) % 12]) code |= 1u << (12 + p);
+    }
+    for (int b = 0; b + 1 < Bands; b++) {
+        if ((bands[b] - bands[b + 1]) - (lastBands[b] - lastBands[b + 1]) > 0.0) code |= 1u << (24 + b);
+    }
+    copy(bands, bands + Bands, lastBands);
+    codes.push_back(code);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Fft.h"
+
+struct Fingerprint {
+    // One 32-bit code per hop of audio (~93 ms), from the first sound on
+    std::vector<std::uint32_t> codes;
+
+    // The track's harmonic outline in 256 bits (see Fingerprinter): copies
+    // differ in a fifth of the bits or fewer, unrelated tracks in about half
+    std::array<std::uint64_t, 4> sketch{};
+
+    bool empty() const { return codes.empty(); }
+};
+
+// Chroma-based acoustic fingerprint of one track, for finding the same
+// recording under another name, path, gain, sample rate or encoding.
+//
+// The audio is mixed down to mono and resampled to 11025 Hz (a windowed-sinc
+// low pass, evaluated with SSE dot products). Hann-windowed 4096-point frames
+// go through a RealFft every 1024 samples; each bin's magnitude is added to
+// its pitch class (C, C#, ... B) between 65 Hz and 3.5 kHz, giving a 12-value
+// chroma vector per frame, smoothed over the last three. A code packs 32
+// comparisons that a gain change, a re-encode or a little noise rarely flip:
+//
+//     bits  0-11  pitch class i stronger than i + 1 (a semitone up)
+//     bits 12-23  pitch class i stronger than i + 7 (a fifth up)
+//     bits 24-31  whether the energy step between neighbouring bands
+//                 (8 of them, log-spaced over the same range) grew since
+//                 the previous frame
+//
+// The sketch is for finding candidates without comparing codes: the chroma
+// averaged over each of 16 stretches of ~3.8 s, less the track's mean chroma
+// (which mostly says what key it is in), projected onto 256 fixed random
+// directions, one bit per sign. Close outlines give mostly equal bits.
+//
+// Leading silence is skipped, so a copy with a different lead-in still lines
+// up, and only the first MaxSeconds of sound are used (~2.6 KB of codes).
+// Not thread-safe; one fingerprinter per track.
+class Fingerprinter {
+public:
+    static constexpr unsigned Rate = 11025;     // Hz, after resampling
+    static constexpr std::size_t FrameSize = 4096;
+    static constexpr std::size_t Hop = 1024;
+    static constexpr double MaxSeconds = 60.0;
+    static constexpr std::size_t MinCodes = 64; // ~6 s of sound; shorter tracks are left out
+    static constexpr std::size_t Segments = 16; // Stretches of the sketch's outline
+    static constexpr std::size_t SketchInputs = Segments * 12;
+    static constexpr std::size_t SketchBits = 256;
+
+    Fingerprinter(unsigned sampleRate, unsigned channels);
+
+    // Interleaved 16-bit samples; any number of whole frames per call
+    void add(const std::int16_t* interleaved, std::size_t frames);
+
+    // MaxSeconds of sound are in: the rest of the track changes nothing
+    bool full() const;
+
+    // The fingerprint of what came in so far (empty if under MinCodes codes)
+    Fingerprint finish() const;
+
+    // Fraction of equal bits, 0..1, at the best alignment of the two within
+    // +-MaxShift codes; 0 if they overlap by less than half the shorter one.
+    // Unrelated music scores around 0.55, the same recording 0.8 and up.
+    static double similarity(const Fingerprint& a, const Fingerprint& b);
+    static constexpr int MaxShift = 32; // ~3 s
+
+    // Sketch bits that differ, 0..SketchBits
+    static int sketchDistance(const Fingerprint& a, const Fingerprint& b);
+
+private:
+    static constexpr int Bands = 9; // Band energies behind the 8 trend bits
+
+    unsigned channels;
+    double step;               // Input samples per output sample
+    std::vector<float> taps;   // Low pass at the input rate, a multiple of 4 long
+    std::vector<float> mono;   // Input not yet consumed by the resampler
+    double position = 0.0;     // Of the next output sample, in 'mono'
+
+    RealFft fft;
+    std::vector<float> window;
+    std::vector<float> frame;  // Resampled, the last FrameSize samples first-to-last
+    std::size_t frameFill = 0;
+    std::vector<float> windowed;
+    std::vector<float> power;
+    std::size_t firstBin = 0;            // Of the chroma range; the two below start there
+    std::vector<std::int8_t> pitchClass; // Per bin, 0 = C
+    std::vector<std::int8_t> band;       // Per bin, 0 .. Bands - 1
+
+    float recent[3][12] = {};  // Chroma of the last three frames
+    double lastBands[Bands] = {};
+    std::vector<std::uint32_t> codes;
+    std::size_t maxCodes;
+    std::size_t perSegment;            // Codes per segment, rounded up so Segments cover maxCodes
+    double outline[Segments][12] = {}; // Chroma summed over each segment
+
+    void resample();
+    void analyzeFrame();
+};
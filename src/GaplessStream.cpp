@@ -0,0 +1,244 @@
+#include "GaplessStream.h"
+#include <algorithm>
+#include <utility>
+#include "Dsp.h"
+
+using namespace std;
+
+GaplessStream::GaplessStream(unique_ptr<AudioOutput> out) : output(std::move(out)) {
+    output->attach(*this);
+}
+
+GaplessStream::~GaplessStream() {
+    // The audio thread calls back into this object, so it must be gone first.
+    // Outputs seek their feed when stopped, their destructor included, so the
+    // output goes now, while the sources it would touch are still here.
+    output->stop();
+    output.reset();
+}
+
+void GaplessStream::start(Source source, Clock::time_point requested) {
+    if (!source) return;
+
+    AudioOutput::Status status = output->status();
+    {
+        lock_guard<mutex> guard(lock);
+        if (status != AudioOutput::Status::Stopped && current && current->sameFormat(*source)) {
+            // Hot path: the audio thread swaps it in on its next chunk
+            pending = std::move(source);
+            queued = nullptr;
+            requestedAt = requested;
+            source = nullptr;
+        }
+    }
+    if (!source) {
+        if (status == AudioOutput::Status::Paused) output->play();
+        return;
+    }
+
+    // Cold path: first track, or the format changed and the device has to be set up again
+    output->stop();
+    buffer.assign(static_cast<size_t>(source->sampleRate()) * ChunkMs / 1000 * source->channelCount(), 0);
+    fadeBuffer.assign(buffer.size(), 0);
+    mix.assign(buffer.size(), 0.0f);
+    fadeMix.assign(buffer.size(), 0.0f);
+    output->initialize(source->channelCount(), source->sampleRate(), source->channelMap());
+    {
+        lock_guard<mutex> guard(lock);
+        current = std::move(source);
+        pending = nullptr;
+        queued = nullptr;
+        fadingOut = nullptr;
+        requestedAt = requested;
+        measuring = true;
+        trackSamples = 0;
+        samplesPerSecond = current->sampleRate() * current->channelCount();
+        ended = false;
+    }
+    output->play();
+}
+
+void GaplessStream::queueNext(Source source) {
+    lock_guard<mutex> guard(lock);
+    queued = std::move(source);
+}
+
+void GaplessStream::clear() {
+    output->stop();
+    lock_guard<mutex> guard(lock);
+    current = nullptr;
+    pending = nullptr;
+    queued = nullptr;
+    fadingOut = nullptr;
+}
+
+sf::Time GaplessStream::trackOffset() const {
+    uint32_t perSecond = samplesPerSecond.load(memory_order_relaxed);
+    if (perSecond == 0) return sf::Time::Zero;
+    return sf::microseconds(static_cast<int64_t>(trackSamples.load(memory_order_relaxed) * 1000000 / perSecond));
+}
+
+bool GaplessStream::hasSource() const {
+    lock_guard<mutex> guard(lock);
+    return current != nullptr || pending != nullptr;
+}
+
+GaplessStream::LatencyStats GaplessStream::latency() const {
+    LatencyStats stats;
+    stats.switches = switches.load(memory_order_relaxed);
+    stats.lastUs = lastLatencyUs.load(memory_order_relaxed);
+    stats.worstUs = worstLatencyUs.load(memory_order_relaxed);
+    if (stats.switches > 0) {
+        stats.averageUs = totalLatencyUs.load(memory_order_relaxed) / static_cast<int64_t>(stats.switches);
+    }
+    return stats;
+}
+
+void GaplessStream::recordLatency() {
+    int64_t us = chrono::duration_cast<chrono::microseconds>(Clock::now() - requestedAt).count();
+    lastLatencyUs.store(us, memory_order_relaxed);
+    totalLatencyUs.fetch_add(us, memory_order_relaxed);
+    if (us > worstLatencyUs.load(memory_order_relaxed)) worstLatencyUs.store(us, memory_order_relaxed);
+    switches.fetch_add(1, memory_order_relaxed);
+}
+
+float GaplessStream::trackGain(const PcmSource& source) const {
+    return replayGainOn.load(memory_order_relaxed) ? source.replayGain() : 1.0f;
+}
+
+void GaplessStream::beginFade(Source outgoing, uint64_t length) {
+    fadingOut = std::move(outgoing);
+    fadeDone = 0;
+    fadeLength = length;
+}
+
+bool GaplessStream::nextChunk(const int16_t*& samples, size_t& count) {
+    Source source;
+    Source outgoing;
+    bool trackEnded = false;
+    {
+        lock_guard<mutex> guard(lock);
+        uint64_t fadeSamples = static_cast<uint64_t>(max(crossfadeMs.load(memory_order_relaxed), 0)) * samplesPerSecond / 1000;
+        if (pending) {
+            // start() checked the format; with crossfading on, the old track fades out under the new one
+            if (fadeSamples > 0 && current) beginFade(std::move(current), fadeSamples);
+            current = std::move(pending);
+            measuring = true;
+            trackSamples = 0;
+        } else if (fadeSamples > 0 && !fadingOut && current && queued && queued->sameFormat(*current)) {
+            // Bring the queued track in over the current one's last seconds
+            uint64_t left = current->remaining();
+            if (left > 0 && left <= fadeSamples) {
+                beginFade(std::move(current), left);
+                current = std::move(queued);
+                trackSamples = 0;
+                advanced.fetch_add(1);
+                trackEnded = true;
+            }
+        }
+        source = current;
+        outgoing = fadingOut;
+    }
+    if (!source || buffer.empty()) {
+        count = 0;
+        return false;
+    }
+
+    // Decode outside the lock so start()/queueNext() never wait on the codec
+    size_t filled = source->read(buffer.data(), buffer.size());
+    trackSamples.fetch_add(filled, memory_order_relaxed);
+    spans.clear();
+    spans.push_back(GainSpan{ 0, filled, trackGain(*source) });
+    while (filled < buffer.size()) {
+        // Current track ran dry: hand over to the queued one in the same chunk
+        lock_guard<mutex> guard(lock);
+        if (pending) break;
+        trackEnded = true;
+        if (!queued || !queued->sameFormat(*source)) break;
+        current = std::move(queued);
+        source = current;
+        advanced.fetch_add(1);
+
+        size_t got = source->read(buffer.data() + filled, buffer.size() - filled);
+        trackSamples.store(got, memory_order_relaxed);
+        spans.push_back(GainSpan{ filled, got, trackGain(*source) });
+        filled += got;
+    }
+
+    bool shaping = outgoing != nullptr || volume.load(memory_order_relaxed) != 1.0f || appliedVolume != 1.0f;
+    for (const GainSpan& span : spans) shaping = shaping || span.gain != 1.0f;
+    if (shaping && filled > 0) shape(outgoing, filled);
+    if (onSamples && filled > 0) onSamples(buffer.data(), filled, source->channelCount(), source->sampleRate());
+
+    bool more;
+    function<void()> notifyEnd;
+    {
+        lock_guard<mutex> guard(lock);
+        if (measuring && filled > 0) {
+            recordLatency();
+            measuring = false;
+        }
+        // A short chunk is the end of the stream, unless a switch came in meanwhile
+        more = filled == buffer.size() || pending != nullptr;
+        if (trackEnded) notifyEnd = onTrackEnd;
+    }
+
+    if (!more) ended = true;
+    if (notifyEnd) notifyEnd();
+
+    samples = buffer.data();
+    count = filled;
+    return more;
+}
+
+// int16 -> float, per-track gain, crossfade, volume, soft clip -> int16, in place in 'buffer'
+void GaplessStream::shape(const Source& outgoing, size_t filled) {
+    const DspKernels& dsp = Dsp::best();
+    float targetVolume = volume.load(memory_order_relaxed);
+    bool boosted = targetVolume > 1.0f || appliedVolume > 1.0f;
+
+    dsp.toFloat(buffer.data(), mix.data(), filled);
+    for (const GainSpan& span : spans) {
+        if (span.gain != 1.0f) dsp.gainRamp(mix.data() + span.offset, span.count, span.gain, span.gain);
+        boosted = boosted || span.gain > 1.0f;
+    }
+
+    if (outgoing) {
+        // Zero-padded if the outgoing track runs out first
+        size_t got = outgoing->read(fadeBuffer.data(), filled);
+        fill(fadeBuffer.begin() + static_cast<ptrdiff_t>(got), fadeBuffer.begin() + static_cast<ptrdiff_t>(filled), int16_t(0));
+        dsp.toFloat(fadeBuffer.data(), fadeMix.data(), filled);
+
+        size_t span = static_cast<size_t>(min<uint64_t>(filled, fadeLength - fadeDone));
+        float outFrom, inFrom, outTo, inTo;
+        Dsp::equalPowerGains(static_cast<double>(fadeDone) / static_cast<double>(fadeLength), outFrom, inFrom);
+        Dsp::equalPowerGains(static_cast<double>(fadeDone + span) / static_cast<double>(fadeLength), outTo, inTo);
+        float outGain = trackGain(*outgoing);
+        dsp.crossfade(fadeMix.data(), mix.data(), mix.data(), span, outFrom * outGain, outTo * outGain, inFrom, inTo);
+        fadeDone += span;
+        boosted = true; // Two tracks at once can add up past full scale
+
+        if (fadeDone >= fadeLength) {
+            lock_guard<mutex> guard(lock);
+            if (fadingOut == outgoing) fadingOut = nullptr;
+        }
+    }
+
+    if (targetVolume != 1.0f || appliedVolume != 1.0f) dsp.gainRamp(mix.data(), filled, appliedVolume, targetVolume);
+    appliedVolume = targetVolume;
+
+    if (boosted) dsp.softClip(mix.data(), filled);
+    dsp.toInt16(mix.data(), buffer.data(), filled);
+}
+
+void GaplessStream::seekTo(chrono::microseconds offset) {
+    Source source;
+    {
+        lock_guard<mutex> guard(lock);
+        source = current;
+        fadingOut = nullptr;
+    }
+    if (!source) return;
+    source->seek(sf::microseconds(offset.count()));
+    trackSamples = static_cast<uint64_t>(max<int64_t>(offset.count(), 0)) * samplesPerSecond / 1000000;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <SFML/Audio.hpp>
+#include "AudioOutput.h"
+#include "PcmSource.h"
+
+// A sound stream whose source can be swapped while it plays.
+// A track change only swaps a pointer: the audio thread picks the new source
+// up on its next chunk, so the device is never stopped and reopened (unless
+// the new track has a different rate or channel layout). A queued source takes
+// over the instant the current one runs dry, in the middle of a chunk if need
+// be, which gives sample-accurate gapless playback between tracks.
+// Where the samples go is up to the AudioOutput: the sound card, or nowhere.
+//
+// On the way out, chunks can pass through a DSP stage (Dsp.h kernels):
+// ReplayGain, volume, an equal-power crossfade between tracks and soft
+// clipping. With all of it off, samples go out untouched, with no float
+// conversion.
+class GaplessStream : public AudioFeed {
+public:
+    using Source = std::shared_ptr<PcmSource>;
+    using Clock = std::chrono::steady_clock;
+    using SampleTap = std::function<void(const std::int16_t* samples, std::size_t count, unsigned channels,
+                                         unsigned sampleRate)>;
+
+    // Time from a track change being requested to its first samples being
+    // handed to the audio device (microseconds)
+    struct LatencyStats {
+        std::int64_t lastUs = 0;
+        std::int64_t averageUs = 0;
+        std::int64_t worstUs = 0;
+        std::uint64_t switches = 0;
+    };
+
+    explicit GaplessStream(std::unique_ptr<AudioOutput> output);
+    ~GaplessStream() override;
+
+    GaplessStream(const GaplessStream&) = delete;
+    GaplessStream& operator=(const GaplessStream&) = delete;
+
+    // Make 'source' the playing track. 'requested' is when the user asked
+    // for it, which is where the latency measurement starts.
+    void start(Source source, Clock::time_point requested = Clock::now());
+
+    // Play 'source' right after the current track ends (nullptr cancels)
+    void queueNext(Source source);
+
+    // Stop and let go of every source
+    void clear();
+
+    bool hasSource() const;
+
+    void play() { output->play(); }
+    void pause() { output->pause(); }
+    AudioOutput::Status status() const { return output->status(); }
+    const AudioOutput& device() const { return *output; }
+
+    // Linear volume; changes ramp over one chunk so they don't click
+    void setVolume(float linear) { volume.store(linear, std::memory_order_relaxed); }
+    float getVolume() const { return volume.load(std::memory_order_relaxed); }
+
+    // Scale each track by its ReplayGain (PcmSource::replayGain())
+    void setReplayGain(bool enabled) { replayGainOn.store(enabled, std::memory_order_relaxed); }
+    bool replayGainEnabled() const { return replayGainOn.load(std::memory_order_relaxed); }
+
+    // Overlap consecutive tracks by 'length' with an equal-power fade, both
+    // when one runs into the queued next and on a start() (0 = gapless cut)
+    void setCrossfade(std::chrono::milliseconds length) { crossfadeMs.store(static_cast<std::int32_t>(length.count()), std::memory_order_relaxed); }
+    std::chrono::milliseconds crossfade() const { return std::chrono::milliseconds(crossfadeMs.load(std::memory_order_relaxed)); }
+
+    // Called on the audio thread whenever a track ends, whether the queued
+    // one took over or the stream ran dry. Set it before the first start().
+    void setTrackEndCallback(std::function<void()> callback) { onTrackEnd = std::move(callback); }
+
+    // Called on the audio thread with every chunk on its way to the output,
+    // after the DSP stage. Must not block. Set it before the first start().
+    void setSampleTap(SampleTap tap) { onSamples = std::move(tap); }
+
+    // Number of times a queued track took over since the last call
+    int takeAdvanced() { return advanced.exchange(0); }
+
+    // True once after the stream stopped because a track ended with nothing queued
+    bool takeEnded() { return ended.exchange(false); }
+
+    // How far into the current track the audio thread has got
+    sf::Time trackOffset() const;
+
+    LatencyStats latency() const;
+
+    // AudioFeed, called on the output's thread
+    bool nextChunk(const std::int16_t*& samples, std::size_t& count) override;
+    void seekTo(std::chrono::microseconds offset) override;
+
+private:
+    static constexpr unsigned ChunkMs = 20;
+
+    std::unique_ptr<AudioOutput> output;
+
+    mutable std::mutex lock; // Guards the source pointers and the latency bookkeeping
+    Source current;
+    Source pending;          // Set by start(), adopted by the audio thread
+    Source queued;
+    Clock::time_point requestedAt;
+    bool measuring = false;  // The next chunk with samples completes a switch
+
+    std::vector<std::int16_t> buffer;
+    std::atomic<int> advanced{ 0 };
+
+    // DSP stage. The buffers are sized with 'buffer', off the audio thread.
+    struct GainSpan {
+        std::size_t offset;
+        std::size_t count;
+        float gain;
+    };
+    std::atomic<float> volume{ 1.0f };
+    std::atomic<bool> replayGainOn{ false };
+    std::atomic<std::int32_t> crossfadeMs{ 0 };
+    Source fadingOut;              // Guarded by 'lock': the track being faded out under the current one
+    std::uint64_t fadeDone = 0;    // Audio thread: samples of the fade mixed so far
+    std::uint64_t fadeLength = 0;
+    float appliedVolume = 1.0f;    // Audio thread: where the last volume ramp ended
+    std::vector<GainSpan> spans;   // Audio thread: which source filled which part of the chunk
+    std::vector<std::int16_t> fadeBuffer;
+    std::vector<float> mix;
+    std::vector<float> fadeMix;
+    std::atomic<bool> ended{ false };
+    std::function<void()> onTrackEnd;
+    SampleTap onSamples;
+
+    // Samples handed over from the current source, and its format
+    std::atomic<std::uint64_t> trackSamples{ 0 };
+    std::atomic<std::uint32_t> samplesPerSecond{ 0 };
+
+    std::atomic<std::int64_t> lastLatencyUs{ 0 };
+    std::atomic<std::int64_t> totalLatencyUs{ 0 };
+    std::atomic<std::int64_t> worstLatencyUs{ 0 };
+    std::atomic<std::uint64_t> switches{ 0 };
+
+    void recordLatency();
+    float trackGain(const PcmSource& source) const;
+    void beginFade(Source outgoing, std::uint64_t length); // Caller holds 'lock'
+    void shape(const Source& outgoing, std::size_t filled);
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map from int keys to small values (e.g. node pointers).
+// Linear probing over a power-of-two table and backward-shift deletion, so
+// there are no tombstones to clean up.
+// Key 0 is reserved as the "empty slot" marker (track IDs start at 1).
+template <typename V>
+class HashIndex {
+private:
+    struct Slot {
+        int key;
+        V value;
+    };
+
+    static constexpr int EmptyKey = 0;
+
+    std::vector<Slot> slots;
+    std::size_t count;
+    std::size_t mask;
+    std::size_t maxProbe; // Furthest any key sits from its home slot
+
+    std::size_t home(int key) const {
+        // Track IDs are handed out by a counter, so they are dense: the low bits
+        // alone spread them perfectly and consecutive IDs land in consecutive
+        // slots (bulk loads walk the table sequentially instead of at random).
+        return static_cast<std::size_t>(static_cast<std::uint32_t>(key)) & mask;
+    }
+
+    void rehash(std::size_t newCapacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+
+        slots.assign(newCapacity, Slot{ EmptyKey, V() });
+        mask = newCapacity - 1;
+        count = 0;
+        maxProbe = 0;
+
+        for (const Slot& s : old) {
+            if (s.key != EmptyKey) insert(s.key, s.value);
+        }
+    }
+
+public:
+    HashIndex() : count(0), mask(0), maxProbe(0) {
+        rehash(16);
+    }
+
+    // Grow up front so 'n' keys fit without rehashing
+    void reserve(std::size_t n) {
+        std::size_t needed = 16;
+        while (needed * 7 < n * 10) needed <<= 1; // keep load factor under 0.7
+        if (needed > slots.size()) rehash(needed);
+    }
+
+    // Inserts or overwrites
+    void insert(int key, V value) {
+        if ((count + 1) * 10 > slots.size() * 7) {
+            rehash(slots.size() * 2);
+        }
+
+        std::size_t i = home(key);
+        while (slots[i].key != EmptyKey) {
+            if (slots[i].key == key) {
+                slots[i].value = value;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i].key = key;
+        slots[i].value = value;
+        count++;
+        std::size_t probe = (i - home(key)) & mask;
+        if (probe > maxProbe) maxProbe = probe;
+    }
+
+    // Returns nullptr if the key is missing
+    V* find(int key) {
+        if (key == EmptyKey) return nullptr;
+        std::size_t i = home(key);
+        while (slots[i].key != EmptyKey) {
+            if (slots[i].key == key) return &slots[i].value;
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    const V* find(int key) const {
+        return const_cast<HashIndex*>(this)->find(key);
+    }
+
+    bool erase(int key) {
+        if (key == EmptyKey) return false;
+        std::size_t i = home(key);
+        while (slots[i].key != key) {
+            if (slots[i].key == EmptyKey) return false;
+            i = (i + 1) & mask;
+        }
+
+        // Backward-shift: pull later members of the probe run into the hole.
+        // Dense IDs make one long run, but only a key displaced by at least
+        // (j - hole) can move, so the scan stops once that exceeds maxProbe.
+        std::size_t hole = i;
+        std::size_t j = (i + 1) & mask;
+        while (slots[j].key != EmptyKey && ((j - hole) & mask) <= maxProbe) {
+            std::size_t want = home(slots[j].key);
+            // Move slots[j] back if its home is not in the range (hole, j]
+            if (((j - want) & mask) >= ((j - hole) & mask)) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+            j = (j + 1) & mask;
+        }
+        slots[hole].key = EmptyKey;
+        slots[hole].value = V();
+        count--;
+        return true;
+    }
+
+    void clear() {
+        for (Slot& s : slots) {
+            s.key = EmptyKey;
+            s.value = V();
+        }
+        count = 0;
+        maxProbe = 0;
+    }
+
+    std::size_t size() const { return count; }
+};
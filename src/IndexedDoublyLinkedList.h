@@ -0,0 +1,561 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "DoublyLinkedList.h"
+
+// A list node that also sits in an implicit treap (an order-statistic tree
+// keyed by list position). The list links (next/prev) are untouched, so code
+// holding node<T>* keeps working and stepping stays O(1).
+template <typename T>
+struct ranked_node : node<T> {
+    ranked_node<T>* left;
+    ranked_node<T>* right;
+    ranked_node<T>* parent;
+    std::uint32_t priority;
+    int size; // Nodes in this subtree, including itself
+
+    template <typename... Args>
+    explicit ranked_node(std::in_place_t, Args&&... args)
+        : node<T>(std::in_place, std::forward<Args>(args)...),
+          left(nullptr), right(nullptr), parent(nullptr), priority(0), size(1) {}
+};
+
+// Same public API as DoublyLinkedList<T>, plus positional queries, but every
+// position-based operation is O(log n) expected instead of a walk from head:
+//     nodeAt(pos), positionOf(node), insertAtAnyPos, deleteAtAnyPos, erase ...
+// next/prev stepping and head/tail access are still O(1).
+template <typename T, template <typename> class Allocator = NodePool>
+class IndexedDoublyLinkedList {
+public:
+    using NodeAllocator = Allocator<ranked_node<T>>;
+
+private:
+    using rnode = ranked_node<T>;
+
+    node<T>* head;
+    node<T>* tail;
+    rnode* root;
+    int listSize;
+    std::uint32_t seed;
+    NodeAllocator alloc;
+
+    static rnode* ranked(node<T>* n) { return static_cast<rnode*>(n); }
+    static int sizeOf(const rnode* t) { return t ? t->size : 0; }
+
+    static void update(rnode* t) {
+        t->size = sizeOf(t->left) + sizeOf(t->right) + 1;
+    }
+
+    std::uint32_t nextPriority() {
+        // xorshift32: cheap and good enough to keep the treap balanced
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    // Split t into l = first k nodes, r = the rest
+    static void split(rnode* t, int k, rnode*& l, rnode*& r) {
+        if (t == nullptr) {
+            l = r = nullptr;
+            return;
+        }
+        if (sizeOf(t->left) < k) {
+            split(t->right, k - sizeOf(t->left) - 1, t->right, r);
+            if (t->right) t->right->parent = t;
+            l = t;
+        } else {
+            split(t->left, k, l, t->left);
+            if (t->left) t->left->parent = t;
+            r = t;
+        }
+        update(t);
+    }
+
+    // Concatenate: every node of a comes before every node of b
+    static rnode* merge(rnode* a, rnode* b) {
+        if (a == nullptr) return b;
+        if (b == nullptr) return a;
+        if (a->priority > b->priority) {
+            a->right = merge(a->right, b);
+            a->right->parent = a;
+            update(a);
+            return a;
+        }
+        b->left = merge(a, b->left);
+        b->left->parent = b;
+        update(b);
+        return b;
+    }
+
+    void setRoot(rnode* t) {
+        root = t;
+        if (root) root->parent = nullptr;
+    }
+
+    // Put a fresh (or detached) node into the tree so that it ends up at 'position'
+    void treeInsertAt(int position, rnode* n) {
+        n->left = n->right = n->parent = nullptr;
+        n->size = 1;
+        n->priority = nextPriority();
+
+        rnode* l;
+        rnode* r;
+        split(root, position - 1, l, r);
+        setRoot(merge(merge(l, n), r));
+    }
+
+    void treeRemove(rnode* n) {
+        rnode* joined = merge(n->left, n->right);
+        rnode* p = n->parent;
+        if (joined) joined->parent = p;
+
+        if (p == nullptr) {
+            root = joined;
+        } else {
+            if (p->left == n) p->left = joined;
+            else p->right = joined;
+            for (rnode* up = p; up != nullptr; up = up->parent) {
+                update(up);
+            }
+        }
+        n->left = n->right = n->parent = nullptr;
+        n->size = 1;
+    }
+
+    // Link n into the list in front of 'position' (nullptr = after the tail)
+    void listLinkBefore(node<T>* position, node<T>* n) {
+        if (position == nullptr) {
+            n->prev = tail;
+            n->next = nullptr;
+            if (tail) tail->next = n;
+            else head = n;
+            tail = n;
+        } else {
+            n->next = position;
+            n->prev = position->prev;
+            if (position->prev) position->prev->next = n;
+            else head = n;
+            position->prev = n;
+        }
+        listSize++;
+    }
+
+    void listUnlink(node<T>* n) {
+        if (n->prev) n->prev->next = n->next;
+        else head = n->next;
+        if (n->next) n->next->prev = n->prev;
+        else tail = n->prev;
+        n->next = n->prev = nullptr;
+        listSize--;
+    }
+
+    // Chain first..last ('count' nodes, already linked to each other) in front
+    // of 'position' (nullptr = at the end); list links only
+    void listLinkChainBefore(node<T>* position, node<T>* first, node<T>* last, int count) {
+        node<T>* before = (position == nullptr) ? tail : position->prev;
+        first->prev = before;
+        last->next = position;
+        if (before) before->next = first;
+        else head = first;
+        if (position) position->prev = last;
+        else tail = last;
+        listSize += count;
+    }
+
+    void listUnlinkChain(node<T>* first, node<T>* last, int count) {
+        if (first->prev) first->prev->next = last->next;
+        else head = last->next;
+        if (last->next) last->next->prev = first->prev;
+        else tail = first->prev;
+        listSize -= count;
+    }
+
+    // Put a whole subtree in at 0-based tree offset 'at'
+    void treeInsertTree(int at, rnode* t) {
+        rnode* l;
+        rnode* r;
+        split(root, at, l, r);
+        setRoot(merge(merge(l, t), r));
+    }
+
+    // Shared by every insert: 1-based position, already validated
+    node<T>* linkAt(int position, rnode* n) {
+        node<T>* before = (position == listSize + 1) ? nullptr : nodeAt(position);
+        treeInsertAt(position, n);
+        listLinkBefore(before, n);
+        return n;
+    }
+
+    // Builds a treap from nodes fed in list order, using the priorities they
+    // already carry. Classic O(n) Cartesian-tree build on the right spine; a
+    // node's subtree is final the moment it leaves the spine, so sizes are
+    // filled in on the way and no second pass is needed.
+    class TreeBuilder {
+    private:
+        std::vector<rnode*> spine;
+
+        static void finish(rnode* t) {
+            t->size = sizeOf(t->left) + sizeOf(t->right) + 1;
+        }
+
+    public:
+        void add(rnode* x) {
+            rnode* last = nullptr;
+            while (!spine.empty() && spine.back()->priority < x->priority) {
+                last = spine.back();
+                spine.pop_back();
+                finish(last);
+            }
+            x->left = last;
+            x->right = nullptr;
+            if (last) last->parent = x;
+            if (!spine.empty()) {
+                spine.back()->right = x;
+                x->parent = spine.back();
+            } else {
+                x->parent = nullptr;
+            }
+            spine.push_back(x);
+        }
+
+        rnode* build() {
+            if (spine.empty()) return nullptr;
+            for (std::size_t i = spine.size(); i-- > 0;) {
+                finish(spine[i]);
+            }
+            rnode* top = spine.front();
+            spine.clear();
+            return top;
+        }
+    };
+
+public:
+    explicit IndexedDoublyLinkedList(const NodeAllocator& allocator = NodeAllocator())
+        : head(nullptr), tail(nullptr), root(nullptr), listSize(0), seed(2463534242u), alloc(allocator) {}
+
+    IndexedDoublyLinkedList(const IndexedDoublyLinkedList&) = delete;
+    IndexedDoublyLinkedList& operator=(const IndexedDoublyLinkedList&) = delete;
+
+    ~IndexedDoublyLinkedList() {
+        freeMemory();
+    }
+
+    node<T>* getHead() const { return head; }
+    node<T>* getTail() const { return tail; }
+    NodeAllocator getAllocator() const { return alloc; }
+
+    void reserve(int count) {
+        if (count > 0) alloc.reserve(static_cast<std::size_t>(count));
+    }
+
+    // --- Positional queries: O(log n) ---
+
+    // 1-based; nullptr if out of range
+    node<T>* nodeAt(int position) const {
+        if (position <= 0 || position > listSize) return nullptr;
+        if (position == 1) return head;
+        if (position == listSize) return tail;
+
+        rnode* t = root;
+        int k = position;
+        while (t != nullptr) {
+            int leftSize = sizeOf(t->left);
+            if (k <= leftSize) {
+                t = t->left;
+            } else if (k == leftSize + 1) {
+                return t;
+            } else {
+                k -= leftSize + 1;
+                t = t->right;
+            }
+        }
+        return nullptr;
+    }
+
+    // 1-based position of a node in this list (0 for nullptr)
+    int positionOf(const node<T>* target) const {
+        if (target == nullptr) return 0;
+        const rnode* t = static_cast<const rnode*>(target);
+        int position = sizeOf(t->left) + 1;
+        while (t->parent != nullptr) {
+            if (t->parent->right == t) {
+                position += sizeOf(t->parent->left) + 1;
+            }
+            t = t->parent;
+        }
+        return position;
+    }
+
+    // --- Emplace ---
+
+    template <typename... Args>
+    node<T>* emplaceAtBeginning(Args&&... args) {
+        return linkAt(1, alloc.create(std::in_place, std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    node<T>* emplaceAtEnd(Args&&... args) {
+        return linkAt(listSize + 1, alloc.create(std::in_place, std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    node<T>* emplaceAt(int position, Args&&... args) {
+        if (position <= 0 || position > listSize + 1) {
+            std::cout << "Invalid position!\n";
+            return nullptr;
+        }
+        return linkAt(position, alloc.create(std::in_place, std::forward<Args>(args)...));
+    }
+
+    // --- Insert ---
+
+    void insertAtBeginning(const T& val) { emplaceAtBeginning(val); }
+    void insertAtBeginning(T&& val) { emplaceAtBeginning(std::move(val)); }
+
+    void insertAtEnd(const T& val) { emplaceAtEnd(val); }
+    void insertAtEnd(T&& val) { emplaceAtEnd(std::move(val)); }
+
+    void insertAtAnyPos(int position, const T& val) { emplaceAt(position, val); }
+    void insertAtAnyPos(int position, T&& val) { emplaceAt(position, std::move(val)); }
+
+    // --- Delete ---
+
+    void deleteFromStart() {
+        if (isEmpty()) return;
+        erase(head);
+    }
+
+    void deleteFromEnd() {
+        if (isEmpty()) return;
+        erase(tail);
+    }
+
+    void deleteAtAnyPos(int position) {
+        if (isEmpty()) {
+            std::cout << "List is empty!\n";
+            return;
+        }
+
+        if (position <= 0 || position > listSize) {
+            std::cout << "Invalid position!\n";
+            return;
+        }
+
+        erase(nodeAt(position));
+    }
+
+    // --- Node handles: O(log n) because the tree has to be fixed up too ---
+
+    node<T>* unlink(node<T>* target) {
+        if (target == nullptr) return nullptr;
+        treeRemove(ranked(target));
+        listUnlink(target);
+        return target;
+    }
+
+    void insertNodeBefore(node<T>* position, node<T>* detached) {
+        if (detached == nullptr) return;
+        int at = (position == nullptr) ? listSize + 1 : positionOf(position);
+        treeInsertAt(at, ranked(detached));
+        listLinkBefore(position, detached);
+    }
+
+    node<T>* erase(node<T>* target) {
+        if (target == nullptr) return nullptr;
+        node<T>* following = target->next;
+        unlink(target);
+        alloc.destroy(ranked(target));
+        return following;
+    }
+
+    // Append 'count' elements, make(i) returning each T. The new nodes get their
+    // own tree built in O(count) which is then merged on: no per-node descent.
+    template <typename Make>
+    void appendBulk(int count, Make&& make) {
+        if (count <= 0) return;
+        reserve(count);
+
+        TreeBuilder builder;
+        for (int i = 0; i < count; i++) {
+            rnode* n = alloc.create(std::in_place, make(i));
+            n->priority = nextPriority();
+            listLinkBefore(nullptr, n);
+            builder.add(n);
+        }
+        setRoot(merge(root, builder.build()));
+    }
+
+    // --- Bulk operations ---
+    // Same API as DoublyLinkedList. The list links change in O(1) as there,
+    // but the tree has to be cut and joined too, so a splice is O(log n).
+
+    // Move the run first..last ('count' nodes) out of 'other' in front of
+    // 'position' (nullptr = at the end). O(log n) expected whatever the count.
+    // 'other' may be this list if 'position' is outside the run. The lists
+    // must share an allocator; returns false and does nothing otherwise.
+    bool splice(node<T>* position, IndexedDoublyLinkedList& other, node<T>* first, node<T>* last, int count) {
+        if (first == nullptr || last == nullptr || count <= 0 || alloc != other.alloc) return false;
+
+        // other's tree = [before the run][the run][after it]
+        rnode* before;
+        rnode* run;
+        rnode* after;
+        split(other.root, other.positionOf(first) - 1, before, run);
+        split(run, count, run, after);
+        other.setRoot(merge(before, after));
+        other.listUnlinkChain(first, last, count);
+
+        treeInsertTree(position == nullptr ? listSize : positionOf(position) - 1, run);
+        listLinkChainBefore(position, first, last, count);
+        return true;
+    }
+
+    bool splice(node<T>* position, IndexedDoublyLinkedList& other) {
+        if (&other == this) return false;
+        if (other.isEmpty()) return true;
+        return splice(position, other, other.head, other.tail, other.listSize);
+    }
+
+    // Everything from 'other' onto the end: O(log n) with a shared allocator,
+    // one move per element without
+    void append(IndexedDoublyLinkedList&& other) {
+        if (&other == this || other.isEmpty()) return;
+        if (splice(nullptr, other)) return;
+
+        node<T>* temp = other.head;
+        appendBulk(other.listSize, [&](int) {
+            T& data = temp->data;
+            temp = temp->next;
+            return std::move(data);
+        });
+        other.freeMemory();
+    }
+
+    // Insert copies of [first, last) in front of 'position' (nullptr = at the
+    // end). The new nodes get a tree of their own in O(k), which is spliced in
+    // with one split and two merges. Returns the first new node, or nullptr.
+    template <typename InputIt>
+    node<T>* insertRange(node<T>* position, InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            reserve(static_cast<int>(std::distance(first, last)));
+        }
+
+        TreeBuilder builder;
+        node<T>* chainHead = nullptr;
+        node<T>* chainTail = nullptr;
+        int count = 0;
+        try {
+            for (; first != last; ++first) {
+                rnode* n = alloc.create(std::in_place, *first);
+                n->priority = nextPriority();
+                n->prev = chainTail;
+                if (chainTail) chainTail->next = n;
+                else chainHead = n;
+                chainTail = n;
+                builder.add(n);
+                count++;
+            }
+        } catch (...) {
+            while (chainHead != nullptr) {
+                node<T>* temp = chainHead;
+                chainHead = chainHead->next;
+                alloc.destroy(ranked(temp));
+            }
+            throw;
+        }
+
+        if (chainHead == nullptr) return nullptr;
+        treeInsertTree(position == nullptr ? listSize : positionOf(position) - 1, builder.build());
+        listLinkChainBefore(position, chainHead, chainTail, count);
+        return chainHead;
+    }
+
+    // Erase every element for which pred(data) is true, in one pass over the
+    // list. The first few go through the tree one by one (O(log n) each); past
+    // a thirty-second of the list, the tree is left alone and rebuilt once at
+    // the end in O(n), which beats fixing it up per node.
+    template <typename Pred>
+    int removeIf(Pred&& pred) {
+        const int fixUpLimit = listSize / 32;
+        int removed = 0;
+        bool rebuild = false;
+        node<T>* temp = head;
+        while (temp != nullptr) {
+            node<T>* following = temp->next;
+            if (pred(temp->data)) {
+                if (removed >= fixUpLimit) rebuild = true;
+                if (rebuild) listUnlink(temp);
+                else unlink(temp);
+                alloc.destroy(ranked(temp));
+                removed++;
+            }
+            temp = following;
+        }
+        if (rebuild) rebuildIndex();
+        return removed;
+    }
+
+    // Stable sorts, as in DoublyLinkedList: the nodes are relinked, then the
+    // tree is rebuilt from the new order in O(n). O(n log n) overall.
+    template <typename Less>
+    void sort(Less less, unsigned threads = 1) {
+        if (listSize < 2) return;
+        ListSort::Chain<T> sorted = ListSort::sort(head, listSize, less, threads);
+        head = sorted.first;
+        tail = sorted.last;
+        rebuildIndex();
+    }
+
+    template <typename KeyOf, typename Less>
+    void sortByKey(KeyOf keyOf, Less less, unsigned threads = 1) {
+        if (listSize < 2) return;
+        ListSort::Chain<T> sorted = ListSort::sortByKey(head, listSize, keyOf, less, threads);
+        head = sorted.first;
+        tail = sorted.last;
+        rebuildIndex();
+    }
+
+    // Rebuild the whole tree from the list order in O(n).
+    // Useful after relinking many nodes by hand.
+    void rebuildIndex() {
+        TreeBuilder builder;
+        for (node<T>* temp = head; temp != nullptr; temp = temp->next) {
+            builder.add(ranked(temp));
+        }
+        setRoot(builder.build());
+    }
+
+    int nodeCount() const {
+        return listSize;
+    }
+
+    bool isEmpty() const {
+        return (head == nullptr);
+    }
+
+    void traverseForward() const {
+        node<T>* temp = head;
+        while (temp != nullptr) {
+            std::cout << temp->data << "\n";
+            temp = temp->next;
+        }
+    }
+
+    void freeMemory() {
+        node<T>* temp;
+        while (head != nullptr) {
+            temp = head;
+            head = head->next;
+            alloc.destroy(ranked(temp));
+        }
+        tail = nullptr;
+        root = nullptr;
+        listSize = 0;
+    }
+};
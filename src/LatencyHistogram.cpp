@@ -0,0 +1,119 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+    const size_t SubBuckets = size_t(1) << LatencyHistogram::SubBucketBits;
+
+    LatencyHistogram probes[static_cast<size_t>(Probe::Count)];
+
+    const char* const ProbeNames[static_cast<size_t>(Probe::Count)] = {
+        "key_to_frame", "input", "track_switch", "file_open", "render", "playlist_edit"
+    };
+
+    void setError(string* error, const string& message) {
+        if (error) *error = message;
+    }
+}
+
+//----------------------------------------------------
+size_t LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < 2 * SubBuckets) return static_cast<size_t>(ns);
+    int msb = bit_width(ns) - 1;
+    if (msb >= MaxBits) return BucketCount - 1;
+    int shift = msb - SubBucketBits;
+    return static_cast<size_t>(shift) * SubBuckets + static_cast<size_t>(ns >> shift);
+}
+
+uint64_t LatencyHistogram::bucketLow(size_t i) {
+    if (i < 2 * SubBuckets) return i;
+    size_t shift = i / SubBuckets - 1;
+    return static_cast<uint64_t>(i % SubBuckets + SubBuckets) << shift;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(clamp(fraction, 0.0, 1.0) * static_cast<double>(n))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; i++) {
+        seen += bucketSamples(i);
+        if (seen >= rank) return min(bucketHigh(i) - 1, maxNs());
+    }
+    return maxNs(); // Samples recorded while we walked
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Summary s;
+    s.count = count();
+    s.maxNs = maxNs();
+    if (s.count == 0) return s;
+    s.meanNs = static_cast<double>(total.load(memory_order_relaxed)) / static_cast<double>(s.count);
+
+    const double fractions[3] = { 0.50, 0.90, 0.99 };
+    uint64_t* targets[3] = { &s.p50Ns, &s.p90Ns, &s.p99Ns };
+    int next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount && next < 3; i++) {
+        seen += bucketSamples(i);
+        while (next < 3 && static_cast<double>(seen) >= fractions[next] * static_cast<double>(s.count)) {
+            *targets[next++] = min(bucketHigh(i) - 1, s.maxNs);
+        }
+    }
+    while (next < 3) *targets[next++] = s.maxNs;
+    return s;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets) b.store(0, memory_order_relaxed);
+    samples.store(0, memory_order_relaxed);
+    total.store(0, memory_order_relaxed);
+    largest.store(0, memory_order_relaxed);
+}
+
+//----------------------------------------------------
+LatencyHistogram& Latency::of(Probe probe) {
+    return probes[static_cast<size_t>(probe)];
+}
+
+const char* Latency::name(Probe probe) {
+    return ProbeNames[static_cast<size_t>(probe)];
+}
+
+bool Latency::dump(const string& path, string* error) {
+    ofstream out(path, ios::trunc);
+    if (!out) {
+        setError(error, "Cannot write " + path);
+        return false;
+    }
+
+    out << "probe,count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n";
+    for (size_t p = 0; p < static_cast<size_t>(Probe::Count); p++) {
+        LatencyHistogram::Summary s = probes[p].summary();
+        if (s.count == 0) continue;
+        out << ProbeNames[p] << "," << s.count << "," << fixed << setprecision(0) << s.meanNs << ","
+            << s.p50Ns << "," << s.p90Ns << "," << s.p99Ns << "," << s.maxNs << "\n";
+    }
+
+    out << "\nprobe,low_ns,high_ns,samples\n";
+    for (size_t p = 0; p < static_cast<size_t>(Probe::Count); p++) {
+        for (size_t i = 0; i < LatencyHistogram::BucketCount; i++) {
+            uint64_t samples = probes[p].bucketSamples(i);
+            if (samples == 0) continue;
+            out << ProbeNames[p] << "," << LatencyHistogram::bucketLow(i) << ","
+                << LatencyHistogram::bucketHigh(i) << "," << samples << "\n";
+        }
+    }
+
+    if (!out) {
+        setError(error, "Cannot write " + path);
+        return false;
+    }
+    return true;
+}
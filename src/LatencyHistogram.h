@@ -0,0 +1,110 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Log-linear histogram of durations in nanoseconds, in the style of HdrHistogram.
+//
+// Values below 64 ns get a bucket each. Above that, every power of two is cut
+// into 32 equal buckets, so a reported value is within ~3% of the real one
+// at any scale up to 2^40 ns (~18 minutes); longer samples land in the last
+// bucket. Recording is a handful of relaxed atomic adds: any thread may
+// record while another reads, with no lock and no allocation.
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int MaxBits = 40;
+    static constexpr std::size_t BucketCount = (MaxBits - SubBucketBits) * (std::size_t(1) << SubBucketBits)
+                                               + (std::size_t(1) << SubBucketBits);
+
+    struct Summary {
+        std::uint64_t count = 0;
+        double meanNs = 0.0;
+        std::uint64_t p50Ns = 0;
+        std::uint64_t p90Ns = 0;
+        std::uint64_t p99Ns = 0;
+        std::uint64_t maxNs = 0;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::uint64_t ns) {
+        buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t seen = largest.load(std::memory_order_relaxed);
+        while (ns > seen && !largest.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(static_cast<std::uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    std::uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    std::uint64_t maxNs() const { return largest.load(std::memory_order_relaxed); }
+
+    // Upper end of the bucket holding the sample at 'fraction' (0..1) of the
+    // way through, capped at the max: the value that many samples are at or
+    // below. 0 when empty. O(BucketCount).
+    std::uint64_t percentile(double fraction) const;
+
+    // count, mean, p50/p90/p99 and max from one pass over the buckets
+    Summary summary() const;
+
+    // Samples in bucket 'i', and the range of values it holds: [low, high)
+    std::uint64_t bucketSamples(std::size_t i) const { return buckets[i].load(std::memory_order_relaxed); }
+    static std::uint64_t bucketLow(std::size_t i);
+    static std::uint64_t bucketHigh(std::size_t i) { return bucketLow(i + 1); }
+
+    static std::size_t bucketOf(std::uint64_t ns);
+
+    void reset();
+
+private:
+    std::array<std::atomic<std::uint64_t>, BucketCount> buckets{};
+    std::atomic<std::uint64_t> samples{ 0 };
+    std::atomic<std::uint64_t> total{ 0 };
+    std::atomic<std::uint64_t> largest{ 0 };
+};
+
+// The places the player measures. Each has one process-wide histogram.
+enum class Probe {
+    KeyToFrame,   // Key press until the frame that shows its effect is on screen
+    Input,        // Key press until its handler returned
+    TrackSwitch,  // playAudio(): stop the old track, open (or take the prefetched) new one, play
+    FileOpen,     // PcmSource::open, on whichever thread did it
+    Render,       // drawDashboard(), present() included
+    PlaylistEdit, // Adds, removes, moves and sorts on the Playlist
+    Count
+};
+
+class Latency {
+public:
+    static LatencyHistogram& of(Probe probe);
+    static const char* name(Probe probe);
+
+    // CSV for offline analysis: one summary row per probe, then every
+    // non-empty bucket (probe,low_ns,high_ns,samples) so any percentile can
+    // be recomputed. Probes with no samples are left out.
+    static bool dump(const std::string& path, std::string* error = nullptr);
+};
+
+// Records the time from construction to destruction into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Probe probe) : histogram(Latency::of(probe)), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram.record(std::chrono::steady_clock::now() - start); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
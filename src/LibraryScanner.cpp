@@ -0,0 +1,240 @@
+#include "LibraryScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include "TagReader.h"
+#include "ThreadPool.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    const size_t FilesPerTask = 32;
+
+    struct ScanState {
+        ThreadPool& pool;
+        vector<vector<Track>> buckets; // One per worker (+1 for the calling thread)
+        atomic<size_t> filesSeen{ 0 };
+        atomic<size_t> failed{ 0 };
+
+        mutex visitedLock;
+        unordered_set<string> visited; // Real (canonical) paths of the folders walked so far
+        FolderTimes folders;           // Under visitedLock too
+
+        explicit ScanState(ThreadPool& p) : pool(p), buckets(p.size() + 1) {}
+
+        vector<Track>& myBucket() {
+            int worker = ThreadPool::currentWorker();
+            return buckets[worker < 0 ? pool.size() : static_cast<size_t>(worker)];
+        }
+
+        // False if this folder was already walked, under this name or another. Symlinked
+        // folders are followed, so a link back up the tree would otherwise never end.
+        bool firstVisit(const fs::path& directory) {
+            error_code ec;
+            fs::path real = fs::canonical(directory, ec);
+            if (ec) return false;
+            lock_guard<mutex> guard(visitedLock);
+            return visited.insert(real.generic_string()).second;
+        }
+
+        void stamp(const string& folder, int64_t modified) {
+            lock_guard<mutex> guard(visitedLock);
+            folders[folder] = modified;
+        }
+    };
+
+    // The key a folder goes by in FolderTimes
+    string folderKey(const fs::path& directory) {
+        string key = directory.generic_string();
+        if (key.empty() || key.back() != '/') key += '/';
+        return key;
+    }
+
+    // False if the folder's time can't be read
+    bool folderTime(const fs::path& directory, int64_t& modified) {
+        error_code ec;
+        fs::file_time_type time = fs::last_write_time(directory, ec);
+        if (ec) return false;
+        modified = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    void parseFiles(ScanState& state, const vector<string>& files) {
+        vector<Track>& bucket = state.myBucket();
+        for (const string& path : files) {
+            bool parsed = false;
+            bucket.push_back(LibraryScanner::readTrack(path, &parsed));
+            if (!parsed) state.failed.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    void walkDirectory(ScanState& state, const fs::path& directory) {
+        if (!state.firstVisit(directory)) return;
+
+        // Stamped before listing: anything that changes while we look moves the time past it
+        int64_t modified;
+        if (folderTime(directory, modified)) state.stamp(folderKey(directory), modified);
+
+        error_code ec;
+        fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec);
+        if (ec) return;
+
+        auto batch = make_shared<vector<string>>();
+        for (; it != fs::directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            const fs::directory_entry& entry = *it;
+
+            error_code typeError;
+            if (entry.is_directory(typeError)) {
+                fs::path sub = entry.path();
+                state.pool.submit([&state, sub] { walkDirectory(state, sub); });
+            } else if (entry.is_regular_file(typeError)) {
+                string path = entry.path().generic_string();
+                if (!isSupportedAudioFile(path)) continue;
+
+                state.filesSeen.fetch_add(1, memory_order_relaxed);
+                batch->push_back(std::move(path));
+                if (batch->size() == FilesPerTask) {
+                    state.pool.submit([&state, batch] { parseFiles(state, *batch); });
+                    batch = make_shared<vector<string>>();
+                }
+            }
+        }
+
+        // The leftover batch is parsed right here, no need to bounce it through the pool
+        if (!batch->empty()) parseFiles(state, *batch);
+    }
+
+    // The per-worker buckets in one go, sorted by path
+    vector<Track> mergeBuckets(ScanState& state) {
+        vector<Track> tracks;
+        size_t total = 0;
+        for (const vector<Track>& bucket : state.buckets) total += bucket.size();
+        tracks.reserve(total);
+        for (vector<Track>& bucket : state.buckets) {
+            move(bucket.begin(), bucket.end(), back_inserter(tracks));
+        }
+        sort(tracks.begin(), tracks.end(), [](const Track& a, const Track& b) { return a.filePath < b.filePath; });
+        return tracks;
+    }
+}
+
+//----------------------------------------------------
+LibraryScanner::LibraryScanner(ThreadPool& p) : pool(p) {}
+
+Track LibraryScanner::readTrack(const string& filePath, bool* parsed) {
+    TrackTags tags;
+    bool ok = readTrackTags(filePath, tags);
+    if (parsed) *parsed = ok;
+
+    if (tags.title.empty()) tags.title = fs::path(filePath).stem().string();
+    if (tags.artist.empty()) tags.artist = "Unknown Artist";
+
+    return Track{ 0, std::move(tags.title), std::move(tags.artist), tags.duration, filePath };
+}
+
+ScanResult LibraryScanner::scan(const string& rootDirectory) {
+    auto start = chrono::steady_clock::now();
+    ScanResult result;
+
+    ScanState state(pool);
+    error_code ec;
+    if (fs::is_directory(rootDirectory, ec)) {
+        pool.submit([&state, rootDirectory] { walkDirectory(state, rootDirectory); });
+        pool.wait();
+    }
+
+    result.tracks = mergeBuckets(state);
+    result.filesSeen = state.filesSeen.load();
+    result.failed = state.failed.load();
+    result.folders = std::move(state.folders);
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+LibraryChanges LibraryScanner::catchUp(FolderTimes& folders, const vector<string>& knownFiles) {
+    LibraryChanges changes;
+
+    // Folders that went, and folders whose time moved (with their old time)
+    vector<string> gone;
+    vector<pair<string, int64_t>> changed;
+    for (auto& [folder, stamp] : folders) {
+        error_code ec;
+        int64_t modified;
+        if (!fs::is_directory(folder, ec) || !folderTime(folder, modified)) {
+            if (gone.empty() || !folder.starts_with(gone.back())) gone.push_back(folder); // Not under one already gone
+        } else if (modified != stamp) {
+            changed.emplace_back(folder, stamp);
+            stamp = modified;
+        }
+    }
+    for (const string& prefix : gone) {
+        for (auto it = folders.lower_bound(prefix); it != folders.end() && it->first.starts_with(prefix);) it = folders.erase(it);
+    }
+    changes.removedDirectories = std::move(gone);
+    if (changed.empty()) return changes;
+
+    // Known files by folder, only for the folders to list
+    unordered_map<string_view, unordered_set<string_view>> known;
+    for (const auto& entry : changed) known[entry.first];
+    for (const string& path : knownFiles) {
+        size_t split = path.find_last_of('/');
+        if (split == string::npos) continue;
+        auto folder = known.find(string_view(path).substr(0, split + 1));
+        if (folder != known.end()) folder->second.insert(path);
+    }
+
+    ScanState state(pool);
+    vector<string> toRead;
+    for (const auto& [folder, stamp] : changed) {
+        unordered_set<string_view>& missing = known[folder]; // Until seen
+        error_code ec;
+        fs::directory_iterator it(folder, fs::directory_options::skip_permission_denied, ec);
+        if (ec) continue; // Unreadable for now: left as it was
+        for (; it != fs::directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            const fs::directory_entry& entry = *it;
+
+            error_code typeError;
+            if (entry.is_directory(typeError)) {
+                fs::path sub = entry.path();
+                if (folders.count(folderKey(sub)) == 0) state.pool.submit([&state, sub] { walkDirectory(state, sub); });
+            } else if (entry.is_regular_file(typeError)) {
+                string path = entry.path().generic_string();
+                if (!isSupportedAudioFile(path)) continue;
+
+                if (missing.erase(path) == 0) {
+                    toRead.push_back(std::move(path)); // New
+                    continue;
+                }
+                int64_t modified = 0;
+                error_code timeError;
+                fs::file_time_type time = entry.last_write_time(timeError);
+                if (!timeError) modified = static_cast<int64_t>(time.time_since_epoch().count());
+                if (timeError || modified >= stamp) toRead.push_back(std::move(path)); // Written since
+            }
+        }
+        if (ec) continue; // Listing cut short: don't take files for gone
+        for (string_view path : missing) changes.removedFiles.emplace_back(path);
+    }
+
+    for (size_t i = 0; i < toRead.size(); i += FilesPerTask) {
+        auto batch = make_shared<vector<string>>(toRead.begin() + static_cast<ptrdiff_t>(i),
+                                                 toRead.begin() + static_cast<ptrdiff_t>(min(i + FilesPerTask, toRead.size())));
+        pool.submit([&state, batch] { parseFiles(state, *batch); });
+    }
+    pool.wait();
+
+    for (Track& track : mergeBuckets(state)) changes.updated.push_back(FileUpdate{ std::move(track), "" });
+    sort(changes.removedFiles.begin(), changes.removedFiles.end());
+    folders.merge(state.folders); // New subfolders
+    return changes;
+}
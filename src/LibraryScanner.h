@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Track.h"
+
+class ThreadPool;
+
+// When each folder of the library last changed, as its modification time in
+// file-clock ticks. Keyed by folder path ending in '/', as in the store's
+// directory names.
+using FolderTimes = std::map<std::string, std::int64_t>;
+
+// Result of one scan. Tracks come back with id 0; Playlist::addTracks assigns IDs.
+struct ScanResult {
+    std::vector<Track> tracks;   // Sorted by file path, so the order is stable between runs
+    std::size_t filesSeen = 0;   // Supported audio files found
+    std::size_t failed = 0;      // Files whose headers could not be parsed (still added)
+    FolderTimes folders;         // Every folder walked, stamped before it was listed
+    double seconds = 0.0;
+
+    double filesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(filesSeen) / seconds : 0.0;
+    }
+};
+
+// Walks a directory tree on a work-stealing pool: every directory is a task
+// that spawns tasks for its subdirectories and for batches of files to parse.
+// Each worker collects into its own bucket, and the buckets are merged once
+// at the end, so there is no locking on the hot path.
+class LibraryScanner {
+public:
+    explicit LibraryScanner(ThreadPool& pool);
+
+    ScanResult scan(const std::string& rootDirectory);
+
+    // What changed on disk while nothing was watching, judged by the folder
+    // times of the last scan (or snapshot): only folders whose time moved
+    // are listed again. There, unknown files are new, known files missing
+    // are removed, and known files written since the folder's old time are
+    // re-read; new subfolders are walked whole. Folders that went are
+    // removed directories. 'folders' is brought up to date.
+    //
+    // A file rewritten in place leaves its folder's time alone, so it is
+    // only noticed if something else changed in that folder; a rename
+    // comes out as a removal and an addition.
+    LibraryChanges catchUp(FolderTimes& folders, const std::vector<std::string>& knownFiles);
+
+    // Build one Track from a single file (title falls back to the file name)
+    static Track readTrack(const std::string& filePath, bool* parsed = nullptr);
+
+private:
+    ThreadPool& pool;
+};
@@ -0,0 +1,382 @@
+#include "LibrarySnapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+#include "Playlist.h"
+#include "PlaylistManager.h"
+
+using namespace std;
+
+namespace {
+    const char Magic[8] = { 'H', 'I', 'V', 'E', 'S', 'N', 'A', 'P' };
+
+    void setError(string* error, const string& message) {
+        if (error) *error = message;
+    }
+
+    // String table builder. Artists and directories are already interned by the
+    // TrackStore, so every string is simply appended.
+    class StringTable {
+    public:
+        string bytes;
+
+        uint32_t add(string_view s) {
+            uint32_t offset = static_cast<uint32_t>(bytes.size());
+            bytes.append(s.data(), s.size());
+            return offset;
+        }
+    };
+
+    void addSymbols(const SymbolTable& table, StringTable& strings, vector<SnapshotSymbol>& out) {
+        for (uint32_t symbol = 0; symbol < table.size(); symbol++) {
+            string_view name = table.name(symbol);
+            out.push_back(SnapshotSymbol{ strings.add(name), static_cast<uint32_t>(name.size()) });
+        }
+    }
+}
+
+//----------------------------------------------------
+uint64_t LibrarySnapshot::checksum(const unsigned char* data, size_t size) {
+    // Four independent multiply-xor lanes over 8-byte words, folded at the end
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t lanes[4] = { 1, 2, 3, 4 };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    uint64_t h = size;
+    for (int lane = 0; lane < 4; lane++) {
+        h = (h ^ lanes[lane]) * prime;
+    }
+    for (; i < size; i++) {
+        h = (h ^ data[i]) * prime;
+    }
+    return h ^ (h >> 32);
+}
+
+//----------------------------------------------------
+bool LibrarySnapshot::save(const string& path, Playlist& playlist, const string& libraryRoot, string* error) {
+    return write(path, playlist, nullptr, nullptr, libraryRoot, error);
+}
+
+bool LibrarySnapshot::save(const string& path, PlaylistManager& lists, const string& libraryRoot,
+                           const FolderTimes& folders, string* error) {
+    return write(path, lists.shown(), &lists, &folders, libraryRoot, error);
+}
+
+bool LibrarySnapshot::load(const string& path, Playlist& playlist, const string& libraryRoot, string* error) {
+    return read(path, playlist, nullptr, nullptr, libraryRoot, error);
+}
+
+bool LibrarySnapshot::load(const string& path, PlaylistManager& lists, const string& libraryRoot, FolderTimes& folders,
+                           string* error) {
+    return read(path, lists.shown(), &lists, &folders, libraryRoot, error);
+}
+
+//----------------------------------------------------
+bool LibrarySnapshot::write(const string& path, Playlist& playlist, const PlaylistManager* lists,
+                            const FolderTimes* folders, const string& libraryRoot, string* error) {
+    const TrackStore& store = playlist.getStore();
+    StringTable strings;
+    vector<SnapshotRecord> records;
+    records.reserve(static_cast<size_t>(playlist.getTotalTracks()));
+    const uint32_t NoRecord = 0xFFFFFFFFu;
+    vector<uint32_t> recordOf(store.handleLimit(), NoRecord); // By handle
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.recordSize = sizeof(SnapshotRecord);
+    header.rootOffset = strings.add(libraryRoot);
+    header.rootLength = static_cast<uint32_t>(libraryRoot.size());
+
+    vector<SnapshotSymbol> symbols;
+    addSymbols(store.artistSymbols(), strings, symbols);
+    addSymbols(store.directorySymbols(), strings, symbols);
+    header.artistCount = store.artistSymbols().size();
+    header.directoryCount = store.directorySymbols().size();
+
+    auto addRecord = [&](TrackHandle h) {
+        recordOf[h] = static_cast<uint32_t>(records.size());
+        string_view name = store.fileName(h);
+        string_view title = store.title(h);
+
+        SnapshotRecord r = {};
+        r.id = store.id(h);
+        r.duration = store.duration(h);
+        r.artist = store.artist(h);
+        r.directory = store.directory(h);
+        r.nameOffset = strings.add(name);
+        r.nameLength = static_cast<uint16_t>(name.size());
+        r.titleLength = static_cast<uint16_t>(title.size());
+        // Keep sharing the file name's bytes when the store did
+        if (title.data() >= name.data() && title.data() + title.size() <= name.data() + name.size()) {
+            r.titleOffset = r.nameOffset + static_cast<uint32_t>(title.data() - name.data());
+        } else {
+            r.titleOffset = strings.add(title);
+        }
+        records.push_back(r);
+    };
+    playlist.forEachTrack([&](TrackRef t) { addRecord(t.getHandle()); });
+    header.shownCount = records.size();
+
+    // Kept lists by record number; tracks only they hold get records after the playlist's
+    vector<SnapshotList> kept;
+    vector<uint32_t> entries;
+    if (lists != nullptr) {
+        const string& shownName = lists->shownName();
+        header.shownNameOffset = strings.add(shownName);
+        header.shownNameLength = static_cast<uint32_t>(shownName.size());
+        lists->forEachList([&](const string& name, const PlaylistManager::List& list) {
+            SnapshotList l = { strings.add(name), static_cast<uint32_t>(name.size()), static_cast<uint32_t>(entries.size()),
+                               static_cast<uint32_t>(list.size()) };
+            list.forEach([&](const PlaylistManager::SharedTrack& t) {
+                if (recordOf[t.handle()] == NoRecord) addRecord(t.handle());
+                entries.push_back(recordOf[t.handle()]);
+            });
+            kept.push_back(l);
+        });
+    }
+
+    vector<SnapshotFolder> stamps;
+    if (folders != nullptr) {
+        stamps.reserve(folders->size());
+        for (const auto& [folder, modified] : *folders) {
+            stamps.push_back(SnapshotFolder{ strings.add(folder), static_cast<uint32_t>(folder.size()), modified });
+        }
+    }
+
+    size_t recordsBytes = records.size() * sizeof(SnapshotRecord);
+    size_t symbolsBytes = symbols.size() * sizeof(SnapshotSymbol);
+    size_t listsBytes = kept.size() * sizeof(SnapshotList);
+    size_t entriesBytes = entries.size() * sizeof(uint32_t);
+    size_t foldersBytes = stamps.size() * sizeof(SnapshotFolder);
+    header.trackCount = records.size();
+    header.recordsOffset = sizeof(SnapshotHeader);
+    header.symbolsOffset = header.recordsOffset + recordsBytes;
+    header.listCount = kept.size();
+    header.listsOffset = header.symbolsOffset + symbolsBytes;
+    header.entryCount = entries.size();
+    header.entriesOffset = header.listsOffset + listsBytes;
+    header.folderCount = stamps.size();
+    header.foldersOffset = header.entriesOffset + entriesBytes;
+    header.stringsOffset = header.foldersOffset + foldersBytes;
+    header.stringsSize = strings.bytes.size();
+    header.nextId = playlist.getNextId();
+    TrackRef current = playlist.getCurrentTrack();
+    header.currentId = current ? current.id() : 0;
+
+    // Checksum the body exactly as it will sit on disk
+    vector<unsigned char> body(header.stringsOffset + strings.bytes.size() - sizeof(SnapshotHeader));
+    auto place = [&](uint64_t offset, const void* data, size_t size) {
+        if (size > 0) memcpy(body.data() + (offset - sizeof(SnapshotHeader)), data, size);
+    };
+    place(header.recordsOffset, records.data(), recordsBytes);
+    place(header.symbolsOffset, symbols.data(), symbolsBytes);
+    place(header.listsOffset, kept.data(), listsBytes);
+    place(header.entriesOffset, entries.data(), entriesBytes);
+    place(header.foldersOffset, stamps.data(), foldersBytes);
+    place(header.stringsOffset, strings.bytes.data(), strings.bytes.size());
+    header.checksum = checksum(body.data(), body.size());
+
+    string tempPath = path + ".tmp";
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        if (!out) {
+            setError(error, "Cannot write " + tempPath);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(body.data()), static_cast<streamsize>(body.size()));
+        if (!out) {
+            setError(error, "Write failed: " + tempPath);
+            return false;
+        }
+    }
+
+    // The text may be borrowed from the very file about to be replaced
+    playlist.releaseBackingStores();
+
+    error_code ec;
+    filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        setError(error, "Cannot replace " + path + ": " + ec.message());
+        filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------
+bool LibrarySnapshot::read(const string& path, Playlist& playlist, PlaylistManager* lists, FolderTimes* folders,
+                           const string& libraryRoot, string* error) {
+    auto file = make_shared<MappedFile>();
+    if (!file->open(path)) {
+        setError(error, "No snapshot at " + path);
+        return false;
+    }
+
+    const unsigned char* base = file->data();
+    size_t size = file->size();
+    if (size < sizeof(SnapshotHeader)) {
+        setError(error, "Snapshot too small");
+        return false;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+        header.recordSize != sizeof(SnapshotRecord)) {
+        setError(error, "Snapshot has an unknown format or version");
+        return false;
+    }
+
+    uint64_t recordsBytes = header.trackCount * sizeof(SnapshotRecord);
+    uint64_t symbolCount = uint64_t(header.artistCount) + header.directoryCount;
+    if (header.recordsOffset != sizeof(SnapshotHeader) || header.trackCount > 0x7FFFFFFF ||
+        header.shownCount > header.trackCount || header.listCount > 0x7FFFFFFF || header.entryCount > 0xFFFFFFFF ||
+        header.symbolsOffset != header.recordsOffset + recordsBytes ||
+        header.listsOffset != header.symbolsOffset + symbolCount * sizeof(SnapshotSymbol) ||
+        header.entriesOffset != header.listsOffset + header.listCount * sizeof(SnapshotList) ||
+        header.folderCount > 0x7FFFFFFF || header.foldersOffset != header.entriesOffset + header.entryCount * sizeof(uint32_t) ||
+        header.stringsOffset != header.foldersOffset + header.folderCount * sizeof(SnapshotFolder) ||
+        header.stringsOffset + header.stringsSize != size || header.stringsSize > 0xFFFFFFFF) {
+        setError(error, "Snapshot is truncated");
+        return false;
+    }
+
+    if (checksum(base + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader)) != header.checksum) {
+        setError(error, "Snapshot checksum mismatch");
+        return false;
+    }
+
+    const char* strings = reinterpret_cast<const char*>(base + header.stringsOffset);
+    auto fits = [&](uint32_t offset, uint32_t length) {
+        return uint64_t(offset) + length <= header.stringsSize;
+    };
+
+    if (!fits(header.rootOffset, header.rootLength) ||
+        string_view(strings + header.rootOffset, header.rootLength) != libraryRoot) {
+        setError(error, "Snapshot was made from another library folder");
+        return false;
+    }
+
+    const SnapshotSymbol* symbols = reinterpret_cast<const SnapshotSymbol*>(base + header.symbolsOffset);
+    for (uint64_t i = 0; i < symbolCount; i++) {
+        if (!fits(symbols[i].offset, symbols[i].length)) {
+            setError(error, "Snapshot symbol out of range");
+            return false;
+        }
+    }
+
+    const SnapshotList* kept = reinterpret_cast<const SnapshotList*>(base + header.listsOffset);
+    const uint32_t* entries = reinterpret_cast<const uint32_t*>(base + header.entriesOffset);
+    bool listsFit = fits(header.shownNameOffset, header.shownNameLength);
+    for (uint64_t i = 0; i < header.listCount && listsFit; i++) {
+        listsFit = fits(kept[i].nameOffset, kept[i].nameLength) &&
+                   uint64_t(kept[i].firstEntry) + kept[i].entryCount <= header.entryCount;
+    }
+    for (uint64_t i = 0; i < header.entryCount && listsFit; i++) listsFit = entries[i] < header.trackCount;
+    if (!listsFit) {
+        setError(error, "Snapshot list out of range");
+        return false;
+    }
+
+    // Into a map of our own, so a failure leaves the caller's alone
+    FolderTimes stamps;
+    for (uint64_t i = 0; i < header.folderCount; i++) {
+        SnapshotFolder f;
+        memcpy(&f, base + header.foldersOffset + i * sizeof(SnapshotFolder), sizeof(f));
+        if (!fits(f.nameOffset, f.nameLength)) {
+            setError(error, "Snapshot folder out of range");
+            return false;
+        }
+        if (folders != nullptr) stamps.emplace(string(strings + f.nameOffset, f.nameLength), f.modified);
+    }
+
+    // Without a manager only the playlist's own records are loaded
+    const SnapshotRecord* records = reinterpret_cast<const SnapshotRecord*>(base + header.recordsOffset);
+    int count = static_cast<int>(lists != nullptr ? header.trackCount : header.shownCount);
+    vector<int32_t> ids;
+    ids.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; i++) {
+        const SnapshotRecord& r = records[i];
+        if (r.id <= 0 || r.id >= header.nextId || r.artist >= header.artistCount || r.directory >= header.directoryCount ||
+            !fits(r.titleOffset, r.titleLength) || !fits(r.nameOffset, r.nameLength)) {
+            setError(error, "Snapshot record out of range");
+            return false;
+        }
+        ids.push_back(r.id);
+    }
+
+    // An ID twice (or one the playlist already has) would leave the ID index
+    // pointing at only one of the tracks
+    sort(ids.begin(), ids.end());
+    if (adjacent_find(ids.begin(), ids.end()) != ids.end() ||
+        any_of(ids.begin(), ids.end(), [&](int32_t id) { return static_cast<bool>(playlist.findTrack(id)); })) {
+        setError(error, "Snapshot has a track ID twice");
+        return false;
+    }
+
+    vector<TrackHandle> handles;
+    playlist.restoreTracks([&](TrackStore& store) {
+        // Into an empty store the string table becomes the text arena as is;
+        // otherwise the text is copied track by track
+        bool zeroCopy = store.borrowText(strings, header.stringsSize);
+
+        // Snapshot symbol -> store symbol (the same numbers when the store was empty)
+        vector<uint32_t> symbolMap(static_cast<size_t>(symbolCount));
+        for (uint64_t i = 0; i < symbolCount; i++) {
+            SymbolTable& table = i < header.artistCount ? store.artistSymbols() : store.directorySymbols();
+            symbolMap[i] = table.internBorrowed(string_view(strings + symbols[i].offset, symbols[i].length));
+        }
+
+        handles.reserve(static_cast<size_t>(count));
+        store.reserve(static_cast<size_t>(count), zeroCopy ? 0 : header.stringsSize);
+        for (int i = 0; i < count; i++) {
+            const SnapshotRecord& r = records[i];
+            uint32_t artist = symbolMap[r.artist];
+            uint32_t directory = symbolMap[header.artistCount + r.directory];
+            if (zeroCopy) {
+                handles.push_back(store.addStored(r.id, r.duration, artist, directory,
+                                                  TrackText{ r.titleOffset, r.nameOffset, r.titleLength, r.nameLength }));
+            } else {
+                handles.push_back(store.add(r.id, string_view(strings + r.titleOffset, r.titleLength), artist, r.duration,
+                                            directory, string_view(strings + r.nameOffset, r.nameLength)));
+            }
+        }
+        return vector<TrackHandle>(handles.begin(), handles.begin() + static_cast<ptrdiff_t>(header.shownCount));
+    }, file);
+
+    playlist.setNextId(header.nextId);
+    if (header.currentId > 0) playlist.jumpToTrack(header.currentId);
+    if (lists == nullptr) return true;
+    *folders = std::move(stamps);
+
+    // The lists count their tracks; then the records past the playlist's drop
+    // the reference add() gave them, so one no list holds goes again
+    for (uint64_t i = 0; i < header.listCount; i++) {
+        vector<PlaylistManager::SharedTrack> tracks;
+        tracks.reserve(kept[i].entryCount);
+        for (uint32_t e = kept[i].firstEntry; e < kept[i].firstEntry + kept[i].entryCount; e++) {
+            tracks.push_back(lists->share(handles[entries[e]]));
+        }
+        lists->put(string(strings + kept[i].nameOffset, kept[i].nameLength), lists->makeList(tracks));
+    }
+    TrackStore& store = playlist.sharedStore();
+    for (size_t i = static_cast<size_t>(header.shownCount); i < handles.size(); i++) store.release(handles[i]);
+    if (header.shownNameLength > 0) lists->rename(lists->shownName(), string(strings + header.shownNameOffset, header.shownNameLength));
+    return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "LibraryScanner.h"
+
+class Playlist;
+class PlaylistManager;
+
+// Compact on-disk image of a Playlist, and of the other lists a
+// PlaylistManager keeps of its tracks, loaded by mapping the file into memory.
+// It also keeps the library's folder times, so the next start can tell which
+// folders changed while the player was closed (LibraryScanner::catchUp).
+//
+// Layout (native little-endian), a straight copy of the TrackStore's shape:
+//     SnapshotHeader
+//     SnapshotRecord[trackCount]                 fixed-width; the first shownCount
+//                                                in playlist order, then the
+//                                                tracks only kept lists hold
+//     SnapshotSymbol[artistCount + directoryCount]
+//     SnapshotList[listCount]                    the kept lists
+//     uint32 record numbers[entryCount]          their tracks, list after list
+//     SnapshotFolder[folderCount]                the library's folder times
+//     string table                               raw UTF-8 bytes, no terminators
+//
+// Loading does no per-field parsing: the string table becomes the start of the
+// store's text arena and the symbols borrow their names from it, so no string
+// is copied. The mapping is kept alive by the Playlist until it goes away.
+struct SnapshotHeader {
+    char magic[8];               // "HIVESNAP"
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t trackCount;
+    std::uint64_t recordsOffset;
+    std::uint32_t artistCount;
+    std::uint32_t directoryCount;
+    std::uint64_t symbolsOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint32_t rootOffset;    // Library folder the snapshot was made from
+    std::uint32_t rootLength;
+    std::int32_t nextId;
+    std::int32_t currentId;
+    std::uint64_t shownCount;    // Records of the playlist itself
+    std::uint64_t listsOffset;
+    std::uint64_t listCount;
+    std::uint64_t entriesOffset;
+    std::uint64_t entryCount;
+    std::uint32_t shownNameOffset; // The playlist's name among the lists
+    std::uint32_t shownNameLength;
+    std::uint64_t foldersOffset;
+    std::uint64_t folderCount;
+    std::uint64_t checksum;      // Over everything after the header
+};
+
+// Offsets are into the string table; artist/directory are symbol numbers
+struct SnapshotRecord {
+    std::int32_t id;
+    std::int32_t duration;
+    std::uint32_t artist;
+    std::uint32_t directory;
+    std::uint32_t titleOffset;
+    std::uint32_t nameOffset;
+    std::uint16_t titleLength;
+    std::uint16_t nameLength;
+};
+
+struct SnapshotSymbol {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+// A kept list: its name, and where its record numbers are among the entries
+struct SnapshotList {
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint32_t firstEntry;
+    std::uint32_t entryCount;
+};
+
+// A folder and its modification time (see FolderTimes). Not 8-byte aligned
+// in the file: read with memcpy.
+struct SnapshotFolder {
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::int64_t modified;
+};
+
+static_assert(sizeof(SnapshotHeader) == 152, "SnapshotHeader layout changed");
+static_assert(sizeof(SnapshotRecord) == 28, "SnapshotRecord layout changed");
+static_assert(sizeof(SnapshotSymbol) == 8, "SnapshotSymbol layout changed");
+static_assert(sizeof(SnapshotList) == 16, "SnapshotList layout changed");
+static_assert(sizeof(SnapshotFolder) == 16, "SnapshotFolder layout changed");
+
+class LibrarySnapshot {
+public:
+    static const std::uint32_t Version = 4;
+
+    // Writes to a temporary file first and renames it over 'path'. The playlist
+    // first lets go of any snapshot it has mapped: Windows cannot replace a
+    // file while a view of it is open.
+    static bool save(const std::string& path, Playlist& playlist, const std::string& libraryRoot,
+                     std::string* error = nullptr);
+
+    // The manager's playlist, its name, every list it keeps, and the folder times
+    static bool save(const std::string& path, PlaylistManager& lists, const std::string& libraryRoot,
+                     const FolderTimes& folders, std::string* error = nullptr);
+
+    // Appends the snapshot's playlist to 'playlist' (kept lists are skipped).
+    // Zero-copy into an empty one; a playlist that already has tracks gets
+    // copies of the text.
+    // Fails without touching the playlist if the file is missing, corrupt, from
+    // another version, or was made from a different library folder, or if a
+    // track ID repeats (within the file or with the playlist) or is not below
+    // the saved next ID.
+    static bool load(const std::string& path, Playlist& playlist, const std::string& libraryRoot,
+                     std::string* error = nullptr);
+
+    // The same into the manager's playlist, then the kept lists are put into
+    // the manager under their names, and the playlist takes its saved name.
+    // 'folders' is replaced by the saved folder times.
+    static bool load(const std::string& path, PlaylistManager& lists, const std::string& libraryRoot,
+                     FolderTimes& folders, std::string* error = nullptr);
+
+    static std::uint64_t checksum(const unsigned char* data, std::size_t size);
+
+private:
+    static bool write(const std::string& path, Playlist& playlist, const PlaylistManager* lists,
+                      const FolderTimes* folders, const std::string& libraryRoot, std::string* error);
+    static bool read(const std::string& path, Playlist& playlist, PlaylistManager* lists, FolderTimes* folders,
+                     const std::string& libraryRoot, std::string* error);
+};
@@ -0,0 +1,280 @@
+#include "LibraryWatcher.h"
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+#include "LibraryScanner.h"
+#include "TagReader.h"
+#include "ThreadPool.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    // Under 'directory' (a folder path without its trailing separator)
+    bool isUnder(const string& path, const string& directory) {
+        return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+               (path[directory.size()] == '/' || directory.back() == '/');
+    }
+}
+
+#ifdef __linux__
+namespace {
+    const uint32_t FolderEvents = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                  IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+}
+
+//----------------------------------------------------
+LibraryWatcher::LibraryWatcher(function<void()> changed) : onChanges(std::move(changed)) {
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return;
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return;
+    }
+    worker = thread([this] { run(); });
+}
+
+LibraryWatcher::~LibraryWatcher() {
+    stopping = true;
+    if (worker.joinable()) {
+        char byte = 0;
+        (void)!write(wakePipe[1], &byte, 1);
+        worker.join();
+    }
+    for (int fd : { inotifyFd, wakePipe[0], wakePipe[1] }) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool LibraryWatcher::supported() {
+    return true;
+}
+
+bool LibraryWatcher::watch(const string& directory) {
+    if (inotifyFd < 0) return false;
+    {
+        lock_guard<mutex> guard(lock);
+        requests.push_back(directory);
+    }
+    char byte = 0;
+    (void)!write(wakePipe[1], &byte, 1); // A full pipe already holds a wake-up
+    return true;
+}
+
+//----------------------------------------------------
+void LibraryWatcher::run() {
+    ThreadPool::lowerCurrentPriority();
+
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (!stopping) {
+        // Asleep until an event, a request or the batch falling due
+        int timeoutMs = -1;
+        if (eventCount > 0) {
+            Clock::time_point due = min(lastEvent + chrono::milliseconds(QuietMs), firstEvent + chrono::milliseconds(MaxDelayMs));
+            timeoutMs = static_cast<int>(max<int64_t>(chrono::ceil<chrono::milliseconds>(due - Clock::now()).count(), 0));
+        }
+        pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, timeoutMs) < 0 && errno != EINTR) break;
+        if (stopping) break;
+
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            vector<string> roots;
+            {
+                lock_guard<mutex> guard(lock);
+                roots.swap(requests);
+            }
+            for (const string& root : roots) addTree(root, false); // Already in the playlist
+        }
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t got;
+            while ((got = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* at = buffer; at < buffer + got;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+                    handle(event->wd, event->mask, event->cookie, event->len > 0 ? event->name : "");
+                    at += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+        if (eventCount > 0) {
+            Clock::time_point now = Clock::now();
+            if (now - lastEvent >= chrono::milliseconds(QuietMs) || now - firstEvent >= chrono::milliseconds(MaxDelayMs)) flush();
+        }
+    }
+}
+
+// Watch 'root' and the folders under it. With 'reportFiles', the audio files
+// found in them count as new (they may have arrived before their folder's watch).
+void LibraryWatcher::addTree(const string& root, bool reportFiles) {
+    vector<string> stack{ root };
+    while (!stack.empty() && !stopping) {
+        string folder = std::move(stack.back());
+        stack.pop_back();
+
+        int wd = inotify_add_watch(inotifyFd, folder.c_str(), FolderEvents);
+        if (wd < 0) {
+            if (errno == ENOSPC) failedCount++; // Over fs.inotify.max_user_watches
+            continue;
+        }
+        if (!folders.try_emplace(wd, folder).second) continue; // Already watched (e.g. reached again through a link)
+        watchCount++;
+
+        error_code ec;
+        for (fs::directory_iterator it(folder, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::directory_entry& entry = *it;
+            error_code typeError;
+            if (entry.is_directory(typeError)) {
+                stack.push_back(entry.path().string());
+            } else if (reportFiles && entry.is_regular_file(typeError)) {
+                string path = entry.path().string();
+                if (isSupportedAudioFile(path)) {
+                    pending[path] = Pending{};
+                    noted();
+                }
+            }
+        }
+    }
+}
+
+// Stop watching a folder that went away, and everything under it
+void LibraryWatcher::forgetTree(const string& directory) {
+    for (auto it = folders.begin(); it != folders.end();) {
+        if (it->second == directory || isUnder(it->second, directory)) {
+            inotify_rm_watch(inotifyFd, it->first);
+            watchCount--;
+            it = folders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LibraryWatcher::handle(int wd, uint32_t mask, uint32_t cookie, const char* name) {
+    if (mask & IN_Q_OVERFLOW) {
+        overflowed = true;
+        noted();
+        return;
+    }
+    auto folder = folders.find(wd);
+    if (folder == folders.end()) return; // A watch already forgotten
+
+    if (mask & IN_IGNORED) {
+        folders.erase(folder);
+        watchCount--;
+        return;
+    }
+    if (mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        // Only still known if its parent isn't watched, i.e. a watched root itself
+        string gone = folder->second;
+        removedDirectories.push_back(gone);
+        forgetTree(gone);
+        noted();
+        return;
+    }
+
+    string path = (fs::path(folder->second) / name).string();
+    if (mask & IN_ISDIR) {
+        if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+            removedDirectories.push_back(path);
+            forgetTree(path);
+            for (auto it = pending.lower_bound(path); it != pending.end() && isUnder(it->first, path);) it = pending.erase(it);
+            noted();
+        } else if (mask & (IN_CREATE | IN_MOVED_TO)) {
+            addTree(path, true);
+        }
+        return;
+    }
+
+    if (!isSupportedAudioFile(path)) return;
+    if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+        Pending& was = pending[path];
+        if (mask & IN_MOVED_FROM) movedAway[cookie] = MovedAway{ path, was.removed ? string() : was.renamedFrom };
+        was = Pending{ true, string() };
+        noted();
+    } else if (mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+        Pending now;
+        auto moved = (mask & IN_MOVED_TO) ? movedAway.find(cookie) : movedAway.end();
+        if (moved != movedAway.end()) {
+            // The other half of a rename: the file is the one that was at moved->path
+            now.renamedFrom = moved->second.renamedFrom.empty() ? moved->second.path : moved->second.renamedFrom;
+            pending.erase(moved->second.path);
+            movedAway.erase(moved);
+        } else {
+            auto earlier = pending.find(path);
+            if (earlier != pending.end() && !earlier->second.removed) now.renamedFrom = earlier->second.renamedFrom;
+        }
+        pending[path] = std::move(now);
+        noted();
+    }
+}
+
+#else
+
+LibraryWatcher::LibraryWatcher(function<void()> changed) : onChanges(std::move(changed)) {}
+LibraryWatcher::~LibraryWatcher() {}
+bool LibraryWatcher::supported() { return false; }
+bool LibraryWatcher::watch(const string&) { return false; }
+void LibraryWatcher::run() {}
+void LibraryWatcher::addTree(const string&, bool) {}
+void LibraryWatcher::forgetTree(const string&) {}
+void LibraryWatcher::handle(int, uint32_t, uint32_t, const char*) {}
+
+#endif
+
+//----------------------------------------------------
+vector<LibraryChanges> LibraryWatcher::takeChanges() {
+    lock_guard<mutex> guard(lock);
+    vector<LibraryChanges> batches;
+    batches.swap(ready);
+    return batches;
+}
+
+// One more event for the batch being gathered
+void LibraryWatcher::noted() {
+    lastEvent = Clock::now();
+    if (eventCount++ == 0) firstEvent = lastEvent;
+}
+
+// Read what arrived or changed, and hand the batch over
+void LibraryWatcher::flush() {
+    LibraryChanges batch;
+    batch.events = eventCount;
+    batch.overflowed = overflowed;
+
+    sort(removedDirectories.begin(), removedDirectories.end());
+    removedDirectories.erase(unique(removedDirectories.begin(), removedDirectories.end()), removedDirectories.end());
+    batch.removedDirectories = std::move(removedDirectories);
+
+    for (auto& [path, change] : pending) {
+        error_code ec;
+        if (change.removed || !fs::is_regular_file(path, ec)) {
+            batch.removedFiles.push_back(path); // Also what went again before the batch was read
+        } else {
+            batch.updated.push_back(FileUpdate{ LibraryScanner::readTrack(path), std::move(change.renamedFrom) });
+        }
+    }
+
+    pending.clear();
+    removedDirectories.clear();
+    movedAway.clear(); // A rename's halves arrive together; one left alone moved out of (or into) sight
+    eventCount = 0;
+    overflowed = false;
+
+    {
+        lock_guard<mutex> guard(lock);
+        ready.push_back(std::move(batch));
+    }
+    if (onChanges) onChanges();
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Track.h"
+
+// Follows the library on disk, so the playlist can pick up new, rewritten,
+// renamed and deleted files without a rescan.
+//
+// Linux only, through inotify: one watch per folder, read on a thread of its
+// own that sleeps in poll() until something happens. Events are coalesced by
+// path while they keep coming: a batch goes out once the folders have been
+// quiet for QuietMs (or MaxDelayMs after its first event, during a long
+// copy), so an album copied in is one batch and each file in it is read once.
+// Files count once they are closed after writing, not when created. A rename
+// inside the watched folders is reported as one (renamedFrom), so the track
+// can keep its ID and place; moving a folder is its removal plus the arrival
+// of its files. Folders made later are watched as they appear.
+//
+// The tags of new and changed files are read on the watcher thread (at low
+// OS priority). The owner is called back when a batch is ready and takes it
+// with takeChanges() on its own thread. Elsewhere supported() is false and
+// watch() does nothing.
+class LibraryWatcher {
+public:
+    static constexpr int QuietMs = 400;
+    static constexpr int MaxDelayMs = 3000;
+
+    // 'onChanges' runs on the watcher thread each time a batch is ready
+    explicit LibraryWatcher(std::function<void()> onChanges);
+    ~LibraryWatcher();
+
+    LibraryWatcher(const LibraryWatcher&) = delete;
+    LibraryWatcher& operator=(const LibraryWatcher&) = delete;
+
+    static bool supported();
+
+    // Watch this folder and every one under it, from now on. Returns at once;
+    // the folders are walked on the watcher thread. False if this platform or
+    // process can't watch anything.
+    bool watch(const std::string& directory);
+
+    // The batches since the last call, oldest first (apply them in order)
+    std::vector<LibraryChanges> takeChanges();
+
+    std::size_t watchedDirectories() const { return watchCount.load(); }
+    std::size_t unwatchedDirectories() const { return failedCount.load(); } // Over the system's watch limit
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        bool removed = false;
+        std::string renamedFrom;
+    };
+
+    struct MovedAway {
+        std::string path;        // Where a file was moved from
+        std::string renamedFrom; // And where it had been before that, within this batch
+    };
+
+    std::function<void()> onChanges;
+
+    mutable std::mutex lock;           // Guards 'requests' and 'ready'
+    std::vector<std::string> requests; // Folders for the watcher thread to add
+    std::vector<LibraryChanges> ready;
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::size_t> watchCount{ 0 };
+    std::atomic<std::size_t> failedCount{ 0 };
+
+    int inotifyFd = -1;
+    int wakePipe[2] = { -1, -1 };
+
+    // Watcher thread only: watches and the batch being gathered
+    std::unordered_map<int, std::string> folders;           // Watch descriptor -> folder path
+    std::map<std::string, Pending> pending;                 // By file path
+    std::vector<std::string> removedDirectories;
+    std::unordered_map<std::uint32_t, MovedAway> movedAway; // By rename cookie, until its other half arrives
+    std::size_t eventCount = 0;
+    bool overflowed = false;
+    Clock::time_point firstEvent, lastEvent;
+
+    std::thread worker; // Last: it uses everything above
+
+    void run();
+    void addTree(const std::string& root, bool reportFiles);
+    void forgetTree(const std::string& directory);
+    void handle(int wd, std::uint32_t mask, std::uint32_t cookie, const char* name);
+    void noted();
+    void flush();
+};
@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+struct node;
+
+// Stable merge sort for the list containers, done purely by relinking: no
+// node is copied, moved or reallocated, so a node<T>* held anywhere else
+// still points at the same element afterwards.
+//
+// sort() merges the nodes as a chain through 'next' alone and redoes 'prev'
+// in one pass at the end. Bottom-up with a bin per power
+// of two, as std::list::sort does: no recursion, O(n log n) compares, and the
+// small early merges stay in cache. With several threads, a long chain is cut
+// into one run per thread; the runs are sorted side by side and then merged
+// pairwise, again in parallel, until one is left. sortByKey() is the faster
+// choice when each element's sort key can be taken out up front.
+namespace ListSort {
+    template <typename T>
+    struct Chain {
+        node<T>* first;
+        node<T>* last;
+    };
+
+    // Nodes per run below which another thread costs more than it saves
+    constexpr int MinParallelRun = 1 << 15;
+
+    // Merge two sorted chains. On ties 'a' goes first, which keeps the sort stable.
+    template <typename T, typename Less>
+    node<T>* merge(node<T>* a, node<T>* b, const Less& less) {
+        node<T>* head = nullptr;
+        node<T>** link = &head;
+        while (a != nullptr && b != nullptr) {
+            if (less(b->data, a->data)) {
+                *link = b;
+                link = &b->next;
+                b = b->next;
+            } else {
+                *link = a;
+                link = &a->next;
+                a = a->next;
+            }
+        }
+        *link = (a != nullptr) ? a : b;
+        return head;
+    }
+
+    // Sort a null-terminated chain; returns its new first node
+    template <typename T, typename Less>
+    node<T>* sortChain(node<T>* chain, const Less& less) {
+        // bins[i] is empty or a sorted chain of 2^i nodes; higher bins hold earlier nodes
+        node<T>* bins[64] = {};
+        int used = 0;
+        while (chain != nullptr) {
+            node<T>* carry = chain;
+            chain = chain->next;
+            carry->next = nullptr;
+
+            int i = 0;
+            for (; i < used && bins[i] != nullptr; i++) {
+                carry = merge(bins[i], carry, less);
+                bins[i] = nullptr;
+            }
+            bins[i] = carry;
+            if (i == used) used++;
+        }
+
+        node<T>* sorted = nullptr;
+        for (int i = 0; i < used; i++) {
+            if (bins[i] != nullptr) sorted = merge(bins[i], sorted, less);
+        }
+        return sorted;
+    }
+
+    // Run job(i) for every i in [0, jobs), each on its own thread (the last on this one)
+    template <typename Job>
+    void inParallel(int jobs, const Job& job) {
+        std::vector<std::thread> workers;
+        workers.reserve(static_cast<std::size_t>(std::max(jobs - 1, 0)));
+        for (int i = 0; i + 1 < jobs; i++) workers.emplace_back([&job, i] { job(i); });
+        if (jobs > 0) job(jobs - 1);
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    inline int runsFor(int count, unsigned threads) {
+        return static_cast<int>(std::min<long long>(threads, count / MinParallelRun));
+    }
+
+    // The same for a chain of 'count' nodes on up to 'threads' threads (the
+    // caller's included). 'less' is then called from all of them at once.
+    template <typename T, typename Less>
+    node<T>* sortChain(node<T>* chain, int count, const Less& less, unsigned threads) {
+        int runs = runsFor(count, threads);
+        if (runs <= 1) return sortChain(chain, less);
+
+        // Cut into 'runs' chains of (nearly) equal length
+        std::vector<node<T>*> heads(static_cast<std::size_t>(runs));
+        for (int r = 0; r < runs; r++) {
+            heads[r] = chain;
+            int length = count / runs + (r < count % runs ? 1 : 0);
+            for (int i = 1; i < length; i++) chain = chain->next;
+            node<T>* following = chain->next;
+            chain->next = nullptr;
+            chain = following;
+        }
+
+        inParallel(runs, [&](int r) { heads[r] = sortChain(heads[r], less); });
+        while (heads.size() > 1) {
+            int pairs = static_cast<int>(heads.size() / 2);
+            inParallel(pairs, [&](int p) { heads[2 * p] = merge(heads[2 * p], heads[2 * p + 1], less); });
+            // An odd run out waits for the next round
+            for (int p = 0; p < pairs; p++) heads[p] = heads[2 * p];
+            if (heads.size() % 2 != 0) heads[pairs] = heads.back();
+            heads.resize(heads.size() - static_cast<std::size_t>(pairs));
+        }
+        return heads.front();
+    }
+
+    // Redo the 'prev' links along a sorted chain
+    template <typename T>
+    Chain<T> linkBack(node<T>* first) {
+        node<T>* previous = nullptr;
+        for (node<T>* n = first; n != nullptr; n = n->next) {
+            n->prev = previous;
+            previous = n;
+        }
+        return Chain<T>{ first, previous };
+    }
+
+    // Stable sort of a list of 'count' nodes starting at 'first' (its last
+    // node's 'next' is null). Returns the new ends; every link is redone.
+    template <typename T, typename Less>
+    Chain<T> sort(node<T>* first, int count, const Less& less, unsigned threads) {
+        return linkBack(sortChain(first, count, less, threads));
+    }
+
+    // The same, ordered by less(keyOf(a), keyOf(b)) with each key taken out
+    // once. The (key, node) pairs are merge-sorted as an array (runs side by
+    // side, then pairwise merges, as above) and the nodes relinked in that
+    // order. Costs a pair of memory per node, but a compare then reads two
+    // neighbouring slots instead of two nodes scattered over the heap plus
+    // whatever they point to, which on a long list is most of a sort's time.
+    template <typename T, typename KeyOf, typename Less>
+    Chain<T> sortByKey(node<T>* first, int count, const KeyOf& keyOf, const Less& less, unsigned threads) {
+        using Key = std::decay_t<decltype(keyOf(first->data))>;
+        struct Entry {
+            Key key;
+            node<T>* item;
+        };
+        std::vector<Entry> entries;
+        entries.reserve(static_cast<std::size_t>(count));
+        for (node<T>* n = first; n != nullptr; n = n->next) entries.push_back(Entry{ keyOf(n->data), n });
+
+        auto byKey = [&less](const Entry& a, const Entry& b) { return less(a.key, b.key); };
+        int runs = std::max(runsFor(count, threads), 1);
+        std::vector<std::size_t> bounds(static_cast<std::size_t>(runs) + 1);
+        for (int r = 0; r <= runs; r++) bounds[r] = entries.size() * static_cast<std::size_t>(r) / static_cast<std::size_t>(runs);
+        auto at = [&](int r) { return entries.begin() + static_cast<std::ptrdiff_t>(bounds[std::min(r, runs)]); };
+
+        inParallel(runs, [&](int r) { std::stable_sort(at(r), at(r + 1), byKey); });
+        for (int width = 1; width < runs; width *= 2) {
+            int merges = (runs - width + 2 * width - 1) / (2 * width); // Pairs that have a right-hand run
+            inParallel(merges, [&](int m) {
+                int r = m * 2 * width;
+                std::inplace_merge(at(r), at(r + width), at(r + 2 * width), byKey);
+            });
+        }
+
+        // Both directions in one pass over the array
+        node<T>* previous = nullptr;
+        for (const Entry& e : entries) {
+            e.item->prev = previous;
+            if (previous != nullptr) previous->next = e.item;
+            previous = e.item;
+        }
+        previous->next = nullptr;
+        return Chain<T>{ entries.front().item, previous };
+    }
+}
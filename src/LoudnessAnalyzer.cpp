@@ -0,0 +1,133 @@
+#include "LoudnessAnalyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "LoudnessMeter.h"
+#include "PcmSource.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    const size_t FilesPerTask = 16;
+    const size_t ChunkFrames = 16384;       // Between stop checks and throttling sleeps
+    const size_t SaveEvery = 200;           // Files measured between saves of the store
+    const int64_t ReportIntervalNs = 250'000'000;
+
+    int64_t nowNs() {
+        return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+}
+
+//----------------------------------------------------
+LoudnessAnalyzer::LoudnessAnalyzer(LoudnessStore& s, string path, unsigned threads, double load)
+    : store(s), storePath(std::move(path)), maxLoad(clamp(load, 0.01, 1.0)) {
+    if (threads == 0) threads = max(thread::hardware_concurrency(), 2u) - 1;
+    pool = make_unique<ThreadPool>(threads);
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer() {
+    stopping = true;
+    pool.reset(); // Queued batches return at once; a file mid-decode stops at its next chunk
+    save(1);
+}
+
+void LoudnessAnalyzer::setProgressCallback(function<void()> callback) {
+    onProgress = std::move(callback);
+}
+
+void LoudnessAnalyzer::analyze(const vector<string>& paths) {
+    if (paths.empty()) return;
+    queued.fetch_add(paths.size());
+    for (size_t first = 0; first < paths.size(); first += FilesPerTask) {
+        size_t last = min(first + FilesPerTask, paths.size());
+        auto batch = make_shared<vector<string>>(paths.begin() + static_cast<ptrdiff_t>(first),
+                                                 paths.begin() + static_cast<ptrdiff_t>(last));
+        pool->submit([this, batch] { analyzeFiles(*batch); });
+    }
+}
+
+LoudnessAnalyzer::Progress LoudnessAnalyzer::progress() const {
+    Progress p;
+    p.measured = measured.load();
+    p.unchanged = unchanged.load();
+    p.failed = failed.load();
+    p.queued = queued.load(); // Last: never less than done()
+    p.busySeconds = static_cast<double>(busyNs.load()) / 1e9;
+    p.audioSeconds = static_cast<double>(audioMs.load()) / 1e3;
+    return p;
+}
+
+//----------------------------------------------------
+void LoudnessAnalyzer::analyzeFiles(const vector<string>& paths) {
+    thread_local bool lowered = false;
+    if (!lowered) {
+        ThreadPool::lowerCurrentPriority();
+        lowered = true;
+    }
+
+    for (const string& path : paths) {
+        if (stopping) return;
+
+        LoudnessInfo info;
+        if (store.find(path, info)) {
+            unchanged++;
+        } else if (LoudnessStore::stamp(path, info.modified, info.size) && measure(path, info)) {
+            store.put(path, info);
+            measured++;
+        } else {
+            if (stopping) return;
+            failed++;
+        }
+        fileDone();
+    }
+}
+
+bool LoudnessAnalyzer::measure(const string& path, LoudnessInfo& info) {
+    PcmSource source;
+    if (!source.open(path, 0)) return false;
+
+    unsigned channels = source.channelCount();
+    LoudnessMeter meter(source.sampleRate(), channels);
+    vector<int16_t> chunk(ChunkFrames * channels);
+    while (!stopping) {
+        auto start = Clock::now();
+        size_t got = source.read(chunk.data(), chunk.size());
+        if (got == 0) break;
+        meter.add(chunk.data(), got / channels);
+
+        auto busy = Clock::now() - start;
+        busyNs.fetch_add(chrono::duration_cast<chrono::nanoseconds>(busy).count(), memory_order_relaxed);
+        // Idle long enough that this thread is busy 'maxLoad' of the time
+        if (maxLoad < 1.0) this_thread::sleep_for(busy * (1.0 / maxLoad - 1.0));
+    }
+    if (stopping) return false;
+
+    info.integratedLufs = static_cast<float>(meter.integratedLufs());
+    info.truePeak = static_cast<float>(meter.truePeak());
+    audioMs.fetch_add(static_cast<int64_t>(meter.seconds() * 1000.0), memory_order_relaxed);
+    return true;
+}
+
+void LoudnessAnalyzer::fileDone() {
+    bool last = measured.load() + unchanged.load() + failed.load() == queued.load();
+    save(last ? 1 : SaveEvery);
+
+    if (!onProgress) return;
+    int64_t now = nowNs();
+    int64_t previous = lastReportNs.load(memory_order_relaxed);
+    if (last || (now - previous >= ReportIntervalNs && lastReportNs.compare_exchange_strong(previous, now))) {
+        onProgress();
+    }
+}
+
+// Saves if at least 'minNew' files were measured since the last save
+void LoudnessAnalyzer::save(size_t minNew) {
+    lock_guard<mutex> guard(saveLock);
+    size_t now = measured.load();
+    if (now - savedMeasured < minNew) return;
+    store.save(storePath);
+    savedMeasured = now;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LoudnessStore.h"
+
+class ThreadPool;
+
+// Measures the loudness of library files in the background, so playback can
+// level tracks that carry no ReplayGain tags without ever decoding at play time.
+//
+// Files are decoded on a thread pool of their own and fed through a
+// LoudnessMeter; results go into a LoudnessStore, which is saved as they come
+// in. A file whose size and modification time match its stored result is
+// skipped, so a restart only measures what was added or changed.
+//
+// Throttled so playback never waits on it: the threads run at low OS priority,
+// there is one fewer than there are cores, and each one sleeps after every
+// chunk so it is busy at most 'maxLoad' of the time.
+class LoudnessAnalyzer {
+public:
+    static constexpr double DefaultLoad = 0.5;
+
+    struct Progress {
+        std::size_t queued = 0;    // Files handed to analyze() so far
+        std::size_t measured = 0;  // Decoded and measured this session
+        std::size_t unchanged = 0; // Already measured in an earlier session
+        std::size_t failed = 0;    // Couldn't be opened
+        double busySeconds = 0.0;  // Decoding and measuring, summed over threads
+        double audioSeconds = 0.0; // Of the files measured
+
+        std::size_t done() const { return measured + unchanged + failed; }
+        bool finished() const { return done() == queued; }
+    };
+
+    // 'store' must outlive the analyzer. 0 threads = one per core, less one.
+    LoudnessAnalyzer(LoudnessStore& store, std::string storePath, unsigned threads = 0,
+                     double maxLoad = DefaultLoad);
+
+    // Abandons what isn't measured yet and saves the rest
+    ~LoudnessAnalyzer();
+
+    LoudnessAnalyzer(const LoudnessAnalyzer&) = delete;
+    LoudnessAnalyzer& operator=(const LoudnessAnalyzer&) = delete;
+
+    // Called on an analysis thread a few times a second while work is going
+    // on, and once when the last queued file is done. Set before analyze().
+    void setProgressCallback(std::function<void()> callback);
+
+    // Queue files; returns at once
+    void analyze(const std::vector<std::string>& paths);
+
+    Progress progress() const;
+
+private:
+    LoudnessStore& store;
+    std::string storePath;
+    double maxLoad;
+    std::function<void()> onProgress;
+
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::size_t> queued{ 0 };
+    std::atomic<std::size_t> measured{ 0 };
+    std::atomic<std::size_t> unchanged{ 0 };
+    std::atomic<std::size_t> failed{ 0 };
+    std::atomic<std::int64_t> busyNs{ 0 };
+    std::atomic<std::int64_t> audioMs{ 0 };
+    std::atomic<std::int64_t> lastReportNs{ 0 };
+
+    std::mutex saveLock;
+    std::size_t savedMeasured = 0; // 'measured' as of the last save
+
+    std::unique_ptr<ThreadPool> pool; // Last: its threads use everything above
+
+    void analyzeFiles(const std::vector<std::string>& paths);
+    bool measure(const std::string& path, LoudnessInfo& info); // Decode the whole file
+    void fileDone();
+    void save(std::size_t minNew);
+};
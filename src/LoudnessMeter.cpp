@@ -0,0 +1,226 @@
+#include "LoudnessMeter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// SSE2 is part of x86-64, so no run-time check is needed
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define HIVE_LOUDNESS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    const double SampleScale = 1.0 / 32768.0;
+    const double AbsoluteGate = -70.0; // LUFS
+    const double RelativeGate = -10.0; // LU below the absolute-gated loudness
+
+    // BS.1770-4 Annex 2: 4x interpolation, 48 taps as 4 phases of 12.
+    // Stored tap-major, so one tap of all four phases loads as one vector.
+    alignas(16) const float PeakFilter[12][4] = {
+        {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+        {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+        { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+        {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+        { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+        {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+        {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+        { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+        {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+        { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+        {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+        { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f },
+    };
+
+    double blockLoudness(double energy) {
+        return -0.691 + 10.0 * log10(energy);
+    }
+}
+
+LoudnessMeter::LoudnessMeter(unsigned sampleRate, unsigned channelCount)
+    : rate(max(sampleRate, 1u)), channels(max(channelCount, 1u)), weights(channels, 1.0), state(channels),
+      history(channels), stepFrames(max<size_t>(rate / 10, 1)) {
+    // The K-weighting filters, derived for any sample rate (the standard only
+    // tabulates 48 kHz; these reproduce its coefficients there)
+    const double pi = 3.14159265358979323846;
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        double k = tan(pi * f0 / rate);
+        double vh = pow(10.0, gainDb / 20.0);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                  2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        double k = tan(pi * f0 / rate);
+        double a0 = 1.0 + k / q + k * k;
+        highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    // L R C LFE Ls Rs, and the same without the LFE
+    if (channels == 6) weights = { 1.0, 1.0, 1.0, 0.0, 1.41, 1.41 };
+    else if (channels == 5) weights = { 1.0, 1.0, 1.0, 1.41, 1.41 };
+
+    steps.reserve(3000); // Five minutes
+}
+
+void LoudnessMeter::add(const int16_t* interleaved, size_t frames) {
+    while (frames > 0) {
+        // Never across a step boundary
+        size_t n = min(frames, stepFrames - stepFilled);
+        filter(interleaved, n);
+        measurePeaks(interleaved, n);
+        stepFilled += n;
+        totalFrames += n;
+        interleaved += n * channels;
+        frames -= n;
+        if (stepFilled == stepFrames) endStep();
+    }
+}
+
+void LoudnessMeter::filter(const int16_t* interleaved, size_t frames) {
+    unsigned c = 0;
+#ifdef HIVE_LOUDNESS_SSE2
+    // Two channels per register: the recursion is serial in time, not across channels
+    const __m128d scale = _mm_set1_pd(SampleScale);
+    const __m128d sb0 = _mm_set1_pd(shelf.b0), sb1 = _mm_set1_pd(shelf.b1), sb2 = _mm_set1_pd(shelf.b2);
+    const __m128d sa1 = _mm_set1_pd(shelf.a1), sa2 = _mm_set1_pd(shelf.a2);
+    const __m128d hb0 = _mm_set1_pd(highPass.b0), hb1 = _mm_set1_pd(highPass.b1), hb2 = _mm_set1_pd(highPass.b2);
+    const __m128d ha1 = _mm_set1_pd(highPass.a1), ha2 = _mm_set1_pd(highPass.a2);
+    for (; c + 1 < channels; c += 2) {
+        ChannelState& left = state[c];
+        ChannelState& right = state[c + 1];
+        __m128d z1 = _mm_set_pd(right.z1, left.z1), z2 = _mm_set_pd(right.z2, left.z2);
+        __m128d w1 = _mm_set_pd(right.w1, left.w1), w2 = _mm_set_pd(right.w2, left.w2);
+        __m128d energy = _mm_setzero_pd();
+
+        const int16_t* in = interleaved + c;
+        for (size_t f = 0; f < frames; f++, in += channels) {
+            __m128d x = _mm_mul_pd(_mm_set_pd(in[1], in[0]), scale);
+            __m128d y = _mm_add_pd(_mm_mul_pd(sb0, x), z1);
+            z1 = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(sb1, x), z2), _mm_mul_pd(sa1, y));
+            z2 = _mm_sub_pd(_mm_mul_pd(sb2, x), _mm_mul_pd(sa2, y));
+            __m128d k = _mm_add_pd(_mm_mul_pd(hb0, y), w1);
+            w1 = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(hb1, y), w2), _mm_mul_pd(ha1, k));
+            w2 = _mm_sub_pd(_mm_mul_pd(hb2, y), _mm_mul_pd(ha2, k));
+            energy = _mm_add_pd(energy, _mm_mul_pd(k, k));
+        }
+
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, z1);
+        left.z1 = lanes[0], right.z1 = lanes[1];
+        _mm_store_pd(lanes, z2);
+        left.z2 = lanes[0], right.z2 = lanes[1];
+        _mm_store_pd(lanes, w1);
+        left.w1 = lanes[0], right.w1 = lanes[1];
+        _mm_store_pd(lanes, w2);
+        left.w2 = lanes[0], right.w2 = lanes[1];
+        _mm_store_pd(lanes, energy);
+        left.energy += lanes[0];
+        right.energy += lanes[1];
+    }
+#endif
+    for (; c < channels; c++) {
+        ChannelState& s = state[c];
+        const int16_t* in = interleaved + c;
+        for (size_t f = 0; f < frames; f++, in += channels) {
+            double x = *in * SampleScale;
+            double y = shelf.b0 * x + s.z1;
+            s.z1 = shelf.b1 * x + s.z2 - shelf.a1 * y;
+            s.z2 = shelf.b2 * x - shelf.a2 * y;
+            double k = highPass.b0 * y + s.w1;
+            s.w1 = highPass.b1 * y + s.w2 - highPass.a1 * k;
+            s.w2 = highPass.b2 * y - highPass.a2 * k;
+            s.energy += k * k;
+        }
+    }
+}
+
+void LoudnessMeter::measurePeaks(const int16_t* interleaved, size_t frames) {
+    for (unsigned c = 0; c < channels; c++) {
+        PeakHistory& h = history[c];
+        const int16_t* in = interleaved + c;
+#ifdef HIVE_LOUDNESS_SSE2
+        // All four interpolated phases of one input sample in one register
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128 peaks = _mm_set1_ps(peak);
+        for (size_t f = 0; f < frames; f++, in += channels) {
+            float x = static_cast<float>(*in * SampleScale);
+            h.samples[h.next] = h.samples[h.next + PeakTaps] = x;
+            h.next = h.next + 1 == PeakTaps ? 0 : h.next + 1;
+
+            const float* window = h.samples + h.next; // Oldest first
+            __m128 sum = _mm_mul_ps(_mm_set1_ps(window[0]), _mm_load_ps(PeakFilter[0]));
+            for (unsigned t = 1; t < PeakTaps; t++) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(window[t]), _mm_load_ps(PeakFilter[t])));
+            }
+            peaks = _mm_max_ps(peaks, _mm_and_ps(sum, absMask));
+            peaks = _mm_max_ps(peaks, _mm_set1_ps(fabsf(x)));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, peaks);
+        peak = max({ lanes[0], lanes[1], lanes[2], lanes[3] });
+#else
+        for (size_t f = 0; f < frames; f++, in += channels) {
+            float x = static_cast<float>(*in * SampleScale);
+            h.samples[h.next] = h.samples[h.next + PeakTaps] = x;
+            h.next = h.next + 1 == PeakTaps ? 0 : h.next + 1;
+
+            const float* window = h.samples + h.next;
+            float sum[4] = {};
+            for (unsigned t = 0; t < PeakTaps; t++) {
+                for (unsigned p = 0; p < 4; p++) sum[p] += window[t] * PeakFilter[t][p];
+            }
+            for (float s : sum) peak = max(peak, fabsf(s));
+            peak = max(peak, fabsf(x));
+        }
+#endif
+    }
+}
+
+void LoudnessMeter::endStep() {
+    double energy = 0.0;
+    for (unsigned c = 0; c < channels; c++) {
+        energy += weights[c] * state[c].energy;
+        state[c].energy = 0.0;
+    }
+    steps.push_back(energy / static_cast<double>(stepFrames));
+    stepFilled = 0;
+}
+
+double LoudnessMeter::integratedLufs() const {
+    // 400 ms blocks, 75% overlap: four consecutive steps each
+    vector<double> blocks;
+    if (steps.size() >= 4) blocks.reserve(steps.size() - 3);
+    for (size_t i = 0; i + 3 < steps.size(); i++) {
+        double energy = (steps[i] + steps[i + 1] + steps[i + 2] + steps[i + 3]) / 4.0;
+        if (energy > 0.0 && blockLoudness(energy) > AbsoluteGate) blocks.push_back(energy);
+    }
+    if (blocks.empty()) return -numeric_limits<double>::infinity();
+
+    double sum = 0.0;
+    for (double energy : blocks) sum += energy;
+    double threshold = blockLoudness(sum / static_cast<double>(blocks.size())) + RelativeGate;
+
+    double gated = 0.0;
+    size_t count = 0;
+    for (double energy : blocks) {
+        if (blockLoudness(energy) > threshold) {
+            gated += energy;
+            count++;
+        }
+    }
+    if (count == 0) return -numeric_limits<double>::infinity();
+    return blockLoudness(gated / static_cast<double>(count));
+}
+
+double LoudnessMeter::truePeak() const {
+    return peak;
+}
+
+double LoudnessMeter::seconds() const {
+    return static_cast<double>(totalFrames) / rate;
+}
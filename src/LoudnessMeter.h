@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Integrated loudness and true peak of one track, per ITU-R BS.1770-4 / EBU R128.
+//
+// Samples go through the K-weighting filter (a high shelf and a high pass),
+// their energy is summed over 100 ms steps, and the 400 ms blocks made of four
+// consecutive steps are gated: absolutely at -70 LUFS, then 10 LU below the
+// loudness of what passed. True peak is the largest absolute value of the
+// signal upsampled 4x with the standard's 48-tap interpolation filter.
+//
+// Channels are filtered two at a time in SSE2 registers where available.
+// Not thread-safe; one meter per track.
+class LoudnessMeter {
+public:
+    LoudnessMeter(unsigned sampleRate, unsigned channels);
+
+    // Interleaved 16-bit samples; any number of whole frames per call
+    void add(const std::int16_t* interleaved, std::size_t frames);
+
+    // LUFS; -infinity if nothing passed the gates (silence, or under 400 ms)
+    double integratedLufs() const;
+
+    // Linear, 1.0 = full scale (dBTP = 20 * log10)
+    double truePeak() const;
+
+    double seconds() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    // Both K-weighting stages, transposed direct form II
+    struct ChannelState {
+        double z1 = 0.0, z2 = 0.0; // Shelf
+        double w1 = 0.0, w2 = 0.0; // High pass
+        double energy = 0.0;       // Of the current step
+    };
+
+    static constexpr unsigned PeakTaps = 12; // Per phase of the 4x interpolator
+
+    // Last PeakTaps samples of one channel, stored twice so the window is contiguous
+    struct PeakHistory {
+        float samples[2 * PeakTaps] = {};
+        unsigned next = 0;
+    };
+
+    unsigned rate;
+    unsigned channels;
+    Biquad shelf;
+    Biquad highPass;
+    std::vector<double> weights; // Per channel; surrounds count 1.41, LFE not at all
+    std::vector<ChannelState> state;
+    std::vector<PeakHistory> history;
+    float peak = 0.0f;
+
+    std::size_t stepFrames; // 100 ms
+    std::size_t stepFilled = 0;
+    std::vector<double> steps; // Weighted energy of each complete step
+    std::uint64_t totalFrames = 0;
+
+    void filter(const std::int16_t* interleaved, std::size_t frames);
+    void measurePeaks(const std::int16_t* interleaved, std::size_t frames);
+    void endStep();
+};
@@ -0,0 +1,138 @@
+#include "LoudnessStore.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+
+using namespace std;
+
+namespace {
+    const char Magic[] = "HIVELOUDNESS";
+
+    void setError(string* error, const string& message) {
+        if (error) *error = message;
+    }
+
+    // Next tab-separated field of 'line' from 'pos'; false if there is no tab left
+    bool nextField(const string& line, size_t& pos, string& field) {
+        size_t tab = line.find('\t', pos);
+        if (tab == string::npos) return false;
+        field.assign(line, pos, tab - pos);
+        pos = tab + 1;
+        return true;
+    }
+}
+
+//----------------------------------------------------
+bool LoudnessStore::load(const string& path, string* error) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        setError(error, "No loudness store at " + path);
+        return false;
+    }
+
+    string line;
+    if (!getline(in, line) || line != string(Magic) + " " + to_string(Version)) {
+        setError(error, "Loudness store has an unknown format or version");
+        return false;
+    }
+
+    unordered_map<string, LoudnessInfo> loaded;
+    string modified, size, lufs, peak;
+    while (getline(in, line)) {
+        size_t pos = 0;
+        if (!nextField(line, pos, modified) || !nextField(line, pos, size) || !nextField(line, pos, lufs) ||
+            !nextField(line, pos, peak) || pos >= line.size()) {
+            continue; // A torn last line: that one file gets measured again
+        }
+        LoudnessInfo info;
+        info.modified = strtoll(modified.c_str(), nullptr, 10);
+        info.size = strtoull(size.c_str(), nullptr, 10);
+        info.integratedLufs = strtof(lufs.c_str(), nullptr);
+        info.truePeak = strtof(peak.c_str(), nullptr);
+        loaded[line.substr(pos)] = info;
+    }
+
+    unique_lock<shared_mutex> guard(lock);
+    entries = std::move(loaded);
+    return true;
+}
+
+bool LoudnessStore::save(const string& path, string* error) const {
+    // Formatted under the lock, written without it
+    ostringstream text;
+    text << Magic << " " << Version << "\n";
+    {
+        shared_lock<shared_mutex> guard(lock);
+        for (const auto& [trackPath, info] : entries) {
+            if (trackPath.find('\n') != string::npos) continue; // Can't be stored in a line; measured again next time
+            text << info.modified << "\t" << info.size << "\t" << info.integratedLufs << "\t" << info.truePeak << "\t"
+                 << trackPath << "\n";
+        }
+    }
+
+    string tempPath = path + ".tmp";
+    {
+        ofstream out(tempPath, ios::binary | ios::trunc);
+        if (!out) {
+            setError(error, "Cannot write " + tempPath);
+            return false;
+        }
+        string bytes = text.str();
+        out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+        if (!out) {
+            setError(error, "Write failed: " + tempPath);
+            return false;
+        }
+    }
+
+    error_code ec;
+    filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        setError(error, "Cannot replace " + path + ": " + ec.message());
+        filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LoudnessStore::find(const string& trackPath, LoudnessInfo& out) const {
+    int64_t modified;
+    uint64_t size;
+    LoudnessInfo info;
+    if (!findAny(trackPath, info) || !stamp(trackPath, modified, size)) return false;
+    if (info.modified != modified || info.size != size) return false;
+    out = info;
+    return true;
+}
+
+bool LoudnessStore::findAny(const string& trackPath, LoudnessInfo& out) const {
+    shared_lock<shared_mutex> guard(lock);
+    auto found = entries.find(trackPath);
+    if (found == entries.end()) return false;
+    out = found->second;
+    return true;
+}
+
+void LoudnessStore::put(const string& trackPath, const LoudnessInfo& info) {
+    unique_lock<shared_mutex> guard(lock);
+    entries[trackPath] = info;
+}
+
+size_t LoudnessStore::size() const {
+    shared_lock<shared_mutex> guard(lock);
+    return entries.size();
+}
+
+bool LoudnessStore::stamp(const string& trackPath, int64_t& modified, uint64_t& size) {
+    error_code ec;
+    auto time = filesystem::last_write_time(trackPath, ec);
+    if (ec) return false;
+    auto bytes = filesystem::file_size(trackPath, ec);
+    if (ec) return false;
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    size = static_cast<uint64_t>(bytes);
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// What the analysis found for one file, and which version of the file it was
+struct LoudnessInfo {
+    // ReplayGain 2.0 puts its reference level here
+    static constexpr float ReferenceLufs = -18.0f;
+
+    std::int64_t modified = 0; // File's last write time, in filesystem clock ticks
+    std::uint64_t size = 0;
+    float integratedLufs = 0.0f; // -infinity for silence
+    float truePeak = 0.0f;       // Linear
+
+    bool hasLoudness() const { return std::isfinite(integratedLufs); }
+
+    // Gain that brings the track to the reference level
+    float gainDb() const { return ReferenceLufs - integratedLufs; }
+};
+
+// Loudness of every analysed file, keyed by path and persisted between runs
+// (hive_loudness.db next to the library snapshot). A result only counts while
+// the file's size and modification time still match the ones it was measured
+// at, so an edited or replaced file is analysed again and nothing else is.
+//
+// File format: one header line "HIVELOUDNESS <version>", then one line per
+// file: modified, size, LUFS, true peak and path, tab-separated.
+//
+// Thread-safe: analysis threads write while the playback side reads.
+class LoudnessStore {
+public:
+    static const int Version = 1;
+
+    // Replaces the contents. Fails if the file is missing or not a loudness store.
+    bool load(const std::string& path, std::string* error = nullptr);
+
+    // Writes to a temporary file first and renames it over 'path'
+    bool save(const std::string& path, std::string* error = nullptr) const;
+
+    // The result for 'trackPath', if there is one for the file as it is now on disk
+    bool find(const std::string& trackPath, LoudnessInfo& out) const;
+
+    // The stored result, however old
+    bool findAny(const std::string& trackPath, LoudnessInfo& out) const;
+
+    void put(const std::string& trackPath, const LoudnessInfo& info);
+
+    std::size_t size() const;
+
+    // The file's current modification time and size; false if it can't be read
+    static bool stamp(const std::string& trackPath, std::int64_t& modified, std::uint64_t& size);
+
+private:
+    mutable std::shared_mutex lock;
+    std::unordered_map<std::string, LoudnessInfo> entries;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// ==========================================
+// Node allocators for DoublyLinkedList<T>
+// ==========================================
+// Both allocators expose the same tiny interface:
+//     NodeT* create(args...)   -> construct a node in place
+//     void   destroy(NodeT*)   -> destroy it and give the memory back
+//     operator==               -> true when nodes from one may be freed by the other
+//
+// Copies of an allocator share the same storage, so two lists built with the
+// same allocator may free each other's nodes.
+
+// Slab/arena pool: nodes are carved out of big slabs and recycled through an
+// intrusive free list. One heap allocation per slab instead of one per node.
+// Not thread-safe: a pool must only be used by one thread at a time.
+// Nodes must be destroyed by their lists before the last copy of the pool goes away.
+template <typename NodeT>
+class NodePool {
+private:
+    union Slot {
+        Slot* nextFree;
+        alignas(NodeT) unsigned char storage[sizeof(NodeT)];
+    };
+
+    struct Storage {
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        Slot* freeList = nullptr;
+        std::size_t slotsPerSlab;
+        std::size_t freeSlots = 0;
+        std::size_t liveNodes = 0;
+
+        explicit Storage(std::size_t perSlab) : slotsPerSlab(perSlab) {}
+        Storage(const Storage&) = delete;
+        Storage& operator=(const Storage&) = delete;
+
+        void grow() {
+            slabs.emplace_back(new Slot[slotsPerSlab]);
+            Slot* slab = slabs.back().get();
+
+            // Thread the fresh slots onto the free list (in address order)
+            for (std::size_t i = slotsPerSlab; i-- > 0;) {
+                slab[i].nextFree = freeList;
+                freeList = &slab[i];
+            }
+            freeSlots += slotsPerSlab;
+        }
+    };
+
+    std::shared_ptr<Storage> pool;
+
+public:
+    static constexpr std::size_t DefaultSlabSize = 1024;
+
+    explicit NodePool(std::size_t nodesPerSlab = DefaultSlabSize)
+        : pool(std::make_shared<Storage>(nodesPerSlab > 0 ? nodesPerSlab : 1)) {}
+
+    template <typename... Args>
+    NodeT* create(Args&&... args) {
+        if (pool->freeList == nullptr) {
+            pool->grow();
+        }
+
+        Slot* slot = pool->freeList;
+        pool->freeList = slot->nextFree;
+        pool->freeSlots--;
+
+        NodeT* newNode;
+        try {
+            newNode = ::new (static_cast<void*>(slot->storage)) NodeT(std::forward<Args>(args)...);
+        } catch (...) {
+            slot->nextFree = pool->freeList;
+            pool->freeList = slot;
+            pool->freeSlots++;
+            throw;
+        }
+        pool->liveNodes++;
+        return newNode;
+    }
+
+    void destroy(NodeT* target) {
+        if (target == nullptr) return;
+
+        target->~NodeT();
+        Slot* slot = reinterpret_cast<Slot*>(target);
+        slot->nextFree = pool->freeList;
+        pool->freeList = slot;
+        pool->freeSlots++;
+        pool->liveNodes--;
+    }
+
+    // Make sure at least 'count' nodes can be created without touching the heap again
+    void reserve(std::size_t count) {
+        while (pool->freeSlots < count) {
+            pool->grow();
+        }
+    }
+
+    std::size_t slabCount() const { return pool->slabs.size(); }
+    std::size_t liveNodes() const { return pool->liveNodes; }
+
+    bool operator==(const NodePool& other) const { return pool == other.pool; }
+    bool operator!=(const NodePool& other) const { return pool != other.pool; }
+};
+
+// Plain new/delete per node (the original behaviour). Stateless, so any two
+// instances are interchangeable.
+template <typename NodeT>
+class HeapNodeAllocator {
+public:
+    template <typename... Args>
+    NodeT* create(Args&&... args) {
+        return new NodeT(std::forward<Args>(args)...);
+    }
+
+    void destroy(NodeT* target) {
+        delete target;
+    }
+
+    void reserve(std::size_t) {}
+
+    bool operator==(const HeapNodeAllocator&) const { return true; }
+    bool operator!=(const HeapNodeAllocator&) const { return false; }
+};
@@ -0,0 +1,142 @@
+#include "NullOutput.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    // Behind this much, real-time pacing gives up catching up and starts afresh
+    const auto MaxLag = chrono::milliseconds(100);
+
+    void put16(ofstream& out, uint16_t v) {
+        char bytes[2] = { static_cast<char>(v & 0xFF), static_cast<char>(v >> 8) };
+        out.write(bytes, 2);
+    }
+
+    void put32(ofstream& out, uint32_t v) {
+        put16(out, static_cast<uint16_t>(v & 0xFFFF));
+        put16(out, static_cast<uint16_t>(v >> 16));
+    }
+}
+
+NullOutput::NullOutput(Pacing p, const string& wavPath) : pacing(p) {
+    if (!wavPath.empty()) wav.open(wavPath, ios::binary | ios::trunc);
+}
+
+NullOutput::~NullOutput() {
+    stop();
+    finishWav();
+}
+
+void NullOutput::initialize(unsigned channelCount, unsigned sampleRate, const vector<sf::SoundChannel>&) {
+    channels = channelCount;
+    rate = sampleRate;
+    if (!wav.is_open()) return;
+
+    if (wavChannels == 0) {
+        // RIFF header with the sizes left at zero until finishWav()
+        wavChannels = channels;
+        wavRate = rate;
+        wav.write("RIFF", 4);
+        put32(wav, 0);
+        wav.write("WAVEfmt ", 8);
+        put32(wav, 16);
+        put16(wav, 1); // PCM
+        put16(wav, static_cast<uint16_t>(channels));
+        put32(wav, rate);
+        put32(wav, rate * channels * 2);
+        put16(wav, static_cast<uint16_t>(channels * 2));
+        put16(wav, 16);
+        wav.write("data", 4);
+        put32(wav, 0);
+    } else if (channels != wavChannels || rate != wavRate) {
+        finishWav();
+    }
+}
+
+void NullOutput::play() {
+    Status current = state.load();
+    if (current == Status::Playing) return;
+    if (current == Status::Paused) {
+        {
+            lock_guard<mutex> guard(lock);
+            state = Status::Playing;
+        }
+        resumed.notify_all();
+        return;
+    }
+
+    // Stopped: the last run may have ended by itself and still needs joining
+    if (worker.joinable()) worker.join();
+    if (feed == nullptr || channels == 0 || rate == 0) return;
+    stopping = false;
+    state = Status::Playing;
+    worker = thread([this] { run(); });
+}
+
+void NullOutput::pause() {
+    lock_guard<mutex> guard(lock);
+    if (state == Status::Playing) state = Status::Paused;
+}
+
+void NullOutput::stop() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    resumed.notify_all();
+    if (worker.joinable()) worker.join();
+    state = Status::Stopped;
+    if (feed != nullptr) feed->seekTo(chrono::microseconds(0));
+}
+
+void NullOutput::run() {
+    Clock::time_point due = Clock::now();
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            if (state == Status::Paused) {
+                resumed.wait(guard, [&] { return stopping || state != Status::Paused; });
+                due = Clock::now();
+            }
+            if (stopping) return;
+        }
+
+        const int16_t* samples = nullptr;
+        size_t count = 0;
+        bool more = feed->nextChunk(samples, count);
+        pulled.fetch_add(count, memory_order_relaxed);
+        writeWav(samples, count);
+        if (!more) {
+            state = Status::Stopped;
+            return;
+        }
+
+        if (pacing == Pacing::RealTime) {
+            // Sleep off the chunk's playing time, so the feed sees a real device's pace
+            due += chrono::nanoseconds(static_cast<int64_t>(count * 1000000000ull / (static_cast<uint64_t>(channels) * rate)));
+            due = max(due, Clock::now() - MaxLag);
+            unique_lock<mutex> guard(lock);
+            resumed.wait_until(guard, due, [&] { return stopping.load(); });
+            if (stopping) return;
+        }
+    }
+}
+
+void NullOutput::writeWav(const int16_t* samples, size_t count) {
+    if (!wav.is_open() || count == 0) return;
+    // Samples are already little-endian on every platform we build for
+    wav.write(reinterpret_cast<const char*>(samples), static_cast<streamsize>(count * sizeof(int16_t)));
+    wavBytes += count * sizeof(int16_t);
+}
+
+void NullOutput::finishWav() {
+    if (!wav.is_open()) return;
+    if (wavChannels != 0) {
+        uint32_t data = static_cast<uint32_t>(min<uint64_t>(wavBytes, 0xFFFFFFFFu - 36));
+        wav.seekp(4);
+        put32(wav, 36 + data);
+        wav.seekp(40);
+        put32(wav, data);
+    }
+    wav.close();
+}
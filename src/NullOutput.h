@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "AudioOutput.h"
+
+// An output with no sound card behind it, for headless hosts and CI.
+// Its thread pulls chunks either at the speed they would play (so tracks
+// last as long as they should and the player behaves as usual) or as fast
+// as the feed can decode them. Optionally everything pulled is written to a
+// 16-bit WAV file; a later change of format ends what goes into the file.
+class NullOutput : public AudioOutput {
+public:
+    enum class Pacing { RealTime, Unpaced };
+
+    explicit NullOutput(Pacing pacing = Pacing::RealTime, const std::string& wavPath = std::string());
+    ~NullOutput() override;
+
+    NullOutput(const NullOutput&) = delete;
+    NullOutput& operator=(const NullOutput&) = delete;
+
+    void attach(AudioFeed& feed) override { this->feed = &feed; }
+    void initialize(unsigned channels, unsigned sampleRate, const std::vector<sf::SoundChannel>& channelMap) override;
+    void play() override;
+    void pause() override;
+    void stop() override;
+    Status status() const override { return state.load(); }
+    const char* name() const override { return pacing == Pacing::RealTime ? "null" : "null (unpaced)"; }
+
+    // Samples pulled since construction
+    std::uint64_t samplesPulled() const { return pulled.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Pacing pacing;
+    AudioFeed* feed = nullptr;
+    unsigned channels = 0;
+    unsigned rate = 0;
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable resumed;
+    std::atomic<Status> state{ Status::Stopped };
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::uint64_t> pulled{ 0 };
+
+    std::ofstream wav;
+    unsigned wavChannels = 0;
+    unsigned wavRate = 0;
+    std::uint64_t wavBytes = 0;
+
+    void run();
+    void writeWav(const std::int16_t* samples, std::size_t count);
+    void finishWav();
+};
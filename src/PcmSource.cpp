@@ -0,0 +1,80 @@
+#include "PcmSource.h"
+#include <algorithm>
+#include <cstring>
+#include "Dsp.h"
+
+using namespace std;
+
+bool PcmSource::open(const string& path, unsigned prerollMs) {
+    if (!file.openFromFile(path)) return false;
+    return prime(path, prerollMs);
+}
+
+bool PcmSource::openFromMemory(const string& path, shared_ptr<const vector<char>> bytes, unsigned prerollMs) {
+    if (!bytes || !file.openFromMemory(bytes->data(), bytes->size())) return false;
+    memory = std::move(bytes);
+    return prime(path, prerollMs);
+}
+
+bool PcmSource::prime(const string& path, unsigned prerollMs) {
+    filePath = path;
+    channels = file.getChannelCount();
+    rate = file.getSampleRate();
+    if (channels == 0 || rate == 0) return false;
+
+    // Whole frames only, so the decoder is left on a frame boundary
+    size_t frames = static_cast<size_t>(rate) * prerollMs / 1000;
+    preroll.resize(frames * channels);
+    size_t got = static_cast<size_t>(file.read(preroll.data(), preroll.size()));
+    preroll.resize(got - got % channels);
+    prerollPos = 0;
+    position = 0;
+    return true;
+}
+
+size_t PcmSource::read(int16_t* out, size_t maxSamples) {
+    size_t written = 0;
+
+    if (prerollPos < preroll.size()) {
+        written = min(maxSamples, preroll.size() - prerollPos);
+        memcpy(out, preroll.data() + prerollPos, written * sizeof(int16_t));
+        prerollPos += written;
+    }
+
+    if (written < maxSamples) {
+        written += static_cast<size_t>(file.read(out + written, maxSamples - written));
+    }
+    position += written;
+    return written;
+}
+
+void PcmSource::seek(sf::Time offset) {
+    if (channels == 0) return;
+
+    uint64_t frame = static_cast<uint64_t>(max<int64_t>(offset.asMicroseconds(), 0)) * rate / 1000000;
+    uint64_t sample = frame * channels;
+    position = sample;
+
+    // Seeking back into the preroll (e.g. a replay from 0) costs no decoding
+    if (sample < preroll.size()) {
+        prerollPos = static_cast<size_t>(sample);
+        file.seek(static_cast<uint64_t>(preroll.size()));
+    } else {
+        prerollPos = preroll.size();
+        file.seek(sample);
+    }
+}
+
+uint64_t PcmSource::remaining() const {
+    uint64_t total = file.getSampleCount();
+    return total > position ? total - position : 0;
+}
+
+void PcmSource::setReplayGain(float gainDb, float peak) {
+    gain = Dsp::dbToGain(gainDb);
+    if (peak > 0.0f && gain * peak > 1.0f) gain = 1.0f / peak; // ReplayGain's clipping prevention
+}
+
+bool PcmSource::sameFormat(const PcmSource& other) const {
+    return channels == other.channels && rate == other.rate && channelMap() == other.channelMap();
+}
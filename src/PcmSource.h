@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SFML/Audio.hpp>
+
+// A decoder for one track whose first few hundred milliseconds are decoded
+// ahead of time, so the first read after opening never waits on the codec.
+// Reads come from the preroll buffer first, then straight from the decoder.
+// Not thread-safe: it is opened on one thread and then read by one other.
+class PcmSource {
+public:
+    static constexpr unsigned DefaultPrerollMs = 300;
+
+    PcmSource() = default;
+    PcmSource(const PcmSource&) = delete;
+    PcmSource& operator=(const PcmSource&) = delete;
+
+    bool open(const std::string& path, unsigned prerollMs = DefaultPrerollMs);
+
+    // Decode a file that is already in memory (e.g. from a TrackCache); the
+    // source keeps 'bytes' alive for as long as it lives
+    bool openFromMemory(const std::string& path, std::shared_ptr<const std::vector<char>> bytes,
+                        unsigned prerollMs = DefaultPrerollMs);
+
+    // Interleaved 16-bit samples; returns 0 at the end of the track
+    std::size_t read(std::int16_t* out, std::size_t maxSamples);
+    void seek(sf::Time offset);
+
+    const std::string& path() const { return filePath; }
+    unsigned channelCount() const { return channels; }
+    unsigned sampleRate() const { return rate; }
+    const std::vector<sf::SoundChannel>& channelMap() const { return file.getChannelMap(); }
+
+    // Same channel layout and rate: one stream can play both without reinitialising
+    bool sameFormat(const PcmSource& other) const;
+
+    // Samples (all channels) left to read; 0 if the decoder can't tell
+    std::uint64_t remaining() const;
+
+    // The track's ReplayGain values, set by whoever opened it (before it plays)
+    void setReplayGain(float gainDb, float peak);
+
+    // Linear gain that brings the track to ReplayGain reference level,
+    // lowered where needed so its peak stays below full scale (1.0 if untagged)
+    float replayGain() const { return gain; }
+
+private:
+    std::shared_ptr<const std::vector<char>> memory; // Declared before 'file', which reads from it
+    sf::InputSoundFile file;
+    std::string filePath;
+    unsigned channels = 0;
+    unsigned rate = 0;
+    std::vector<std::int16_t> preroll;
+    std::size_t prerollPos = 0;
+    std::uint64_t position = 0; // Samples handed out since the start of the track
+    float gain = 1.0f;
+
+    bool prime(const std::string& path, unsigned prerollMs); // Format + preroll, once the file is open
+};
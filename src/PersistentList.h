@@ -0,0 +1,349 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+
+// An immutable-node sequence with structural sharing: copying a list is O(1)
+// and an edit copies only the O(log n) nodes on the path to it, so any number
+// of lists can be derived from one another and each costs only its edits.
+//
+// A weight-balanced tree (each side holds at least a quarter of a subtree),
+// kept that way purely by join(left, value, right), which every operation is
+// built from: split a list at a position and join the pieces around the
+// change. Nodes are reference counted, so a subtree is freed when the last
+// list using it lets go. A node referenced only once is still copied on
+// edit; the old one goes straight back to the pool.
+//
+// The repo's other position trees are treaps, but a treap's random
+// priorities would be copied along with its nodes: a list assembled from
+// overlapping slices of another repeats priorities and can lose its balance.
+// Weight balance depends on sizes alone, so it holds whatever the history.
+//
+// Positions are 0-based here (this is a value type, not a playlist).
+// Not thread-safe, the reference counts included: lists that share nodes
+// must be used from one thread at a time. Lists may only share nodes (append)
+// if they use the same allocator.
+template <typename T, template <typename> class Allocator = NodePool>
+class PersistentList {
+private:
+    struct Node {
+        T value;
+        Node* left;
+        Node* right;
+        std::uint32_t size;
+        std::uint32_t refs;
+
+        Node(Node* l, T v, Node* r)
+            : value(std::move(v)), left(l), right(r), size(sizeOf(l) + sizeOf(r) + 1), refs(1) {}
+    };
+
+public:
+    using NodeAllocator = Allocator<Node>;
+
+private:
+    NodeAllocator alloc; // Before 'root': nodes go back to it when the root is released
+    Node* root;
+
+    static std::uint32_t sizeOf(const Node* n) { return n != nullptr ? n->size : 0; }
+
+    // Weights (size + 1) within a factor of 3 of each other, i.e. alpha = 1/4,
+    // which join's rebalancing needs to be at most 1 - 1/sqrt(2)
+    static bool balanced(std::uint32_t a, std::uint32_t b) {
+        std::uint64_t wa = std::uint64_t(a) + 1, wb = std::uint64_t(b) + 1;
+        return 3 * wa >= wb && 3 * wb >= wa;
+    }
+
+    static Node* retain(Node* n) {
+        if (n != nullptr) n->refs++;
+        return n;
+    }
+
+    // Every function below takes ownership of the references it is passed
+    // and returns owned ones; a value is taken by copy or move.
+    void release(Node* n) {
+        while (n != nullptr && --n->refs == 0) {
+            Node* right = n->right;
+            release(n->left); // Depth is O(log n); the right spine is a loop
+            alloc.destroy(n);
+            n = right;
+        }
+    }
+
+    Node* make(Node* l, T value, Node* r) {
+        return alloc.create(l, std::move(value), r);
+    }
+
+    // Take a node apart: its children (owned) and its value
+    struct Parts {
+        Node* left;
+        T value;
+        Node* right;
+    };
+
+    Parts expose(Node* n) {
+        if (n->refs == 1) {
+            // Ours alone: hand its references over instead of counting them up and down
+            Parts parts{ n->left, std::move(n->value), n->right };
+            n->left = n->right = nullptr;
+            release(n);
+            return parts;
+        }
+        Parts parts{ retain(n->left), n->value, retain(n->right) };
+        release(n);
+        return parts;
+    }
+
+    Node* rotateLeft(Node* n) {
+        Parts top = expose(n);
+        Parts right = expose(top.right);
+        return make(make(top.left, std::move(top.value), right.left), std::move(right.value), right.right);
+    }
+
+    Node* rotateRight(Node* n) {
+        Parts top = expose(n);
+        Parts left = expose(top.left);
+        return make(left.left, std::move(left.value), make(left.right, std::move(top.value), top.right));
+    }
+
+    // 'l' much heavier than 'r': go down l's right spine until they balance
+    Node* joinRight(Node* l, T value, Node* r) {
+        if (balanced(sizeOf(l), sizeOf(r))) return make(l, std::move(value), r);
+        Parts top = expose(l);
+        Node* joined = joinRight(top.right, std::move(value), r);
+        if (balanced(sizeOf(top.left), sizeOf(joined))) return make(top.left, std::move(top.value), joined);
+        if (balanced(sizeOf(top.left), sizeOf(joined->left)) &&
+            balanced(sizeOf(top.left) + sizeOf(joined->left) + 1, sizeOf(joined->right))) {
+            return rotateLeft(make(top.left, std::move(top.value), joined));
+        }
+        return rotateLeft(make(top.left, std::move(top.value), rotateRight(joined)));
+    }
+
+    Node* joinLeft(Node* l, T value, Node* r) {
+        if (balanced(sizeOf(l), sizeOf(r))) return make(l, std::move(value), r);
+        Parts top = expose(r);
+        Node* joined = joinLeft(l, std::move(value), top.left);
+        if (balanced(sizeOf(joined), sizeOf(top.right))) return make(joined, std::move(top.value), top.right);
+        if (balanced(sizeOf(joined->right), sizeOf(top.right)) &&
+            balanced(sizeOf(joined->left), sizeOf(joined->right) + sizeOf(top.right) + 1)) {
+            return rotateRight(make(joined, std::move(top.value), top.right));
+        }
+        return rotateRight(make(rotateLeft(joined), std::move(top.value), top.right));
+    }
+
+    // Everything in 'l', then 'value', then everything in 'r', balanced
+    Node* join(Node* l, T value, Node* r) {
+        if (balanced(sizeOf(l), sizeOf(r))) return make(l, std::move(value), r);
+        if (sizeOf(l) > sizeOf(r)) return joinRight(l, std::move(value), r);
+        return joinLeft(l, std::move(value), r);
+    }
+
+    // The first 'count' values and the rest
+    std::pair<Node*, Node*> split(Node* n, std::uint32_t count) {
+        if (n == nullptr) return { nullptr, nullptr };
+        if (count == 0) return { nullptr, n };
+        if (count >= n->size) return { n, nullptr };
+        Parts parts = expose(n);
+        std::uint32_t leftSize = sizeOf(parts.left);
+        if (count <= leftSize) {
+            auto [first, rest] = split(parts.left, count);
+            return { first, join(rest, std::move(parts.value), parts.right) };
+        }
+        auto [first, rest] = split(parts.right, count - leftSize - 1);
+        return { join(parts.left, std::move(parts.value), first), rest };
+    }
+
+    // Concatenation with nothing in between
+    Node* join2(Node* l, Node* r) {
+        if (l == nullptr) return r;
+        if (r == nullptr) return l;
+        auto [rest, last] = takeLast(l);
+        return join(rest, std::move(last), r);
+    }
+
+    // The rest and the last value; 'n' is not empty
+    std::pair<Node*, T> takeLast(Node* n) {
+        Parts parts = expose(n);
+        if (parts.right == nullptr) return { parts.left, std::move(parts.value) };
+        auto [rest, last] = takeLast(parts.right);
+        return { join(parts.left, std::move(parts.value), rest), std::move(last) };
+    }
+
+    // 'n' is borrowed. Unchanged subtrees come back as they are (shared).
+    template <typename Pred>
+    Node* filter(Node* n, Pred& isDoomed, int& removed) {
+        if (n == nullptr) return nullptr;
+        Node* l = filter(n->left, isDoomed, removed);
+        bool doomed = isDoomed(n->value);
+        Node* r = filter(n->right, isDoomed, removed);
+        if (!doomed && l == n->left && r == n->right) {
+            release(l);
+            release(r);
+            return retain(n);
+        }
+        if (!doomed) return join(l, n->value, r);
+        removed++;
+        return join2(l, r);
+    }
+
+    Node* build(const T* values, std::uint32_t count) {
+        if (count == 0) return nullptr;
+        std::uint32_t middle = count / 2;
+        Node* l = build(values, middle);
+        Node* r = build(values + middle + 1, count - middle - 1);
+        return make(l, values[middle], r);
+    }
+
+public:
+    explicit PersistentList(const NodeAllocator& a = NodeAllocator()) : alloc(a), root(nullptr) {}
+
+    // O(n), perfectly balanced
+    PersistentList(const std::vector<T>& values, const NodeAllocator& a = NodeAllocator())
+        : alloc(a), root(build(values.data(), static_cast<std::uint32_t>(values.size()))) {}
+
+    // O(1): both lists share every node until one of them changes
+    PersistentList(const PersistentList& other) : alloc(other.alloc), root(retain(other.root)) {}
+    PersistentList(PersistentList&& other) noexcept : alloc(other.alloc), root(other.root) { other.root = nullptr; }
+
+    PersistentList& operator=(const PersistentList& other) {
+        Node* previous = root;
+        root = retain(other.root);
+        release(previous); // After the retain: 'other' may be a part of this list
+        alloc = other.alloc;
+        return *this;
+    }
+
+    PersistentList& operator=(PersistentList&& other) noexcept {
+        if (this != &other) {
+            Node* previous = root;
+            root = other.root;
+            other.root = nullptr;
+            release(previous);
+            alloc = other.alloc;
+        }
+        return *this;
+    }
+
+    ~PersistentList() { release(root); }
+
+    int size() const { return static_cast<int>(sizeOf(root)); }
+    bool isEmpty() const { return root == nullptr; }
+    const NodeAllocator& allocator() const { return alloc; }
+
+    // True if the two share their whole tree (one is an untouched copy of the other)
+    bool sharesAll(const PersistentList& other) const { return root == other.root; }
+
+    // --- Reads: O(log n) ---
+    const T& at(int position) const {
+        const Node* n = root;
+        std::uint32_t index = static_cast<std::uint32_t>(position);
+        while (true) {
+            std::uint32_t leftSize = sizeOf(n->left);
+            if (index < leftSize) {
+                n = n->left;
+            } else if (index == leftSize) {
+                return n->value;
+            } else {
+                index -= leftSize + 1;
+                n = n->right;
+            }
+        }
+    }
+
+    // visit(value) for 'count' values from 'first' on, in order: O(log n + count)
+    template <typename Visit>
+    void forEach(int first, int count, Visit&& visit) const {
+        const Node* stack[96]; // Depth is at most log_{4/3} of 2^32 ~ 77
+        int depth = 0;
+        std::uint32_t skip = static_cast<std::uint32_t>(first);
+        // Down to the first value, stacking the nodes still to visit
+        for (const Node* n = root; n != nullptr;) {
+            std::uint32_t leftSize = sizeOf(n->left);
+            if (skip < leftSize) {
+                stack[depth++] = n;
+                n = n->left;
+            } else if (skip == leftSize) {
+                stack[depth++] = n;
+                break;
+            } else {
+                skip -= leftSize + 1;
+                n = n->right;
+            }
+        }
+        while (count-- > 0 && depth > 0) {
+            const Node* n = stack[--depth];
+            visit(n->value);
+            for (n = n->right; n != nullptr; n = n->left) stack[depth++] = n;
+        }
+    }
+
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        forEach(0, size(), visit);
+    }
+
+    // --- Edits: O(log n), copying only the nodes they pass through ---
+    void pushBack(T value) { root = join(root, std::move(value), nullptr); }
+    void pushFront(T value) { root = join(nullptr, std::move(value), root); }
+
+    // 0 <= position <= size()
+    void insertAt(int position, T value) {
+        auto [first, rest] = split(root, static_cast<std::uint32_t>(position));
+        root = join(first, std::move(value), rest);
+    }
+
+    // 0 <= position < size()
+    void eraseAt(int position) {
+        auto [first, rest] = split(root, static_cast<std::uint32_t>(position));
+        auto [doomed, after] = split(rest, 1);
+        release(doomed);
+        root = join2(first, after);
+    }
+
+    void set(int position, T value) {
+        auto [first, rest] = split(root, static_cast<std::uint32_t>(position));
+        auto [old, after] = split(rest, 1);
+        release(old);
+        root = join(first, std::move(value), after);
+    }
+
+    // Move 'count' values starting at 'first' so they start at 'position' of
+    // what is left without them
+    void moveRange(int first, int count, int position) {
+        auto [before, rest] = split(root, static_cast<std::uint32_t>(first));
+        auto [block, after] = split(rest, static_cast<std::uint32_t>(count));
+        Node* others = join2(before, after);
+        auto [head, tail] = split(others, static_cast<std::uint32_t>(position));
+        root = join2(join2(head, block), tail);
+    }
+
+    // Everything in 'other' after everything here; shares other's nodes
+    void append(const PersistentList& other) { root = join2(root, retain(other.root)); }
+
+    // 'count' values from 'first' on, as a list sharing this one's nodes
+    PersistentList slice(int first, int count) const {
+        PersistentList part(*this);
+        auto [before, rest] = part.split(part.root, static_cast<std::uint32_t>(first));
+        auto [middle, after] = part.split(rest, static_cast<std::uint32_t>(count));
+        part.release(before);
+        part.release(after);
+        part.root = middle;
+        return part;
+    }
+
+    // Drop every value with isDoomed(value). Subtrees with nothing to drop
+    // stay shared; returns how many went. O(n) reads, O(k log n) new nodes.
+    template <typename Pred>
+    int removeIf(Pred&& isDoomed) {
+        int removed = 0;
+        Node* kept = filter(root, isDoomed, removed);
+        release(root);
+        root = kept;
+        return removed;
+    }
+
+    void clear() {
+        release(root);
+        root = nullptr;
+    }
+};
@@ -0,0 +1,190 @@
+#include "PlaybackController.h"
+#include <utility>
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+PlaybackController::PlaybackController(unique_ptr<AudioOutput> output, size_t cacheBytes, const LoudnessStore* loudness,
+                                       GaplessStream::SampleTap tap, function<void()> changed)
+    : stream(std::move(output)), prefetcher(cacheBytes, loudness), onChange(std::move(changed)), uiReader(published.registerReader()) {
+    prefetcher.setNextReadyCallback([this](const GaplessStream::Source& next) {
+        stream.queueNext(next);
+    });
+    // Audio thread -> playback thread: all it does is bump a counter
+    stream.setTrackEndCallback([this] { wake(); });
+    stream.setSampleTap(std::move(tap));
+    worker = thread([this] { run(); });
+}
+
+PlaybackController::~PlaybackController() {
+    PlaybackCommand quit;
+    quit.type = PlaybackCommand::Type::Quit;
+    while (!send(std::move(quit))) this_thread::yield();
+    worker.join();
+}
+
+//----------------------------------------------------
+// UI side
+
+bool PlaybackController::send(PlaybackCommand&& command) {
+    if (!commands.tryPush(std::move(command))) return false;
+    wake();
+    return true;
+}
+
+void PlaybackController::wake() {
+    wakeups.fetch_add(1, memory_order_release);
+    wakeups.notify_one();
+}
+
+uint64_t PlaybackController::play(const string& path, Clock::time_point requested) {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Play;
+    command.generation = lastGeneration + 1;
+    command.path = path;
+    command.requested = requested;
+    if (!send(std::move(command))) return 0;
+    return ++lastGeneration;
+}
+
+bool PlaybackController::pause() {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Pause;
+    return send(std::move(command));
+}
+
+bool PlaybackController::resume() {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Resume;
+    return send(std::move(command));
+}
+
+bool PlaybackController::stop() {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Stop;
+    return send(std::move(command));
+}
+
+bool PlaybackController::prefetch(const string& nextPath, const string& prevPath) {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::Prefetch;
+    command.path = nextPath;
+    command.prevPath = prevPath;
+    return send(std::move(command));
+}
+
+bool PlaybackController::setVolume(float linear) {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::SetVolume;
+    command.value = linear;
+    return send(std::move(command));
+}
+
+bool PlaybackController::setReplayGain(bool enabled) {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::SetReplayGain;
+    command.value = enabled ? 1.0f : 0.0f;
+    return send(std::move(command));
+}
+
+bool PlaybackController::setCrossfade(chrono::milliseconds length) {
+    PlaybackCommand command;
+    command.type = PlaybackCommand::Type::SetCrossfade;
+    command.value = static_cast<float>(length.count());
+    return send(std::move(command));
+}
+
+PlaybackState PlaybackController::state() {
+    auto snapshot = published.read(uiReader);
+    return *snapshot;
+}
+
+//----------------------------------------------------
+// Playback thread
+
+bool PlaybackController::handle(PlaybackCommand& command) {
+    switch (command.type) {
+        case PlaybackCommand::Type::Play: {
+            // Whatever the audio did before this request belongs to the track before it
+            stream.takeAdvanced();
+            stream.takeEnded();
+            working.generation = command.generation;
+            working.advances = 0;
+            working.endings = 0;
+
+            ScopedTimer timer(Probe::TrackSwitch);
+            // Usually already opened in the background, so this is a pointer swap
+            GaplessStream::Source source = prefetcher.acquire(command.path);
+            working.failed = !source;
+            if (source) stream.start(source, command.requested);
+            else stream.clear();
+            return working.failed;
+        }
+        case PlaybackCommand::Type::Pause:
+            stream.pause();
+            return false;
+        case PlaybackCommand::Type::Resume:
+            stream.play();
+            return false;
+        case PlaybackCommand::Type::Stop:
+            stream.clear();
+            return false;
+        case PlaybackCommand::Type::Prefetch:
+            stream.queueNext(nullptr); // Whatever was queued may not be "next" any more
+            prefetcher.prefetch(command.path, command.prevPath);
+            return false;
+        case PlaybackCommand::Type::SetVolume:
+            stream.setVolume(command.value);
+            return false;
+        // The dashboard shows these two from the published state, so let the UI redraw
+        case PlaybackCommand::Type::SetReplayGain:
+            stream.setReplayGain(command.value != 0.0f);
+            return true;
+        case PlaybackCommand::Type::SetCrossfade:
+            stream.setCrossfade(chrono::milliseconds(static_cast<int64_t>(command.value)));
+            return true;
+        case PlaybackCommand::Type::None:
+        case PlaybackCommand::Type::Quit:
+            break;
+    }
+    return false;
+}
+
+void PlaybackController::run() {
+    PlaybackCommand command;
+    for (;;) {
+        // Read before draining: anything pushed after this makes wait() return at once
+        uint32_t seen = wakeups.load(memory_order_acquire);
+
+        bool changed = false;
+        bool tellUi = false;
+        while (commands.tryPop(command)) {
+            if (command.type == PlaybackCommand::Type::Quit) return;
+            tellUi |= handle(command);
+            changed = true;
+        }
+
+        int advanced = stream.takeAdvanced();
+        bool ended = stream.takeEnded();
+        if (advanced > 0 || ended) {
+            working.advances += advanced;
+            working.endings += ended ? 1 : 0;
+            changed = tellUi = true;
+        }
+
+        if (changed) {
+            working.status = stream.status();
+            working.hasSource = stream.hasSource();
+            working.prefetchHits = prefetcher.hits();
+            working.prefetchMisses = prefetcher.misses();
+            working.cache = prefetcher.cacheStats();
+            working.volume = stream.getVolume();
+            working.replayGain = stream.replayGainEnabled();
+            working.crossfadeMs = static_cast<int>(stream.crossfade().count());
+            published.publish(make_unique<PlaybackState>(working));
+            if (tellUi && onChange) onChange();
+        }
+
+        wakeups.wait(seen, memory_order_acquire);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "AudioOutput.h"
+#include "Dsp.h"
+#include "GaplessStream.h"
+#include "RcuCell.h"
+#include "SpscRing.h"
+#include "TrackPrefetcher.h"
+
+// A request from the UI thread to the playback thread
+struct PlaybackCommand {
+    enum class Type { None, Play, Pause, Resume, Stop, Prefetch, SetVolume, SetReplayGain, SetCrossfade, Quit };
+    using Clock = GaplessStream::Clock;
+
+    Type type = Type::None;
+    std::uint64_t generation = 0; // Play: numbers the request, starting at 1
+    std::string path;             // Play: the track. Prefetch: what Next would play
+    std::string prevPath;         // Prefetch: what Prev would play
+    Clock::time_point requested;  // Play: when the user asked for it
+    float value = 0.0f;           // SetVolume: linear gain. SetReplayGain: 0 / 1. SetCrossfade: milliseconds
+};
+
+// What the playback thread last reported. Counters start over with every
+// Play, so the UI can tell events of the track it asked for from those of
+// the one before it.
+struct PlaybackState {
+    AudioOutput::Status status = AudioOutput::Status::Stopped;
+    bool hasSource = false;
+    std::uint64_t generation = 0; // Last Play handled
+    bool failed = false;          // Its file couldn't be decoded
+    int advances = 0;             // Queued tracks that took over gaplessly since then
+    int endings = 0;              // Times the stream ran dry since then
+    std::uint64_t prefetchHits = 0;
+    std::uint64_t prefetchMisses = 0;
+    TrackCache::Stats cache;
+    float volume = 1.0f;
+    bool replayGain = false;
+    int crossfadeMs = 0;
+};
+
+// Owns the audio side: the GaplessStream, the prefetcher and a thread that is
+// the only one to touch them. The UI thread sends commands through a
+// wait-free ring and reads state back from an RCU cell, so a slow file open
+// or device restart never holds up a frame, and nothing the audio side does
+// ever waits for the UI.
+class PlaybackController {
+public:
+    using Clock = PlaybackCommand::Clock;
+
+    // 'onChange' runs on the playback thread whenever audio moved on by
+    // itself (a track ended) or a Play failed; it should wake the UI.
+    // 'cacheBytes' is the budget for recently read track files. 'loudness'
+    // (may be null) levels tracks that have no ReplayGain tags. 'tap' (may be
+    // empty) sees every chunk on the audio thread: see GaplessStream::setSampleTap().
+    PlaybackController(std::unique_ptr<AudioOutput> output, std::size_t cacheBytes, const LoudnessStore* loudness,
+                       GaplessStream::SampleTap tap, std::function<void()> onChange);
+    ~PlaybackController();
+
+    PlaybackController(const PlaybackController&) = delete;
+    PlaybackController& operator=(const PlaybackController&) = delete;
+
+    // UI thread only. Play returns the request's generation, the others
+    // success; 0 / false if the command ring is full.
+    std::uint64_t play(const std::string& path, Clock::time_point requested = Clock::now());
+    bool pause();
+    bool resume();
+    bool stop();
+    bool prefetch(const std::string& nextPath, const std::string& prevPath);
+    bool setVolume(float linear);
+    bool setReplayGain(bool enabled);
+    bool setCrossfade(std::chrono::milliseconds length);
+
+    // UI thread only: the latest published state
+    PlaybackState state();
+
+    // Any thread; plain atomic reads of the stream's counters
+    sf::Time trackOffset() const { return stream.trackOffset(); }
+    GaplessStream::LatencyStats latency() const { return stream.latency(); }
+
+    // Any thread: the file changed on disk, so don't play it from the cache again
+    void forgetFile(const std::string& path) { prefetcher.forget(path); }
+
+    // Instruction set of the DSP kernels in use
+    static const char* dspName() { return Dsp::best().name; }
+
+private:
+    static constexpr std::size_t RingSize = 64;
+
+    GaplessStream stream;
+    TrackPrefetcher prefetcher; // Declared after 'stream': its worker queues tracks on it
+    std::function<void()> onChange;
+
+    SpscRing<PlaybackCommand, RingSize> commands;
+    std::atomic<std::uint32_t> wakeups{ 0 }; // Bumped after every push and track end
+    RcuCell<PlaybackState> published;
+    RcuCell<PlaybackState>::Reader uiReader;
+    std::uint64_t lastGeneration = 0; // UI side
+
+    PlaybackState working; // Playback thread's copy of what it publishes
+    std::thread worker;
+
+    bool send(PlaybackCommand&& command);
+    void wake();
+    void run();
+    bool handle(PlaybackCommand& command); // True if the UI should hear about it
+};
@@ -0,0 +1,745 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Track.h"
+#include "TrackStore.h"
+#include "IndexedDoublyLinkedList.h"
+#include "HashIndex.h"
+#include "SearchIndex.h"
+#include "ShuffleOrder.h"
+
+// What Playlist::sortTracks() orders by
+enum class SortKey { Id, Title, Artist, Duration };
+
+// ==========================================
+// 2. DOMAIN LOGIC (Playlist Class)
+// ==========================================
+class Playlist {
+private:
+    TrackStore store; // The tracks themselves; nodes only hold handles into it
+    IndexedDoublyLinkedList<TrackHandle> dll; // O(log n) positional ops, O(1) next/prev
+    HashIndex<node<TrackHandle>*> idIndex; // Track ID -> node, kept in sync on every add/remove
+    node<TrackHandle>* currentTrackNode;
+    int nextId;
+    std::vector<std::shared_ptr<const void>> backingStores; // Keep borrowed text (e.g. mapped snapshots) alive
+    SearchIndex searchIndex; // Trigrams of title/artist -> IDs, built on the first search
+    bool searchIndexReady;
+    mutable ShuffleOrder shuffleOrder; // Drawn lazily, even by the const peeks
+    bool shuffling;
+
+    // 8 lower-cased bytes of 'text' from 'offset' on, big-endian, so that
+    // integer order is text order (zeros past the end)
+    static std::uint64_t foldedWord(std::string_view text, std::size_t offset) {
+        std::uint64_t word = 0;
+        for (std::size_t i = offset; i < offset + 8; i++) {
+            word = (word << 8) | (i < text.size() ? SearchIndex::lower(text[i]) : 0u);
+        }
+        return word;
+    }
+
+    // Every live track's title rank, indexed by handle: its place in
+    // case-insensitive text order, equal titles sharing one. An MSD sort
+    // with 8-byte digits: sort by the first 8 folded bytes, then re-sort only
+    // the runs that tie on the next 8, and so on. A title is read once per
+    // digit it needs, and no comparison ever goes back to the text.
+    std::vector<std::uint32_t> titleRanks() const {
+        struct Item {
+            std::uint64_t word;
+            TrackHandle handle;
+        };
+        struct Run {
+            std::size_t begin, end, offset;
+            bool settled; // Titles all equal: one rank for the lot
+        };
+
+        std::vector<Item> items;
+        items.reserve(static_cast<std::size_t>(dll.nodeCount()));
+        for (const node<TrackHandle>* n = dll.getHead(); n != nullptr; n = n->next) {
+            items.push_back(Item{ foldedWord(store.title(n->data), 0), n->data });
+        }
+
+        // Depth first, so ranks are handed out in order: the stack's top is
+        // always the run that comes first in text order
+        std::vector<std::uint32_t> rank(store.handleLimit());
+        std::uint32_t nextRank = 0;
+        std::vector<Run> runs{ Run{ 0, items.size(), 0, items.size() < 2 } };
+        while (!runs.empty()) {
+            Run run = runs.back();
+            runs.pop_back();
+            if (run.settled) {
+                for (std::size_t k = run.begin; k < run.end; k++) rank[items[k].handle] = nextRank;
+                nextRank++;
+                continue;
+            }
+
+            std::sort(items.begin() + static_cast<std::ptrdiff_t>(run.begin), items.begin() + static_cast<std::ptrdiff_t>(run.end),
+                      [](const Item& a, const Item& b) { return a.word < b.word; });
+
+            // Runs of equal digits; those with text left go on to the next 8 bytes
+            std::size_t pushed = runs.size();
+            std::size_t next = run.offset + 8;
+            for (std::size_t i = run.begin; i < run.end;) {
+                std::size_t j = i + 1;
+                while (j < run.end && items[j].word == items[i].word) j++;
+                bool more = false;
+                for (std::size_t k = i; k < j && j - i > 1 && !more; k++) more = store.title(items[k].handle).size() > next;
+                if (more) {
+                    for (std::size_t k = i; k < j; k++) items[k].word = foldedWord(store.title(items[k].handle), next);
+                }
+                runs.push_back(Run{ i, j, next, !more });
+                i = j;
+            }
+            std::reverse(runs.begin() + static_cast<std::ptrdiff_t>(pushed), runs.end());
+        }
+        return rank;
+    }
+
+    static bool lessIgnoreCase(std::string_view a, std::string_view b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+            return SearchIndex::lower(x) < SearchIndex::lower(y);
+        });
+    }
+
+    bool isLive(int id) const {
+        return idIndex.find(id) != nullptr;
+    }
+
+    // Make the track with this ID current; the ID must be live
+    void setCurrentId(int id) {
+        currentTrackNode = *idIndex.find(id);
+    }
+
+    void indexForSearch(TrackHandle h) {
+        if (searchIndexReady) searchIndex.add(store.id(h), store.title(h), store.artistName(h));
+    }
+
+    // Walk IDs in increasing order so every posting list is appended in order
+    void buildSearchIndex() {
+        searchIndex.clear();
+        for (int id = 1; id < nextId; id++) {
+            node<TrackHandle>** found = idIndex.find(id);
+            if (found) searchIndex.add(id, store.title((*found)->data), store.artistName((*found)->data));
+        }
+        searchIndexReady = true;
+    }
+
+    // Put 'count' freshly linked nodes, starting at 'first', into the ID and
+    // search indexes in one sweep. IDs come from the store.
+    void indexNewNodes(node<TrackHandle>* first, int count) {
+        idIndex.reserve(idIndex.size() + static_cast<std::size_t>(count));
+        for (node<TrackHandle>* n = first; n != nullptr && count-- > 0; n = n->next) {
+            int id = store.id(n->data);
+            idIndex.insert(id, n);
+            if (id >= nextId) nextId = id + 1;
+            indexForSearch(n->data);
+        }
+
+        if (currentTrackNode == nullptr) {
+            currentTrackNode = dll.getHead();
+        }
+    }
+
+    // Append a batch of handles made by make(i), then index the new nodes
+    template <typename Make>
+    void appendBatch(int count, Make&& make) {
+        node<TrackHandle>* oldTail = dll.getTail();
+        dll.appendBulk(count, make);
+        indexNewNodes(oldTail ? oldTail->next : dll.getHead(), count);
+    }
+
+    // Store handles of the given tracks (IDs assigned here), grown once for the batch
+    std::vector<TrackHandle> storeTracks(std::vector<Track>& tracks) {
+        std::size_t textBytes = 0;
+        for (const Track& t : tracks) textBytes += t.title.size() + t.filePath.size();
+        store.reserve(tracks.size(), textBytes);
+
+        std::vector<TrackHandle> handles;
+        handles.reserve(tracks.size());
+        for (Track& t : tracks) {
+            t.id = nextId++;
+            handles.push_back(store.add(t));
+        }
+        return handles;
+    }
+
+    // One pass over the list dropping every track with isDoomed(handle). If the
+    // current track goes, the first surviving track after it takes over (or,
+    // shuffling, the next one in the shuffle order), as with removeTrack.
+    template <typename IsDoomed>
+    int removeWhere(IsDoomed&& isDoomed) {
+        node<TrackHandle>* current = currentTrackNode;
+        bool currentRemoved = false;
+        node<TrackHandle>* firstKept = nullptr;
+        node<TrackHandle>* keptAfterCurrent = nullptr;
+
+        int removed = dll.removeIf([&](TrackHandle h) {
+            int id = store.id(h);
+            if (!isDoomed(h)) {
+                if (firstKept == nullptr || (currentRemoved && keptAfterCurrent == nullptr)) {
+                    node<TrackHandle>* kept = *idIndex.find(id);
+                    if (firstKept == nullptr) firstKept = kept;
+                    if (currentRemoved && keptAfterCurrent == nullptr) keptAfterCurrent = kept;
+                }
+                return false;
+            }
+            if (current != nullptr && h == current->data) currentRemoved = true;
+            idIndex.erase(id);
+            store.release(h);
+            if (searchIndexReady) searchIndex.remove();
+            return true;
+        });
+        if (removed == 0) return 0;
+
+        if (currentRemoved) {
+            currentTrackNode = keptAfterCurrent ? keptAfterCurrent : firstKept;
+            if (shuffling && currentTrackNode != nullptr) {
+                setCurrentId(shuffleOrder.next(nextId, [this](int id) { return isLive(id); }));
+            }
+        }
+        if (searchIndexReady && searchIndex.needsCompaction()) {
+            searchIndex.compact([&](int liveId) { return idIndex.find(liveId) != nullptr; });
+        }
+        return removed;
+    }
+
+public:
+    Playlist() : currentTrackNode(nullptr), nextId(1), searchIndexReady(false), shuffling(false) {}
+
+    // The strings are copied into the track store (artist and directory interned)
+    void addTrack(std::string title, std::string artist, int duration, std::string path) {
+        addTrack(Track{ 0, std::move(title), std::move(artist), duration, std::move(path) });
+    }
+
+    // Takes a whole Track (its id is replaced by a fresh one)
+    void addTrack(Track&& track) {
+        track.id = nextId++;
+        node<TrackHandle>* added = dll.emplaceAtEnd(store.add(track));
+        idIndex.insert(track.id, added);
+        indexForSearch(added->data);
+
+        // If it's the first track, point current to it
+        if (dll.nodeCount() == 1) {
+            currentTrackNode = dll.getHead();
+        }
+    }
+
+    // Batch import (e.g. from LibraryScanner). IDs are assigned here, the store
+    // grows once for the whole batch, and so does the list index.
+    void addTracks(std::vector<Track>&& tracks) {
+        std::size_t textBytes = 0;
+        for (const Track& t : tracks) textBytes += t.title.size() + t.filePath.size();
+        store.reserve(tracks.size(), textBytes);
+
+        int firstId = nextId;
+        appendBatch(static_cast<int>(tracks.size()), [&](int i) {
+            Track& t = tracks[static_cast<std::size_t>(i)];
+            t.id = firstId + i;
+            return store.add(t);
+        });
+        tracks.clear();
+    }
+
+    // Batch insert so the first new track lands at a 1-based position (past the
+    // end appends). One allocation batch and one tree splice: O(k + log n).
+    bool insertTracks(int position, std::vector<Track>&& tracks) {
+        if (position <= 0 || position > dll.nodeCount() + 1) return false;
+        std::vector<TrackHandle> handles = storeTracks(tracks);
+        node<TrackHandle>* first = dll.insertRange(dll.nodeAt(position), handles.begin(), handles.end());
+        indexNewNodes(first, static_cast<int>(handles.size()));
+        tracks.clear();
+        return true;
+    }
+
+    // Bulk restore (e.g. from a LibrarySnapshot): load(store) puts the tracks into
+    // the store, IDs included, and returns their handles in playlist order.
+    // 'backing' owns any memory the store borrows text or symbols from.
+    template <typename Load>
+    void restoreTracks(Load&& load, std::shared_ptr<const void> backing) {
+        if (backing) backingStores.push_back(std::move(backing));
+        std::vector<TrackHandle> handles = load(store);
+        appendBatch(static_cast<int>(handles.size()), [&](int i) { return handles[static_cast<std::size_t>(i)]; });
+    }
+
+    // Copy any text the store borrows into the store and let go of the memory
+    // it was borrowed from (e.g. unmap a snapshot so the file can be replaced)
+    void releaseBackingStores() {
+        if (backingStores.empty()) return;
+        store.ownText();
+        backingStores.clear();
+    }
+
+    // Read access to the track data, e.g. for writing a snapshot
+    const TrackStore& getStore() const {
+        return store;
+    }
+
+    // For a PlaylistManager keeping other lists of these tracks: it may
+    // retain() and release() them, and nothing else
+    TrackStore& sharedStore() {
+        return store;
+    }
+
+    // Show another list of the store's tracks instead (e.g. one a
+    // PlaylistManager kept): the playlist becomes 'handles' in order, each
+    // track once. The current track stays current if it is among them, else
+    // the first one is; shuffle starts a new order. O(n).
+    void replaceTracks(const std::vector<TrackHandle>& handles) {
+        // The new references first: the old list may share tracks with this one
+        std::vector<char> seen(store.handleLimit(), 0);
+        std::vector<TrackHandle> kept;
+        kept.reserve(handles.size());
+        for (TrackHandle h : handles) {
+            if (seen[h]) continue;
+            seen[h] = 1;
+            store.retain(h);
+            kept.push_back(h);
+        }
+
+        int currentId = currentTrackNode != nullptr ? store.id(currentTrackNode->data) : 0;
+        for (node<TrackHandle>* n = dll.getHead(); n != nullptr; n = n->next) store.release(n->data);
+        dll.freeMemory();
+        idIndex.clear();
+        currentTrackNode = nullptr;
+        searchIndex.clear();
+        searchIndexReady = false;
+
+        appendBatch(static_cast<int>(kept.size()), [&](int i) { return kept[static_cast<std::size_t>(i)]; });
+        if (isLive(currentId)) setCurrentId(currentId);
+        if (shuffling) setShuffle(true);
+    }
+
+    // Visit every track in playlist order
+    template <typename Visit>
+    void forEachTrack(Visit&& visit) const {
+        for (const node<TrackHandle>* n = dll.getHead(); n != nullptr; n = n->next) {
+            visit(store.ref(n->data));
+        }
+    }
+
+    // Visit the first 'limit' tracks only
+    template <typename Visit>
+    void forEachTrack(int limit, Visit&& visit) const {
+        for (const node<TrackHandle>* n = dll.getHead(); n != nullptr && limit-- > 0; n = n->next) {
+            visit(store.ref(n->data));
+        }
+    }
+
+    int getNextId() const {
+        return nextId;
+    }
+
+    void setNextId(int id) {
+        if (id > nextId) nextId = id;
+    }
+
+    // Hash lookup + erase(node): no list walk
+    bool removeTrack(int id) {
+        node<TrackHandle>** found = idIndex.find(id);
+        if (found == nullptr) return false;
+
+        node<TrackHandle>* temp = *found;
+        TrackHandle handle = temp->data;
+        // Out of the index first, so the shuffle order can't draw it again
+        idIndex.erase(id);
+        // Safety: If deleting the playing track, move pointer to next
+        if (temp == currentTrackNode) {
+            if (dll.nodeCount() == 1) currentTrackNode = nullptr; // It was the only track
+            else moveNext();
+        }
+        dll.erase(temp);
+        store.release(handle);
+
+        if (searchIndexReady) {
+            searchIndex.remove();
+            if (searchIndex.needsCompaction()) {
+                searchIndex.compact([&](int liveId) { return idIndex.find(liveId) != nullptr; });
+            }
+        }
+        return true;
+    }
+
+    // Remove every track for which pred(TrackRef) is true, in one pass over the
+    // list plus an O(n) index rebuild, instead of one removeTrack per match.
+    // Returns how many were removed.
+    template <typename Pred>
+    int removeTracksIf(Pred&& pred) {
+        return removeWhere([&](TrackHandle h) { return pred(store.ref(h)); });
+    }
+
+    // Every track by this artist (exact name). Compares interned symbols only.
+    int removeArtist(std::string_view artist) {
+        std::uint32_t symbol = store.artistSymbols().find(artist);
+        if (symbol == SymbolTable::NotFound) return 0;
+        return removeWhere([&](TrackHandle h) { return store.artist(h) == symbol; });
+    }
+
+    // Keep one track of each group of IDs (e.g. copies of one recording, as
+    // DuplicateIndex finds them) and remove the others, all in one pass. The
+    // playing track is kept if it is in the group, else the one earliest in
+    // the playlist; IDs no longer in the playlist are ignored. Returns how
+    // many were removed.
+    int collapseDuplicates(const std::vector<std::vector<int>>& groups) {
+        std::vector<char> doomed(static_cast<std::size_t>(nextId), 0);
+        int current = currentTrackNode != nullptr ? store.id(currentTrackNode->data) : 0;
+        for (const std::vector<int>& group : groups) {
+            int keep = 0;
+            int keepPosition = 0;
+            for (int id : group) {
+                if (!isLive(id)) continue;
+                if (id == current) {
+                    keep = id;
+                    break;
+                }
+                int position = getTrackPosition(id);
+                if (keep == 0 || position < keepPosition) {
+                    keep = id;
+                    keepPosition = position;
+                }
+            }
+            for (int id : group) {
+                if (id != keep && isLive(id)) doomed[static_cast<std::size_t>(id)] = 1;
+            }
+        }
+        return removeWhere([&](TrackHandle h) { return doomed[static_cast<std::size_t>(store.id(h))] != 0; });
+    }
+
+    // What syncFiles() did
+    struct SyncResult {
+        int added = 0;
+        int updated = 0;
+        int removed = 0;
+        std::vector<char> gone; // By handle: tracks whose files went, listed here or not (empty if none)
+    };
+
+    // Follow files that changed on disk (e.g. as LibraryWatcher reports them),
+    // in one pass over the store however big the batch:
+    //   - tracks of removed files, or of files under a removed folder, go
+    //     (the current track moves on as with removeTracksIf)
+    //   - a track whose file was rewritten is re-read in place: same ID, same
+    //     place, and the current track stays current
+    //   - a renamed file's track takes on the new path the same way, unless
+    //     the new path is in the store already (that track is re-read and
+    //     the old one goes)
+    //   - the files left over are new: appended, in the batch's order
+    // Only tracks in the folders involved are compared by path. Every track
+    // in the store is followed, so tracks that other lists hold (see
+    // PlaylistManager) are re-read too; those to drop from them are in 'gone'.
+    SyncResult syncFiles(std::vector<FileUpdate>&& updates, const std::vector<std::string>& removedFiles,
+                         const std::vector<std::string>& removedDirectories) {
+        const int Removed = -1;
+        SyncResult result;
+
+        // Path -> what becomes of its tracks (an index into 'updates', or
+        // Removed). A file's own path wins over a rename's old one.
+        std::unordered_map<std::string, int> actions;
+        for (std::size_t i = 0; i < updates.size(); i++) actions.emplace(updates[i].track.filePath.str(), static_cast<int>(i));
+        for (std::size_t i = 0; i < updates.size(); i++) {
+            if (!updates[i].renamedFrom.empty()) actions.emplace(updates[i].renamedFrom, static_cast<int>(i));
+        }
+        for (const std::string& path : removedFiles) actions.emplace(path, Removed);
+
+        // Folders to look in: 1 = compare paths there, 2 = all of it went
+        const SymbolTable& folders = store.directorySymbols();
+        std::vector<char> look(folders.size(), 0);
+        for (const auto& action : actions) {
+            std::string_view path = action.first;
+            std::size_t split = path.find_last_of("/\\");
+            std::uint32_t folder = folders.find(path.substr(0, split == std::string_view::npos ? 0 : split + 1));
+            if (folder != SymbolTable::NotFound) look[folder] |= 1;
+        }
+        for (std::string prefix : removedDirectories) {
+            if (prefix.empty()) continue;
+            if (prefix.back() != '/' && prefix.back() != '\\') prefix += '/';
+            for (std::uint32_t folder = 0; folder < folders.size(); folder++) {
+                if (folders.name(folder).starts_with(prefix)) look[folder] |= 2;
+            }
+        }
+
+        std::vector<char> doomed(store.handleLimit(), 0);
+        std::vector<std::pair<TrackHandle, std::size_t>> reread; // Tracks to re-read, from which update
+        std::vector<std::pair<TrackHandle, std::size_t>> renamed;
+        std::vector<char> listed(updates.size(), 0); // Already in the store under its own path
+        bool removing = false;
+        for (TrackHandle h = 0; h < store.handleLimit(); h++) {
+            if (store.id(h) == 0) continue; // Free handle
+            char how = look[store.directory(h)];
+            if (how == 0) continue;
+            auto action = (how & 1) ? actions.find(store.filePath(h)) : actions.end();
+            if (action != actions.end() && action->second != Removed) {
+                std::size_t i = static_cast<std::size_t>(action->second);
+                if (updates[i].track.filePath.view() == action->first) {
+                    reread.emplace_back(h, i);
+                    listed[i] = 1;
+                } else {
+                    renamed.emplace_back(h, i);
+                }
+            } else if (action != actions.end() || (how & 2)) {
+                doomed[h] = 1;
+                removing = true;
+            }
+        }
+        for (const auto& [h, i] : renamed) {
+            if (listed[i]) {
+                doomed[h] = 1;
+                removing = true;
+            } else {
+                reread.emplace_back(h, i);
+            }
+        }
+        if (removing) {
+            result.removed = removeWhere([&](TrackHandle h) { return doomed[h] != 0; });
+            result.gone = std::move(doomed);
+        }
+
+        // Same handle, same ID, so every list holding the track sees the change
+        std::vector<char> used(updates.size(), 0);
+        for (const auto& [h, i] : reread) {
+            store.update(h, updates[i].track);
+            if (searchIndexReady && isLive(store.id(h))) {
+                searchIndex.remove(); // The old words stay listed until compaction; searches check the text anyway
+                indexForSearch(h);
+            }
+            used[i] = 1;
+            result.updated++;
+        }
+
+        std::vector<Track> added;
+        for (std::size_t i = 0; i < updates.size(); i++) {
+            if (!used[i]) added.push_back(std::move(updates[i].track));
+        }
+        result.added = static_cast<int>(added.size());
+        if (!added.empty()) addTracks(std::move(added));
+        updates.clear();
+        return result;
+    }
+
+    // Case-insensitive substring search over title and artist; at most 'limit'
+    // matches, in playlist order for short queries and ID order otherwise.
+    // The trigram index is built on the first call and kept up to date after that,
+    // so startup doesn't pay for it.
+    std::vector<TrackRef> searchTracks(std::string_view query, int limit) {
+        std::vector<TrackRef> matches;
+        if (query.empty() || limit <= 0) return matches;
+
+        // Artists are interned, so each distinct name is tested once per query
+        // and a track's artist check becomes a table lookup
+        std::string needle = SearchIndex::toLower(query);
+        const SymbolTable& artists = store.artistSymbols();
+        std::vector<char> artistMatches(artists.size());
+        for (std::uint32_t a = 0; a < artists.size(); a++) {
+            artistMatches[a] = SearchIndex::containsIgnoreCase(artists.name(a), needle);
+        }
+        auto isMatch = [&](TrackHandle h) {
+            return artistMatches[store.artist(h)] || SearchIndex::containsIgnoreCase(store.title(h), needle);
+        };
+
+        if (needle.size() < SearchIndex::MinQueryLength) {
+            // One or two characters: no trigram to look up, but such a broad
+            // query fills 'limit' within the first few tracks of a walk
+            for (node<TrackHandle>* n = dll.getHead(); n != nullptr && static_cast<int>(matches.size()) < limit; n = n->next) {
+                if (isMatch(n->data)) matches.push_back(store.ref(n->data));
+            }
+            return matches;
+        }
+
+        if (!searchIndexReady) buildSearchIndex();
+        searchIndex.forEachCandidate(needle, [&](int id) {
+            node<TrackHandle>** found = idIndex.find(id);
+            if (found && isMatch((*found)->data)) matches.push_back(store.ref((*found)->data));
+            return static_cast<int>(matches.size()) < limit;
+        });
+        return matches;
+    }
+
+    // O(1) lookup by ID (converts to false if there is no such track)
+    TrackRef findTrack(int id) const {
+        const node<TrackHandle>* const* found = idIndex.find(id);
+        if (found == nullptr) return TrackRef();
+        return store.ref((*found)->data);
+    }
+
+    // Make the track with this ID the current one. O(1).
+    bool jumpToTrack(int id) {
+        node<TrackHandle>** found = idIndex.find(id);
+        if (found == nullptr) return false;
+        currentTrackNode = *found;
+        if (shuffling) shuffleOrder.jumpTo(id);
+        return true;
+    }
+
+    // Drag a track to a new 1-based position. O(log n).
+    bool moveTrack(int id, int newPosition) {
+        node<TrackHandle>** found = idIndex.find(id);
+        if (found == nullptr || newPosition <= 0 || newPosition > dll.nodeCount()) return false;
+
+        node<TrackHandle>* moving = dll.unlink(*found);
+        // Positions now count the remaining tracks; nullptr means "at the end"
+        dll.insertNodeBefore(dll.nodeAt(newPosition), moving);
+        return true;
+    }
+
+    // Move 'count' tracks starting at a 1-based position as one block, so that
+    // the block then starts at 'newPosition' (counted among the other tracks,
+    // like moveTrack). One splice: O(log n) whatever the block size. Nodes
+    // aren't touched, so the current track and every index stay valid.
+    bool moveTracks(int firstPosition, int count, int newPosition) {
+        int total = dll.nodeCount();
+        if (count <= 0 || firstPosition <= 0 || firstPosition + count - 1 > total) return false;
+        if (newPosition <= 0 || newPosition > total - count + 1) return false;
+
+        node<TrackHandle>* first = dll.nodeAt(firstPosition);
+        node<TrackHandle>* last = dll.nodeAt(firstPosition + count - 1);
+        if (newPosition == firstPosition) return true;
+
+        // The node the block goes in front of, counted as if the block were gone
+        int beforeIndex = newPosition < firstPosition ? newPosition : newPosition + count;
+        node<TrackHandle>* before = dll.nodeAt(beforeIndex); // nullptr past the end
+        return dll.splice(before, dll, first, last, count);
+    }
+
+    // Reorder the whole playlist by 'key': a stable merge sort that relinks the
+    // list nodes, so tracks with equal keys keep their order (sort by title,
+    // then by artist, to get artists with their titles in order). Titles and
+    // artists compare without regard to ASCII case. Nodes stay where they
+    // are, so the current track, the ID index and the shuffle order all stay
+    // valid. 0 threads = one per core. O(n log n).
+    void sortTracks(SortKey key, unsigned threads = 0) {
+        if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+        auto ascending = [](auto a, auto b) { return a < b; };
+        switch (key) {
+            case SortKey::Id:
+                dll.sortByKey([this](TrackHandle h) { return store.id(h); }, ascending, threads);
+                break;
+            case SortKey::Duration:
+                dll.sortByKey([this](TrackHandle h) { return store.duration(h); }, ascending, threads);
+                break;
+            case SortKey::Artist: {
+                // Artists are interned: rank the distinct names once, then sort by rank
+                const SymbolTable& artists = store.artistSymbols();
+                std::vector<std::uint32_t> bySymbol(artists.size());
+                for (std::uint32_t a = 0; a < artists.size(); a++) bySymbol[a] = a;
+                std::sort(bySymbol.begin(), bySymbol.end(), [&](std::uint32_t a, std::uint32_t b) {
+                    return lessIgnoreCase(artists.name(a), artists.name(b));
+                });
+                // Names equal but for case ("ABBA", "abba") share a rank, so their
+                // tracks keep their order whichever way std::sort left them
+                std::vector<std::uint32_t> rank(artists.size());
+                std::uint32_t r = 0;
+                for (std::size_t k = 0; k < bySymbol.size(); k++) {
+                    if (k > 0 && lessIgnoreCase(artists.name(bySymbol[k - 1]), artists.name(bySymbol[k]))) r++;
+                    rank[bySymbol[k]] = r;
+                }
+                dll.sortByKey([&](TrackHandle h) { return rank[store.artist(h)]; }, ascending, threads);
+                break;
+            }
+            case SortKey::Title: {
+                std::vector<std::uint32_t> rank = titleRanks();
+                dll.sortByKey([&](TrackHandle h) { return rank[h]; }, ascending, threads);
+                break;
+            }
+        }
+    }
+
+    // 1-based position of a track (0 if there is no such ID). O(log n).
+    int getTrackPosition(int id) const {
+        const node<TrackHandle>* const* found = idIndex.find(id);
+        if (found == nullptr) return 0;
+        return dll.positionOf(*found);
+    }
+
+    // Make the track at a 1-based position the current one. O(log n).
+    bool jumpToPosition(int position) {
+        node<TrackHandle>* found = dll.nodeAt(position);
+        if (found == nullptr) return false;
+        currentTrackNode = found;
+        if (shuffling) shuffleOrder.jumpTo(store.id(found->data));
+        return true;
+    }
+
+    // Node at a 1-based position, for views that walk a window of the list. O(log n).
+    const node<TrackHandle>* getTrackNodeAt(int position) const {
+        return dll.nodeAt(position);
+    }
+
+    // 1-based position of the current track (0 if there is none). O(log n).
+    int getCurrentPosition() const {
+        return dll.positionOf(currentTrackNode);
+    }
+
+    // Shuffle mode: Next/Prev follow a random order instead of the list.
+    // Turning it on is O(1); the order is drawn one step at a time.
+    void setShuffle(bool on) {
+        shuffling = on;
+        if (on) {
+            int currentId = currentTrackNode ? store.id(currentTrackNode->data) : 0;
+            shuffleOrder.start(currentId, nextId, std::random_device{}());
+        }
+    }
+
+    bool isShuffling() const {
+        return shuffling;
+    }
+
+    void moveNext() {
+        if (shuffling) {
+            if (dll.isEmpty()) currentTrackNode = nullptr;
+            else setCurrentId(shuffleOrder.next(nextId, [this](int id) { return isLive(id); }));
+            return;
+        }
+        if (currentTrackNode && currentTrackNode->next) {
+            currentTrackNode = currentTrackNode->next;
+        } else {
+            currentTrackNode = dll.getHead(); // Loop back to start
+        }
+    }
+
+    void movePrev() {
+        if (shuffling) {
+            int id = shuffleOrder.prev([this](int id) { return isLive(id); });
+            if (id > 0) setCurrentId(id);
+            return;
+        }
+        if (currentTrackNode && currentTrackNode->prev) {
+            currentTrackNode = currentTrackNode->prev;
+        }
+    }
+
+    // The tracks moveNext()/movePrev() would land on, without moving (false if none)
+    TrackRef peekNext() const {
+        if (shuffling) {
+            if (dll.isEmpty()) return TrackRef();
+            return findTrack(shuffleOrder.peekNext(nextId, [this](int id) { return isLive(id); }));
+        }
+        if (currentTrackNode && currentTrackNode->next) return store.ref(currentTrackNode->next->data);
+        node<TrackHandle>* head = dll.getHead();
+        return head ? store.ref(head->data) : TrackRef();
+    }
+
+    TrackRef peekPrev() const {
+        if (shuffling) return findTrack(shuffleOrder.peekPrev([this](int id) { return isLive(id); }));
+        if (currentTrackNode && currentTrackNode->prev) return store.ref(currentTrackNode->prev->data);
+        return TrackRef();
+    }
+
+    TrackRef getCurrentTrack() const {
+        if (currentTrackNode) return store.ref(currentTrackNode->data);
+        return TrackRef();
+    }
+
+    void displayPlaylist() const {
+        forEachTrack([](TrackRef t) { std::cout << t << "\n"; });
+    }
+
+    int getTotalTracks() const {
+        return dll.nodeCount(); // This must be O(1)
+    }
+};
@@ -0,0 +1,116 @@
+#include "PlaylistManager.h"
+#include <algorithm>
+
+using namespace std;
+
+//----------------------------------------------------
+PlaylistManager::PlaylistManager(Playlist& shown, string shownName)
+    : playlist(shown), store(shown.sharedStore()), currentName(std::move(shownName)) {}
+
+PlaylistManager::SharedTrack PlaylistManager::share(TrackHandle h) {
+    store.retain(h);
+    return SharedTrack(*this, h);
+}
+
+PlaylistManager::List PlaylistManager::capture() {
+    vector<SharedTrack> shared;
+    shared.reserve(static_cast<size_t>(playlist.getTotalTracks()));
+    playlist.forEachTrack([&](TrackRef t) { shared.push_back(share(t.getHandle())); });
+    return List(shared, nodes);
+}
+
+Playlist::SyncResult PlaylistManager::syncFiles(vector<FileUpdate>&& updates, const vector<string>& removedFiles,
+                                                const vector<string>& removedDirectories) {
+    Playlist::SyncResult result = playlist.syncFiles(std::move(updates), removedFiles, removedDirectories);
+    if (!result.gone.empty()) {
+        // Gone tracks the playlist didn't hold still have their handles: none was reused
+        for (auto& entry : lists) {
+            entry.second.removeIf([&](const SharedTrack& t) { return t.handle() < result.gone.size() && result.gone[t.handle()]; });
+        }
+    }
+    return result;
+}
+
+//----------------------------------------------------
+bool PlaylistManager::show(string_view name) {
+    if (name == currentName) return true;
+    auto found = lists.find(name);
+    if (found == lists.end()) return false;
+
+    string next(name); // 'name' may be the map's own key
+    List list = std::move(found->second);
+    lists.erase(found);
+    lists.emplace(currentName, capture());
+
+    vector<TrackHandle> handles;
+    handles.reserve(static_cast<size_t>(list.size()));
+    list.forEach([&](const SharedTrack& t) { handles.push_back(t.handle()); });
+    playlist.replaceTracks(handles); // Counts them before 'list' lets go
+    currentName = std::move(next);
+    return true;
+}
+
+//----------------------------------------------------
+bool PlaylistManager::create(const string& name) {
+    if (name == currentName) return false;
+    return lists.try_emplace(name, nodes).second;
+}
+
+bool PlaylistManager::put(const string& name, List list) {
+    if (name == currentName || !(list.allocator() == nodes)) return false;
+    auto found = lists.find(name);
+    if (found == lists.end()) lists.emplace(name, std::move(list));
+    else found->second = std::move(list);
+    return true;
+}
+
+bool PlaylistManager::clone(string_view from, const string& to) {
+    if (to == currentName || lists.find(to) != lists.end()) return false;
+    if (from == currentName) {
+        lists.emplace(to, capture());
+        return true;
+    }
+    auto source = lists.find(from);
+    if (source == lists.end()) return false;
+    lists.emplace(to, source->second);
+    return true;
+}
+
+bool PlaylistManager::rename(string_view from, const string& to) {
+    if (to == currentName || lists.find(to) != lists.end()) return false;
+    if (from == currentName) {
+        currentName = to;
+        return true;
+    }
+    auto source = lists.find(from);
+    if (source == lists.end()) return false;
+    List moved = std::move(source->second);
+    lists.erase(source);
+    lists.emplace(to, std::move(moved));
+    return true;
+}
+
+bool PlaylistManager::remove(string_view name) {
+    auto found = lists.find(name);
+    if (found == lists.end()) return false;
+    lists.erase(found);
+    return true;
+}
+
+PlaylistManager::List* PlaylistManager::find(string_view name) {
+    auto found = lists.find(name);
+    return found == lists.end() ? nullptr : &found->second;
+}
+
+const PlaylistManager::List* PlaylistManager::find(string_view name) const {
+    auto found = lists.find(name);
+    return found == lists.end() ? nullptr : &found->second;
+}
+
+vector<string> PlaylistManager::names() const {
+    vector<string> all;
+    all.reserve(lists.size() + 1);
+    for (const auto& entry : lists) all.push_back(entry.first);
+    all.insert(upper_bound(all.begin(), all.end(), currentName), currentName);
+    return all;
+}
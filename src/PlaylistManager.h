@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+#include "PersistentList.h"
+#include "Playlist.h"
+#include "Track.h"
+#include "TrackStore.h"
+
+// Any number of named playlists over one set of tracks.
+//
+// The manager works alongside the Playlist the player shows: the tracks are
+// stored once, in that playlist's TrackStore, and counted there. The list
+// being shown lives in the Playlist itself; the others are kept here, each a
+// PersistentList of SharedTracks (a handle plus the count it owns), so a
+// record lives exactly as long as some list, or some caller, still lists
+// it. Cloning a kept list is O(1) and shares every node; editing either side
+// afterwards copies only the O(log n) nodes on the path to the edit, so a
+// hundred variants of a 100k-track library cost the library once plus their
+// edits. Switching lists, or cloning the one shown, takes it out of the
+// Playlist in O(n). All kept lists draw nodes from one pool, so any of them
+// can be appended to any other.
+//
+// Not thread-safe: one thread owns the manager, the playlist and its tracks.
+// Lists and SharedTracks must be gone before the manager is, and the
+// manager before the playlist.
+class PlaylistManager {
+public:
+    // A counted reference to a track record. Copies count, destruction
+    // uncounts, and the last one out removes the track from the store.
+    class SharedTrack {
+    private:
+        PlaylistManager* owner;
+        TrackHandle h;
+
+        SharedTrack(PlaylistManager& m, TrackHandle handle) : owner(&m), h(handle) {}
+        friend class PlaylistManager;
+
+    public:
+        SharedTrack() : owner(nullptr), h(0) {}
+        SharedTrack(const SharedTrack& other) : owner(other.owner), h(other.h) {
+            if (owner != nullptr) owner->store.retain(h);
+        }
+        SharedTrack(SharedTrack&& other) noexcept : owner(other.owner), h(other.h) { other.owner = nullptr; }
+
+        SharedTrack& operator=(SharedTrack other) noexcept {
+            std::swap(owner, other.owner);
+            std::swap(h, other.h);
+            return *this;
+        }
+
+        ~SharedTrack() {
+            if (owner != nullptr) owner->store.release(h);
+        }
+
+        explicit operator bool() const { return owner != nullptr; }
+        TrackHandle handle() const { return h; }
+        TrackRef ref() const { return owner != nullptr ? owner->store.ref(h) : TrackRef(); }
+
+        friend bool operator==(const SharedTrack& a, const SharedTrack& b) {
+            return a.owner == b.owner && (a.owner == nullptr || a.h == b.h);
+        }
+    };
+
+    using List = PersistentList<SharedTrack>;
+
+    // 'shown' is the list on screen, known here as 'shownName'
+    PlaylistManager(Playlist& shown, std::string shownName);
+    PlaylistManager(const PlaylistManager&) = delete;
+    PlaylistManager& operator=(const PlaylistManager&) = delete;
+
+    // --- Tracks ---
+
+    // A new reference to a track in the store (e.g. one of the playlist's)
+    SharedTrack share(TrackHandle h);
+
+    const TrackStore& getStore() const { return store; }
+    std::size_t trackCount() const { return store.size(); }
+
+    // How many times a track is referenced (the playlist, list nodes and
+    // SharedTracks); 0 for an empty SharedTrack or one from another manager
+    std::uint32_t refCount(const SharedTrack& track) const { return track.owner == this ? store.refCount(track.h) : 0; }
+
+    // Playlist::syncFiles, then the tracks whose files went are dropped from
+    // the kept lists as well
+    Playlist::SyncResult syncFiles(std::vector<FileUpdate>&& updates, const std::vector<std::string>& removedFiles,
+                                   const std::vector<std::string>& removedDirectories);
+
+    // --- The list shown ---
+
+    Playlist& shown() { return playlist; }
+    const std::string& shownName() const { return currentName; }
+
+    // Keep the list being shown and show 'name' instead (in O(n)); nothing
+    // changes if there is no such list
+    bool show(std::string_view name);
+
+    // --- Lists ---
+
+    // An empty list using the shared node pool (lists built elsewhere can't
+    // be stored here)
+    List makeList() const { return List(nodes); }
+
+    // These tracks, in order, as a balanced list in O(n)
+    List makeList(const std::vector<SharedTrack>& tracks) const { return List(tracks, nodes); }
+
+    // False if the name is taken
+    bool create(const std::string& name);
+
+    // Store 'list' under 'name', replacing any list kept there. False, and
+    // nothing stored, if 'name' is being shown or the list's nodes don't come
+    // from this manager's pool (it would later be appended to or freed into
+    // the wrong one)
+    bool put(const std::string& name, List list);
+
+    // 'to' becomes a copy of 'from', sharing all of it: O(1) whatever the size
+    // (O(n) when 'from' is the list shown). False if there is no 'from' or
+    // 'to' is taken.
+    bool clone(std::string_view from, const std::string& to);
+
+    bool rename(std::string_view from, const std::string& to);
+
+    // False for the list being shown
+    bool remove(std::string_view name);
+
+    // A kept list; null if there is no such list or it is the one shown (that
+    // one is the Playlist). The pointer stays valid until the list is removed
+    // or shown.
+    List* find(std::string_view name);
+    const List* find(std::string_view name) const;
+
+    // Every kept list with its name, in name order (not the one shown)
+    template <typename Visit>
+    void forEachList(Visit&& visit) const {
+        for (const auto& [name, list] : lists) visit(name, list);
+    }
+
+    // All of them, the shown one included, in name order
+    std::vector<std::string> names() const;
+    std::size_t listCount() const { return lists.size() + 1; }
+
+    // List nodes alive across the kept lists (shared ones counted once)
+    std::size_t nodeCount() const { return nodes.liveNodes(); }
+
+private:
+    Playlist& playlist;
+    TrackStore& store; // The playlist's
+    std::string currentName;
+    List::NodeAllocator nodes;
+    std::map<std::string, List, std::less<>> lists; // Last: its nodes count tracks in the store
+
+    // The playlist's tracks as a list of their own
+    List capture();
+};
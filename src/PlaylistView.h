@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include "Playlist.h"
+
+// A window onto the playlist: only the rows that fit on screen are ever visited.
+// The view remembers positions (the top row and the selected row), not node
+// pointers, so removing a track can never leave it holding a dangling node.
+// Each frame it resolves the top row with one O(log n) lookup and then steps
+// 'rows' nodes along next, so drawing costs the same for 50 tracks or 1M.
+//
+// While "following" (the default, and after jumpToCurrent) the window keeps
+// the current track in view as playback moves on. Scrolling by hand stops that.
+class PlaylistView {
+private:
+    int rows;       // Viewport height
+    int scroll;     // 1-based position of the top row
+    int cursor;     // 1-based position of the selected row
+    bool following; // Keep the current track selected and in view
+
+    void clampTo(int total) {
+        cursor = std::clamp(cursor, 1, std::max(total, 1));
+        // Keep the selection on screen, then don't scroll past the last page
+        if (cursor < scroll) scroll = cursor;
+        if (cursor >= scroll + rows) scroll = cursor - rows + 1;
+        scroll = std::clamp(scroll, 1, std::max(total - rows + 1, 1));
+    }
+
+public:
+    PlaylistView() : rows(1), scroll(1), cursor(1), following(true) {}
+
+    void setRows(int visibleRows) {
+        rows = std::max(visibleRows, 1);
+    }
+
+    // Up/Down (delta = +-1), PageUp/PageDown (delta = +-rows)
+    void moveCursor(int delta, int total) {
+        following = false;
+        cursor += delta;
+        clampTo(total);
+    }
+
+    void pageUp(int total) { moveCursor(-rows, total); }
+    void pageDown(int total) { moveCursor(rows, total); }
+
+    void cursorToStart(int total) { moveCursor(-cursor, total); }
+    void cursorToEnd(int total) { moveCursor(total, total); }
+
+    void jumpToCurrent() {
+        following = true;
+    }
+
+    int getCursor() const { return cursor; }
+    int getScroll() const { return scroll; }
+    int getRows() const { return rows; }
+
+    // Settle the window for this frame, then call
+    //     visit(track, position, isSelected, isCurrent)
+    // for each visible row, top to bottom. O(log n + rows).
+    template <typename Visit>
+    void forEachVisible(const Playlist& playlist, Visit&& visit) {
+        int total = playlist.getTotalTracks();
+        if (following) {
+            int current = playlist.getCurrentPosition();
+            if (current > 0) {
+                // Re-centre only when the current track leaves the window,
+                // so plain Next/Prev doesn't make the list jump around
+                if (current < scroll || current >= scroll + rows) scroll = current - rows / 3;
+                cursor = current;
+            }
+        }
+        clampTo(total);
+
+        const TrackStore& store = playlist.getStore();
+        TrackRef current = playlist.getCurrentTrack();
+        const node<TrackHandle>* n = playlist.getTrackNodeAt(scroll);
+        for (int position = scroll; n != nullptr && position < scroll + rows; position++, n = n->next) {
+            TrackRef track = store.ref(n->data);
+            visit(track, position, position == cursor, track == current);
+        }
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// One value published by a single writer thread and read by up to MaxReaders
+// other threads, read-copy-update style with epoch-based reclamation.
+//
+// The writer builds a new T and swaps the pointer; readers never lock, never
+// wait and never see a half-written value. A replaced T is freed only once
+// every reader that might still hold it has left its read section: each
+// reader announces the epoch it entered at, and the writer frees what was
+// retired before the oldest announced epoch. Neither side ever waits for the
+// other; a reader that stays inside a read section just delays frees.
+template <typename T, std::size_t MaxReaders = 4>
+class RcuCell {
+private:
+    static constexpr std::uint64_t Quiescent = 0;
+
+    struct Retired {
+        const T* value;
+        std::uint64_t epoch; // Unsafe to free while a reader entered before this
+    };
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> entered{ Quiescent };
+    };
+
+    std::atomic<const T*> current;
+    std::atomic<std::uint64_t> epoch{ 1 };
+    std::array<ReaderSlot, MaxReaders> readers;
+    std::atomic<std::size_t> readerCount{ 0 };
+    std::vector<Retired> retired; // Writer only
+
+    void reclaim() {
+        std::uint64_t oldest = UINT64_MAX;
+        std::size_t count = readerCount.load();
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint64_t e = readers[i].entered.load();
+            if (e != Quiescent && e < oldest) oldest = e;
+        }
+        std::size_t kept = 0;
+        for (Retired& r : retired) {
+            if (r.epoch <= oldest) delete r.value;
+            else retired[kept++] = r;
+        }
+        retired.resize(kept);
+    }
+
+public:
+    // A registered reader thread; pass it to read()
+    class Reader {
+        friend class RcuCell;
+        std::size_t slot;
+        explicit Reader(std::size_t s) : slot(s) {}
+    };
+
+    // Keeps the value it points at alive until it goes out of scope
+    class ReadGuard {
+        friend class RcuCell;
+        std::atomic<std::uint64_t>* entered;
+        const T* value;
+
+        ReadGuard(std::atomic<std::uint64_t>& e, const T* v) : entered(&e), value(v) {}
+
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ~ReadGuard() { entered->store(Quiescent, std::memory_order_release); }
+
+        const T& operator*() const { return *value; }
+        const T* operator->() const { return value; }
+    };
+
+    explicit RcuCell(std::unique_ptr<T> initial = std::make_unique<T>()) : current(initial.release()) {}
+
+    ~RcuCell() {
+        delete current.load();
+        for (Retired& r : retired) delete r.value;
+    }
+
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    // Once per reader thread, up front (MaxReaders at most)
+    Reader registerReader() {
+        return Reader(readerCount.fetch_add(1));
+    }
+
+    // Reader side: O(1), no locks. Hold the guard briefly and don't nest
+    // guards for the same Reader.
+    ReadGuard read(const Reader& reader) {
+        std::atomic<std::uint64_t>& entered = readers[reader.slot].entered;
+        entered.store(epoch.load()); // seq_cst: announced before the pointer is loaded
+        return ReadGuard(entered, current.load());
+    }
+
+    // Writer side (one thread only): make 'next' the value new reads see, and
+    // free whatever no reader can still be looking at.
+    void publish(std::unique_ptr<T> next) {
+        const T* old = current.exchange(next.release());
+        // Readers that announce the new epoch loaded their pointer after the swap
+        std::uint64_t safeFrom = epoch.fetch_add(1) + 1;
+        retired.push_back(Retired{ old, safeFrom });
+        reclaim();
+    }
+
+    // Number of replaced values still waiting for readers to move on
+    std::size_t pendingFrees() const { return retired.size(); }
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inverted index from character trigrams to track IDs, for case-insensitive
+// substring search over title and artist.
+//
+// Every 3-byte window of a (lower-cased) field is hashed into one of a fixed
+// number of buckets; each bucket holds the IDs containing it, ascending. A
+// query's trigrams select a few buckets, and only IDs present in all of them
+// are candidates. Hash collisions (and trigrams that matched in different
+// fields) can produce false candidates, so the caller checks each one against
+// the real text before reporting it.
+//
+// IDs come from a counter, so appending keeps the lists sorted for free.
+// Removing a track only counts it as dead: its ID stays in the lists until
+// compact(), and the caller's ID lookup skips it in the meantime.
+class SearchIndex {
+public:
+    static constexpr std::size_t MinQueryLength = 3; // Shorter queries have no trigram to look up
+
+private:
+    static constexpr int BucketBits = 18;
+
+    std::vector<std::vector<int>> buckets;
+    std::size_t live;
+    std::size_t dead;
+
+    static std::uint32_t bucketOf(unsigned char a, unsigned char b, unsigned char c) {
+        std::uint32_t trigram = (std::uint32_t(a) << 16) | (std::uint32_t(b) << 8) | c;
+        return (trigram * 2654435761u) >> (32 - BucketBits);
+    }
+
+    static void collect(std::string_view text, std::vector<std::uint32_t>& out) {
+        for (std::size_t i = 0; i + 2 < text.size(); i++) {
+            out.push_back(bucketOf(lower(text[i]), lower(text[i + 1]), lower(text[i + 2])));
+        }
+    }
+
+    void addField(int id, std::string_view text) {
+        for (std::size_t i = 0; i + 2 < text.size(); i++) {
+            std::vector<int>& list = buckets[bucketOf(lower(text[i]), lower(text[i + 1]), lower(text[i + 2]))];
+            if (list.empty() || list.back() < id) {
+                list.push_back(id);
+            } else if (list.back() != id) {
+                // Out-of-order ID: keep the list sorted (and free of repeats)
+                auto at = std::lower_bound(list.begin(), list.end(), id);
+                if (*at != id) list.insert(at, id);
+            }
+            // list.back() == id: a trigram this track already has
+        }
+    }
+
+public:
+    SearchIndex() : live(0), dead(0) {}
+
+    bool isEmpty() const { return buckets.empty(); }
+
+    void clear() {
+        buckets.clear();
+        buckets.shrink_to_fit();
+        live = dead = 0;
+    }
+
+    // IDs should arrive in ascending order (anything else is insertion-sorted)
+    void add(int id, std::string_view title, std::string_view artist) {
+        if (buckets.empty()) buckets.resize(std::size_t(1) << BucketBits);
+
+        addField(id, title);
+        addField(id, artist);
+        live++;
+    }
+
+    void remove() {
+        if (live > 0) live--;
+        dead++;
+    }
+
+    // Worth a sweep once dead IDs make up a good share of the lists
+    bool needsCompaction() const {
+        return dead > 4096 && dead > live / 2;
+    }
+
+    // Drop every ID for which isLive(id) is false
+    template <typename IsLive>
+    void compact(IsLive&& isLive) {
+        for (std::vector<int>& list : buckets) {
+            list.erase(std::remove_if(list.begin(), list.end(), [&](int id) { return !isLive(id); }), list.end());
+        }
+        dead = 0;
+    }
+
+    // Calls visit(id) for each candidate ID, ascending, until it returns false.
+    // The query must be at least MinQueryLength bytes.
+    template <typename Visit>
+    void forEachCandidate(std::string_view query, Visit&& visit) const {
+        if (buckets.empty() || query.size() < MinQueryLength) return;
+
+        std::vector<std::uint32_t> wanted;
+        collect(query, wanted);
+        std::sort(wanted.begin(), wanted.end());
+        wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+        // Walk the shortest list; probe the others with a binary search that
+        // only ever moves forward (IDs are visited in increasing order)
+        std::vector<const std::vector<int>*> lists;
+        for (std::uint32_t b : wanted) lists.push_back(&buckets[b]);
+        std::sort(lists.begin(), lists.end(), [](const std::vector<int>* x, const std::vector<int>* y) {
+            return x->size() < y->size();
+        });
+        if (lists.front()->empty()) return;
+
+        std::vector<std::vector<int>::const_iterator> cursors;
+        for (const std::vector<int>* list : lists) cursors.push_back(list->begin());
+
+        for (int id : *lists.front()) {
+            bool inAll = true;
+            for (std::size_t k = 1; k < lists.size(); k++) {
+                cursors[k] = std::lower_bound(cursors[k], lists[k]->end(), id);
+                if (cursors[k] == lists[k]->end()) return; // No later ID can be in every list
+                if (*cursors[k] != id) {
+                    inAll = false;
+                    break;
+                }
+            }
+            if (inAll && !visit(id)) return;
+        }
+    }
+
+    // ASCII case folding, the only kind search and sorting use
+    static unsigned char lower(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return (u >= 'A' && u <= 'Z') ? static_cast<unsigned char>(u + ('a' - 'A')) : u;
+    }
+
+    // Case-insensitive (ASCII) substring test; 'loweredNeedle' must already be lower case
+    static bool containsIgnoreCase(std::string_view text, std::string_view loweredNeedle) {
+        if (loweredNeedle.empty()) return true;
+        if (text.size() < loweredNeedle.size()) return false;
+        for (std::size_t i = 0; i + loweredNeedle.size() <= text.size(); i++) {
+            std::size_t k = 0;
+            while (k < loweredNeedle.size() && lower(text[i + k]) == static_cast<unsigned char>(loweredNeedle[k])) k++;
+            if (k == loweredNeedle.size()) return true;
+        }
+        return false;
+    }
+
+    static std::string toLower(std::string_view text) {
+        std::string result(text);
+        for (char& c : result) c = static_cast<char>(lower(c));
+        return result;
+    }
+};
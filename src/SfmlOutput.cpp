@@ -0,0 +1,34 @@
+#include "SfmlOutput.h"
+
+using namespace std;
+
+SfmlOutput::~SfmlOutput() {
+    // The audio thread calls into the feed, so it has to stop before anything goes away
+    stream.stop();
+}
+
+void SfmlOutput::initialize(unsigned channels, unsigned sampleRate, const vector<sf::SoundChannel>& channelMap) {
+    stream.initialize(channels, sampleRate, channelMap);
+}
+
+AudioOutput::Status SfmlOutput::status() const {
+    switch (stream.getStatus()) {
+        case sf::SoundSource::Status::Playing: return Status::Playing;
+        case sf::SoundSource::Status::Paused: return Status::Paused;
+        default: return Status::Stopped;
+    }
+}
+
+bool SfmlOutput::Stream::onGetData(Chunk& data) {
+    if (feed == nullptr) return false;
+    const int16_t* samples = nullptr;
+    size_t count = 0;
+    bool more = feed->nextChunk(samples, count);
+    data.samples = samples;
+    data.sampleCount = count;
+    return more;
+}
+
+void SfmlOutput::Stream::onSeek(sf::Time timeOffset) {
+    if (feed != nullptr) feed->seekTo(chrono::microseconds(timeOffset.asMicroseconds()));
+}
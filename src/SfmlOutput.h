@@ -0,0 +1,35 @@
+#pragma once
+#include <SFML/Audio.hpp>
+#include "AudioOutput.h"
+
+// The sound card, through an sf::SoundStream
+class SfmlOutput : public AudioOutput {
+public:
+    SfmlOutput() = default;
+    ~SfmlOutput() override;
+
+    SfmlOutput(const SfmlOutput&) = delete;
+    SfmlOutput& operator=(const SfmlOutput&) = delete;
+
+    void attach(AudioFeed& feed) override { stream.feed = &feed; }
+    void initialize(unsigned channels, unsigned sampleRate, const std::vector<sf::SoundChannel>& channelMap) override;
+    void play() override { stream.play(); }
+    void pause() override { stream.pause(); }
+    void stop() override { stream.stop(); }
+    Status status() const override;
+    const char* name() const override { return "sfml"; }
+
+private:
+    class Stream : public sf::SoundStream {
+    public:
+        AudioFeed* feed = nullptr;
+
+        using sf::SoundStream::initialize;
+
+    protected:
+        bool onGetData(Chunk& data) override;
+        void onSeek(sf::Time timeOffset) override;
+    };
+
+    Stream stream;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "HashIndex.h"
+
+// A random play order over track IDs, produced one step at a time.
+//
+// IDs 1..limit-1 are run through a keyed Feistel permutation of a power-of-two
+// domain; values past the limit and IDs of removed tracks are skipped ("cycle
+// walking"). Turning shuffle on is O(1) and each step is O(1) expected, as
+// long as most IDs below the limit are still live.
+//
+// Only what was actually visited is remembered: the history (for Prev) and
+// the IDs handed out this round. Tracks added mid-shuffle join the order; if
+// the library outgrows the domain, the permutation is re-keyed over a bigger
+// one and the played set stops anything from coming up twice in a round.
+class ShuffleOrder {
+private:
+    static constexpr int Rounds = 4;
+
+    std::vector<int> history; // Play order; may hold removed IDs, skipped lazily
+    int cursor;               // Index of the current track in 'history' (-1 before the first)
+    HashIndex<bool> played;   // IDs handed out this round
+    std::uint64_t key;
+    std::uint64_t counter;    // Next Feistel input
+    int bits;                 // Domain is [0, 2^bits), bits even
+
+    static std::uint64_t mix(std::uint64_t x) {
+        // splitmix64 finaliser
+        x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27; x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    static int domainBits(int limit) {
+        int b = 2;
+        while ((std::uint64_t(1) << b) < static_cast<std::uint64_t>(limit > 1 ? limit - 1 : 1)) b += 2;
+        return b;
+    }
+
+    // Bijection on [0, 2^bits): a balanced Feistel network on two bits/2 halves
+    std::uint64_t permute(std::uint64_t x) const {
+        int half = bits / 2;
+        std::uint64_t mask = (std::uint64_t(1) << half) - 1;
+        std::uint64_t left = x >> half;
+        std::uint64_t right = x & mask;
+        for (int round = 0; round < Rounds; round++) {
+            std::uint64_t next = left ^ (mix(right ^ (key + round * 0x9E3779B97F4A7C15ull)) & mask);
+            left = right;
+            right = next;
+        }
+        return (left << half) | right;
+    }
+
+    void newRound(int limit) {
+        bits = domainBits(limit);
+        key = mix(key + 1);
+        counter = 0;
+    }
+
+    // Next ID of the permutation that is live and wasn't played this round
+    template <typename IsLive>
+    int fresh(int limit, IsLive&& isLive) {
+        while (true) {
+            if ((std::uint64_t(1) << bits) < static_cast<std::uint64_t>(limit - 1)) {
+                newRound(limit); // Library outgrew the domain; 'played' still holds this round
+            } else if (counter == (std::uint64_t(1) << bits)) {
+                played.clear(); // Everything had its turn: start over in a new order
+                newRound(limit);
+            }
+
+            int id = static_cast<int>(permute(counter++)) + 1;
+            if (id < limit && isLive(id) && played.find(id) == nullptr) {
+                played.insert(id, true);
+                return id;
+            }
+        }
+    }
+
+public:
+    ShuffleOrder() : cursor(-1), key(0), counter(0), bits(2) {}
+
+    // Begin a new order that starts at 'currentId' (0 for none). O(1).
+    void start(int currentId, int limit, std::uint64_t seed) {
+        history.clear();
+        cursor = -1;
+        played.clear();
+        key = mix(seed);
+        counter = 0;
+        bits = domainBits(limit);
+        if (currentId > 0) jumpTo(currentId);
+    }
+
+    // Step forward: replay the history if we went back, else draw a new ID.
+    // There must be at least one live ID below 'limit'.
+    template <typename IsLive>
+    int next(int limit, IsLive&& isLive) {
+        while (cursor + 1 < static_cast<int>(history.size())) {
+            cursor++;
+            if (isLive(history[static_cast<std::size_t>(cursor)])) return history[static_cast<std::size_t>(cursor)];
+        }
+        history.push_back(fresh(limit, isLive));
+        cursor = static_cast<int>(history.size()) - 1;
+        return history.back();
+    }
+
+    // What next() will return, without moving (drawn now and kept for next())
+    template <typename IsLive>
+    int peekNext(int limit, IsLive&& isLive) {
+        for (std::size_t i = static_cast<std::size_t>(cursor + 1); i < history.size(); i++) {
+            if (isLive(history[i])) return history[i];
+        }
+        history.push_back(fresh(limit, isLive));
+        return history.back();
+    }
+
+    // Step back through the history; 0 (and no move) at its start
+    template <typename IsLive>
+    int prev(IsLive&& isLive) {
+        for (int i = cursor - 1; i >= 0; i--) {
+            if (isLive(history[static_cast<std::size_t>(i)])) {
+                cursor = i;
+                return history[static_cast<std::size_t>(i)];
+            }
+        }
+        return 0;
+    }
+
+    template <typename IsLive>
+    int peekPrev(IsLive&& isLive) const {
+        for (int i = cursor - 1; i >= 0; i--) {
+            if (isLive(history[static_cast<std::size_t>(i)])) return history[static_cast<std::size_t>(i)];
+        }
+        return 0;
+    }
+
+    // The user picked a track: it becomes current, and whatever was already
+    // lined up after it still comes next
+    void jumpTo(int id) {
+        history.insert(history.begin() + (cursor + 1), id);
+        cursor++;
+        played.insert(id, true);
+    }
+
+    std::size_t remembered() const { return history.size(); }
+};
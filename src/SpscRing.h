@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Bounded single-producer / single-consumer queue.
+//
+// Exactly one thread may push and exactly one (other) thread may pop. Both
+// sides are wait-free: a push or pop is a few loads and one store, never a
+// lock or a retry loop. pushSome()/popSome() move a block of plain values
+// (e.g. audio samples) with one index update. Capacity must be a power of
+// two; the indices run freely and are masked on use, so all 'Capacity'
+// slots are usable.
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    static constexpr std::size_t Mask = Capacity - 1;
+    static constexpr std::size_t LineSize = 64; // Keeps the two indices off each other's cache line
+
+    alignas(LineSize) std::atomic<std::size_t> head{ 0 }; // Next slot to pop; written by the consumer
+    alignas(LineSize) std::size_t cachedTail = 0;         // Consumer's last look at 'tail'
+    alignas(LineSize) std::atomic<std::size_t> tail{ 0 }; // Next slot to fill; written by the producer
+    alignas(LineSize) std::size_t cachedHead = 0;         // Producer's last look at 'head'
+    alignas(LineSize) T slots[Capacity];
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only. False (and 'value' untouched) if the ring is full.
+    bool tryPush(T&& value) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) return false;
+        }
+        slots[t & Mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. False if the ring is empty.
+    bool tryPop(T& out) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        out = std::move(slots[h & Mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Copies as many of 'values' as fit; returns how many.
+    std::size_t pushSome(const T* values, std::size_t count) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (Capacity - (t - cachedHead) < count) cachedHead = head.load(std::memory_order_acquire);
+        std::size_t n = std::min(count, Capacity - (t - cachedHead));
+        for (std::size_t i = 0; i < n; i++) slots[(t + i) & Mask] = values[i];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only. Copies up to 'maxCount' values into 'out'; returns how many.
+    std::size_t popSome(T* out, std::size_t maxCount) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (cachedTail - h < maxCount) cachedTail = tail.load(std::memory_order_acquire);
+        std::size_t n = std::min(maxCount, cachedTail - h);
+        for (std::size_t i = 0; i < n; i++) out[i] = slots[(h + i) & Mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Approximate when called while the other side is active
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,544 @@
+#include "TagReader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+typedef vector<unsigned char> Bytes;
+
+namespace {
+
+    //----------------------------------------------------
+    // Small byte helpers
+    //----------------------------------------------------
+    uint32_t be32(const unsigned char* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+    uint32_t be24(const unsigned char* p) {
+        return (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]);
+    }
+    uint32_t le32(const unsigned char* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+    uint64_t le64(const unsigned char* p) {
+        return uint64_t(le32(p)) | (uint64_t(le32(p + 4)) << 32);
+    }
+    uint32_t syncsafe32(const unsigned char* p) {
+        return (uint32_t(p[0] & 0x7F) << 21) | (uint32_t(p[1] & 0x7F) << 14) | (uint32_t(p[2] & 0x7F) << 7) | uint32_t(p[3] & 0x7F);
+    }
+
+    Bytes readAt(ifstream& file, uint64_t offset, size_t count) {
+        Bytes buffer(count);
+        file.clear();
+        file.seekg(static_cast<streamoff>(offset));
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<streamsize>(count));
+        buffer.resize(static_cast<size_t>(max<streamsize>(file.gcount(), 0)));
+        return buffer;
+    }
+
+    string lowercase(string s) {
+        transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        return s;
+    }
+
+    //----------------------------------------------------
+    // Text decoding (ID3 text frames can be Latin-1, UTF-16 or UTF-8)
+    //----------------------------------------------------
+    void appendUtf8(string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    string latin1ToUtf8(const unsigned char* p, size_t len) {
+        string out;
+        for (size_t i = 0; i < len && p[i] != 0; i++) {
+            appendUtf8(out, p[i]);
+        }
+        return out;
+    }
+
+    string utf16ToUtf8(const unsigned char* p, size_t len, bool bigEndian) {
+        if (len >= 2) {
+            if (p[0] == 0xFF && p[1] == 0xFE) { bigEndian = false; p += 2; len -= 2; }
+            else if (p[0] == 0xFE && p[1] == 0xFF) { bigEndian = true; p += 2; len -= 2; }
+        }
+
+        string out;
+        for (size_t i = 0; i + 1 < len; i += 2) {
+            uint32_t unit = bigEndian ? uint32_t((p[i] << 8) | p[i + 1]) : uint32_t(p[i] | (p[i + 1] << 8));
+            if (unit == 0) break;
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < len) {
+                uint32_t low = bigEndian ? uint32_t((p[i + 2] << 8) | p[i + 3]) : uint32_t(p[i + 2] | (p[i + 3] << 8));
+                if (low >= 0xDC00 && low < 0xE000) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+            appendUtf8(out, unit);
+        }
+        return out;
+    }
+
+    string trimmed(string s) {
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\0')) s.pop_back();
+        size_t start = 0;
+        while (start < s.size() && s[start] == ' ') start++;
+        return s.substr(start);
+    }
+
+    string decodeId3Text(const unsigned char* p, size_t len) {
+        if (len < 1) return "";
+        unsigned char encoding = p[0];
+        p++;
+        len--;
+
+        switch (encoding) {
+            case 0: return trimmed(latin1ToUtf8(p, len));
+            case 1: return trimmed(utf16ToUtf8(p, len, false));
+            case 2: return trimmed(utf16ToUtf8(p, len, true));
+            default: {
+                size_t end = 0;
+                while (end < len && p[end] != 0) end++;
+                return trimmed(string(reinterpret_cast<const char*>(p), end));
+            }
+        }
+    }
+
+    // TXXX / TXX body: encoding, description, terminator, value
+    bool decodeId3UserText(const unsigned char* p, size_t len, string& description, string& value) {
+        if (len < 2) return false;
+        unsigned char encoding = p[0];
+        size_t unit = (encoding == 1 || encoding == 2) ? 2 : 1;
+        size_t end = 1;
+        while (end + unit <= len && !(p[end] == 0 && (unit == 1 || p[end + 1] == 0))) end += unit;
+        if (end + unit > len) return false;
+
+        // Both halves decode like ordinary text frames with the same encoding byte
+        Bytes part(1, encoding);
+        part.insert(part.end(), p + 1, p + end);
+        description = decodeId3Text(part.data(), part.size());
+        part.assign(1, encoding);
+        part.insert(part.end(), p + end + unit, p + len);
+        value = decodeId3Text(part.data(), part.size());
+        return true;
+    }
+
+    // Undo ID3 "unsynchronisation" (0xFF 0x00 -> 0xFF)
+    Bytes removeUnsync(const unsigned char* p, size_t len) {
+        Bytes out;
+        out.reserve(len);
+        for (size_t i = 0; i < len; i++) {
+            out.push_back(p[i]);
+            if (p[i] == 0xFF && i + 1 < len && p[i + 1] == 0x00) i++;
+        }
+        return out;
+    }
+
+    // "REPLAYGAIN_TRACK_GAIN" = "-6.54 dB", "REPLAYGAIN_TRACK_PEAK" = "0.988525"
+    void applyReplayGain(const string& lowerKey, const string& value, TrackTags& out) {
+        if (lowerKey == "replaygain_track_gain") {
+            char* end = nullptr;
+            float db = strtof(value.c_str(), &end);
+            if (end != value.c_str()) {
+                out.replayGainDb = db;
+                out.hasReplayGain = true;
+            }
+        } else if (lowerKey == "replaygain_track_peak") {
+            out.replayPeak = max(strtof(value.c_str(), nullptr), 0.0f);
+        }
+    }
+
+    //----------------------------------------------------
+    // Vorbis comments (shared by FLAC and Ogg Vorbis)
+    //----------------------------------------------------
+    void parseVorbisComment(const unsigned char* p, size_t len, TrackTags& out) {
+        if (len < 8) return;
+        size_t pos = 0;
+        uint32_t vendorLength = le32(p);
+        pos = 4 + static_cast<size_t>(vendorLength);
+        if (pos + 4 > len) return;
+
+        uint32_t count = le32(p + pos);
+        pos += 4;
+        for (uint32_t i = 0; i < count && pos + 4 <= len; i++) {
+            uint32_t entryLength = le32(p + pos);
+            pos += 4;
+            if (entryLength > len - pos) return;
+
+            string entry(reinterpret_cast<const char*>(p + pos), entryLength);
+            pos += entryLength;
+
+            size_t eq = entry.find('=');
+            if (eq == string::npos) continue;
+            string key = lowercase(entry.substr(0, eq));
+            if (key == "title" && out.title.empty()) out.title = trimmed(entry.substr(eq + 1));
+            else if (key == "artist" && out.artist.empty()) out.artist = trimmed(entry.substr(eq + 1));
+            else applyReplayGain(key, trimmed(entry.substr(eq + 1)), out);
+        }
+    }
+
+    //----------------------------------------------------
+    // MP3
+    //----------------------------------------------------
+    struct MpegFrame {
+        int bitrate = 0;      // kbit/s
+        int sampleRate = 0;
+        int samplesPerFrame = 0;
+        int frameLength = 0;  // bytes
+        int sideInfoSize = 0;
+    };
+
+    bool parseMpegHeader(const unsigned char* p, MpegFrame& f) {
+        if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+
+        int version = (p[1] >> 3) & 3;   // 0 = 2.5, 2 = 2, 3 = 1
+        int layer = (p[1] >> 1) & 3;     // 1 = III, 2 = II, 3 = I
+        int bitrateIndex = p[2] >> 4;
+        int rateIndex = (p[2] >> 2) & 3;
+        int padding = (p[2] >> 1) & 1;
+        bool mono = (p[3] >> 6) == 3;
+        if (version == 1 || layer == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) return false;
+
+        static const int rates[3][3] = { { 11025, 12000, 8000 }, { 22050, 24000, 16000 }, { 44100, 48000, 32000 } };
+        static const int v1Bitrates[3][15] = {
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 }, // Layer I
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },    // Layer II
+            { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }      // Layer III
+        };
+        static const int v2Bitrates[2][15] = {
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },    // Layer I
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }          // Layer II & III
+        };
+
+        bool mpeg1 = (version == 3);
+        int layerNumber = 4 - layer; // 1, 2 or 3
+        f.sampleRate = rates[version == 0 ? 0 : (version == 2 ? 1 : 2)][rateIndex];
+        f.bitrate = mpeg1 ? v1Bitrates[layerNumber - 1][bitrateIndex]
+                          : v2Bitrates[layerNumber == 1 ? 0 : 1][bitrateIndex];
+
+        if (layerNumber == 1) {
+            f.samplesPerFrame = 384;
+            f.frameLength = (12 * f.bitrate * 1000 / f.sampleRate + padding) * 4;
+        } else {
+            f.samplesPerFrame = (layerNumber == 3 && !mpeg1) ? 576 : 1152;
+            f.frameLength = f.samplesPerFrame / 8 * f.bitrate * 1000 / f.sampleRate + padding;
+        }
+
+        if (mpeg1) f.sideInfoSize = mono ? 17 : 32;
+        else f.sideInfoSize = mono ? 9 : 17;
+        return f.frameLength > 4;
+    }
+
+    void parseId3v2Frames(const Bytes& tag, int major, TrackTags& out, int& tlenMs) {
+        size_t pos = 0;
+        size_t idLength = (major == 2) ? 3 : 4;
+        size_t headerLength = (major == 2) ? 6 : 10;
+
+        while (pos + headerLength <= tag.size()) {
+            const unsigned char* h = tag.data() + pos;
+            if (h[0] == 0) break; // Padding
+
+            string id(reinterpret_cast<const char*>(h), idLength);
+            size_t size;
+            if (major == 2) size = be24(h + 3);
+            else if (major == 4) size = syncsafe32(h + 4);
+            else size = be32(h + 4);
+
+            pos += headerLength;
+            if (size > tag.size() - pos) break;
+
+            const unsigned char* body = tag.data() + pos;
+            size_t bodyLength = size;
+            Bytes cleaned;
+
+            if (major == 3) {
+                unsigned char flags = h[9];
+                if (flags & 0xC0) { pos += size; continue; }       // Compressed / encrypted
+                if ((flags & 0x20) && bodyLength > 0) { body++; bodyLength--; }        // Grouping byte
+            } else if (major == 4) {
+                unsigned char flags = h[9];
+                if (flags & 0x0C) { pos += size; continue; }       // Compressed / encrypted
+                if ((flags & 0x40) && bodyLength > 0) { body++; bodyLength--; }        // Grouping byte
+                if ((flags & 0x01) && bodyLength >= 4) { body += 4; bodyLength -= 4; }  // Data length indicator
+                if (flags & 0x02) {
+                    cleaned = removeUnsync(body, bodyLength);
+                    body = cleaned.data();
+                    bodyLength = cleaned.size();
+                }
+            }
+            pos += size;
+
+            if (id == "TIT2" || id == "TT2") {
+                if (out.title.empty()) out.title = decodeId3Text(body, bodyLength);
+            } else if (id == "TPE1" || id == "TP1") {
+                if (out.artist.empty()) out.artist = decodeId3Text(body, bodyLength);
+            } else if (id == "TLEN" || id == "TLE") {
+                tlenMs = atoi(decodeId3Text(body, bodyLength).c_str());
+            } else if (id == "TXXX" || id == "TXX") {
+                string description, value;
+                if (decodeId3UserText(body, bodyLength, description, value)) applyReplayGain(lowercase(description), value, out);
+            }
+        }
+    }
+
+    bool readMp3(ifstream& file, uint64_t fileSize, TrackTags& out) {
+        uint64_t audioStart = 0;
+        int tlenMs = 0;
+
+        // ID3v2 at the front
+        Bytes header = readAt(file, 0, 10);
+        if (header.size() == 10 && header[0] == 'I' && header[1] == 'D' && header[2] == '3') {
+            int major = header[3];
+            unsigned char flags = header[5];
+            uint32_t tagSize = syncsafe32(&header[6]);
+            audioStart = 10 + tagSize + ((flags & 0x10) ? 10 : 0); // Footer
+
+            if (major >= 2 && major <= 4) {
+                // Cap the read: huge tags are almost always cover art we don't need
+                Bytes tag = readAt(file, 10, min<uint32_t>(tagSize, 4u * 1024 * 1024));
+                if (flags & 0x80 && major < 4) tag = removeUnsync(tag.data(), tag.size());
+
+                size_t skip = 0;
+                if ((flags & 0x40) && tag.size() >= 4) {
+                    skip = (major == 4) ? syncsafe32(tag.data()) : be32(tag.data()) + 4;
+                }
+                if (skip < tag.size()) {
+                    tag.erase(tag.begin(), tag.begin() + static_cast<ptrdiff_t>(skip));
+                    parseId3v2Frames(tag, major, out, tlenMs);
+                }
+            }
+        }
+
+        // ID3v1 at the back (only fills what v2 didn't)
+        bool hasV1 = false;
+        if (fileSize >= 128) {
+            Bytes v1 = readAt(file, fileSize - 128, 128);
+            if (v1.size() == 128 && v1[0] == 'T' && v1[1] == 'A' && v1[2] == 'G') {
+                hasV1 = true;
+                if (out.title.empty()) out.title = trimmed(latin1ToUtf8(&v1[3], 30));
+                if (out.artist.empty()) out.artist = trimmed(latin1ToUtf8(&v1[33], 30));
+            }
+        }
+
+        // Duration from the first real frame
+        Bytes scan = readAt(file, audioStart, 64 * 1024);
+        MpegFrame frame;
+        size_t at = 0;
+        bool found = false;
+        for (; at + 4 <= scan.size(); at++) {
+            if (!parseMpegHeader(&scan[at], frame)) continue;
+            // Demand a second valid header right after, to avoid false syncs
+            size_t nextAt = at + static_cast<size_t>(frame.frameLength);
+            MpegFrame second;
+            if (nextAt + 4 > scan.size() || parseMpegHeader(&scan[nextAt], second)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            if (tlenMs > 0) out.duration = tlenMs / 1000;
+            return tlenMs > 0 || !out.title.empty();
+        }
+
+        // Xing / Info (VBR or LAME CBR) right after the side info
+        size_t xing = at + 4 + static_cast<size_t>(frame.sideInfoSize);
+        size_t vbri = at + 4 + 32;
+        uint32_t frames = 0;
+        if (xing + 12 <= scan.size() && (memcmp(&scan[xing], "Xing", 4) == 0 || memcmp(&scan[xing], "Info", 4) == 0)) {
+            if (be32(&scan[xing + 4]) & 1) frames = be32(&scan[xing + 8]);
+        } else if (vbri + 18 <= scan.size() && memcmp(&scan[vbri], "VBRI", 4) == 0) {
+            frames = be32(&scan[vbri + 14]);
+        }
+
+        if (frames > 0) {
+            out.duration = static_cast<int>(uint64_t(frames) * frame.samplesPerFrame / frame.sampleRate);
+        } else if (tlenMs > 0) {
+            out.duration = tlenMs / 1000;
+        } else {
+            uint64_t audioEnd = fileSize - (hasV1 ? 128 : 0);
+            uint64_t firstFrame = audioStart + at;
+            uint64_t audioBytes = audioEnd > firstFrame ? audioEnd - firstFrame : 0;
+            out.duration = static_cast<int>(audioBytes * 8 / (uint64_t(frame.bitrate) * 1000));
+        }
+        return true;
+    }
+
+    //----------------------------------------------------
+    // FLAC
+    //----------------------------------------------------
+    bool readFlac(ifstream& file, TrackTags& out) {
+        Bytes magic = readAt(file, 0, 4);
+        if (magic.size() < 4 || memcmp(magic.data(), "fLaC", 4) != 0) return false;
+
+        uint64_t pos = 4;
+        bool last = false;
+        while (!last) {
+            Bytes blockHeader = readAt(file, pos, 4);
+            if (blockHeader.size() < 4) break;
+            last = (blockHeader[0] & 0x80) != 0;
+            int type = blockHeader[0] & 0x7F;
+            uint32_t length = be24(&blockHeader[1]);
+            pos += 4;
+
+            if (type == 0 && length >= 18) { // STREAMINFO
+                Bytes info = readAt(file, pos, 18);
+                if (info.size() == 18) {
+                    uint32_t sampleRate = (uint32_t(info[10]) << 12) | (uint32_t(info[11]) << 4) | (info[12] >> 4);
+                    uint64_t totalSamples = (uint64_t(info[13] & 0x0F) << 32) | be32(&info[14]);
+                    if (sampleRate > 0) out.duration = static_cast<int>(totalSamples / sampleRate);
+                }
+            } else if (type == 4) { // VORBIS_COMMENT
+                Bytes comment = readAt(file, pos, length);
+                parseVorbisComment(comment.data(), comment.size(), out);
+            }
+            pos += length;
+        }
+        return true;
+    }
+
+    //----------------------------------------------------
+    // Ogg Vorbis
+    //----------------------------------------------------
+    bool readOgg(ifstream& file, uint64_t fileSize, TrackTags& out) {
+        Bytes head = readAt(file, 0, 256 * 1024);
+        if (head.size() < 27 || memcmp(head.data(), "OggS", 4) != 0) return false;
+
+        // Reassemble the first two packets (identification + comment headers)
+        vector<Bytes> packets(1);
+        uint32_t serial = le32(&head[14]);
+        size_t pos = 0;
+        while (pos + 27 <= head.size() && packets.size() <= 2) {
+            const unsigned char* page = &head[pos];
+            if (memcmp(page, "OggS", 4) != 0) break;
+            int segments = page[26];
+            if (pos + 27 + static_cast<size_t>(segments) > head.size()) break;
+
+            const unsigned char* table = page + 27;
+            size_t dataPos = pos + 27 + static_cast<size_t>(segments);
+            bool ours = le32(page + 14) == serial;
+
+            for (int s = 0; s < segments; s++) {
+                size_t lacing = table[s];
+                if (dataPos + lacing > head.size()) { dataPos = head.size(); break; }
+                if (ours && packets.size() <= 2) {
+                    packets.back().insert(packets.back().end(), head.begin() + static_cast<ptrdiff_t>(dataPos),
+                                          head.begin() + static_cast<ptrdiff_t>(dataPos + lacing));
+                    if (lacing < 255) packets.emplace_back();
+                }
+                dataPos += lacing;
+            }
+            pos = dataPos;
+        }
+
+        const Bytes& ident = packets[0];
+        if (ident.size() < 16 || ident[0] != 0x01 || memcmp(&ident[1], "vorbis", 6) != 0) return false;
+        uint32_t sampleRate = le32(&ident[12]);
+
+        if (packets.size() > 1) {
+            const Bytes& comment = packets[1];
+            if (comment.size() > 7 && comment[0] == 0x03 && memcmp(&comment[1], "vorbis", 6) == 0) {
+                parseVorbisComment(comment.data() + 7, comment.size() - 7, out);
+            }
+        }
+
+        // The last page's granule position is the total sample count
+        uint64_t tailSize = min<uint64_t>(fileSize, 64 * 1024);
+        Bytes tail = readAt(file, fileSize - tailSize, static_cast<size_t>(tailSize));
+        for (size_t i = tail.size() >= 27 ? tail.size() - 27 + 1 : 0; i-- > 0;) {
+            if (memcmp(&tail[i], "OggS", 4) == 0 && le32(&tail[i + 14]) == serial) {
+                uint64_t granule = le64(&tail[i + 6]);
+                if (sampleRate > 0 && granule != ~0ull) out.duration = static_cast<int>(granule / sampleRate);
+                break;
+            }
+        }
+        return true;
+    }
+
+    //----------------------------------------------------
+    // WAV
+    //----------------------------------------------------
+    bool readWav(ifstream& file, TrackTags& out) {
+        Bytes riff = readAt(file, 0, 12);
+        if (riff.size() < 12 || memcmp(riff.data(), "RIFF", 4) != 0 || memcmp(&riff[8], "WAVE", 4) != 0) return false;
+
+        uint64_t pos = 12;
+        uint32_t byteRate = 0;
+        uint64_t dataSize = 0;
+        while (true) {
+            Bytes chunk = readAt(file, pos, 8);
+            if (chunk.size() < 8) break;
+            uint32_t length = le32(&chunk[4]);
+            pos += 8;
+
+            if (memcmp(chunk.data(), "fmt ", 4) == 0) {
+                Bytes fmt = readAt(file, pos, 16);
+                if (fmt.size() == 16) byteRate = le32(&fmt[8]);
+            } else if (memcmp(chunk.data(), "data", 4) == 0) {
+                dataSize = length;
+            } else if (memcmp(chunk.data(), "LIST", 4) == 0) {
+                Bytes list = readAt(file, pos, min<uint32_t>(length, 64 * 1024));
+                if (list.size() >= 4 && memcmp(list.data(), "INFO", 4) == 0) {
+                    size_t at = 4;
+                    while (at + 8 <= list.size()) {
+                        uint32_t itemLength = le32(&list[at + 4]);
+                        if (itemLength > list.size() - at - 8) break;
+                        string value = trimmed(latin1ToUtf8(&list[at + 8], itemLength));
+                        if (memcmp(&list[at], "INAM", 4) == 0 && out.title.empty()) out.title = value;
+                        if (memcmp(&list[at], "IART", 4) == 0 && out.artist.empty()) out.artist = value;
+                        at += 8 + itemLength + (itemLength & 1);
+                    }
+                }
+            }
+            pos += length + (length & 1);
+        }
+
+        if (byteRate > 0) out.duration = static_cast<int>(dataSize / byteRate);
+        return byteRate > 0;
+    }
+}
+
+//----------------------------------------------------
+bool isSupportedAudioFile(const string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos) return false;
+    string ext = lowercase(path.substr(dot));
+    return ext == ".mp3" || ext == ".flac" || ext == ".ogg" || ext == ".oga" || ext == ".wav";
+}
+
+bool readTrackTags(const string& path, TrackTags& out) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+
+    file.seekg(0, ios::end);
+    streamoff end = file.tellg();
+    if (end <= 0) return false;
+    uint64_t fileSize = static_cast<uint64_t>(end);
+
+    size_t dot = path.find_last_of('.');
+    string ext = (dot == string::npos) ? "" : lowercase(path.substr(dot));
+
+    if (ext == ".flac") return readFlac(file, out);
+    if (ext == ".ogg" || ext == ".oga") return readOgg(file, fileSize, out);
+    if (ext == ".wav") return readWav(file, out);
+    if (ext == ".mp3") return readMp3(file, fileSize, out);
+    return false;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+// Metadata pulled straight out of an audio file's tags and stream headers.
+struct TrackTags {
+    std::string title;   // Empty if the file has no title tag
+    std::string artist;  // Empty if the file has no artist tag
+    int duration = 0;    // Seconds, from the stream headers (0 if unknown)
+
+    // ReplayGain track values, if the file was tagged with them
+    bool hasReplayGain = false;
+    float replayGainDb = 0.0f;
+    float replayPeak = 0.0f;     // Linear sample peak (0 if not tagged)
+};
+
+// Reads tags without decoding any audio:
+//     MP3  : ID3v2.2/2.3/2.4 (TIT2/TPE1/TLEN, TXXX ReplayGain), ID3v1, Xing/Info/VBRI or CBR duration
+//     FLAC : STREAMINFO + VORBIS_COMMENT (incl. REPLAYGAIN_TRACK_GAIN/PEAK)
+//     OGG  : Vorbis identification + comment headers, last granule position
+//     WAV  : fmt + data chunk sizes
+// Returns false if the file can't be opened or isn't a supported format.
+bool readTrackTags(const std::string& path, TrackTags& out);
+
+// True for the extensions the player (and readTrackTags) understands
+bool isSupportedAudioFile(const std::string& path);
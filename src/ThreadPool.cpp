@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    thread_local int workerIndex = -1;
+    thread_local const void* workerOwner = nullptr;
+}
+
+//----------------------------------------------------
+ThreadPool::ThreadPool(unsigned threadCount)
+    : queued(0), pending(0), nextQueue(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 2;
+    }
+
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+void ThreadPool::lowerCurrentPriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+//----------------------------------------------------
+void ThreadPool::submit(Task task) {
+    // Workers push onto their own deque; outsiders spread work round-robin
+    unsigned target;
+    if (workerOwner == this) {
+        target = static_cast<unsigned>(workerIndex);
+    } else {
+        target = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    }
+
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+
+    // Taking the sleep lock orders this notify after any worker's predicate check
+    { std::lock_guard<std::mutex> guard(sleepLock); }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(sleepLock);
+    allDone.wait(guard, [this] { return pending.load() == 0; });
+
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+//----------------------------------------------------
+bool ThreadPool::popLocal(unsigned self, Task& out) {
+    WorkQueue& q = *queues[self];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) return false;
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned self, Task& out) {
+    unsigned count = size();
+    for (unsigned offset = 1; offset < count; offset++) {
+        WorkQueue& victim = *queues[(self + offset) % count];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.tasks.empty()) continue;
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    workerIndex = static_cast<int>(self);
+    workerOwner = this;
+
+    Task task;
+    while (true) {
+        if (popLocal(self, task) || steal(self, task)) {
+            queued.fetch_sub(1);
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                if (!firstError) firstError = std::current_exception();
+            }
+            task = nullptr;
+
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        workAvailable.wait(guard, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own work at the back
+// (newest first, good for cache locality when a task spawns subtasks) and,
+// when it runs dry, steals the oldest task from the front of another worker.
+// Tasks may submit more tasks; wait() returns once all of them have finished.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads = one per hardware core
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+
+    // Block until every submitted task (and everything they spawned) is done.
+    // Rethrows the first exception a task threw, if any.
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Index of the calling worker in [0, size()), or -1 off the pool
+    static int currentWorker();
+
+    // Drop the calling thread below the UI and audio threads, so the scheduler
+    // always prefers them (background work calls it from its tasks). Linux
+    // niceness is per thread; where there is no such thing it does nothing.
+    static void lowerCurrentPriority();
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<std::size_t> queued;   // Tasks sitting in some deque
+    std::atomic<std::size_t> pending;  // Tasks submitted but not finished
+    std::atomic<unsigned> nextQueue;   // Round-robin for submits from outside
+    bool stopping;
+
+    std::mutex sleepLock;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::exception_ptr firstError;
+
+    bool popLocal(unsigned self, Task& out);
+    bool steal(unsigned self, Task& out);
+    void workerLoop(unsigned self);
+};
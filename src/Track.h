@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Text field of a Track. Normally owns its characters, but a track loaded from
+// a snapshot borrows them straight from the mapped file and only makes its own
+// copy once the field is assigned a new value. 16 bytes, versus 32 for std::string.
+// Copies of a borrowed string borrow the same memory.
+class TrackString {
+private:
+    const char* chars;
+    std::uint32_t length;
+    bool owns;
+
+    void assign(const char* s, std::size_t n) {
+        if (n == 0) {
+            chars = "";
+            length = 0;
+            owns = false;
+            return;
+        }
+        char* copy = new char[n];
+        std::memcpy(copy, s, n);
+        chars = copy;
+        length = static_cast<std::uint32_t>(n);
+        owns = true;
+    }
+
+    void release() {
+        if (owns) delete[] chars;
+        chars = "";
+        length = 0;
+        owns = false;
+    }
+
+public:
+    TrackString() : chars(""), length(0), owns(false) {}
+    TrackString(std::string_view s) : TrackString() { assign(s.data(), s.size()); }
+    TrackString(const std::string& s) : TrackString(std::string_view(s)) {}
+    TrackString(const char* s) : TrackString(std::string_view(s)) {}
+
+    TrackString(const TrackString& other) : TrackString() {
+        if (other.owns) assign(other.chars, other.length);
+        else { chars = other.chars; length = other.length; }
+    }
+
+    TrackString(TrackString&& other) noexcept : chars(other.chars), length(other.length), owns(other.owns) {
+        other.chars = "";
+        other.length = 0;
+        other.owns = false;
+    }
+
+    TrackString& operator=(TrackString other) noexcept {
+        std::swap(chars, other.chars);
+        std::swap(length, other.length);
+        std::swap(owns, other.owns);
+        return *this;
+    }
+
+    ~TrackString() { release(); }
+
+    // Refer to memory someone else keeps alive (e.g. a mapped snapshot)
+    static TrackString borrow(const char* s, std::uint32_t n) {
+        TrackString result;
+        result.chars = s;
+        result.length = n;
+        return result;
+    }
+
+    std::string_view view() const { return std::string_view(chars, length); }
+    std::string str() const { return std::string(chars, length); }
+    operator std::string_view() const { return view(); }
+
+    bool isBorrowed() const { return !owns && length > 0; }
+    bool empty() const { return length == 0; }
+    std::size_t size() const { return length; }
+
+    friend bool operator==(const TrackString& a, const TrackString& b) { return a.view() == b.view(); }
+    friend bool operator<(const TrackString& a, const TrackString& b) { return a.view() < b.view(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const TrackString& s) {
+        return os << s.view();
+    }
+};
+
+// ==========================================
+// 1. DATA ENTITY
+// ==========================================
+struct Track {
+    int id;
+    TrackString title;
+    TrackString artist;
+    int duration; // Seconds
+    TrackString filePath;
+
+    bool operator==(const Track& other) const { return id == other.id; }
+
+    friend std::ostream& operator<<(std::ostream& os, const Track& t) {
+        os << "[" << t.id << "] " << t.title << " by " << t.artist;
+        return os;
+    }
+};
+
+// A track read again because its file appeared, was rewritten or was renamed
+// on disk (LibraryWatcher), as Playlist::syncFiles() takes it
+struct FileUpdate {
+    Track track;             // Its id is ignored
+    std::string renamedFrom; // Where the file was before a rename, else empty
+};
+
+// What changed in the library's folders: over one burst of activity
+// (LibraryWatcher), or while nothing was watching (LibraryScanner::catchUp)
+struct LibraryChanges {
+    std::vector<FileUpdate> updated;             // New, rewritten or renamed files, read afresh (in path order)
+    std::vector<std::string> removedFiles;
+    std::vector<std::string> removedDirectories; // Everything under these went (deleted or moved away)
+    std::size_t events = 0;                      // Kernel events folded into this batch
+    bool overflowed = false;                     // The kernel dropped events: some changes are missing
+};
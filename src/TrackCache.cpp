@@ -0,0 +1,82 @@
+#include "TrackCache.h"
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+using namespace std;
+
+TrackCache::TrackCache(size_t budgetBytes) : budget(budgetBytes) {
+}
+
+TrackCache::Bytes TrackCache::load(const string& path) {
+    {
+        lock_guard<mutex> guard(lock);
+        auto found = byPath.find(path);
+        if (found != byPath.end()) {
+            // Move it to the front of the recency order
+            node<Entry>* entry = recency.unlink(found->second);
+            recency.insertNodeBefore(recency.getHead(), entry);
+            hitCount++;
+            return entry->data.bytes;
+        }
+        missCount++;
+        if (budget == 0) return nullptr;
+    }
+
+    error_code ec;
+    uintmax_t size = filesystem::file_size(path, ec);
+    if (ec || size > budget) return nullptr;
+
+    ifstream in(path, ios::binary);
+    if (!in) return nullptr;
+    auto data = make_shared<vector<char>>(static_cast<size_t>(size));
+    if (!in.read(data->data(), static_cast<streamsize>(size))) return nullptr;
+    Bytes bytes = std::move(data);
+
+    lock_guard<mutex> guard(lock);
+    auto found = byPath.find(path);
+    if (found != byPath.end()) return found->second->data.bytes; // Another thread read it meanwhile
+
+    byPath[path] = recency.emplaceAtBeginning(Entry{ path, bytes });
+    held += bytes->size();
+    evictOverBudget();
+    return bytes;
+}
+
+void TrackCache::forget(const string& path) {
+    lock_guard<mutex> guard(lock);
+    auto found = byPath.find(path);
+    if (found == byPath.end()) return;
+    held -= found->second->data.bytes->size();
+    recency.erase(found->second);
+    byPath.erase(found);
+}
+
+void TrackCache::setBudget(size_t budgetBytes) {
+    lock_guard<mutex> guard(lock);
+    budget = budgetBytes;
+    evictOverBudget();
+}
+
+TrackCache::Stats TrackCache::stats() const {
+    lock_guard<mutex> guard(lock);
+    Stats s;
+    s.hits = hitCount;
+    s.misses = missCount;
+    s.evictedBytes = evicted;
+    s.bytes = held;
+    s.entries = static_cast<size_t>(recency.nodeCount());
+    s.budget = budget;
+    return s;
+}
+
+void TrackCache::evictOverBudget() {
+    while (held > budget && !recency.isEmpty()) {
+        node<Entry>* oldest = recency.getTail();
+        size_t size = oldest->data.bytes->size();
+        held -= size;
+        evicted += size;
+        byPath.erase(oldest->data.path);
+        recency.erase(oldest);
+    }
+}
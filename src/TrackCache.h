@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DoublyLinkedList.h"
+
+// Whole audio files (still compressed) kept in memory, so reopening a track
+// that played recently, or was prefetched, decodes from RAM instead of going
+// back to the disk or network share. Least recently used files are dropped
+// once the total passes the byte budget. Thread-safe; the disk read itself
+// happens outside the lock.
+class TrackCache {
+public:
+    using Bytes = std::shared_ptr<const std::vector<char>>;
+
+    static constexpr std::size_t DefaultBudget = std::size_t{ 256 } << 20;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictedBytes = 0; // Dropped to stay under the budget, in total
+        std::size_t bytes = 0;          // Held right now
+        std::size_t entries = 0;
+        std::size_t budget = 0;
+    };
+
+    // A budget of 0 turns caching off: every load() misses and returns nullptr
+    explicit TrackCache(std::size_t budgetBytes = DefaultBudget);
+
+    TrackCache(const TrackCache&) = delete;
+    TrackCache& operator=(const TrackCache&) = delete;
+
+    // The file's bytes: from memory on a hit, else read and kept. nullptr if it
+    // can't be read or is bigger than the whole budget; stream it from disk then.
+    // An evicted file stays alive for as long as someone holds its Bytes.
+    Bytes load(const std::string& path);
+
+    // Drop the file, e.g. because it changed on disk. Whoever holds its Bytes keeps them.
+    void forget(const std::string& path);
+
+    void setBudget(std::size_t budgetBytes);
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string path;
+        Bytes bytes;
+    };
+
+    mutable std::mutex lock;
+    DoublyLinkedList<Entry> recency;                      // Most recently used first
+    std::unordered_map<std::string, node<Entry>*> byPath; // Into 'recency'
+    std::size_t budget;
+    std::size_t held = 0;
+    std::uint64_t hitCount = 0;
+    std::uint64_t missCount = 0;
+    std::uint64_t evicted = 0;
+
+    void evictOverBudget(); // Caller holds 'lock'
+};
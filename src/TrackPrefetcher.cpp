@@ -0,0 +1,138 @@
+#include "TrackPrefetcher.h"
+#include <algorithm>
+#include <utility>
+#include "LatencyHistogram.h"
+#include "TagReader.h"
+
+using namespace std;
+
+TrackPrefetcher::TrackPrefetcher(size_t cacheBytes, const LoudnessStore* store) : cache(cacheBytes), loudness(store) {
+    worker = thread([this] { workerLoop(); });
+}
+
+TrackPrefetcher::~TrackPrefetcher() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void TrackPrefetcher::setNextReadyCallback(ReadyCallback callback) {
+    lock_guard<mutex> guard(lock);
+    onNextReady = std::move(callback);
+}
+
+void TrackPrefetcher::prefetch(const string& nextPath, const string& prevPath) {
+    {
+        lock_guard<mutex> guard(lock);
+        wantedNext = nextPath;
+        wantedPrev = prevPath;
+        nextAnnounced = false;
+
+        // A delivered entry went to the stream, which has played or dropped it by now
+        ready.erase(remove_if(ready.begin(), ready.end(), [&](const Entry& e) {
+            return e.delivered || (e.path != wantedNext && e.path != wantedPrev);
+        }), ready.end());
+
+        announceNext();
+    }
+    wake.notify_one();
+}
+
+TrackPrefetcher::Source TrackPrefetcher::acquire(const string& path) {
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = find_if(ready.begin(), ready.end(), [&](const Entry& e) { return e.path == path; });
+        if (it != ready.end() && it->source) {
+            Source source = std::move(it->source);
+            ready.erase(it);
+            hitCount++;
+            return source;
+        }
+        missCount++;
+    }
+
+    // Miss: open it on the caller's thread, like a plain player would
+    return openTrack(path);
+}
+
+uint64_t TrackPrefetcher::hits() const {
+    lock_guard<mutex> guard(lock);
+    return hitCount;
+}
+
+uint64_t TrackPrefetcher::misses() const {
+    lock_guard<mutex> guard(lock);
+    return missCount;
+}
+
+TrackPrefetcher::Source TrackPrefetcher::openTrack(const string& path) {
+    auto source = make_shared<PcmSource>();
+    ScopedTimer timer(Probe::FileOpen);
+    TrackCache::Bytes bytes = cache.load(path);
+    bool opened = bytes ? source->openFromMemory(path, std::move(bytes)) : source->open(path);
+    if (!opened) return nullptr;
+
+    // The decoder doesn't expose tags; ReplayGain lives in the first few KB
+    // Tags win; otherwise what the background analysis measured
+    TrackTags tags;
+    LoudnessInfo measured;
+    if (readTrackTags(path, tags) && tags.hasReplayGain) {
+        source->setReplayGain(tags.replayGainDb, tags.replayPeak);
+    } else if (loudness && loudness->find(path, measured) && measured.hasLoudness()) {
+        source->setReplayGain(measured.gainDb(), measured.truePeak);
+    }
+    return source;
+}
+
+TrackPrefetcher::Entry* TrackPrefetcher::findReady(const string& path) {
+    for (Entry& e : ready) {
+        if (e.path == path) return &e;
+    }
+    return nullptr;
+}
+
+bool TrackPrefetcher::nextJob(string& path) {
+    // "next" first: it is both the likeliest key press and the gapless handover
+    for (const string* wanted : { &wantedNext, &wantedPrev }) {
+        if (!wanted->empty() && *wanted != inFlight && findReady(*wanted) == nullptr) {
+            path = *wanted;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrackPrefetcher::announceNext() {
+    if (nextAnnounced || !onNextReady) return;
+    Entry* entry = findReady(wantedNext);
+    if (entry == nullptr || !entry->source) return;
+
+    entry->delivered = true;
+    nextAnnounced = true;
+    onNextReady(entry->source);
+}
+
+void TrackPrefetcher::workerLoop() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        string path;
+        wake.wait(guard, [&] { return stopping || nextJob(path); });
+        if (stopping) return;
+
+        inFlight = path;
+        guard.unlock();
+
+        // The slow part (file read + decoder setup + preroll) runs unlocked
+        Source source = openTrack(path);
+
+        guard.lock();
+        inFlight.clear();
+        if (path == wantedNext || path == wantedPrev) {
+            ready.push_back(Entry{ path, std::move(source) });
+            announceNext();
+        }
+    }
+}
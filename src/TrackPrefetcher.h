@@ -0,0 +1,83 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LoudnessStore.h"
+#include "PcmSource.h"
+#include "TrackCache.h"
+
+// Opens the tracks on either side of the current one on a background thread,
+// so that Next/Prev find a decoder that is already set up with its first few
+// hundred milliseconds decoded. Holds at most the two tracks it was last
+// asked for; anything else is dropped as soon as the wanted set changes.
+// Files are read through a TrackCache, so going back to a track that played
+// or was prefetched recently decodes it from memory. Tracks without ReplayGain
+// tags are levelled by their measured loudness, when a LoudnessStore has it.
+class TrackPrefetcher {
+public:
+    using Source = std::shared_ptr<PcmSource>;
+    using ReadyCallback = std::function<void(const Source&)>;
+
+    // 'cacheBytes' is the TrackCache budget (0 = always read from disk).
+    // 'loudness' may be null, and otherwise must outlive the prefetcher.
+    explicit TrackPrefetcher(std::size_t cacheBytes = TrackCache::DefaultBudget,
+                             const LoudnessStore* loudness = nullptr);
+    ~TrackPrefetcher();
+
+    TrackPrefetcher(const TrackPrefetcher&) = delete;
+    TrackPrefetcher& operator=(const TrackPrefetcher&) = delete;
+
+    // Called on the worker thread (or inside prefetch()) once the "next"
+    // track is ready, e.g. to queue it on a GaplessStream
+    void setNextReadyCallback(ReadyCallback callback);
+
+    // Replace the wanted set. Empty paths are ignored.
+    void prefetch(const std::string& nextPath, const std::string& prevPath);
+
+    // Hand over a prefetched track, or open it here and now if it isn't ready.
+    // nullptr if the file can't be decoded.
+    Source acquire(const std::string& path);
+
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+    TrackCache::Stats cacheStats() const { return cache.stats(); }
+
+    // Any thread: the file changed on disk, so read it afresh next time
+    void forget(const std::string& path) { cache.forget(path); }
+
+private:
+    struct Entry {
+        std::string path;
+        Source source;          // nullptr if opening failed
+        bool delivered = false; // Given to the ready callback
+    };
+
+    TrackCache cache;
+    const LoudnessStore* loudness;
+
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::thread worker;
+    bool stopping = false;
+
+    std::string wantedNext;
+    std::string wantedPrev;
+    bool nextAnnounced = false;
+    std::string inFlight;
+    std::vector<Entry> ready;
+    ReadyCallback onNextReady;
+
+    std::uint64_t hitCount = 0;
+    std::uint64_t missCount = 0;
+
+    Source openTrack(const std::string& path); // From the cache if it can, else from disk
+    Entry* findReady(const std::string& path);
+    bool nextJob(std::string& path); // Caller holds 'lock'
+    void announceNext();             // Caller holds 'lock'
+    void workerLoop();
+};
@@ -0,0 +1,224 @@
+#include "TrackStore.h"
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace {
+    // Owned text is rewritten once this much of it belongs to removed tracks
+    const size_t CompactAfterDeadBytes = 1 << 20;
+
+    string_view cut(string_view s) {
+        return s.substr(0, min(s.size(), TrackStore::MaxTextLength));
+    }
+}
+
+//----------------------------------------------------
+uint32_t SymbolTable::insert(TrackString&& name) {
+    uint32_t symbol = static_cast<uint32_t>(names.size());
+    names.push_back(std::move(name));
+    lookup.emplace(names.back().view(), symbol);
+    lastSymbol = symbol;
+    return symbol;
+}
+
+uint32_t SymbolTable::intern(string_view s) {
+    if (!names.empty() && names[lastSymbol].view() == s) return lastSymbol;
+    auto found = lookup.find(s);
+    if (found != lookup.end()) return lastSymbol = found->second;
+    return insert(TrackString(s));
+}
+
+uint32_t SymbolTable::internBorrowed(string_view s) {
+    if (!names.empty() && names[lastSymbol].view() == s) return lastSymbol;
+    auto found = lookup.find(s);
+    if (found != lookup.end()) return lastSymbol = found->second;
+    return insert(TrackString::borrow(s.data(), static_cast<uint32_t>(s.size())));
+}
+
+void SymbolTable::ownNames() {
+    lookup.clear();
+    for (uint32_t symbol = 0; symbol < names.size(); symbol++) {
+        if (names[symbol].isBorrowed()) names[symbol] = TrackString(names[symbol].view());
+        lookup.emplace(names[symbol].view(), symbol);
+    }
+}
+
+//----------------------------------------------------
+void TrackStore::reserve(size_t tracks, size_t textBytes) {
+    // Grow at least geometrically: batch after batch must not copy everything each time
+    size_t count = ids.size() + tracks;
+    if (count > ids.capacity()) count = max(count, ids.capacity() * 2);
+    ids.reserve(count);
+    durations.reserve(count);
+    artistOf.reserve(count);
+    directoryOf.reserve(count);
+    text.reserve(count);
+    refs.reserve(count);
+
+    size_t bytes = owned.size() + textBytes;
+    if (bytes > owned.capacity()) owned.reserve(max(bytes, owned.capacity() * 2));
+}
+
+TrackHandle TrackStore::allocate() {
+    if (!freeHandles.empty()) {
+        TrackHandle h = freeHandles.back();
+        freeHandles.pop_back();
+        return h;
+    }
+    ids.push_back(0);
+    durations.push_back(0);
+    artistOf.push_back(0);
+    directoryOf.push_back(0);
+    text.push_back(TrackText{});
+    refs.push_back(0);
+    return static_cast<TrackHandle>(ids.size() - 1);
+}
+
+uint32_t TrackStore::appendText(string_view s) {
+    uint32_t offset = borrowedSize + static_cast<uint32_t>(owned.size());
+    owned.insert(owned.end(), s.begin(), s.end());
+    return offset;
+}
+
+TrackHandle TrackStore::add(const Track& track) {
+    string_view path = track.filePath.view();
+    size_t split = path.find_last_of("/\\");
+    size_t nameStart = (split == string_view::npos) ? 0 : split + 1;
+
+    uint32_t artist = artists.intern(track.artist.view());
+    uint32_t directory = directories.intern(path.substr(0, nameStart));
+    return add(track.id, track.title.view(), artist, track.duration, directory, path.substr(nameStart));
+}
+
+TrackHandle TrackStore::add(int id, string_view title, uint32_t artist, int duration, uint32_t directory, string_view fileName) {
+    return addStored(id, duration, artist, directory, storeText(title, fileName));
+}
+
+TrackText TrackStore::storeText(string_view title, string_view fileName) {
+    title = cut(title);
+    fileName = cut(fileName);
+
+    TrackText t = {};
+    t.nameOffset = appendText(fileName);
+    t.nameLength = static_cast<uint16_t>(fileName.size());
+    t.titleLength = static_cast<uint16_t>(title.size());
+
+    // "07 - Title.mp3" already holds the title
+    size_t inName = title.empty() ? 0 : fileName.find(title);
+    if (inName != string_view::npos) {
+        t.titleOffset = t.nameOffset + static_cast<uint32_t>(inName);
+    } else {
+        t.titleOffset = appendText(title);
+    }
+    return t;
+}
+
+TrackHandle TrackStore::addStored(int id, int duration, uint32_t artist, uint32_t directory, const TrackText& t) {
+    TrackHandle h = allocate();
+    ids[h] = id;
+    durations[h] = duration;
+    artistOf[h] = artist;
+    directoryOf[h] = directory;
+    text[h] = t;
+    refs[h] = 1;
+    return h;
+}
+
+bool TrackStore::borrowText(const char* bytes, size_t size) {
+    if (borrowed != nullptr || !owned.empty() || size > 0xFFFFFFFFu) return false;
+    borrowed = bytes;
+    borrowedSize = static_cast<uint32_t>(size);
+    return true;
+}
+
+// The borrowed bytes go in front of the owned ones: offset o then reads owned[o]
+// just as it read borrowed[o] (or owned[o - borrowedSize]) before
+void TrackStore::ownText() {
+    if (borrowed != nullptr) {
+        owned.insert(owned.begin(), borrowed, borrowed + borrowedSize);
+        borrowed = nullptr;
+        borrowedSize = 0;
+    }
+    artists.ownNames();
+    directories.ownNames();
+}
+
+string TrackStore::filePath(TrackHandle h) const {
+    string path(directoryName(h));
+    path += fileName(h);
+    return path;
+}
+
+//----------------------------------------------------
+size_t TrackStore::ownedBytesOf(const TrackText& t) const {
+    size_t bytes = 0;
+    if (t.nameOffset >= borrowedSize) bytes += t.nameLength;
+
+    bool titleInName = t.titleOffset >= t.nameOffset &&
+                       t.titleOffset + t.titleLength <= t.nameOffset + t.nameLength;
+    if (t.titleOffset >= borrowedSize && !titleInName) bytes += t.titleLength;
+    return bytes;
+}
+
+void TrackStore::update(TrackHandle h, const Track& track) {
+    string_view path = track.filePath.view();
+    size_t split = path.find_last_of("/\\");
+    size_t nameStart = (split == string_view::npos) ? 0 : split + 1;
+
+    deadBytes += ownedBytesOf(text[h]);
+    durations[h] = track.duration;
+    artistOf[h] = artists.intern(track.artist.view());
+    directoryOf[h] = directories.intern(path.substr(0, nameStart));
+    text[h] = storeText(track.title.view(), path.substr(nameStart));
+
+    if (deadBytes > CompactAfterDeadBytes && deadBytes > owned.size() / 2) compactText();
+}
+
+void TrackStore::remove(TrackHandle h) {
+    deadBytes += ownedBytesOf(text[h]);
+    ids[h] = 0;
+    text[h] = TrackText{};
+    refs[h] = 0;
+    freeHandles.push_back(h);
+
+    if (deadBytes > CompactAfterDeadBytes && deadBytes > owned.size() / 2) compactText();
+}
+
+bool TrackStore::release(TrackHandle h) {
+    if (--refs[h] > 0) return false;
+    remove(h);
+    return true;
+}
+
+// Copy the owned text of live tracks into a fresh arena; borrowed text stays put
+void TrackStore::compactText() {
+    vector<char> fresh;
+    fresh.reserve(owned.size() - deadBytes);
+
+    auto move = [&](uint32_t offset, uint16_t length) {
+        uint32_t moved = borrowedSize + static_cast<uint32_t>(fresh.size());
+        const char* from = owned.data() + (offset - borrowedSize);
+        fresh.insert(fresh.end(), from, from + length);
+        return moved;
+    };
+
+    for (size_t h = 0; h < ids.size(); h++) {
+        if (ids[h] == 0) continue;
+        TrackText& t = text[h];
+        bool titleInName = t.titleOffset >= t.nameOffset &&
+                           t.titleOffset + t.titleLength <= t.nameOffset + t.nameLength;
+
+        if (t.nameOffset >= borrowedSize) {
+            uint32_t moved = move(t.nameOffset, t.nameLength);
+            if (titleInName) t.titleOffset = moved + (t.titleOffset - t.nameOffset);
+            t.nameOffset = moved;
+        }
+        if (t.titleOffset >= borrowedSize && !titleInName) {
+            t.titleOffset = move(t.titleOffset, t.titleLength);
+        }
+    }
+
+    owned.swap(fresh);
+    deadBytes = 0;
+}
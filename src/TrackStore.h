@@ -0,0 +1,200 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Track.h"
+
+// Index of a track inside a TrackStore. Playlist nodes hold one of these
+// (4 bytes) instead of a whole Track.
+using TrackHandle = std::uint32_t;
+
+// Distinct strings stored once each and named by a dense 32-bit symbol.
+// Used for artist names and directories, which repeat thousands of times.
+class SymbolTable {
+private:
+    std::vector<TrackString> names;
+    std::unordered_map<std::string_view, std::uint32_t> lookup; // Views into 'names' (their bytes never move)
+    std::uint32_t lastSymbol = 0; // Tracks arrive grouped by album, so the previous answer is usually right
+
+    std::uint32_t insert(TrackString&& name);
+
+public:
+    // Symbol for 's', copying it the first time it is seen
+    std::uint32_t intern(std::string_view s);
+
+    // Same, but a new entry borrows 's' (e.g. from a mapped snapshot) instead of copying it
+    std::uint32_t internBorrowed(std::string_view s);
+
+    static constexpr std::uint32_t NotFound = 0xFFFFFFFFu;
+
+    // Symbol of 's' if it was ever interned, else NotFound
+    std::uint32_t find(std::string_view s) const {
+        auto found = lookup.find(s);
+        return found == lookup.end() ? NotFound : found->second;
+    }
+
+    // Copy every borrowed name, so the memory it came from can go away
+    void ownNames();
+
+    std::string_view name(std::uint32_t symbol) const { return names[symbol].view(); }
+    std::uint32_t size() const { return static_cast<std::uint32_t>(names.size()); }
+};
+
+// Where a track's title and file name live in the store's text.
+// When the title appears inside the file name ("07 - Title.mp3") it points
+// into the file name's bytes and costs nothing extra.
+struct TrackText {
+    std::uint32_t titleOffset;
+    std::uint32_t nameOffset;
+    std::uint16_t titleLength;
+    std::uint16_t nameLength;
+};
+
+class TrackRef;
+
+// Struct-of-arrays storage for every track of a playlist.
+//
+// The fields a full-library pass reads (id, duration, artist symbol) sit in
+// their own contiguous arrays, so a scan streams through 12 bytes per track
+// instead of hopping between nodes and heap strings. Artists and directories
+// are interned; titles and file names are packed into one text arena, which
+// may start with a borrowed region (a mapped snapshot) followed by owned bytes.
+// Text offsets below the borrowed size point into the borrowed region.
+//
+// Tracks are counted: add() hands out the first reference, and the track is
+// removed when release() drops the last one. A Playlist holds one per track
+// it lists; a PlaylistManager holds one per list entry.
+//
+// About 32 bytes per track plus its text, versus a Track's 64 bytes plus
+// three heap blocks. Handles of removed tracks are recycled.
+class TrackStore {
+public:
+    static constexpr std::size_t MaxTextLength = 0xFFFF; // Longer titles/names are cut
+
+    TrackStore() = default;
+    TrackStore(const TrackStore&) = delete;
+    TrackStore& operator=(const TrackStore&) = delete;
+
+    // Room for 'tracks' more tracks and 'textBytes' more bytes of text
+    void reserve(std::size_t tracks, std::size_t textBytes);
+
+    // Interns the artist, splits the path into directory + file name
+    TrackHandle add(const Track& track);
+    TrackHandle add(int id, std::string_view title, std::uint32_t artist, int duration,
+                    std::uint32_t directory, std::string_view fileName);
+
+    // Adds a track whose text is already in the store (a borrowed region).
+    // The caller has checked the offsets.
+    TrackHandle addStored(int id, int duration, std::uint32_t artist, std::uint32_t directory, const TrackText& text);
+
+    // Use 'bytes' as the start of the text arena without copying it. Only possible
+    // while no text has been added yet; the caller keeps the memory alive.
+    bool borrowText(const char* bytes, std::size_t size);
+
+    // Copy the borrowed text and symbol names into the store, after which the
+    // memory they were borrowed from is no longer needed. Offsets stay valid.
+    void ownText();
+
+    // Give the track new fields and text (its file was re-read or renamed),
+    // keeping its ID, its handle and its references
+    void update(TrackHandle h, const Track& track);
+
+    // Removes the track whatever its count
+    void remove(TrackHandle handle);
+
+    void retain(TrackHandle h) { refs[h]++; }
+    // True if that was the last reference and the track is gone
+    bool release(TrackHandle h);
+    std::uint32_t refCount(TrackHandle h) const { return refs[h]; }
+
+    SymbolTable& artistSymbols() { return artists; }
+    SymbolTable& directorySymbols() { return directories; }
+    const SymbolTable& artistSymbols() const { return artists; }
+    const SymbolTable& directorySymbols() const { return directories; }
+
+    // --- Field access: O(1) ---
+    int id(TrackHandle h) const { return ids[h]; }
+    int duration(TrackHandle h) const { return durations[h]; }
+    std::uint32_t artist(TrackHandle h) const { return artistOf[h]; }
+    std::uint32_t directory(TrackHandle h) const { return directoryOf[h]; }
+    std::string_view artistName(TrackHandle h) const { return artists.name(artistOf[h]); }
+    std::string_view directoryName(TrackHandle h) const { return directories.name(directoryOf[h]); }
+    std::string_view title(TrackHandle h) const { return textView(text[h].titleOffset, text[h].titleLength); }
+    std::string_view fileName(TrackHandle h) const { return textView(text[h].nameOffset, text[h].nameLength); }
+    std::string filePath(TrackHandle h) const;
+
+    TrackRef ref(TrackHandle h) const;
+
+    std::size_t size() const { return ids.size() - freeHandles.size(); }
+
+    // Every handle, live or free, is below this (for tables indexed by handle)
+    std::size_t handleLimit() const { return ids.size(); }
+
+private:
+    // Hot: read by full-library passes
+    std::vector<std::int32_t> ids; // 0 marks a free handle
+    std::vector<std::int32_t> durations;
+    std::vector<std::uint32_t> artistOf;
+    // Cold: only read when a track is shown or played
+    std::vector<std::uint32_t> directoryOf;
+    std::vector<TrackText> text;
+    std::vector<std::uint32_t> refs;
+
+    SymbolTable artists;
+    SymbolTable directories;
+
+    const char* borrowed = nullptr;
+    std::uint32_t borrowedSize = 0;
+    std::vector<char> owned;
+    std::size_t deadBytes = 0; // Owned text no live track refers to any more
+    std::vector<TrackHandle> freeHandles;
+
+    std::string_view textView(std::uint32_t offset, std::uint16_t length) const {
+        const char* base = offset < borrowedSize ? borrowed + offset : owned.data() + (offset - borrowedSize);
+        return std::string_view(base, length);
+    }
+
+    std::uint32_t appendText(std::string_view s);
+    TrackText storeText(std::string_view title, std::string_view fileName);
+    TrackHandle allocate();
+    std::size_t ownedBytesOf(const TrackText& t) const;
+    void compactText();
+};
+
+// A track as seen through the store: a store pointer and a handle, cheap to copy.
+// Converts to false when it refers to nothing (e.g. no current track).
+// Only valid until that track is removed.
+class TrackRef {
+private:
+    const TrackStore* store;
+    TrackHandle handle;
+
+public:
+    TrackRef() : store(nullptr), handle(0) {}
+    TrackRef(const TrackStore& s, TrackHandle h) : store(&s), handle(h) {}
+
+    explicit operator bool() const { return store != nullptr; }
+    TrackHandle getHandle() const { return handle; }
+
+    int id() const { return store->id(handle); }
+    int duration() const { return store->duration(handle); }
+    std::string_view title() const { return store->title(handle); }
+    std::string_view artist() const { return store->artistName(handle); }
+    std::string filePath() const { return store->filePath(handle); }
+
+    friend bool operator==(const TrackRef& a, const TrackRef& b) {
+        return a.store == b.store && (a.store == nullptr || a.handle == b.handle);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const TrackRef& t) {
+        return os << "[" << t.id() << "] " << t.title() << " by " << t.artist();
+    }
+};
+
+inline TrackRef TrackStore::ref(TrackHandle h) const {
+    return TrackRef(*this, h);
+}
@@ -0,0 +1,176 @@
+#include "Visualizer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    const float MinFrequency = 40.0f;
+    const float MaxFrequency = 16000.0f;
+    const float SpectrumFloorDb = -70.0f; // Bottom of the bars
+    const float LevelFloorDb = -48.0f;    // Bottom of the VU meter
+    const float FallPerSecond = 1.5f;     // Bars and levels: full height in two thirds of a second
+    const float PeakFallPerSecond = 0.4f;
+    const size_t FeedBlock = 256;         // Frames converted per pushSome()
+
+    // 'db' in [floor, 0] -> [0, 1]
+    float toScale(float db, float floor) {
+        return clamp((db - floor) / -floor, 0.0f, 1.0f);
+    }
+}
+
+Visualizer::Visualizer(function<void()> frameReady, unsigned framesPerSecond)
+    : onFrame(std::move(frameReady)), interval(chrono::nanoseconds(1000000000 / max(framesPerSecond, 1u))),
+      uiReader(published.registerReader()), fft(FftSize), history(FftSize), window(FftSize), windowed(FftSize),
+      power(fft.bins()), drained(RingFrames) {
+    const double pi = 3.14159265358979323846;
+    for (size_t i = 0; i < FftSize; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * cos(2.0 * pi * static_cast<double>(i) / FftSize));
+    }
+    worker = thread([this] { run(); });
+}
+
+Visualizer::~Visualizer() {
+    stopping = true;
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    worker.join();
+}
+
+void Visualizer::feed(const int16_t* interleaved, size_t frames, unsigned channels, unsigned sampleRate) {
+    if (!on.load(memory_order_relaxed) || channels == 0) return;
+    rate.store(sampleRate, memory_order_relaxed);
+
+    // Left and right only (mono twice); whatever doesn't fit is dropped
+    StereoSample block[FeedBlock];
+    for (size_t done = 0; done < frames;) {
+        size_t n = min(FeedBlock, frames - done);
+        for (size_t i = 0; i < n; i++) {
+            const int16_t* frame = interleaved + (done + i) * channels;
+            block[i] = StereoSample{ frame[0], channels > 1 ? frame[1] : frame[0] };
+        }
+        if (ring.pushSome(block, n) < n) break;
+        done += n;
+    }
+
+    // Only a sleeping worker needs a notify, which is a system call.
+    // The fence pairs with the worker's: either it sees the samples or we see 'idle'.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (idle.load(memory_order_relaxed)) {
+        idle.store(false, memory_order_relaxed);
+        wakeups.fetch_add(1);
+        wakeups.notify_one();
+    }
+}
+
+void Visualizer::setEnabled(bool enable) {
+    on.store(enable, memory_order_relaxed);
+}
+
+VisualizerFrame Visualizer::frame() {
+    auto latest = published.read(uiReader);
+    return *latest;
+}
+
+//----------------------------------------------------
+void Visualizer::run() {
+    auto next = Clock::now();
+    while (!stopping) {
+        size_t got = ring.popSome(drained.data(), drained.size());
+        bool moving = render(got);
+        if (onFrame) onFrame();
+
+        if (!moving && got == 0) {
+            // Silent and settled: sleep until feed() brings samples
+            uint32_t seen = wakeups.load();
+            idle.store(true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (ring.empty() && !stopping) wakeups.wait(seen);
+            idle.store(false, memory_order_relaxed);
+            next = Clock::now();
+            continue;
+        }
+
+        // A fixed cadence; after a stall, carry on from now rather than catch up
+        next += interval;
+        auto now = Clock::now();
+        if (next < now) next = now;
+        this_thread::sleep_until(next);
+    }
+}
+
+bool Visualizer::render(size_t count) {
+    unsigned cols = columns.load(memory_order_relaxed);
+    float seconds = chrono::duration<float>(interval).count();
+    float fall = FallPerSecond * seconds;
+    float peakFall = PeakFallPerSecond * seconds;
+
+    working.bands.resize(cols, 0.0f);
+    working.wave.assign(cols, 0.0f);
+
+    double sum[2] = {};
+    for (size_t i = 0; i < count; i++) {
+        float left = drained[i].left / 32768.0f;
+        float right = drained[i].right / 32768.0f;
+        sum[0] += static_cast<double>(left) * left;
+        sum[1] += static_cast<double>(right) * right;
+
+        float mono = 0.5f * (left + right);
+        history[historyPos] = mono;
+        historyPos = historyPos + 1 == FftSize ? 0 : historyPos + 1;
+        if (cols > 0) {
+            float& slice = working.wave[i * cols / count];
+            slice = max(slice, fabsf(mono));
+        }
+    }
+
+    if (count > 0) {
+        spectrum(cols, rate.load(memory_order_relaxed));
+    } else {
+        for (float& band : working.bands) band = max(band - fall, 0.0f);
+    }
+
+    bool moving = false;
+    for (int ch = 0; ch < 2; ch++) {
+        float target = 0.0f;
+        if (count > 0) target = toScale(10.0f * log10f(static_cast<float>(sum[ch] / count) + 1e-12f), LevelFloorDb);
+        working.level[ch] = max(target, working.level[ch] - fall);
+        working.peak[ch] = max(working.level[ch], working.peak[ch] - peakFall);
+        moving = moving || working.peak[ch] > 0.0f;
+    }
+    for (float band : working.bands) moving = moving || band > 0.0f;
+
+    working.number++;
+    published.publish(make_unique<VisualizerFrame>(working));
+    return moving;
+}
+
+void Visualizer::spectrum(unsigned cols, unsigned sampleRate) {
+    // Oldest sample first
+    for (size_t i = 0; i < FftSize; i++) {
+        size_t at = historyPos + i;
+        windowed[i] = history[at < FftSize ? at : at - FftSize] * window[i];
+    }
+    fft.powerSpectrum(windowed.data(), power.data());
+
+    // A full-scale sine peaks at |X| = N/4 under a Hann window: that is 0 dB
+    const float norm = 16.0f / (static_cast<float>(FftSize) * FftSize);
+    float binHz = static_cast<float>(sampleRate) / FftSize;
+    float top = min(MaxFrequency, sampleRate / 2.0f);
+    float fall = FallPerSecond * chrono::duration<float>(interval).count();
+    size_t lastBin = power.size() - 1;
+
+    for (unsigned c = 0; c < cols; c++) {
+        float from = MinFrequency * powf(top / MinFrequency, static_cast<float>(c) / cols);
+        float to = MinFrequency * powf(top / MinFrequency, static_cast<float>(c + 1) / cols);
+        size_t first = min(static_cast<size_t>(from / binHz), lastBin);
+        size_t last = min(max(first, static_cast<size_t>(to / binHz)), lastBin);
+
+        float strongest = 0.0f;
+        for (size_t b = first; b <= last; b++) strongest = max(strongest, power[b]);
+        float target = toScale(10.0f * log10f(strongest * norm + 1e-12f), SpectrumFloorDb);
+        working.bands[c] = max(target, working.bands[c] - fall);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "Fft.h"
+#include "RcuCell.h"
+#include "SpscRing.h"
+
+// One picture of what is playing, every value scaled to 0..1
+struct VisualizerFrame {
+    std::vector<float> bands; // Spectrum, one per column, log-spaced from 40 Hz up
+    std::vector<float> wave;  // Peak amplitude of each column's slice of the last frame's samples
+    float level[2] = {};      // RMS of left/right over the last frame, on a -48..0 dBFS scale
+    float peak[2] = {};       // Recent peaks on the same scale, falling back slowly
+    std::uint64_t number = 0; // Frames published so far
+};
+
+// Live spectrum, waveform and VU meter of the audio being played.
+//
+// The audio thread hands each chunk to feed(), which copies (at most) two
+// channels into a wait-free ring and returns; it never blocks, and a full
+// ring just drops samples. A worker thread wakes at the frame rate, drains
+// the ring, runs a Hann-windowed RealFft over the latest 2048 samples, bins
+// the spectrum into the requested number of columns and publishes a frame
+// through an RcuCell for the UI to read. After the audio stops it lets the
+// bars fall to zero, then sleeps until samples arrive again.
+class Visualizer {
+public:
+    static constexpr std::size_t FftSize = 2048;
+    static constexpr std::size_t RingFrames = 16384; // ~0.35 s at 48 kHz
+
+    // 'onFrame' runs on the worker after each published frame (e.g. to wake the UI)
+    explicit Visualizer(std::function<void()> onFrame, unsigned framesPerSecond = 30);
+    ~Visualizer();
+
+    Visualizer(const Visualizer&) = delete;
+    Visualizer& operator=(const Visualizer&) = delete;
+
+    // Audio thread. Interleaved samples as they go to the device.
+    void feed(const std::int16_t* interleaved, std::size_t frames, unsigned channels, unsigned sampleRate);
+
+    // Off: feed() drops everything and the worker sleeps
+    void setEnabled(bool on);
+    bool enabled() const { return on.load(std::memory_order_relaxed); }
+
+    // How many columns the next frames have (UI thread)
+    void setColumns(unsigned count) { columns.store(count, std::memory_order_relaxed); }
+
+    // The latest frame (UI thread only)
+    VisualizerFrame frame();
+
+private:
+    struct StereoSample {
+        std::int16_t left;
+        std::int16_t right;
+    };
+
+    std::function<void()> onFrame;
+    std::chrono::nanoseconds interval;
+
+    SpscRing<StereoSample, RingFrames> ring;
+    std::atomic<bool> on{ true };
+    std::atomic<unsigned> columns{ 0 };
+    std::atomic<unsigned> rate{ 44100 };
+    std::atomic<bool> idle{ false };
+    std::atomic<std::uint32_t> wakeups{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    RcuCell<VisualizerFrame, 2> published;
+    RcuCell<VisualizerFrame, 2>::Reader uiReader;
+
+    // Worker only
+    RealFft fft;
+    std::vector<float> history; // Mono, circular, FftSize samples
+    std::size_t historyPos = 0;
+    std::vector<float> window;  // Hann
+    std::vector<float> windowed;
+    std::vector<float> power;
+    std::vector<StereoSample> drained;
+    VisualizerFrame working;
+
+    std::thread worker;
+
+    void run();
+    bool render(std::size_t count); // False once everything has fallen to zero
+    void spectrum(unsigned cols, unsigned sampleRate);
+};
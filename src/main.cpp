@@ -1,174 +1,643 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
 #include <iostream>
 #include <string>
-#include <limits>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
 #include <SFML/Audio.hpp>
 #include "ConsoleUtils.h"
-#include "DoublyLinkedList.h" 
+#include "Playlist.h"
+#include "PlaylistManager.h"
+#include "PlaylistView.h"
+#include "LibraryScanner.h"
+#include "LibraryWatcher.h"
+#include "ThreadPool.h"
+#include "LibrarySnapshot.h"
+#include "PlaybackController.h"
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "SfmlOutput.h"
+#include "NullOutput.h"
+#include "DecodeBenchmark.h"
+#include "DuplicateFinder.h"
+#include "LoudnessAnalyzer.h"
+#include "Visualizer.h"
 
 using namespace std;
 
 // ==========================================
-// 1. DATA ENTITY
-// ==========================================
-struct Track {
-    int id;
-    string title;
-    string artist;
-    int duration;
-    string filePath;
-
-    bool operator==(const Track& other) const { return id == other.id; }
-    
-    friend ostream& operator<<(ostream& os, const Track& t) {
-        os << "[" << t.id << "] " << t.title << " by " << t.artist;
-        return os;
-    }
-};
-
-// ==========================================
-// 2. DOMAIN LOGIC (Playlist Class)
+// 3. PRESENTATION LAYER (MusicPlayer Class)
 // ==========================================
-class Playlist {
+class MusicPlayer {
 private:
-    DoublyLinkedList<Track> dll;
-    node<Track>* currentTrackNode;
-    int nextId;
+    static constexpr int VisualizerWidth = 64;     // Columns of spectrum at most
+    static constexpr int VisualizerMinHeight = 36; // Smaller terminals keep the rows for the playlist
 
-public:
-    Playlist() : currentTrackNode(nullptr), nextId(1) {}
-
-    void addTrack(const string& title, const string& artist, int duration, const string& path) {
-        Track newTrack = { nextId++, title, artist, duration, path };
-        dll.insertAtEnd(newTrack);
-        
-        // If it's the first track, point current to it
-        if (dll.nodeCount() == 1) {
-            currentTrackNode = dll.getHead();
-        }
-    }
-
-    void removeTrack(int id) {
-        // Find position of ID (O(N) search)
-        node<Track>* temp = dll.getHead();
-        int pos = 1;
-        while (temp != nullptr) {
-            if (temp->data.id == id) {
-                // Safety: If deleting the playing track, move pointer to next
-                if (temp == currentTrackNode) {
-                    moveNext(); 
-                    if (temp == currentTrackNode) currentTrackNode = nullptr; // If it was the only track
-                }
-                dll.deleteAtAnyPos(pos);
-                return;
-            }
-            temp = temp->next;
-            pos++;
-        }
-    }
+    PlaylistManager& lists; // Named playlists over the library; one of them is shown
+    Playlist& playlist;     // The one shown
+    PlaylistView view; // Scroll position + selection over the playlist
+    LibraryScanner& scanner;
+    FolderTimes& folders; // Library folder times, saved with the snapshot for the next start's catch-up
+    ConsoleUtils utils;
+    ScreenBuffer screen;
+    EventLoop events; // Keys, playback thread wake-ups and the clock tick, all in one wait
+    Visualizer visualizer;       // Declared after 'events' and before 'playback': fed by the audio thread
+    PlaybackController playback; // Declared after 'events': its thread wakes the loop
+    atomic<bool> stateChanged;   // Set with every wake-up that needs a full redraw (not the visualizer's)
+    int visualizerTop;           // Where the last full redraw put the visualizer (0 rows = not shown)
+    int visualizerRows;
+    int parkedX, parkedY;        // And where it left the pen
+    bool isPlaying;
+    PlaybackState playbackState; // As of the last syncPlayback()
+    uint64_t playGeneration;     // Of the last Play sent; older reports are stale
+    int seenAdvances;            // How much of playbackState's counters the playlist has followed
+    int seenEndings;
+    float volume;                // What '+'/'-' last asked for
+    unique_ptr<LoudnessAnalyzer> analyzer; // Background loudness measurement (null if turned off)
+    unique_ptr<DuplicateFinder> duplicates; // Fingerprinting pass, made on the first 'D'
+    unique_ptr<LibraryWatcher> watcher;     // Follows the library folders on disk (null if not watching)
+    Playlist::SyncResult synced;            // What the watcher's changes did to the playlist, in total
+    string statusMessage; // One line of feedback shown under the header
+    int sortStep;         // Which order 'O' sorts by next
 
-    void moveNext() {
-        if (currentTrackNode && currentTrackNode->next) {
-            currentTrackNode = currentTrackNode->next;
-        } else {
-            currentTrackNode = dll.getHead(); // Loop back to start
-        }
-    }
+    // Search-as-you-type ('/' opens it, Esc closes it)
+    bool searching;
+    string searchQuery;
+    vector<TrackRef> searchResults;
+    int searchSelected;
+    double searchMs;
 
-    void movePrev() {
-        if (currentTrackNode && currentTrackNode->prev) {
-            currentTrackNode = currentTrackNode->prev;
-        }
+    // Latency probes ('s' shows them; all of them go to a CSV at exit)
+    bool showStats;
+    chrono::steady_clock::time_point keyPressed; // When the key being handled arrived
+    bool framePending;                           // A key was handled but its frame isn't out yet
+
+    void playAudio() {
+        TrackRef current = playlist.getCurrentTrack();
+        if (!current) return;
+
+        // The playback thread opens and starts it; a failure comes back through syncPlayback()
+        uint64_t generation = playback.play(current.filePath());
+        if (generation == 0) return;
+        playGeneration = generation;
+        seenAdvances = 0;
+        seenEndings = 0;
+        isPlaying = true;
+        refreshPrefetch();
     }
 
-    Track* getCurrentTrack() {
-        if (currentTrackNode) return &(currentTrackNode->data);
-        return nullptr;
+    // From any thread: the next wake-up redraws everything, not just the visualizer
+    void requestRedraw() {
+        stateChanged = true;
+        events.notify();
     }
 
-    void displayPlaylist() {
-        dll.traverseForward();
+    // Warm up whatever Next/Prev would play now (call after any playlist change)
+    void refreshPrefetch() {
+        TrackRef next = playlist.peekNext();
+        TrackRef prev = playlist.peekPrev();
+        playback.prefetch(next ? next.filePath() : string(), prev ? prev.filePath() : string());
     }
 
-    int getTotalTracks() {
-        return dll.nodeCount(); // This must be O(1)
+    // Catch the playlist up with what the playback thread last reported
+    void syncPlayback() {
+        playbackState = playback.state();
+        if (playbackState.generation != playGeneration) return; // Our last Play is still on its way
+
+        if (playbackState.failed) isPlaying = false;
+        if (playbackState.advances > seenAdvances) {
+            // Gapless hand-over already happened; just follow it
+            while (seenAdvances < playbackState.advances) {
+                playlist.moveNext();
+                seenAdvances++;
+            }
+            refreshPrefetch();
+        }
+        if (playbackState.endings > seenEndings && isPlaying) {
+            seenEndings = playbackState.endings;
+            // Nothing was queued (not prefetched yet, or a different format): start it now
+            playlist.moveNext();
+            playAudio();
+        }
     }
-};
 
-// ==========================================
-// 3. PRESENTATION LAYER (MusicPlayer Class)
-// ==========================================
-class MusicPlayer {
-private:
-    Playlist& playlist;
-    sf::Music music;
-    ConsoleUtils utils;
-    bool isPlaying;
+    static string formatTime(int seconds) {
+        ostringstream text;
+        text << seconds / 60 << ":" << setw(2) << setfill('0') << seconds % 60;
+        return text.str();
+    }
 
-    void playAudio() {
-        Track* current = playlist.getCurrentTrack();
-        if (!current) return;
+    bool promptLine(const string& prompt, string& line) {
+        // Typed text scrolls the terminal behind the screen buffer's back
+        screen.invalidate();
+        cout << "\n" << prompt << flush;
+        bool entered = events.readLine(line);
+        keyPressed = chrono::steady_clock::now(); // Time from the Enter, not from the key that opened the prompt
+        return entered;
+    }
 
-        music.stop();
-        if (music.openFromFile(current->filePath)) {
-            music.play();
-            isPlaying = true;
-        } else {
-            isPlaying = false;
-        }
+    bool promptNumber(const string& prompt, int& value) {
+        string line;
+        if (!promptLine(prompt, line)) return false;
+        istringstream parse(line);
+        return static_cast<bool>(parse >> value);
     }
 
     void drawDashboard() {
-        utils.clearConsole();
+        // Drawn into a back buffer, then only the cells that changed go out
+        int width, height;
+        ConsoleUtils::getConsoleSize(width, height);
+        screen.resize(width, height);
+        screen.clear();
+        visualizerRows = 0;
 
         // Header
-        utils.setForegroundColor(ConsoleColor::BrightCyan);
-        cout << "+------------------------------------------------+\n";
-        cout << "|                      HIVE                      |\n";
-        cout << "+------------------------------------------------+\n";
+        screen.setColor(ConsoleColor::BrightCyan);
+        screen << "+------------------------------------------------+\n";
+        screen << "|                      HIVE                      |\n";
+        screen << "+------------------------------------------------+\n";
 
         // 2. Your Signature 
-        utils.setForegroundColor(ConsoleColor::BrightYellow);
+        screen.setColor(ConsoleColor::BrightYellow);
         // 39 spaces ensures 'D' aligns perfectly with the box edge
-        cout << "                                  BY: JAWAD AHMED\n\n";
+        screen << "                                  BY: JAWAD AHMED\n\n";
+
+        if (!statusMessage.empty()) {
+            screen.setColor(ConsoleColor::BrightBlack);
+            screen << statusMessage << "\n\n";
+        }
 
         // Now Playing
-        Track* current = playlist.getCurrentTrack();
+        TrackRef current = playlist.getCurrentTrack();
         if (current) {
-            utils.setForegroundColor(ConsoleColor::BrightGreen);
-            cout << ">>> NOW PLAYING <<<\n";
-            utils.setForegroundColor(ConsoleColor::White);
-            cout << "Title  : " << current->title << "\n";
-            cout << "Artist : " << current->artist << "\n";
+            screen.setColor(ConsoleColor::BrightGreen);
+            screen << ">>> NOW PLAYING <<<\n";
+            screen.setColor(ConsoleColor::White);
+            screen << "Title  : " << current.title() << "\n";
+            screen << "Artist : " << current.artist() << "\n";
             
             if (isPlaying) {
-                utils.setForegroundColor(ConsoleColor::BrightYellow);
-                cout << "Status : [ PLAYING ]\n\n";
+                screen.setColor(ConsoleColor::BrightYellow);
+                screen << "Status : [ PLAYING ]";
             } else {
-                utils.setForegroundColor(ConsoleColor::BrightRed);
-                cout << "Status : [ PAUSED ]\n\n";
+                screen.setColor(ConsoleColor::BrightRed);
+                screen << "Status : [ PAUSED ]";
+            }
+            if (playlist.isShuffling()) {
+                screen.setColor(ConsoleColor::BrightMagenta);
+                screen << "  [ SHUFFLE ]";
+            }
+            screen << "\n\n";
+
+            screen.setColor(ConsoleColor::White);
+            screen << "Time   : " << formatTime(static_cast<int>(playback.trackOffset().asSeconds()));
+            if (current.duration() > 0) screen << " / " << formatTime(current.duration());
+            screen << "\n\n";
+
+            if (visualizer.enabled() && screen.height() >= VisualizerMinHeight) {
+                visualizerTop = screen.cursorY();
+                drawVisualizer();
+                visualizerRows = screen.cursorY() - visualizerTop;
+                screen << "\n";
+            }
+
+            GaplessStream::LatencyStats switchTime = playback.latency();
+            if (switchTime.switches > 0) {
+                screen.setColor(ConsoleColor::BrightBlack);
+                screen << "Switch : " << fixed << setprecision(1) << switchTime.lastUs / 1000.0
+                       << " ms to first sample (avg " << switchTime.averageUs / 1000.0 << " ms, "
+                       << playbackState.prefetchHits << "/" << playbackState.prefetchHits + playbackState.prefetchMisses
+                       << " prefetched)\n";
+            }
+            const TrackCache::Stats& cache = playbackState.cache;
+            if (cache.budget > 0 && cache.hits + cache.misses > 0) {
+                screen.setColor(ConsoleColor::BrightBlack);
+                screen << "Cache  : " << fixed << setprecision(1) << cache.bytes / 1048576.0 << " of "
+                       << cache.budget / 1048576.0 << " MB in " << cache.entries << " files, " << cache.hits << " hits / "
+                       << cache.misses << " misses, " << cache.evictedBytes / 1048576.0 << " MB evicted\n";
             }
+            screen.setColor(ConsoleColor::BrightBlack);
+            screen << "Audio  : volume " << static_cast<int>(volume * 100.0f + 0.5f) << "%, ReplayGain "
+                   << (playbackState.replayGain ? "on" : "off");
+            if (playbackState.crossfadeMs > 0) screen << ", crossfade " << setprecision(1) << playbackState.crossfadeMs / 1000.0 << " s";
+            screen << " (" << PlaybackController::dspName() << " DSP)\n";
+            if (analyzer) drawLoudnessLine();
+            if (duplicates) drawDuplicatesLine();
+            if (watcher) drawWatchLine();
+            screen << "Render : " << fixed << setprecision(2) << screen.lastFrameMilliseconds() << " ms, "
+                   << screen.lastFrameBytes() << " B/frame, " << setprecision(1) << screen.framesPerSecond() << " fps\n\n";
         } else {
-            utils.setForegroundColor(ConsoleColor::BrightRed);
-            cout << ">>> PLAYLIST EMPTY <<<\n\n";
+            screen.setColor(ConsoleColor::BrightRed);
+            screen << ">>> PLAYLIST EMPTY <<<\n\n";
         }
 
-        // Playlist Overview
-        utils.setForegroundColor(ConsoleColor::BrightMagenta);
-        cout << "--- PLAYLIST (" << playlist.getTotalTracks() << " Tracks) ---\n";
-        utils.setForegroundColor(ConsoleColor::White);
-        playlist.displayPlaylist();
-        cout << "\n";
+        if (showStats) drawStatsPanel();
+
+        const int ControlRows = 8;
+        if (searching) {
+            drawSearchResults(max(screen.height() - screen.cursorY() - ControlRows - 1, 1));
+        } else {
+            drawPlaylistWindow(ControlRows);
+        }
 
         // Controls
-        utils.setForegroundColor(ConsoleColor::BrightCyan);
-        cout << "+------------------------------------------------+\n";
-        utils.setForegroundColor(ConsoleColor::White);
-        cout << "[1] Play/Pause    [2] Next Track    [3] Prev Track\n";
-        cout << "[4] Add Song      [5] Remove Song   [6] Exit\n";
-        cout << "+------------------------------------------------+\n";
-        utils.setForegroundColor(ConsoleColor::BrightGreen);
-        cout << "Enter choice: ";
-        utils.setDefaultColor();
+        screen.setColor(ConsoleColor::BrightCyan);
+        screen << "+------------------------------------------------+\n";
+        screen.setColor(ConsoleColor::White);
+        screen << "[1] Play/Pause    [2] Next Track    [3] Prev Track    [+/-] Volume\n";
+        screen << "[4] Add Song      [5] Remove Song   [6] Exit          [S] Stats    [V] Visualizer\n";
+        screen << "[7] Jump to ID    [8] Move Song     [9] Shuffle       [0] Show Current  [O] Sort  [D] Dupes\n";
+        if (searching) {
+            screen << "[Type] Search title/artist   [Up/Down] Select   [Enter] Play   [Esc] Close\n";
+        } else {
+            screen << "[Up/Down PgUp/PgDn Home/End] Browse   [Enter] Play selected   [/] Search   [L] Lists   [C] Copy list\n";
+        }
+        screen << "+------------------------------------------------+\n";
+        screen.setColor(ConsoleColor::BrightGreen);
+        if (searching) {
+            screen << "Search: " << searchQuery;
+        } else {
+            screen << "Press a key: ";
+        }
+        screen.setDefaultColor();
+
+        parkedX = screen.cursorX();
+        parkedY = screen.cursorY();
+        screen.present();
+    }
+
+    // Spectrum bars, a waveform strip and a VU meter per channel. Every row is
+    // written out to the same width, so drawing it again over the last frame
+    // leaves nothing behind.
+    void drawVisualizer() {
+        static const char* const Rising[9] = { " ", "\xe2\x96\x81", "\xe2\x96\x82", "\xe2\x96\x83", "\xe2\x96\x84",
+                                               "\xe2\x96\x85", "\xe2\x96\x86", "\xe2\x96\x87", "\xe2\x96\x88" };
+        static const char* const Growing[9] = { " ", "\xe2\x96\x8f", "\xe2\x96\x8e", "\xe2\x96\x8d", "\xe2\x96\x8c",
+                                                "\xe2\x96\x8b", "\xe2\x96\x8a", "\xe2\x96\x89", "\xe2\x96\x88" };
+        const int SpectrumRows = 4;
+
+        int cols = min(screen.width(), VisualizerWidth);
+        visualizer.setColumns(static_cast<unsigned>(cols));
+        VisualizerFrame frame = visualizer.frame();
+        auto eighths = [](float value, int scale) { return static_cast<int>(value * static_cast<float>(scale) * 8.0f + 0.5f); };
+
+        // A new width takes a frame to reach the worker: blank until then
+        bool fits = static_cast<int>(frame.bands.size()) == cols;
+        screen.setColor(ConsoleColor::BrightCyan);
+        for (int row = 0; row < SpectrumRows; row++) {
+            for (int c = 0; c < cols; c++) {
+                int filled = fits ? eighths(frame.bands[c], SpectrumRows) - (SpectrumRows - 1 - row) * 8 : 0;
+                screen << Rising[clamp(filled, 0, 8)];
+            }
+            screen << "\n";
+        }
+        screen.setColor(ConsoleColor::BrightBlack);
+        for (int c = 0; c < cols; c++) screen << Rising[fits ? clamp(eighths(frame.wave[c], 1), 0, 8) : 0];
+        screen << "\n";
+
+        int meter = cols - 2;
+        for (int ch = 0; ch < 2; ch++) {
+            screen.setColor(ConsoleColor::White);
+            screen << (ch == 0 ? "L " : "R ");
+            int filled = eighths(frame.level[ch], meter);
+            int peakAt = min(static_cast<int>(frame.peak[ch] * static_cast<float>(meter)), meter - 1);
+            screen.setColor(ConsoleColor::BrightGreen);
+            for (int i = 0; i < meter; i++) {
+                if (i == peakAt && frame.peak[ch] > 0.0f && filled <= i * 8) screen << "|";
+                else screen << Growing[clamp(filled - i * 8, 0, 8)];
+            }
+            screen << "\n";
+        }
+    }
+
+    // A new visualizer frame and nothing else: redraw just its rows over the
+    // last full frame, so present() only sends the bars that moved
+    void redrawVisualizer() {
+        int width, height;
+        ConsoleUtils::getConsoleSize(width, height);
+        if (visualizerRows == 0 || width != screen.width() || height != screen.height()) return;
+        screen.setCursor(0, visualizerTop);
+        drawVisualizer();
+        screen.setDefaultColor();
+        screen.setCursor(parkedX, parkedY);
+        screen.present();
+    }
+
+    void drawLoudnessLine() {
+        LoudnessAnalyzer::Progress p = analyzer->progress();
+        if (p.queued == 0) return;
+        screen << "Level  : ";
+        if (p.finished()) screen << "loudness of " << p.measured + p.unchanged << " files known";
+        else screen << "measuring loudness, " << p.done() << " of " << p.queued << " files";
+        screen << " (" << p.measured << " measured in " << fixed << setprecision(1) << p.busySeconds << " s, "
+               << p.unchanged << " unchanged";
+        if (p.failed > 0) screen << ", " << p.failed << " unreadable";
+        screen << ")\n";
+    }
+
+    void drawDuplicatesLine() {
+        DuplicateFinder::Progress p = duplicates->progress();
+        if (p.queued == 0) return;
+        screen << "Dupes  : ";
+        if (p.running()) screen << "fingerprinting, " << p.done() << " of " << p.queued << " files";
+        else if (p.duplicates == 0) screen << "no duplicates among " << p.queued << " files";
+        else screen << "copies found: " << p.duplicates << " extra, of " << p.groups << " recordings; [D] removes them";
+        screen << " (" << fixed << setprecision(1) << p.busySeconds << " s";
+        if (p.tooShort > 0) screen << ", " << p.tooShort << " too short";
+        if (p.failed > 0) screen << ", " << p.failed << " unreadable";
+        screen << ")\n";
+    }
+
+    void drawWatchLine() {
+        screen << "Watch  : " << watcher->watchedDirectories() << " folders";
+        if (watcher->unwatchedDirectories() > 0) {
+            screen << " (" << watcher->unwatchedDirectories() << " over the limit, see fs.inotify.max_user_watches)";
+        }
+        if (synced.added + synced.updated + synced.removed > 0) {
+            screen << ", " << synced.added << " added, " << synced.updated << " updated, " << synced.removed << " removed";
+        }
+        screen << "\n";
+    }
+
+    // Fold what the watcher saw on disk into the playlist, a batch at a time.
+    // The playing track keeps playing: even a removed one plays to its end.
+    void syncLibrary() {
+        vector<LibraryChanges> batches = watcher->takeChanges();
+        if (batches.empty()) return;
+
+        for (LibraryChanges& batch : batches) {
+            vector<string> changed;
+            changed.reserve(batch.updated.size());
+            for (const FileUpdate& update : batch.updated) {
+                changed.push_back(update.track.filePath.str());
+                playback.forgetFile(changed.back()); // Never the old bytes from the cache
+            }
+            Playlist::SyncResult result;
+            {
+                ScopedTimer timer(Probe::PlaylistEdit);
+                result = lists.syncFiles(std::move(batch.updated), batch.removedFiles, batch.removedDirectories);
+            }
+            synced.added += result.added;
+            synced.updated += result.updated;
+            synced.removed += result.removed;
+            analyzeLoudness(changed);
+
+            ostringstream line;
+            line << "Library changed on disk: " << result.added << " added, " << result.updated << " updated, "
+                 << result.removed << " removed (" << batch.events << " file events)";
+            if (batch.overflowed) line << "; some changes were missed, --rescan to catch up";
+            statusMessage = line.str();
+        }
+
+        if (!playlist.getCurrentTrack()) {
+            playback.stop();
+            isPlaying = false;
+        }
+        if (searching) runSearch(); // Re-read tracks have new titles, and removed ones are gone
+        refreshPrefetch();
+    }
+
+    // 'D' fingerprints every track in the background; once copies of the same
+    // recording turn up, 'D' again keeps one of each and removes the rest
+    void findDuplicates() {
+        if (!duplicates) {
+            duplicates = make_unique<DuplicateFinder>();
+            duplicates->setProgressCallback([this] { requestRedraw(); });
+        }
+        DuplicateFinder::Progress p = duplicates->progress();
+        if (p.running()) {
+            statusMessage = "Still fingerprinting (" + to_string(p.done()) + " of " + to_string(p.queued) + " files)";
+            return;
+        }
+        if (p.grouped && p.duplicates > 0) {
+            vector<vector<int>> groups = duplicates->takeGroups();
+            int removed;
+            {
+                ScopedTimer timer(Probe::PlaylistEdit);
+                removed = playlist.collapseDuplicates(groups);
+            }
+            statusMessage = "Removed " + to_string(removed) + " duplicate tracks, kept one of each of " +
+                            to_string(groups.size()) + " recordings";
+            refreshPrefetch();
+            return;
+        }
+
+        vector<pair<int, string>> tracks;
+        tracks.reserve(static_cast<size_t>(playlist.getTotalTracks()));
+        playlist.forEachTrack([&](TrackRef track) { tracks.emplace_back(track.id(), track.filePath()); });
+        duplicates->find(std::move(tracks));
+        statusMessage = "Looking for duplicates among " + to_string(playlist.getTotalTracks()) + " tracks";
+    }
+
+    // Measure whatever the store doesn't know yet (unchanged files are skipped)
+    void analyzeLoudness(const vector<string>& paths) {
+        if (analyzer) analyzer->analyze(paths);
+    }
+
+    // p50/p99/max of every probe so far, in milliseconds
+    void drawStatsPanel() {
+        screen.setColor(ConsoleColor::BrightMagenta);
+        screen << "--- LATENCY (ms)        count       p50       p99       max ---\n";
+        screen.setColor(ConsoleColor::BrightBlack);
+        for (int p = 0; p < static_cast<int>(Probe::Count); p++) {
+            Probe probe = static_cast<Probe>(p);
+            LatencyHistogram::Summary s = Latency::of(probe).summary();
+            screen << "    " << left << setw(15) << Latency::name(probe) << right << setw(9) << s.count;
+            if (s.count > 0) {
+                screen << fixed << setprecision(3) << setw(10) << s.p50Ns / 1e6 << setw(10) << s.p99Ns / 1e6
+                       << setw(10) << s.maxNs / 1e6;
+            }
+            screen << "\n";
+        }
+        screen << "\n";
+    }
+
+    // Pad the row so a highlight spans the screen, then go to the next one
+    void endRow() {
+        if (screen.cursorX() < screen.width()) screen << string(screen.width() - screen.cursorX(), ' ');
+        screen << "\n";
+    }
+
+    void drawPlaylistWindow(int controlRows) {
+        // A window of as many rows as fit above the controls
+        int total = playlist.getTotalTracks();
+        screen.setColor(ConsoleColor::BrightMagenta);
+        screen << "--- PLAYLIST \"" << lists.shownName() << "\" (" << total << " Tracks) ---\n";
+        view.setRows(max(screen.height() - screen.cursorY() - controlRows, 1));
+        view.forEachVisible(playlist, [&](TrackRef track, int position, bool selected, bool playing) {
+            screen.setColor(playing ? ConsoleColor::BrightGreen : ConsoleColor::White,
+                            selected ? ConsoleColor::BrightBlack : ScreenBuffer::DefaultColor);
+            screen << (playing ? "> " : "  ") << setw(6) << position << "  " << track;
+            endRow();
+        });
+        screen.setColor(ConsoleColor::BrightBlack);
+        if (total > view.getRows()) {
+            screen << "Rows " << view.getScroll() << "-" << min(view.getScroll() + view.getRows() - 1, total)
+                   << " of " << total;
+        }
+        screen << "\n";
+    }
+
+    void drawSearchResults(int rows) {
+        screen.setColor(ConsoleColor::BrightMagenta);
+        screen << "--- SEARCH \"" << searchQuery << "\" (";
+        if (searchQuery.empty()) {
+            screen << "type to search";
+        } else {
+            screen << searchResults.size() << (static_cast<int>(searchResults.size()) > rows ? "+" : "")
+                   << " matches, " << fixed << setprecision(3) << searchMs << " ms";
+        }
+        screen << ") ---\n";
+
+        int shown = min(rows, static_cast<int>(searchResults.size()));
+        for (int i = 0; i < shown; i++) {
+            screen.setColor(ConsoleColor::White, i == searchSelected ? ConsoleColor::BrightBlack : ScreenBuffer::DefaultColor);
+            screen << "  " << searchResults[static_cast<size_t>(i)];
+            endRow();
+        }
+        screen.setDefaultColor();
+        for (int i = shown; i <= rows; i++) screen << "\n";
+    }
+
+    // Re-run the query on every keystroke (the trigram index makes this cheap).
+    // One extra result is fetched so the header can say "N+".
+    void runSearch() {
+        auto start = chrono::steady_clock::now();
+        int rows = max(view.getRows(), 1);
+        searchResults = playlist.searchTracks(searchQuery, rows + 1);
+        searchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        searchSelected = 0;
+    }
+
+    void handleSearchKey(int key) {
+        switch (key) {
+            case EventLoop::KeyEscape:
+                searching = false;
+                break;
+            case EventLoop::KeyEnter:
+                if (searchSelected < static_cast<int>(searchResults.size())) {
+                    playlist.jumpToTrack(searchResults[static_cast<size_t>(searchSelected)].id());
+                    searching = false;
+                    view.jumpToCurrent();
+                    playAudio();
+                }
+                break;
+            case EventLoop::KeyUp:
+                if (searchSelected > 0) searchSelected--;
+                break;
+            case EventLoop::KeyDown:
+                if (searchSelected + 1 < min(static_cast<int>(searchResults.size()), view.getRows())) searchSelected++;
+                break;
+            case 127: // Backspace (DEL on most terminals, BS on some)
+            case 8:
+                // Drop a whole UTF-8 character, not just its last byte
+                while (!searchQuery.empty() && (static_cast<unsigned char>(searchQuery.back()) & 0xC0) == 0x80) searchQuery.pop_back();
+                if (!searchQuery.empty()) searchQuery.pop_back();
+                runSearch();
+                break;
+            default:
+                if (key >= 32 && key < 256) {
+                    searchQuery.push_back(static_cast<char>(key));
+                    runSearch();
+                }
+                break;
+        }
+    }
+
+    // 'O' steps through title, artist and duration, then back to the order the tracks were added in
+    void sortPlaylist() {
+        static const SortKey keys[] = { SortKey::Title, SortKey::Artist, SortKey::Duration, SortKey::Id };
+        static const char* const names[] = { "title", "artist", "duration", "order added" };
+        auto start = chrono::steady_clock::now();
+        {
+            ScopedTimer timer(Probe::PlaylistEdit);
+            playlist.sortTracks(keys[sortStep]);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        ostringstream line;
+        line << "Sorted " << playlist.getTotalTracks() << " tracks by " << names[sortStep] << " in " << fixed
+             << setprecision(1) << ms << " ms";
+        statusMessage = line.str();
+        sortStep = (sortStep + 1) % 4;
+        refreshPrefetch();
+    }
+
+    // 'L': show another playlist (Enter alone steps to the next one). The one
+    // left is kept as it is; the playing track plays on if the new one has it.
+    void showList() {
+        vector<string> names = lists.names();
+        string list;
+        for (const string& name : names) list += (list.empty() ? "" : ", ") + name;
+        string name;
+        if (!promptLine("Playlists: " + list + "\nShow which (Enter = next): ", name)) return;
+        if (name.empty()) {
+            auto next = upper_bound(names.begin(), names.end(), lists.shownName());
+            name = next == names.end() ? names.front() : *next;
+        }
+
+        TrackRef before = playlist.getCurrentTrack();
+        int playingId = before ? before.id() : 0;
+        bool shown;
+        {
+            ScopedTimer timer(Probe::PlaylistEdit);
+            shown = lists.show(name);
+        }
+        if (!shown) {
+            statusMessage = "No playlist called \"" + name + "\"";
+            return;
+        }
+        TrackRef current = playlist.getCurrentTrack();
+        if (!current || current.id() != playingId) {
+            playback.stop();
+            isPlaying = false;
+        }
+        statusMessage = "Showing \"" + name + "\" (" + to_string(playlist.getTotalTracks()) + " tracks)";
+        view.jumpToCurrent();
+        refreshPrefetch();
+    }
+
+    // 'C': keep a copy of the playlist shown under a new name ('L' shows it)
+    void copyList() {
+        string name;
+        if (!promptLine("Name for a copy of \"" + lists.shownName() + "\": ", name) || name.empty()) return;
+        if (lists.clone(lists.shownName(), name)) {
+            statusMessage = "Copied \"" + lists.shownName() + "\" to \"" + name + "\"; [L] shows it";
+        } else {
+            statusMessage = "There is a playlist called \"" + name + "\" already";
+        }
+    }
+
+    void addFromPath(const string& path) {
+        error_code ec;
+        if (filesystem::is_directory(path, ec)) {
+            if (watcher) watcher->watch(path);
+            ScanResult result = scanner.scan(path);
+            statusMessage = describeScan(result);
+            folders.merge(result.folders); // Followed from the next start on, like the library's own
+            vector<string> added;
+            added.reserve(result.tracks.size());
+            for (const Track& track : result.tracks) added.push_back(track.filePath.str());
+            {
+                ScopedTimer timer(Probe::PlaylistEdit);
+                playlist.addTracks(std::move(result.tracks));
+            }
+            analyzeLoudness(added);
+        } else if (filesystem::is_regular_file(path, ec)) {
+            Track track = LibraryScanner::readTrack(path);
+            {
+                ScopedTimer timer(Probe::PlaylistEdit);
+                playlist.addTrack(std::move(track));
+            }
+            analyzeLoudness({ path });
+            statusMessage = "Added 1 track";
+        } else {
+            statusMessage = "No such file or folder: " + path;
+        }
+        refreshPrefetch();
     }
 
     void handleInput(int choice) {
@@ -176,16 +645,15 @@ private:
             case 1: // Play/Pause
                 if (isPlaying) {
                     // If currently playing, simply pause
-                    music.pause();
+                    playback.pause();
                     isPlaying = false;
                 } else {
-                    // CHECK: Is the song actually loaded?
-                    // If Duration is 0, it means no file is loaded yet (Fresh Start).
-                    if (music.getDuration() == sf::Time::Zero) {
+                    // CHECK: Is a track actually loaded? (Fresh Start, or it played to the end)
+                    if (!playbackState.hasSource || playbackState.status == AudioOutput::Status::Stopped) {
                         playAudio(); // Load the file and start from scratch
                     } else {
                         // File is loaded, just resume from where we left off
-                        music.play();
+                        playback.resume();
                         isPlaying = true;
                     }
                 }
@@ -198,82 +666,359 @@ private:
                 playlist.movePrev();
                 playAudio();
                 break;
-            case 4: { // Add
-                string title, artist, path;
-                cout << "Enter Title: "; cin.ignore(); getline(cin, title);
-                cout << "Enter Artist: "; getline(cin, artist);
-                cout << "Enter Filepath (.mp3): "; getline(cin, path);
-                playlist.addTrack(title, artist, 0, path);
+            case 4: { // Add (title/artist/duration come from the file's tags)
+                string path;
+                if (promptLine("Enter file or folder path: ", path)) addFromPath(path);
                 break;
             }
             case 5: { // Remove
                 int id;
-                cout << "Enter Track ID to delete: ";
-                cin >> id;
-                playlist.removeTrack(id);
+                if (!promptNumber("Enter Track ID to delete: ", id)) break;
+                {
+                    ScopedTimer timer(Probe::PlaylistEdit);
+                    playlist.removeTrack(id);
+                }
                 // Resync audio in case we deleted the currently playing track
-                if (playlist.getCurrentTrack() == nullptr) music.stop();
+                if (!playlist.getCurrentTrack()) {
+                    playback.stop();
+                    isPlaying = false;
+                }
+                refreshPrefetch();
+                break;
+            }
+            case 7: { // Jump
+                int id;
+                if (promptNumber("Enter Track ID to play: ", id) && playlist.jumpToTrack(id)) {
+                    view.jumpToCurrent();
+                    playAudio();
+                }
+                break;
+            }
+            case 8: { // Move
+                int id, position;
+                if (!promptNumber("Enter Track ID to move: ", id)) break;
+                if (!promptNumber("Enter new position (1-" + to_string(playlist.getTotalTracks()) + "): ", position)) break;
+                {
+                    ScopedTimer timer(Probe::PlaylistEdit);
+                    playlist.moveTrack(id, position);
+                }
+                refreshPrefetch();
                 break;
             }
+            case 9: // Shuffle on/off (Next/Prev and auto-advance follow it)
+                playlist.setShuffle(!playlist.isShuffling());
+                statusMessage = playlist.isShuffling() ? "Shuffle on" : "Shuffle off";
+                refreshPrefetch();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Keys that move around the playlist window (anything else just redraws)
+    void handleBrowseKey(int key) {
+        int total = playlist.getTotalTracks();
+        switch (key) {
+            case EventLoop::KeyUp: view.moveCursor(-1, total); break;
+            case EventLoop::KeyDown: view.moveCursor(1, total); break;
+            case EventLoop::KeyPageUp: view.pageUp(total); break;
+            case EventLoop::KeyPageDown: view.pageDown(total); break;
+            case EventLoop::KeyHome: view.cursorToStart(total); break;
+            case EventLoop::KeyEnd: view.cursorToEnd(total); break;
+            case '0': view.jumpToCurrent(); break;
+            case 's':
+            case 'S':
+                showStats = !showStats;
+                break;
+            case 'v':
+            case 'V':
+                visualizer.setEnabled(!visualizer.enabled());
+                break;
+            case 'o':
+            case 'O':
+                sortPlaylist();
+                break;
+            case 'd':
+            case 'D':
+                findDuplicates();
+                break;
+            case 'l':
+            case 'L':
+                showList();
+                break;
+            case 'c':
+            case 'C':
+                copyList();
+                break;
+            case '+':
+            case '=':
+            case '-':
+                // 5% steps; above 100% the soft clipper keeps peaks in range
+                volume = clamp(volume + (key == '-' ? -0.05f : 0.05f), 0.0f, 1.5f);
+                playback.setVolume(volume);
+                break;
+            case '/':
+                searching = true;
+                searchQuery.clear();
+                searchResults.clear();
+                break;
+            case EventLoop::KeyEnter:
+                if (playlist.jumpToPosition(view.getCursor())) {
+                    view.jumpToCurrent();
+                    playAudio();
+                }
+                break;
             default:
                 break;
         }
     }
 
 public:
-    MusicPlayer(Playlist& p) : playlist(p), isPlaying(false) {
+    // 'loudness' outlives the player; with 'analyze' set, the library's files
+    // are measured into it in the background
+    MusicPlayer(PlaylistManager& l, LibraryScanner& s, FolderTimes& f, unique_ptr<AudioOutput> output, size_t cacheBytes,
+                LoudnessStore& loudness, const string& loudnessPath, bool analyze)
+        : lists(l), playlist(l.shown()), scanner(s), folders(f), visualizer([this] { events.notify(); }),
+          playback(
+              std::move(output), cacheBytes, &loudness,
+              [this](const int16_t* samples, size_t count, unsigned channels, unsigned rate) {
+                  if (channels > 0) visualizer.feed(samples, count / channels, channels, rate);
+              },
+              [this] { requestRedraw(); }),
+          stateChanged(false), visualizerTop(0), visualizerRows(0), parkedX(0), parkedY(0), isPlaying(false), playGeneration(0), seenAdvances(0), seenEndings(0), volume(1.0f), sortStep(0), searching(false),
+          searchSelected(0), searchMs(0.0), showStats(false), framePending(false) {
         utils.enableVirtualTerminal();
+        refreshPrefetch();
+
+        if (analyze) {
+            analyzer = make_unique<LoudnessAnalyzer>(loudness, loudnessPath);
+            analyzer->setProgressCallback([this] { requestRedraw(); });
+            vector<string> paths;
+            paths.reserve(static_cast<size_t>(playlist.getTotalTracks()));
+            playlist.forEachTrack([&](TrackRef track) { paths.push_back(track.filePath()); });
+            analyzeLoudness(paths);
+        }
+    }
+
+    static string describeScan(const ScanResult& result) {
+        ostringstream line;
+        line << "Scanned " << result.filesSeen << " files in " << fixed << setprecision(2)
+             << result.seconds << " s (" << setprecision(0) << result.filesPerSecond() << " files/sec)";
+        if (result.failed > 0) line << ", " << result.failed << " without readable tags";
+        return line.str();
+    }
+
+    void setStatus(const string& message) {
+        statusMessage = message;
+    }
+
+    // Follow the library folder from now on (where the OS can tell us about changes)
+    void watchLibrary(const string& root) {
+        if (!LibraryWatcher::supported()) return;
+        if (!watcher) watcher = make_unique<LibraryWatcher>([this] { requestRedraw(); });
+        if (!watcher->watch(root)) watcher.reset();
+    }
+
+    void setAudioOptions(bool replayGain, chrono::milliseconds crossfade) {
+        playback.setReplayGain(replayGain);
+        playback.setCrossfade(crossfade);
     }
 
     void run() {
         bool running = true;
-        int choice;
+        bool fullRedraw = true;
 
         while (running) {
-            drawDashboard();
-            
-            cin >> choice;
-
-            if (cin.fail()) {
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                continue; 
+            if (fullRedraw) {
+                stateChanged = false; // Before reading the state: a change from here on wakes us again
+                if (watcher) syncLibrary();
+                syncPlayback();
+                {
+                    ScopedTimer timer(Probe::Render);
+                    drawDashboard();
+                }
+                if (framePending) {
+                    Latency::of(Probe::KeyToFrame).record(chrono::steady_clock::now() - keyPressed);
+                    framePending = false;
+                }
+            } else {
+                redrawVisualizer();
             }
 
-            if (choice == 6) {
-                running = false;
-                continue;
-            }
+            // Tick once a second for the clock, but only while something plays
+            events.setTimer(isPlaying ? chrono::milliseconds(1000) : chrono::milliseconds(0));
 
-            handleInput(choice);
+            EventLoop::Event event = events.next();
+            fullRedraw = true;
+            switch (event.type) {
+                case EventLoop::EventType::Key:
+                    keyPressed = chrono::steady_clock::now();
+                    syncPlayback(); // A track may have ended just before the key
+                    if (searching) {
+                        handleSearchKey(event.key);
+                    } else if (event.key == '6') {
+                        running = false;
+                    } else if (event.key >= '1' && event.key <= '9') {
+                        handleInput(event.key - '0');
+                    } else {
+                        handleBrowseKey(event.key);
+                    }
+                    Latency::of(Probe::Input).record(chrono::steady_clock::now() - keyPressed);
+                    framePending = true;
+                    break;
+                case EventLoop::EventType::Closed:
+                    running = false;
+                    break;
+                case EventLoop::EventType::Wake: // Playback thread reported (handled by syncPlayback()), or a visualizer frame
+                    fullRedraw = stateChanged;
+                    break;
+                case EventLoop::EventType::Timer: // Just redraw
+                    break;
+            }
         }
 
         utils.clearConsole();
         utils.setForegroundColor(ConsoleColor::BrightCyan);
         utils.showCredits();
+        utils.setDefaultColor();
     }
 };
 
 // ==========================================
 // 4. MAIN EXECUTION
 // ==========================================
-int main() {
+int main(int argc, char* argv[]) {
     // 1. Instantiate the Domain Layer
     Playlist myPlaylist;
+    PlaylistManager myLists(myPlaylist, "Library"); // Other playlists of the same tracks
+
+    // Command line: [library folder] [--rescan] [--headless] [--wav file] [--cache-mb N]
+    //               [--crossfade ms] [--no-replaygain] [--no-analysis] [--no-watch]
+    //               [--latency-csv file] [--decode-bench [threads]]
+    string libraryRoot = "assets/music";
+    bool forceRescan = false;
+    bool headless = false;           // No sound card: a null output paced like one
+    string wavPath;                  // Headless only: also write what plays to this file
+    bool decodeBench = false;        // Decode the whole library as fast as possible, report, exit
+    unsigned decodeThreads = 0;
+    size_t cacheBytes = TrackCache::DefaultBudget; // Recently read track files kept in memory (0 = off)
+    int crossfadeMs = 0;             // Overlap between tracks (0 = gapless cut)
+    bool replayGain = true;          // Level tracks by their ReplayGain tags (or measured loudness)
+    bool analyzeLoudness = true;     // Measure the library's loudness in the background
+    bool watchLibrary = true;        // Follow files added, changed or removed on disk
+    string latencyPath;              // Where to save the session's latency histograms (empty = nowhere)
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--rescan") forceRescan = true;
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--wav" && i + 1 < argc) {
+            headless = true;
+            wavPath = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            cacheBytes = static_cast<size_t>(atoll(argv[++i])) << 20;
+        } else if (arg == "--crossfade" && i + 1 < argc) {
+            crossfadeMs = max(atoi(argv[++i]), 0);
+        } else if (arg == "--no-replaygain") {
+            replayGain = false;
+        } else if (arg == "--no-analysis") {
+            analyzeLoudness = false;
+        } else if (arg == "--no-watch") {
+            watchLibrary = false;
+        } else if (arg == "--latency-csv" && i + 1 < argc) {
+            latencyPath = argv[++i];
+        } else if (arg == "--decode-bench") {
+            decodeBench = true;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) decodeThreads = static_cast<unsigned>(atoi(argv[++i]));
+        } else libraryRoot = arg;
+    }
+    const string snapshotPath = "hive_library.snap";
+    const string loudnessPath = "hive_loudness.db";
 
-    // Load initial assets
-    myPlaylist.addTrack("Faslon Ko Takkaluf", "Atif Aslam", 101, "assets/music/Faslon Ko Takkaluf.mp3");
-    myPlaylist.addTrack("Balaghal Ula Bi Kamaalihi", "Ali Zafar", 102, "assets/music/Balaghal Ula Bi Kamaalihi.mp3");
-    myPlaylist.addTrack("MUSTAFA JAAN E REHMAT", "Atif Aslam", 103, "assets/music/MUSTAFA JAAN E REHMAT.mp3");
-    //myPlaylist.addTrack("Song 4", "Artist D", 195, "assets/music/song4.mp3");
-    //myPlaylist.addTrack("Song 5", "Artist E", 220, "assets/music/song5.mp3");
+    ThreadPool workers;
+    LibraryScanner scanner(workers);
+    string startupReport;
+
+    // Fast path: map last session's snapshot. Slow path: scan the folder and write one.
+    auto loadStart = chrono::steady_clock::now();
+    string snapshotError;
+    FolderTimes folders; // When each library folder last changed, as of this start
+    if (!forceRescan && LibrarySnapshot::load(snapshotPath, myLists, libraryRoot, folders, &snapshotError)) {
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+        ostringstream line;
+        line << "Loaded " << myPlaylist.getTotalTracks() << " tracks (" << myLists.listCount() << " playlists) from snapshot in "
+             << fixed << setprecision(1) << ms << " ms";
+
+        // Catch up with what changed on disk while the player was closed: only
+        // folders whose time moved are listed. Not with the library folder
+        // missing, where an unmounted drive would look like every file went.
+        // The times stay as of this start, so the next one also catches what
+        // the watcher followed meanwhile (re-reading a few files for nothing).
+        error_code ec;
+        if (filesystem::is_directory(libraryRoot, ec)) {
+            vector<string> known;
+            const TrackStore& store = myLists.getStore();
+            known.reserve(store.size());
+            for (TrackHandle h = 0; h < store.handleLimit(); h++) {
+                if (store.id(h) != 0) known.push_back(store.filePath(h));
+            }
+            LibraryChanges changes = scanner.catchUp(folders, known);
+            Playlist::SyncResult result = myLists.syncFiles(std::move(changes.updated), changes.removedFiles,
+                                                            changes.removedDirectories);
+            if (result.added + result.updated + result.removed > 0) {
+                line << "; " << result.added << " added, " << result.updated << " updated, " << result.removed
+                     << " removed on disk since";
+            }
+        }
+        startupReport = line.str();
+    } else {
+        ScanResult scanned = scanner.scan(libraryRoot);
+        startupReport = MusicPlayer::describeScan(scanned);
+        myPlaylist.addTracks(std::move(scanned.tracks));
+        folders = std::move(scanned.folders);
+        string saveError;
+        if (!LibrarySnapshot::save(snapshotPath, myLists, libraryRoot, folders, &saveError)) startupReport += " (" + saveError + ")";
+    }
+
+    if (decodeBench) {
+        vector<string> paths;
+        paths.reserve(static_cast<size_t>(myPlaylist.getTotalTracks()));
+        myPlaylist.forEachTrack([&](TrackRef track) { paths.push_back(track.filePath()); });
+        cout << startupReport << "\n";
+        DecodeBenchmark::print(cout, DecodeBenchmark::run(paths, decodeThreads));
+        return 0;
+    }
 
     // 2. Instantiate the Presentation Layer and inject the Playlist
-    MusicPlayer player(myPlaylist);
+    unique_ptr<AudioOutput> output;
+    if (headless) {
+        output = make_unique<NullOutput>(NullOutput::Pacing::RealTime, wavPath);
+        startupReport += wavPath.empty() ? " (headless)" : " (headless, writing " + wavPath + ")";
+    } else {
+        output = make_unique<SfmlOutput>();
+    }
+    // Last session's measurements; missing or unreadable just means measuring from scratch
+    LoudnessStore loudness;
+    loudness.load(loudnessPath);
+
+    MusicPlayer player(myLists, scanner, folders, std::move(output), cacheBytes, loudness, loudnessPath, analyzeLoudness);
+    player.setStatus(startupReport);
+    player.setAudioOptions(replayGain, chrono::milliseconds(crossfadeMs));
+    if (watchLibrary) player.watchLibrary(libraryRoot);
 
     // 3. Start the application
     player.run();
 
+    // Persist this session's adds/removes/moves, and every playlist, for the next launch
+    string saveError;
+    if (!LibrarySnapshot::save(snapshotPath, myLists, libraryRoot, folders, &saveError)) {
+        cerr << "Library snapshot not saved: " << saveError << "\n";
+    }
+
+    // Latency histograms of the session, for offline analysis
+    if (!latencyPath.empty()) Latency::dump(latencyPath);
+
+#ifdef _WIN32
     system("pause>0");
+#endif
     return 0;
 }
\ No newline at end of file
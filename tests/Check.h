@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+// Just enough of a test framework for ctest: a failed CHECK reports where it
+// failed and ends the program with status 1.
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                  \
+        }                                                                                  \
+    } while (false)
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+// Runs every case, or only those named on the command line
+inline int runTests(std::initializer_list<TestCase> tests, int argc, char* argv[]) {
+    int ran = 0;
+    for (const TestCase& test : tests) {
+        bool wanted = argc < 2;
+        for (int i = 1; i < argc; i++) wanted = wanted || std::strcmp(argv[i], test.name) == 0;
+        if (!wanted) continue;
+        test.run();
+        std::printf("ok  %s\n", test.name);
+        ran++;
+    }
+    if (ran == 0) {
+        std::fprintf(stderr, "no such test\n");
+        return 1;
+    }
+    return 0;
+}
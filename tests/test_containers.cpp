@@ -0,0 +1,553 @@
+// The list containers, the ID hash and the search index, each run against a
+// std::vector that does the same thing the obvious way.
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Check.h"
+#include "HashIndex.h"
+#include "IndexedDoublyLinkedList.h"
+#include "ListSort.h"
+#include "NodePool.h"
+#include "PersistentList.h"
+#include "SearchIndex.h"
+
+using namespace std;
+
+namespace {
+    using List = IndexedDoublyLinkedList<int>;
+
+    int pick(mt19937& rng, int from, int to) {
+        return uniform_int_distribution<int>(from, to)(rng);
+    }
+
+    // Both directions of the list links, and the tree's answer for every position
+    void verify(const List& list, const vector<int>& model) {
+        CHECK(list.nodeCount() == static_cast<int>(model.size()));
+        CHECK(list.isEmpty() == model.empty());
+
+        size_t i = 0;
+        for (node<int>* n = list.getHead(); n != nullptr; n = n->next, i++) {
+            CHECK(i < model.size() && n->data == model[i]);
+            CHECK(list.nodeAt(static_cast<int>(i) + 1) == n);
+            CHECK(list.positionOf(n) == static_cast<int>(i) + 1);
+        }
+        CHECK(i == model.size());
+        for (node<int>* n = list.getTail(); n != nullptr; n = n->prev) CHECK(model[--i] == n->data);
+        CHECK(list.nodeAt(0) == nullptr && list.nodeAt(static_cast<int>(model.size()) + 1) == nullptr);
+    }
+
+    void fill(List& list, vector<int>& model, int count, int first) {
+        for (int k = 0; k < count; k++) {
+            list.insertAtEnd(first + k);
+            model.push_back(first + k);
+        }
+    }
+
+    //----------------------------------------------------
+    void indexedListEdits() {
+        mt19937 rng(1);
+        List list;
+        vector<int> model;
+        int next = 0;
+        for (int round = 0; round < 4000; round++) {
+            int size = static_cast<int>(model.size());
+            switch (pick(rng, 0, 5)) {
+            case 0: {
+                int position = pick(rng, 1, size + 1);
+                list.insertAtAnyPos(position, next);
+                model.insert(model.begin() + (position - 1), next++);
+                break;
+            }
+            case 1:
+                if (size == 0) break;
+                {
+                    int position = pick(rng, 1, size);
+                    list.deleteAtAnyPos(position);
+                    model.erase(model.begin() + (position - 1));
+                }
+                break;
+            case 2: {
+                // A few copies in front of a random node (or at the end)
+                int position = pick(rng, 1, size + 1);
+                vector<int> values(static_cast<size_t>(pick(rng, 0, 6)));
+                for (int& v : values) v = next++;
+                list.insertRange(list.nodeAt(position), values.begin(), values.end());
+                model.insert(model.begin() + (position - 1), values.begin(), values.end());
+                break;
+            }
+            case 3:
+                if (size < 2) break;
+                {
+                    // Move one node by handle
+                    int from = pick(rng, 1, size);
+                    node<int>* moving = list.unlink(list.nodeAt(from));
+                    int value = model[static_cast<size_t>(from - 1)];
+                    model.erase(model.begin() + (from - 1));
+                    int to = pick(rng, 1, size);
+                    list.insertNodeBefore(list.nodeAt(to), moving);
+                    model.insert(model.begin() + (to - 1), value);
+                }
+                break;
+            case 4:
+                list.emplaceAtBeginning(next);
+                model.insert(model.begin(), next++);
+                break;
+            default:
+                if (size > 0 && pick(rng, 0, 1) == 0) {
+                    list.deleteFromEnd();
+                    model.pop_back();
+                } else if (size > 0) {
+                    list.deleteFromStart();
+                    model.erase(model.begin());
+                }
+                break;
+            }
+            if (round % 97 == 0) verify(list, model);
+        }
+        verify(list, model);
+    }
+
+    // Up to a thirty-second of the list goes through the tree one node at a
+    // time; past that the tree is rebuilt once at the end
+    void indexedListRemoveIf() {
+        List::NodeAllocator pool;
+        for (int every : { 1000, 97, 31, 3, 1 }) {
+            List list(pool);
+            vector<int> model;
+            fill(list, model, 3200, 0);
+
+            auto doomed = [every](int v) { return v % every == 0; };
+            int removed = list.removeIf(doomed);
+            int expected = static_cast<int>(count_if(model.begin(), model.end(), doomed));
+            model.erase(remove_if(model.begin(), model.end(), doomed), model.end());
+            CHECK(removed == expected);
+            verify(list, model);
+
+            // The rebuilt tree must still take edits
+            list.insertAtAnyPos(1, -1);
+            model.insert(model.begin(), -1);
+            if (model.size() > 10) {
+                list.deleteAtAnyPos(10);
+                model.erase(model.begin() + 9);
+            }
+            verify(list, model);
+            CHECK(pool.liveNodes() == model.size());
+        }
+        CHECK(pool.liveNodes() == 0);
+    }
+
+    void indexedListSplice() {
+        mt19937 rng(2);
+        List::NodeAllocator pool;
+        List a(pool), b(pool);
+        vector<int> modelA, modelB;
+        fill(a, modelA, 300, 0);
+        fill(b, modelB, 300, 1000);
+
+        for (int round = 0; round < 500; round++) {
+            bool fromB = pick(rng, 0, 1) == 0;
+            List& source = fromB ? b : a;
+            List& target = fromB ? a : b;
+            vector<int>& sourceModel = fromB ? modelB : modelA;
+            vector<int>& targetModel = fromB ? modelA : modelB;
+            if (sourceModel.empty()) continue;
+
+            int first = pick(rng, 1, static_cast<int>(sourceModel.size()));
+            int count = pick(rng, 1, min(40, static_cast<int>(sourceModel.size()) - first + 1));
+            vector<int> run(sourceModel.begin() + (first - 1), sourceModel.begin() + (first - 1 + count));
+
+            if (pick(rng, 0, 3) == 0) {
+                // Within one list: the target position lies outside the run
+                // 'outside' indexes the list without the run
+                int outside = pick(rng, 0, static_cast<int>(sourceModel.size()) - count);
+                int position = outside < first - 1 ? outside + 1 : outside + count + 1; // 1-based, or size + 1
+                node<int>* at = source.nodeAt(position);
+                CHECK(source.splice(at, source, source.nodeAt(first), source.nodeAt(first + count - 1), count));
+                vector<int> rest(sourceModel.begin(), sourceModel.begin() + (first - 1));
+                rest.insert(rest.end(), sourceModel.begin() + (first - 1 + count), sourceModel.end());
+                rest.insert(rest.begin() + outside, run.begin(), run.end());
+                sourceModel = rest;
+            } else {
+                int position = pick(rng, 1, static_cast<int>(targetModel.size()) + 1);
+                CHECK(target.splice(target.nodeAt(position), source, source.nodeAt(first), source.nodeAt(first + count - 1), count));
+                sourceModel.erase(sourceModel.begin() + (first - 1), sourceModel.begin() + (first - 1 + count));
+                targetModel.insert(targetModel.begin() + (position - 1), run.begin(), run.end());
+            }
+            if (round % 25 == 0) {
+                verify(a, modelA);
+                verify(b, modelB);
+            }
+        }
+        verify(a, modelA);
+        verify(b, modelB);
+
+        // Whole lists: by splice with a shared pool, element by element without one
+        a.append(std::move(b));
+        modelA.insert(modelA.end(), modelB.begin(), modelB.end());
+        modelB.clear();
+        verify(a, modelA);
+        verify(b, modelB);
+
+        List other; // Its own pool
+        vector<int> otherModel;
+        fill(other, otherModel, 50, 5000);
+        CHECK(!a.splice(nullptr, other, other.getHead(), other.getTail(), 50));
+        a.append(std::move(other));
+        modelA.insert(modelA.end(), otherModel.begin(), otherModel.end());
+        verify(a, modelA);
+        CHECK(other.isEmpty() && other.getAllocator().liveNodes() == 0);
+        CHECK(pool.liveNodes() == modelA.size());
+    }
+
+    //----------------------------------------------------
+    // Keys homed in the last slots of the table run over its end into slot 0
+    // and on; deleting from such a run must shift the wrapped keys back.
+    void hashIndexWrappedRuns() {
+        for (int order = 0; order < 24; order++) {
+            HashIndex<int> index; // 16 slots
+            vector<int> keys = { 14, 30, 46, 15, 31, 47, 1, 17 };
+            for (int key : keys) index.insert(key, key * 10);
+            CHECK(index.size() == keys.size());
+
+            // A different erase order each time
+            mt19937 rng(static_cast<unsigned>(order));
+            shuffle(keys.begin(), keys.end(), rng);
+            vector<int> present = keys;
+            for (int key : keys) {
+                CHECK(index.erase(key));
+                CHECK(!index.erase(key));
+                present.erase(find(present.begin(), present.end(), key));
+                CHECK(index.find(key) == nullptr);
+                for (int other : present) {
+                    const int* value = index.find(other);
+                    CHECK(value != nullptr && *value == other * 10);
+                }
+                CHECK(index.size() == present.size());
+            }
+        }
+    }
+
+    void hashIndexRandom() {
+        mt19937 rng(3);
+        HashIndex<int> index;
+        vector<int> model(4096, 0); // By key; 0 = absent
+        size_t present = 0;
+        for (int round = 0; round < 200000; round++) {
+            // Clustered keys: long probe runs, some wrapping
+            int key = pick(rng, 0, 1) == 0 ? pick(rng, 1, 4095) : 4096 - pick(rng, 1, 64);
+            int& slot = model[static_cast<size_t>(key)];
+            if (pick(rng, 0, 2) == 0) {
+                CHECK(index.erase(key) == (slot != 0));
+                if (slot != 0) present--;
+                slot = 0;
+            } else {
+                int value = round + 1;
+                index.insert(key, value);
+                if (slot == 0) present++;
+                slot = value;
+            }
+            CHECK(index.size() == present);
+            if (round % 1000 == 0) {
+                for (int k = 1; k < 4096; k++) {
+                    const int* value = index.find(k);
+                    CHECK(model[static_cast<size_t>(k)] == 0 ? value == nullptr : (value != nullptr && *value == model[static_cast<size_t>(k)]));
+                }
+            }
+        }
+        CHECK(index.find(0) == nullptr);
+    }
+
+    //----------------------------------------------------
+    // Few distinct keys, so most compares are ties; equal keys must keep their
+    // order, with one thread and with runs merged across several
+    void listSortStability() {
+        using Item = pair<int, int>; // (key, original position)
+        for (int n : { 1, 2, 1000, 100000 }) {
+            for (unsigned threads : { 1u, 4u }) {
+                for (bool byKey : { false, true }) {
+                    mt19937 rng(static_cast<unsigned>(n) + threads);
+                    IndexedDoublyLinkedList<Item> list;
+                    vector<Item> model;
+                    vector<node<Item>*> nodes;
+                    for (int i = 0; i < n; i++) {
+                        model.emplace_back(pick(rng, 0, 9), i);
+                        nodes.push_back(list.emplaceAtEnd(model.back()));
+                    }
+
+                    auto less = [](int a, int b) { return a < b; };
+                    if (byKey) list.sortByKey([](const Item& item) { return item.first; }, less, threads);
+                    else list.sort([](const Item& a, const Item& b) { return a.first < b.first; }, threads);
+                    stable_sort(model.begin(), model.end(), [](const Item& a, const Item& b) { return a.first < b.first; });
+
+                    node<Item>* n0 = list.getHead();
+                    for (int i = 0; i < n; i++, n0 = n0->next) {
+                        CHECK(n0 != nullptr && n0->data == model[static_cast<size_t>(i)]);
+                        CHECK(nodes[static_cast<size_t>(n0->data.second)] == n0); // Relinked, not copied
+                        if (i % 997 == 0) CHECK(list.positionOf(n0) == i + 1 && list.nodeAt(i + 1) == n0);
+                    }
+                    CHECK(n0 == nullptr && list.getTail()->data == model.back());
+                    CHECK(list.getHead()->prev == nullptr);
+                }
+            }
+        }
+    }
+
+    //----------------------------------------------------
+    // Every real match is a candidate (there may be false ones), candidates
+    // come in ascending order, and compacted-away IDs are gone
+    void searchIndexCandidates() {
+        mt19937 rng(4);
+        const string letters = "abcABC xy";
+        auto text = [&](int length) {
+            string s;
+            for (int i = 0; i < length; i++) s += letters[static_cast<size_t>(pick(rng, 0, static_cast<int>(letters.size()) - 1))];
+            return s;
+        };
+
+        struct Entry {
+            int id;
+            string title, artist;
+            bool live;
+        };
+        vector<Entry> model;
+        SearchIndex index;
+        for (int id = 1; id <= 3000; id++) {
+            model.push_back(Entry{ id, text(pick(rng, 0, 20)), text(pick(rng, 0, 8)), true });
+            index.add(id, model.back().title, model.back().artist);
+        }
+        // A few out of order
+        for (int id : { 5000, 4000, 4500 }) {
+            model.push_back(Entry{ id, text(12), text(5), true });
+            index.add(id, model.back().title, model.back().artist);
+        }
+
+        auto check = [&](const string& query, bool compacted) {
+            vector<int> candidates;
+            index.forEachCandidate(query, [&](int id) {
+                candidates.push_back(id);
+                return true;
+            });
+            CHECK(is_sorted(candidates.begin(), candidates.end()));
+            CHECK(adjacent_find(candidates.begin(), candidates.end()) == candidates.end());
+            string lowered = SearchIndex::toLower(query);
+            for (const Entry& e : model) {
+                bool found = binary_search(candidates.begin(), candidates.end(), e.id);
+                if (e.live && (SearchIndex::containsIgnoreCase(e.title, lowered) || SearchIndex::containsIgnoreCase(e.artist, lowered))) CHECK(found);
+                if (compacted && !e.live) CHECK(!found);
+            }
+        };
+
+        for (int q = 0; q < 300; q++) check(text(pick(rng, 3, 6)), false);
+
+        for (Entry& e : model) {
+            if (pick(rng, 0, 2) == 0) {
+                e.live = false;
+                index.remove();
+            }
+        }
+        index.compact([&](int id) {
+            auto e = find_if(model.begin(), model.end(), [id](const Entry& x) { return x.id == id; });
+            return e != model.end() && e->live;
+        });
+        for (int q = 0; q < 300; q++) check(text(pick(rng, 3, 6)), true);
+
+        // Visiting stops when asked
+        int seen = 0;
+        index.forEachCandidate("abc", [&](int) { return ++seen < 2; });
+        CHECK(seen <= 2);
+    }
+
+    //----------------------------------------------------
+    using PList = PersistentList<int>;
+
+    vector<int> contents(const PList& list) {
+        vector<int> values;
+        list.forEach([&](int v) { values.push_back(v); });
+        return values;
+    }
+
+    void verify(const PList& list, const vector<int>& model) {
+        CHECK(list.size() == static_cast<int>(model.size()));
+        CHECK(contents(list) == model);
+        for (size_t i = 0; i < model.size(); i += 1 + model.size() / 16) CHECK(list.at(static_cast<int>(i)) == model[i]);
+        if (model.size() > 4) {
+            // A window out of the middle
+            int first = static_cast<int>(model.size()) / 3;
+            vector<int> window;
+            list.forEach(first, 3, [&](int v) { window.push_back(v); });
+            CHECK(window == vector<int>(model.begin() + first, model.begin() + first + 3));
+        }
+    }
+
+    // Many lists cloned, sliced and appended from one another, each edited on
+    // its own: none may see another's edits, and nothing is left over
+    void persistentListEdits() {
+        mt19937 rng(5);
+        PList::NodeAllocator pool;
+        {
+            vector<PList> lists;
+            vector<vector<int>> models;
+            lists.emplace_back(pool);
+            models.emplace_back();
+            int next = 0;
+            for (int round = 0; round < 20000; round++) {
+                size_t which = static_cast<size_t>(pick(rng, 0, static_cast<int>(lists.size()) - 1));
+                PList& list = lists[which];
+                vector<int>& model = models[which];
+                int size = static_cast<int>(model.size());
+                switch (pick(rng, 0, 11)) {
+                case 0:
+                    list.pushBack(next);
+                    model.push_back(next++);
+                    break;
+                case 1:
+                    list.pushFront(next);
+                    model.insert(model.begin(), next++);
+                    break;
+                case 2: {
+                    int position = pick(rng, 0, size);
+                    list.insertAt(position, next);
+                    model.insert(model.begin() + position, next++);
+                    break;
+                }
+                case 3:
+                    if (size == 0) break;
+                    {
+                        int position = pick(rng, 0, size - 1);
+                        list.eraseAt(position);
+                        model.erase(model.begin() + position);
+                    }
+                    break;
+                case 4:
+                    if (size == 0) break;
+                    {
+                        int position = pick(rng, 0, size - 1);
+                        list.set(position, next);
+                        model[static_cast<size_t>(position)] = next++;
+                    }
+                    break;
+                case 5:
+                    if (size == 0) break;
+                    {
+                        int first = pick(rng, 0, size - 1);
+                        int count = pick(rng, 0, size - first);
+                        int position = pick(rng, 0, size - count);
+                        list.moveRange(first, count, position);
+                        vector<int> block(model.begin() + first, model.begin() + first + count);
+                        model.erase(model.begin() + first, model.begin() + first + count);
+                        model.insert(model.begin() + position, block.begin(), block.end());
+                    }
+                    break;
+                case 6:
+                    if (lists.size() < 12) {
+                        lists.push_back(list); // Clone: 'list' may move with the vector
+                        models.push_back(model);
+                    }
+                    break;
+                case 7:
+                    if (lists.size() < 12) {
+                        int first = pick(rng, 0, size);
+                        int count = pick(rng, 0, size - first);
+                        lists.push_back(list.slice(first, count));
+                        models.emplace_back(model.begin() + first, model.begin() + first + count);
+                    }
+                    break;
+                case 8: {
+                    size_t from = static_cast<size_t>(pick(rng, 0, static_cast<int>(lists.size()) - 1));
+                    if (models[which].size() + models[from].size() > 5000) break;
+                    vector<int> added = models[from]; // 'from' may be 'which'
+                    lists[which].append(lists[from]);
+                    models[which].insert(models[which].end(), added.begin(), added.end());
+                    break;
+                }
+                case 9: {
+                    int modulus = pick(rng, 2, 9);
+                    auto doomed = [modulus](int v) { return v % modulus == 0; };
+                    int expected = static_cast<int>(count_if(model.begin(), model.end(), doomed));
+                    CHECK(list.removeIf(doomed) == expected);
+                    model.erase(remove_if(model.begin(), model.end(), doomed), model.end());
+                    break;
+                }
+                case 10:
+                    if (lists.size() > 1) {
+                        lists.erase(lists.begin() + static_cast<ptrdiff_t>(which));
+                        models.erase(models.begin() + static_cast<ptrdiff_t>(which));
+                    } else {
+                        list.clear();
+                        model.clear();
+                    }
+                    break;
+                default: {
+                    size_t from = static_cast<size_t>(pick(rng, 0, static_cast<int>(lists.size()) - 1));
+                    lists[which] = lists[from];
+                    models[which] = models[from];
+                    break;
+                }
+                }
+                if (round % 50 == 0) {
+                    for (size_t k = 0; k < lists.size(); k++) verify(lists[k], models[k]);
+                }
+            }
+            for (size_t k = 0; k < lists.size(); k++) verify(lists[k], models[k]);
+        }
+        CHECK(pool.liveNodes() == 0);
+    }
+
+    // What is shared stays shared: a clone costs no node, an edit a path's worth
+    void persistentListSharing() {
+        PList::NodeAllocator pool;
+        {
+            vector<int> model(100000);
+            for (size_t i = 0; i < model.size(); i++) model[i] = static_cast<int>(i);
+            PList original(model, pool);
+            CHECK(pool.liveNodes() == model.size());
+
+            PList copy = original;
+            CHECK(copy.sharesAll(original) && pool.liveNodes() == model.size());
+
+            // Nothing to remove: the tree is handed back as it was
+            CHECK(copy.removeIf([](int v) { return v < 0; }) == 0);
+            CHECK(copy.sharesAll(original) && pool.liveNodes() == model.size());
+
+            // One edit copies one path; the original is untouched
+            copy.set(5000, -1);
+            size_t afterSet = pool.liveNodes();
+            CHECK(afterSet > model.size() && afterSet - model.size() < 100);
+            CHECK(original.at(5000) == 5000 && copy.at(5000) == -1);
+
+            // Removing one value: a few paths, not a copy of the list
+            CHECK(copy.removeIf([](int v) { return v == 77777; }) == 1);
+            CHECK(pool.liveNodes() - afterSet < 400);
+            CHECK(copy.size() == original.size() - 1);
+
+            // A slice of the middle shares its inside
+            size_t beforeSlice = pool.liveNodes();
+            PList middle = original.slice(20000, 50000);
+            CHECK(pool.liveNodes() - beforeSlice < 400);
+            verify(middle, vector<int>(model.begin() + 20000, model.begin() + 70000));
+
+            original.clear();
+            verify(middle, vector<int>(model.begin() + 20000, model.begin() + 70000));
+            model[5000] = -1;
+            model.erase(model.begin() + 77777);
+            verify(copy, model);
+        }
+        CHECK(pool.liveNodes() == 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "indexed_list_edits", indexedListEdits },
+        { "indexed_list_remove_if", indexedListRemoveIf },
+        { "indexed_list_splice", indexedListSplice },
+        { "hash_index_wrapped_runs", hashIndexWrappedRuns },
+        { "hash_index_random", hashIndexRandom },
+        { "list_sort_stability", listSortStability },
+        { "search_index_candidates", searchIndexCandidates },
+        { "persistent_list_edits", persistentListEdits },
+        { "persistent_list_sharing", persistentListSharing },
+    }, argc, argv);
+}
@@ -0,0 +1,130 @@
+// Fingerprints of synthetic songs: chords with harmonics, re-rendered at
+// another rate, gain and lead-in for the copies.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "DuplicateIndex.h"
+#include "Fingerprint.h"
+
+using namespace std;
+
+namespace {
+    struct Chord {
+        double start;
+        int notes[3]; // MIDI
+    };
+
+    vector<Chord> song(unsigned seed, double seconds) {
+        mt19937 rng(seed);
+        const int scale[7] = { 0, 2, 4, 5, 7, 9, 11 };
+        vector<Chord> chords;
+        for (double t = 0.0; t < seconds; t += 0.25 + static_cast<double>(rng() % 60) / 100.0) {
+            int root = 48 + scale[rng() % 7];
+            chords.push_back(Chord{ t, { root, root + (rng() % 2 != 0 ? 4 : 3), root + 7 + 12 * static_cast<int>(rng() % 2) } });
+        }
+        return chords;
+    }
+
+    struct Rendering {
+        unsigned rate = 44100;
+        unsigned channels = 2;
+        double gain = 1.0;
+        double noise = 0.0;
+        double leadIn = 0.0; // Seconds of silence first
+    };
+
+    vector<int16_t> render(const vector<Chord>& chords, double seconds, const Rendering& how) {
+        const double Pi = 3.14159265358979323846;
+        size_t frames = static_cast<size_t>((seconds + how.leadIn) * how.rate);
+        vector<int16_t> out(frames * how.channels);
+        mt19937 rng(7);
+        normal_distribution<double> noise(0.0, how.noise > 0.0 ? how.noise : 1.0);
+        size_t current = 0;
+        for (size_t i = 0; i < frames; i++) {
+            double t = static_cast<double>(i) / how.rate - how.leadIn;
+            double v = 0.0;
+            if (t >= 0.0) {
+                while (current + 1 < chords.size() && chords[current + 1].start <= t) current++;
+                const Chord& chord = chords[current];
+                double envelope = exp(-3.0 * (t - chord.start));
+                for (int note : chord.notes) {
+                    double hz = 440.0 * pow(2.0, (note - 69) / 12.0);
+                    for (int h = 1; h <= 4; h++) v += envelope * 0.08 / h * sin(2.0 * Pi * hz * h * t);
+                }
+            }
+            v = v * how.gain + (how.noise > 0.0 ? noise(rng) : 0.0);
+            int16_t sample = static_cast<int16_t>(clamp(v * 32767.0, -32768.0, 32767.0));
+            for (unsigned c = 0; c < how.channels; c++) out[i * how.channels + c] = sample;
+        }
+        return out;
+    }
+
+    // The first 'frames' frames of 'pcm' (all of it by default), in chunks of 'chunk'
+    Fingerprint fingerprint(const vector<int16_t>& pcm, const Rendering& how, size_t frames = SIZE_MAX, size_t chunk = 10000) {
+        Fingerprinter f(how.rate, how.channels);
+        frames = min(frames, pcm.size() / how.channels);
+        for (size_t i = 0; i < frames; i += chunk) f.add(pcm.data() + i * how.channels, min(chunk, frames - i));
+        return f.finish();
+    }
+
+    //----------------------------------------------------
+    // More than MaxSeconds of sound: the codes stop at the limit and the
+    // last of the sketch's segments takes the final ones
+    void longerThanMaxSeconds() {
+        const double seconds = Fingerprinter::MaxSeconds + 15.0;
+        Rendering how;
+        vector<int16_t> pcm = render(song(1, seconds), seconds, how);
+        Fingerprint whole = fingerprint(pcm, how);
+        const size_t maxCodes = static_cast<size_t>(Fingerprinter::MaxSeconds * Fingerprinter::Rate / Fingerprinter::Hop);
+        CHECK(whole.codes.size() == maxCodes);
+        CHECK(whole.sketch != decltype(whole.sketch){});
+
+        // Anything after MaxSeconds changes nothing
+        Fingerprint cut = fingerprint(pcm, how, static_cast<size_t>((Fingerprinter::MaxSeconds + 2.0) * how.rate));
+        CHECK(cut.codes == whole.codes && cut.sketch == whole.sketch);
+
+        // Nor does feeding it in small pieces
+        Fingerprint stepped = fingerprint(pcm, how, SIZE_MAX, 441);
+        CHECK(stepped.codes == whole.codes && stepped.sketch == whole.sketch);
+    }
+
+    void tooShortIsEmpty() {
+        Rendering how;
+        CHECK(fingerprint(render(song(2, 3.0), 3.0, how), how).empty());
+        CHECK(fingerprint(vector<int16_t>(44100 * 2 * 10), how).empty()); // Silence
+    }
+
+    // A copy at another rate, gain, noise and lead-in matches; other songs don't
+    void copiesMatch() {
+        const double seconds = 40.0;
+        vector<Chord> a = song(3, seconds), b = song(4, seconds);
+        Rendering original;
+        Rendering copy{ 48000, 1, 0.4, 0.01, 0.73 };
+        Fingerprint fa = fingerprint(render(a, seconds, original), original);
+        Fingerprint fa2 = fingerprint(render(a, seconds, copy), copy);
+        Fingerprint fb = fingerprint(render(b, seconds, original), original);
+
+        CHECK(Fingerprinter::similarity(fa, fa2) >= DuplicateIndex::DefaultThreshold);
+        CHECK(Fingerprinter::similarity(fa, fb) < DuplicateIndex::DefaultThreshold);
+        CHECK(Fingerprinter::sketchDistance(fa, fa2) <= DuplicateIndex::MaxSketchDistance);
+        CHECK(Fingerprinter::sketchDistance(fa, fb) > Fingerprinter::sketchDistance(fa, fa2));
+
+        DuplicateIndex index;
+        index.add(1, fa);
+        index.add(2, fb);
+        index.add(3, fa2);
+        vector<vector<int>> groups = index.groups();
+        CHECK(groups.size() == 1 && groups[0] == vector<int>({ 1, 3 }));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "longer_than_max_seconds", longerThanMaxSeconds },
+        { "too_short_is_empty", tooShortIsEmpty },
+        { "copies_match", copiesMatch },
+    }, argc, argv);
+}
@@ -0,0 +1,112 @@
+// LibraryScanner: a scan stamps every folder it walks, and catchUp finds what
+// changed on disk since from those stamps alone.
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "LibraryScanner.h"
+#include "Playlist.h"
+#include "ThreadPool.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    // Empty files: no tags to read, so each track is named after its file
+    void writeFile(const fs::path& path, const string& bytes = "") {
+        fs::create_directories(path.parent_path());
+        ofstream out(path, ios::binary | ios::trunc);
+        out << bytes;
+    }
+
+    vector<string> paths(const vector<FileUpdate>& updates) {
+        vector<string> result;
+        for (const FileUpdate& update : updates) {
+            CHECK(update.renamedFrom.empty());
+            result.push_back(update.track.filePath.str());
+        }
+        return result;
+    }
+
+    // Files added, removed and rewritten in changed folders, a folder gone and
+    // a new one, all found without listing the folders that didn't change
+    void catchUpFindsChanges() {
+        fs::path base = fs::temp_directory_path() / "hive_test_catchup";
+        fs::remove_all(base);
+        string root = base.generic_string();
+        for (string file : { "a/1.mp3", "a/2.mp3", "a/3.mp3", "b/4.mp3", "c/5.mp3", "d/6.mp3", "a/notes.txt" }) {
+            writeFile(base / file);
+        }
+
+        // Files older than their folders, as they are once written
+        auto hourAgo = fs::file_time_type::clock::now() - chrono::hours(1);
+        for (const fs::directory_entry& entry : fs::recursive_directory_iterator(base)) {
+            fs::last_write_time(entry.path(), entry.is_directory() ? hourAgo : hourAgo - chrono::hours(1));
+        }
+        fs::last_write_time(base, hourAgo);
+
+        ThreadPool pool(2);
+        LibraryScanner scanner(pool);
+        ScanResult scanned = scanner.scan(root);
+        CHECK(scanned.tracks.size() == 6);
+        set<string> stamped;
+        for (const auto& [folder, modified] : scanned.folders) {
+            stamped.insert(folder);
+            CHECK(modified == static_cast<int64_t>(hourAgo.time_since_epoch().count()));
+        }
+        CHECK((stamped == set<string>{ root + "/", root + "/a/", root + "/b/", root + "/c/", root + "/d/" }));
+
+        vector<string> known;
+        for (const Track& track : scanned.tracks) known.push_back(track.filePath.str());
+        Playlist playlist;
+        playlist.addTracks(std::move(scanned.tracks));
+        FolderTimes folders = scanned.folders;
+
+        fs::remove(base / "a/1.mp3");
+        writeFile(base / "a/2.mp3", "rewritten");
+        writeFile(base / "a/7.mp3");
+        writeFile(base / "b/4.mp3", "rewritten in place: b's time stays"); // Missed
+        fs::remove_all(base / "c");
+        writeFile(base / "d/e/8.mp3");
+
+        LibraryChanges changes = scanner.catchUp(folders, known);
+        CHECK((paths(changes.updated) == vector<string>{ root + "/a/2.mp3", root + "/a/7.mp3", root + "/d/e/8.mp3" }));
+        CHECK((changes.removedFiles == vector<string>{ root + "/a/1.mp3" }));
+        CHECK((changes.removedDirectories == vector<string>{ root + "/c/" }));
+        stamped.clear();
+        for (const auto& [folder, modified] : folders) {
+            stamped.insert(folder);
+            int64_t now = static_cast<int64_t>(fs::last_write_time(folder).time_since_epoch().count());
+            CHECK(modified == now);
+        }
+        CHECK((stamped == set<string>{ root + "/", root + "/a/", root + "/b/", root + "/d/", root + "/d/e/" }));
+
+        // Through the playlist: one re-read, two added, two removed
+        Playlist::SyncResult result = playlist.syncFiles(std::move(changes.updated), changes.removedFiles, changes.removedDirectories);
+        CHECK(result.added == 2 && result.updated == 1 && result.removed == 2);
+        set<string> listed;
+        playlist.forEachTrack([&](TrackRef t) { listed.insert(t.filePath()); });
+        CHECK((listed == set<string>{ root + "/a/2.mp3", root + "/a/3.mp3", root + "/a/7.mp3", root + "/b/4.mp3",
+                                      root + "/d/6.mp3", root + "/d/e/8.mp3" }));
+
+        // Nothing moved since: nothing to do
+        known.clear();
+        playlist.forEachTrack([&](TrackRef t) { known.push_back(t.filePath()); });
+        changes = scanner.catchUp(folders, known);
+        CHECK(changes.updated.empty() && changes.removedFiles.empty() && changes.removedDirectories.empty());
+
+        // The whole library gone: one removed directory, no stamps left
+        fs::remove_all(base);
+        changes = scanner.catchUp(folders, known);
+        CHECK((changes.removedDirectories == vector<string>{ root + "/" }) && folders.empty());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "catch_up_finds_changes", catchUpFindsChanges },
+    }, argc, argv);
+}
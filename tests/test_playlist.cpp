@@ -0,0 +1,220 @@
+// Playlist operations whose result is easy to state: the same thing done on a
+// std::vector of the tracks, or the files on disk syncFiles follows.
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "Playlist.h"
+
+using namespace std;
+
+namespace {
+    string folded(string_view text) {
+        string result(text);
+        for (char& c : result) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return result;
+    }
+
+    // Artists spelt with different case are one artist: sorting by artist
+    // after sorting by title keeps each artist's titles in order
+    void sortByArtistIgnoresCase() {
+        vector<Track> tracks;
+        for (int i = 0; i < 3000; i++) {
+            string artist = "Artist " + to_string(i % 40);
+            if (i % 3 == 1) artist = folded(artist);
+            if (i % 3 == 2) transform(artist.begin(), artist.end(), artist.begin(), [](unsigned char c) { return static_cast<char>(toupper(c)); });
+            string title = "Title " + to_string((i * 7919) % 3000 + 10000);
+            tracks.push_back(Track{ 0, title, artist, 180, "/music/" + to_string(i) + ".mp3" });
+        }
+
+        Playlist playlist;
+        playlist.addTracks(std::move(tracks));
+        playlist.sortTracks(SortKey::Title, 1);
+        playlist.sortTracks(SortKey::Artist, 1);
+
+        struct Row {
+            string artist, title;
+        };
+        vector<Row> rows;
+        playlist.forEachTrack([&](TrackRef t) { rows.push_back(Row{ folded(t.artist()), string(t.title()) }); });
+        CHECK(rows.size() == 3000);
+        for (size_t k = 1; k < rows.size(); k++) {
+            CHECK(rows[k - 1].artist <= rows[k].artist);
+            if (rows[k - 1].artist == rows[k].artist) CHECK(rows[k - 1].title < rows[k].title);
+        }
+    }
+
+    //----------------------------------------------------
+    // Tracks 1..count, the first one playing
+    void fillNumbered(Playlist& playlist, int count) {
+        for (int i = 1; i <= count; i++) playlist.addTrack("Song " + to_string(i), "Artist", 100, "/music/" + to_string(i) + ".mp3");
+        playlist.jumpToTrack(1);
+    }
+
+    int currentId(const Playlist& playlist) {
+        TrackRef current = playlist.getCurrentTrack();
+        return current ? current.id() : 0;
+    }
+
+    // Each track once per round, peeks that agree with the moves, and Prev
+    // walking back the way Next came
+    void shuffleOrder() {
+        for (int count : { 1, 2, 3, 10, 257 }) {
+            Playlist playlist;
+            fillNumbered(playlist, count);
+            playlist.setShuffle(true);
+
+            vector<int> played{ 1 };
+            for (int step = 1; step < 3 * count; step++) {
+                int peeked = playlist.peekNext().id();
+                playlist.moveNext();
+                CHECK(currentId(playlist) == peeked);
+                played.push_back(peeked);
+            }
+            set<int> firstRound(played.begin(), played.begin() + count);
+            CHECK(static_cast<int>(firstRound.size()) == count);
+            CHECK(*firstRound.begin() == 1 && *firstRound.rbegin() == count);
+
+            for (int step = static_cast<int>(played.size()) - 2; step >= 0; step--) {
+                CHECK(playlist.peekPrev().id() == played[static_cast<size_t>(step)]);
+                playlist.movePrev();
+                CHECK(currentId(playlist) == played[static_cast<size_t>(step)]);
+            }
+            CHECK(!playlist.peekPrev());
+            playlist.movePrev();
+            CHECK(currentId(playlist) == 1);
+
+            // Going forward again replays the same order
+            for (size_t step = 1; step < played.size(); step++) {
+                playlist.moveNext();
+                CHECK(currentId(playlist) == played[step]);
+            }
+        }
+    }
+
+    // Removing the playing track moves on to a track still there: the next
+    // one in the list, or in the shuffle order (also after a whole round,
+    // when the order may draw any track again)
+    void removeCurrentTrack() {
+        Playlist single;
+        fillNumbered(single, 1);
+        CHECK(single.removeTrack(1));
+        CHECK(!single.getCurrentTrack());
+
+        Playlist inOrder;
+        fillNumbered(inOrder, 3);
+        inOrder.jumpToTrack(2);
+        CHECK(inOrder.removeTrack(2) && currentId(inOrder) == 3);
+        CHECK(inOrder.removeTrack(3) && currentId(inOrder) == 1);
+
+        for (int run = 0; run < 300; run++) {
+            int count = 2 + run % 4;
+            Playlist playlist;
+            fillNumbered(playlist, count);
+            playlist.setShuffle(true);
+            for (int step = 0; step < run % (2 * count); step++) playlist.moveNext();
+
+            for (int left = count; left > 0; left--) {
+                int removed = currentId(playlist);
+                CHECK(removed != 0);
+                CHECK(playlist.removeTrack(removed));
+                CHECK(playlist.getTotalTracks() == left - 1);
+                if (left > 1) {
+                    CHECK(currentId(playlist) != 0 && currentId(playlist) != removed);
+                    CHECK(playlist.findTrack(currentId(playlist)));
+                    playlist.moveNext();
+                    CHECK(currentId(playlist) != 0);
+                } else {
+                    CHECK(!playlist.getCurrentTrack());
+                }
+            }
+        }
+    }
+
+    // Tracks added while shuffling join the order; removed ones leave it
+    void shuffleFollowsEdits() {
+        Playlist playlist;
+        fillNumbered(playlist, 20);
+        playlist.setShuffle(true);
+        for (int step = 0; step < 5; step++) playlist.moveNext();
+        for (int id = 2; id <= 20; id += 2) {
+            if (id != currentId(playlist)) playlist.removeTrack(id);
+        }
+        for (int i = 0; i < 10; i++) playlist.addTrack("New " + to_string(i), "Artist", 100, "/music/new" + to_string(i) + ".mp3");
+
+        set<int> seen;
+        for (int step = 0; step < 200; step++) {
+            playlist.moveNext();
+            int id = currentId(playlist);
+            CHECK(playlist.findTrack(id));
+            seen.insert(id);
+        }
+        CHECK(static_cast<int>(seen.size()) == playlist.getTotalTracks());
+    }
+
+    //----------------------------------------------------
+    vector<int> ids(const Playlist& playlist) {
+        vector<int> result;
+        playlist.forEachTrack([&](TrackRef t) { result.push_back(t.id()); });
+        return result;
+    }
+
+    // Tracks 1..6 in /music/a, 7..10 in /music/b, track 3 playing
+    void fillFolders(Playlist& playlist) {
+        for (int i = 1; i <= 10; i++) {
+            playlist.addTrack("Song " + to_string(i), "Artist", 100, string(i <= 6 ? "/music/a/" : "/music/b/") + to_string(i) + ".mp3");
+        }
+        playlist.jumpToTrack(3);
+    }
+
+    // Rewritten and renamed files keep their tracks where they are; a rename
+    // onto a file already listed keeps that one; removed files and folders go
+    void syncFilesFollowsDisk() {
+        Playlist playlist;
+        fillFolders(playlist);
+        CHECK(playlist.searchTracks("Song", 1).size() == 1); // The search index is kept up from here on
+
+        vector<FileUpdate> updates;
+        updates.push_back(FileUpdate{ Track{ 0, "Three", "Other", 200, "/music/a/3.mp3" }, "" });
+        updates.push_back(FileUpdate{ Track{ 0, "Four", "Artist", 100, "/music/a/four.mp3" }, "/music/a/4.mp3" });
+        updates.push_back(FileUpdate{ Track{ 0, "Six", "Artist", 100, "/music/a/6.mp3" }, "/music/a/5.mp3" });
+        updates.push_back(FileUpdate{ Track{ 0, "New", "Artist", 100, "/music/c/new.mp3" }, "" });
+        Playlist::SyncResult result = playlist.syncFiles(std::move(updates), { "/music/a/1.mp3" }, { "/music/b" });
+        CHECK(result.added == 1 && result.updated == 3 && result.removed == 6);
+
+        CHECK((ids(playlist) == vector<int>{ 2, 3, 4, 6, 11 }));
+        CHECK(currentId(playlist) == 3 && playlist.getCurrentTrack().title() == "Three");
+        CHECK(playlist.findTrack(3).artist() == "Other" && playlist.findTrack(3).duration() == 200);
+        CHECK(playlist.findTrack(4).filePath() == "/music/a/four.mp3" && playlist.findTrack(6).title() == "Six");
+        CHECK(playlist.findTrack(11).filePath() == "/music/c/new.mp3");
+        CHECK(playlist.searchTracks("Three", 5).size() == 1 && playlist.searchTracks("Song 3", 5).empty());
+        CHECK(result.gone.size() >= 10 && result.gone[0] && !result.gone[1]); // Track 1 was the first handle
+
+        // Nothing to do, nothing done
+        result = playlist.syncFiles({}, { "/music/elsewhere/1.mp3" }, { "/music/b" });
+        CHECK(result.added == 0 && result.updated == 0 && result.removed == 0 && result.gone.empty());
+    }
+
+    // The playing file going moves on as removeTrack does
+    void syncFilesRemovesCurrent() {
+        Playlist playlist;
+        fillFolders(playlist);
+        Playlist::SyncResult result = playlist.syncFiles({}, { "/music/a/3.mp3", "/music/a/4.mp3" }, {});
+        CHECK(result.removed == 2 && currentId(playlist) == 5);
+        result = playlist.syncFiles({}, {}, { "/music/" });
+        CHECK(result.removed == 8 && playlist.getTotalTracks() == 0 && !playlist.getCurrentTrack());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "sort_by_artist_ignores_case", sortByArtistIgnoresCase },
+        { "shuffle_order", shuffleOrder },
+        { "remove_current_track", removeCurrentTrack },
+        { "shuffle_follows_edits", shuffleFollowsEdits },
+        { "sync_files_follows_disk", syncFilesFollowsDisk },
+        { "sync_files_removes_current", syncFilesRemovesCurrent },
+    }, argc, argv);
+}
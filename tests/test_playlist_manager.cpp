@@ -0,0 +1,150 @@
+// PlaylistManager: lists by name over the playlist's counted track records,
+// switching which one the playlist shows, and following files on disk.
+#include <string>
+#include <utility>
+#include <vector>
+#include "Check.h"
+#include "Playlist.h"
+#include "PlaylistManager.h"
+
+using namespace std;
+
+namespace {
+    void fill(Playlist& playlist, int count) {
+        vector<Track> tracks;
+        for (int i = 0; i < count; i++) tracks.push_back(Track{ 0, "Song " + to_string(i), "Artist", 100, "/music/" + to_string(i) + ".mp3" });
+        playlist.addTracks(std::move(tracks));
+    }
+
+    vector<int> ids(const Playlist& playlist) {
+        vector<int> result;
+        playlist.forEachTrack([&](TrackRef t) { result.push_back(t.id()); });
+        return result;
+    }
+
+    vector<int> ids(const PlaylistManager::List& list) {
+        vector<int> result;
+        list.forEach([&](const PlaylistManager::SharedTrack& t) { result.push_back(t.ref().id()); });
+        return result;
+    }
+
+    //----------------------------------------------------
+    // A record lives while the playlist, some list or some SharedTrack holds it
+    void recordsAreCounted() {
+        Playlist playlist;
+        fill(playlist, 10);
+        PlaylistManager manager(playlist, "Library");
+        CHECK(manager.clone("Library", "Copy") && manager.clone("Copy", "Again"));
+        CHECK(manager.trackCount() == 10 && manager.listCount() == 3);
+
+        PlaylistManager::SharedTrack first = manager.find("Copy")->at(0);
+        CHECK(manager.refCount(first) == 3); // The playlist, one node shared by both lists, and 'first'
+        manager.find("Copy")->eraseAt(0);
+        CHECK(manager.refCount(first) == 3); // The node stays, for 'Again'
+        CHECK(manager.remove("Again"));
+        CHECK(manager.refCount(first) == 2);
+        CHECK(playlist.removeTrack(first.ref().id()));
+        CHECK(manager.refCount(first) == 1 && manager.trackCount() == 10);
+        first = PlaylistManager::SharedTrack();
+        CHECK(manager.trackCount() == 9);
+
+        // Nothing to count without an owner, or with another one
+        Playlist otherPlaylist;
+        fill(otherPlaylist, 1);
+        PlaylistManager other(otherPlaylist, "Other");
+        PlaylistManager::SharedTrack elsewhere = other.share(otherPlaylist.getCurrentTrack().getHandle());
+        CHECK(manager.refCount(PlaylistManager::SharedTrack()) == 0);
+        CHECK(manager.refCount(elsewhere) == 0 && other.refCount(elsewhere) == 2);
+    }
+
+    // Lists whose nodes come from another pool are turned away, and so is
+    // any list put under the shown one's name
+    void foreignListsRejected() {
+        Playlist playlist, otherPlaylist;
+        fill(playlist, 5);
+        fill(otherPlaylist, 5);
+        PlaylistManager manager(playlist, "Library");
+        PlaylistManager other(otherPlaylist, "Library");
+        CHECK(other.clone("Library", "Theirs"));
+        CHECK(!manager.put("Theirs", *other.find("Theirs")));
+        CHECK(!manager.put("Heap", PlaylistManager::List()));
+        CHECK(manager.find("Theirs") == nullptr && manager.listCount() == 1);
+
+        PlaylistManager::List ours = manager.makeList();
+        ours.pushBack(manager.share(playlist.getCurrentTrack().getHandle()));
+        CHECK(!manager.put("Library", ours));
+        CHECK(manager.put("Ours", ours));
+        CHECK(manager.find("Ours")->size() == 1);
+        CHECK(!manager.create("Library") && !manager.remove("Library") && !manager.rename("Ours", "Library"));
+    }
+
+    // Showing a list keeps the one left as it was edited, and the playing
+    // track plays on if the new list has it
+    void showSwitchesLists() {
+        Playlist playlist;
+        fill(playlist, 20);
+        PlaylistManager manager(playlist, "Library");
+        CHECK(manager.clone("Library", "Short"));
+        manager.find("Short")->moveRange(10, 10, 0);
+        manager.find("Short")->eraseAt(19);
+        manager.find("Short")->pushBack(manager.find("Short")->at(0)); // Twice: shown once
+        vector<int> shortIds = ids(*manager.find("Short"));
+
+        playlist.removeTrack(3);
+        playlist.jumpToTrack(12);
+        vector<int> libraryIds = ids(playlist);
+
+        CHECK(manager.show("Short") && manager.shownName() == "Short");
+        shortIds.pop_back();
+        CHECK(ids(playlist) == shortIds);
+        CHECK(playlist.getCurrentTrack().id() == 12);
+        CHECK(ids(*manager.find("Library")) == libraryIds);
+        CHECK(manager.find("Short") == nullptr);
+        CHECK((manager.names() == vector<string>{ "Library", "Short" }));
+        CHECK(playlist.searchTracks("Song 15", 5).size() == 1 && playlist.searchTracks("Song 9", 5).empty());
+
+        // Track 3 isn't in "Library" any more: there the first track is current
+        playlist.jumpToTrack(3);
+        CHECK(!manager.show("Nowhere"));
+        CHECK(manager.show("Library") && ids(playlist) == libraryIds);
+        CHECK(playlist.getCurrentTrack().id() == 1);
+        CHECK(manager.rename("Library", "All") && manager.shownName() == "All");
+        CHECK(manager.trackCount() == 20);
+        CHECK(manager.remove("Short") && manager.trackCount() == 19);
+    }
+
+    // Files that went are dropped from every list; rewritten ones are re-read
+    // where they are, in every list
+    void syncReachesEveryList() {
+        Playlist playlist;
+        fill(playlist, 10);
+        PlaylistManager manager(playlist, "Library");
+        CHECK(manager.clone("Library", "Kept"));
+        playlist.removeTrack(2); // Now only in "Kept"
+        playlist.removeTrack(5);
+
+        vector<FileUpdate> updates;
+        updates.push_back(FileUpdate{ Track{ 0, "New 1", "Artist", 1, "/music/1.mp3" }, "" });
+        updates.push_back(FileUpdate{ Track{ 0, "Moved 2", "Artist", 2, "/music/2b.mp3" }, "/music/2.mp3" });
+        updates.push_back(FileUpdate{ Track{ 0, "Fresh", "Artist", 3, "/music/fresh.mp3" }, "" });
+        Playlist::SyncResult result = manager.syncFiles(std::move(updates), { "/music/4.mp3", "/music/7.mp3" }, {});
+        CHECK(result.added == 1 && result.updated == 2 && result.removed == 1);
+
+        // File i is track i + 1
+        CHECK((ids(*manager.find("Kept")) == vector<int>{ 1, 2, 3, 4, 6, 7, 9, 10 }));
+        CHECK((ids(playlist) == vector<int>{ 1, 3, 4, 6, 7, 9, 10, 11 }));
+        CHECK(manager.find("Kept")->at(1).ref().title() == "New 1");
+        CHECK(manager.find("Kept")->at(2).ref().filePath() == "/music/2b.mp3");
+        CHECK(!playlist.findTrack(2) && playlist.findTrack(3).title() == "Moved 2");
+        CHECK(manager.trackCount() == 9);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "records_are_counted", recordsAreCounted },
+        { "foreign_lists_rejected", foreignListsRejected },
+        { "show_switches_lists", showSwitchesLists },
+        { "sync_reaches_every_list", syncReachesEveryList },
+    }, argc, argv);
+}
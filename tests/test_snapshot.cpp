@@ -0,0 +1,244 @@
+// LibrarySnapshot: what is saved comes back, a manager's lists and the folder
+// times included, a snapshot can be saved over the file it was loaded from,
+// and a damaged one is turned away whole.
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "LibrarySnapshot.h"
+#include "Playlist.h"
+#include "PlaylistManager.h"
+
+using namespace std;
+
+namespace {
+    const string Root = "/music";
+
+    string scratchPath(const string& name) {
+        return (filesystem::temp_directory_path() / ("hive_test_" + name)).string();
+    }
+
+    struct Row {
+        int id;
+        string title, artist, path;
+        int duration;
+
+        bool operator==(const Row&) const = default;
+    };
+
+    vector<Row> rows(const Playlist& playlist) {
+        vector<Row> result;
+        playlist.forEachTrack([&](TrackRef t) {
+            result.push_back(Row{ t.id(), string(t.title()), string(t.artist()), t.filePath(), t.duration() });
+        });
+        return result;
+    }
+
+    // Titles that sit inside their file names and titles that don't
+    void fill(Playlist& playlist, int count) {
+        vector<Track> tracks;
+        for (int i = 0; i < count; i++) {
+            string title = "Song " + to_string(i);
+            string file = i % 2 == 0 ? to_string(10 + i % 10) + " - " + title + ".mp3" : "track" + to_string(i) + ".flac";
+            tracks.push_back(Track{ 0, title, "Artist " + to_string(i % 7), 100 + i, Root + "/album" + to_string(i % 5) + "/" + file });
+        }
+        playlist.addTracks(std::move(tracks));
+    }
+
+    //----------------------------------------------------
+    void roundTrip() {
+        string path = scratchPath("round_trip.snap");
+        Playlist saved;
+        fill(saved, 500);
+        saved.removeTrack(17);
+        saved.moveTrack(300, 1);
+        saved.jumpToTrack(42);
+        CHECK(LibrarySnapshot::save(path, saved, Root));
+
+        Playlist loaded;
+        CHECK(LibrarySnapshot::load(path, loaded, Root));
+        CHECK(rows(loaded) == rows(saved));
+        CHECK(loaded.getCurrentTrack().id() == 42);
+        CHECK(loaded.getNextId() == saved.getNextId());
+
+        // Another folder's snapshot is not this one
+        Playlist other;
+        CHECK(!LibrarySnapshot::load(path, other, "/elsewhere"));
+        CHECK(other.getTotalTracks() == 0);
+        filesystem::remove(path);
+    }
+
+    vector<int> ids(const PlaylistManager::List& list) {
+        vector<int> result;
+        list.forEach([&](const PlaylistManager::SharedTrack& t) { result.push_back(t.ref().id()); });
+        return result;
+    }
+
+    // The kept lists come back under their names, with the tracks only they
+    // hold, and the playlist under its own name; so do the folder times
+    void listsRoundTrip() {
+        string path = scratchPath("lists.snap");
+        Playlist saved;
+        fill(saved, 200);
+        PlaylistManager lists(saved, "Library");
+        CHECK(lists.clone("Library", "Old") && lists.clone("Library", "Picks") && lists.create("Empty"));
+        *lists.find("Picks") = lists.find("Picks")->slice(50, 20);
+        lists.find("Picks")->append(lists.find("Old")->slice(0, 3));
+        saved.removeTrack(1); // Only the kept lists have these now
+        saved.removeTrack(2);
+        CHECK(lists.show("Picks") && lists.rename("Library", "All"));
+        FolderTimes folders = { { "/music/", 1 }, { "/music/album0/", -5 }, { "/music/album1/", 1LL << 60 } };
+        CHECK(LibrarySnapshot::save(path, lists, Root, folders));
+
+        Playlist playlist;
+        PlaylistManager loaded(playlist, "Library");
+        FolderTimes loadedFolders = { { "/stale/", 3 } };
+        CHECK(LibrarySnapshot::load(path, loaded, Root, loadedFolders));
+        CHECK(loadedFolders == folders);
+        CHECK(loaded.shownName() == "Picks" && loaded.names() == lists.names());
+        CHECK(rows(playlist) == rows(saved));
+        CHECK(loaded.trackCount() == lists.trackCount() && loaded.trackCount() == 200);
+        lists.forEachList([&](const string& name, const PlaylistManager::List& list) {
+            CHECK(loaded.find(name) != nullptr && ids(*loaded.find(name)) == ids(list));
+        });
+        CHECK(loaded.find("Old")->at(0).ref().title() == "Song 0");
+        CHECK(loaded.remove("Old") && loaded.remove("All") && loaded.trackCount() == 23);
+
+        // Into a playlist alone, the playlist's own tracks and nothing more
+        Playlist alone;
+        CHECK(LibrarySnapshot::load(path, alone, Root));
+        CHECK(rows(alone) == rows(saved) && alone.getStore().size() == 23);
+        filesystem::remove(path);
+    }
+
+    // The loaded playlist borrows its text from the mapped file; saving over
+    // that file must leave the playlist readable, and the new file whole
+    void saveOverLoadedFile() {
+        string path = scratchPath("resave.snap");
+        Playlist first;
+        fill(first, 300);
+        CHECK(LibrarySnapshot::save(path, first, Root));
+
+        Playlist loaded;
+        CHECK(LibrarySnapshot::load(path, loaded, Root));
+        vector<Row> before = rows(loaded);
+        loaded.addTrack("Added", "Someone", 60, Root + "/new/added.mp3");
+        loaded.removeTrack(5);
+        vector<Row> edited = rows(loaded);
+
+        string error;
+        CHECK(LibrarySnapshot::save(path, loaded, Root, &error));
+        CHECK(error.empty());
+        CHECK(rows(loaded) == edited);
+        CHECK(loaded.findTrack(1) && loaded.findTrack(1).title() == before[0].title);
+
+        Playlist again;
+        CHECK(LibrarySnapshot::load(path, again, Root));
+        CHECK(rows(again) == edited);
+
+        // Later edits still intern and append text correctly
+        loaded.addTrack("Later", "Artist 3", 61, Root + "/album1/later.mp3");
+        CHECK(rows(loaded).back() == (Row{ loaded.getNextId() - 1, "Later", "Artist 3", Root + "/album1/later.mp3", 61 }));
+        filesystem::remove(path);
+    }
+
+    //----------------------------------------------------
+    vector<unsigned char> readFile(const string& path) {
+        ifstream in(path, ios::binary);
+        return vector<unsigned char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    void writeFile(const string& path, const vector<unsigned char>& bytes) {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<streamsize>(bytes.size()));
+    }
+
+    // A copy of a good snapshot, edited by 'damage' (checksum redone unless
+    // 'reseal' is false), must not load, and must leave the playlist alone
+    template <typename Damage>
+    void checkRejected(const vector<unsigned char>& good, Damage&& damage, bool reseal = true) {
+        vector<unsigned char> bytes = good;
+        SnapshotHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        SnapshotRecord* records = reinterpret_cast<SnapshotRecord*>(bytes.data() + header.recordsOffset);
+        damage(header, records, bytes);
+        if (reseal) header.checksum = LibrarySnapshot::checksum(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+        if (bytes.size() >= sizeof(header)) memcpy(bytes.data(), &header, sizeof(header));
+
+        string path = scratchPath("damaged.snap");
+        writeFile(path, bytes);
+        Playlist playlist;
+        string error;
+        CHECK(!LibrarySnapshot::load(path, playlist, Root, &error));
+        CHECK(!error.empty());
+        CHECK(playlist.getTotalTracks() == 0 && playlist.getNextId() == 1);
+        filesystem::remove(path);
+    }
+
+    void damagedIsRejected() {
+        string path = scratchPath("good.snap");
+        Playlist saved;
+        fill(saved, 50);
+        CHECK(LibrarySnapshot::save(path, saved, Root));
+        vector<unsigned char> good = readFile(path);
+        filesystem::remove(path);
+        using Bytes = vector<unsigned char>;
+
+        // Each damage alone, so a check that is missing shows up here
+        checkRejected(good, [](SnapshotHeader&, SnapshotRecord* r, Bytes&) { r[7].id = r[3].id; });
+        checkRejected(good, [](SnapshotHeader& h, SnapshotRecord* r, Bytes&) { r[7].id = h.nextId; });
+        checkRejected(good, [](SnapshotHeader&, SnapshotRecord* r, Bytes&) { r[7].id = 0; });
+        checkRejected(good, [](SnapshotHeader& h, SnapshotRecord* r, Bytes&) { r[7].artist = h.artistCount; });
+        checkRejected(good, [](SnapshotHeader& h, SnapshotRecord* r, Bytes&) { r[7].nameOffset = static_cast<uint32_t>(h.stringsSize); });
+        checkRejected(good, [](SnapshotHeader& h, SnapshotRecord*, Bytes&) { h.version++; });
+        checkRejected(good, [](SnapshotHeader&, SnapshotRecord*, Bytes& b) { b.pop_back(); });
+        checkRejected(good, [](SnapshotHeader&, SnapshotRecord*, Bytes& b) { b.back() ^= 1; }, false);
+        checkRejected(good, [](SnapshotHeader&, SnapshotRecord*, Bytes& b) { b.resize(sizeof(SnapshotHeader) - 1); }, false);
+
+        // Lists whose entries or names point outside the file
+        Playlist playlist;
+        fill(playlist, 10);
+        PlaylistManager lists(playlist, "Library");
+        CHECK(lists.clone("Library", "Copy"));
+        CHECK(LibrarySnapshot::save(path, lists, Root, FolderTimes{ { "/music/", 7 }, { "/music/a/", 8 } }));
+        vector<unsigned char> withLists = readFile(path);
+        filesystem::remove(path);
+        auto listAt = [](SnapshotHeader& h, Bytes& b) { return reinterpret_cast<SnapshotList*>(b.data() + h.listsOffset); };
+        auto entryAt = [](SnapshotHeader& h, Bytes& b) { return reinterpret_cast<uint32_t*>(b.data() + h.entriesOffset); };
+        checkRejected(withLists, [&](SnapshotHeader& h, SnapshotRecord*, Bytes& b) { entryAt(h, b)[4] = static_cast<uint32_t>(h.trackCount); });
+        checkRejected(withLists, [&](SnapshotHeader& h, SnapshotRecord*, Bytes& b) { listAt(h, b)->entryCount++; });
+        checkRejected(withLists, [&](SnapshotHeader& h, SnapshotRecord*, Bytes& b) { listAt(h, b)->nameLength = static_cast<uint32_t>(h.stringsSize); });
+        checkRejected(withLists, [](SnapshotHeader& h, SnapshotRecord*, Bytes&) { h.shownNameOffset = static_cast<uint32_t>(h.stringsSize); });
+        checkRejected(withLists, [](SnapshotHeader& h, SnapshotRecord*, Bytes&) { h.shownCount = h.trackCount + 1; });
+        checkRejected(withLists, [](SnapshotHeader& h, SnapshotRecord*, Bytes&) { h.listCount++; });
+        checkRejected(withLists, [](SnapshotHeader& h, SnapshotRecord*, Bytes&) { h.folderCount++; });
+        checkRejected(withLists, [](SnapshotHeader& h, SnapshotRecord*, Bytes& b) {
+            SnapshotFolder f;
+            memcpy(&f, b.data() + h.foldersOffset + sizeof(f), sizeof(f));
+            f.nameLength = static_cast<uint32_t>(h.stringsSize);
+            memcpy(b.data() + h.foldersOffset + sizeof(f), &f, sizeof(f));
+        });
+
+        // Undamaged, it loads, but not into a playlist that has those IDs already
+        path = scratchPath("good.snap");
+        writeFile(path, good);
+        Playlist loaded;
+        CHECK(LibrarySnapshot::load(path, loaded, Root));
+        CHECK(loaded.getTotalTracks() == 50);
+        CHECK(!LibrarySnapshot::load(path, loaded, Root));
+        CHECK(loaded.getTotalTracks() == 50);
+        filesystem::remove(path);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "round_trip", roundTrip },
+        { "lists_round_trip", listsRoundTrip },
+        { "save_over_loaded_file", saveOverLoadedFile },
+        { "damaged_is_rejected", damagedIsRejected },
+    }, argc, argv);
+}
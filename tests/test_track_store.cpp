@@ -0,0 +1,143 @@
+// TrackStore: interned artists and directories, text shared between title and
+// file name, counted references and in-place updates, and handles and text
+// reused after removals.
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Check.h"
+#include "TrackStore.h"
+
+using namespace std;
+
+namespace {
+    bool inside(string_view part, string_view whole) {
+        return part.data() >= whole.data() && part.data() + part.size() <= whole.data() + whole.size();
+    }
+
+    //----------------------------------------------------
+    void interning() {
+        SymbolTable table;
+        uint32_t a = table.intern("Abba");
+        uint32_t b = table.intern("Blur");
+        CHECK(a != b);
+        CHECK(table.intern("Abba") == a && table.intern("Blur") == b);
+        CHECK(table.intern("abba") != a); // Case matters here
+        CHECK(table.size() == 3);
+        CHECK(table.find("Blur") == b && table.find("Cure") == SymbolTable::NotFound);
+
+        // A borrowed name is found by its text like any other
+        const char text[] = "CureAbba";
+        uint32_t cure = table.internBorrowed(string_view(text, 4));
+        CHECK(table.name(cure).data() == text);
+        CHECK(table.internBorrowed(string_view(text + 4, 4)) == a);
+        CHECK(table.intern("Cure") == cure);
+
+        // Owned again: same symbols, own copies
+        table.ownNames();
+        CHECK(table.name(cure) == "Cure" && table.name(cure).data() != text);
+        CHECK(table.find("Cure") == cure && table.intern("Abba") == a);
+    }
+
+    // A thousand tracks of ten artists in four folders store ten artist names
+    // and four directory names
+    void storeSharesText() {
+        TrackStore store;
+        vector<TrackHandle> handles;
+        for (int i = 0; i < 1000; i++) {
+            string title = "Song " + to_string(i);
+            string file = i % 2 == 0 ? to_string(10 + i % 90) + " - " + title + ".mp3" : "track" + to_string(i) + ".flac";
+            string path = "/music/album" + to_string(i % 4) + "/" + file;
+            handles.push_back(store.add(Track{ i + 1, title, "Artist " + to_string(i % 10), 200 + i, path }));
+        }
+        CHECK(store.size() == 1000);
+        CHECK(store.artistSymbols().size() == 10 && store.directorySymbols().size() == 4);
+
+        for (int i = 0; i < 1000; i++) {
+            TrackHandle h = handles[static_cast<size_t>(i)];
+            CHECK(store.id(h) == i + 1 && store.duration(h) == 200 + i);
+            CHECK(store.title(h) == "Song " + to_string(i));
+            CHECK(store.artistName(h) == "Artist " + to_string(i % 10));
+            CHECK(store.directoryName(h) == "/music/album" + to_string(i % 4) + "/");
+            CHECK(store.artist(h) == store.artist(handles[static_cast<size_t>(i % 10)]));
+            // "10 - Song 0.mp3" holds its title; "track1.flac" doesn't
+            CHECK(inside(store.title(h), store.fileName(h)) == (i % 2 == 0));
+        }
+        CHECK(store.filePath(handles[5]) == "/music/album1/track5.flac");
+        CHECK(store.ref(handles[5]).artist() == "Artist 5");
+
+        // A file without a folder, and text too long to keep whole
+        TrackHandle bare = store.add(Track{ 2000, "", "", 1, "bare.mp3" });
+        CHECK(store.directoryName(bare).empty() && store.fileName(bare) == "bare.mp3" && store.title(bare).empty());
+        TrackHandle longOne = store.add(Track{ 2001, string(70000, 't'), "x", 1, "/l/" + string(70000, 'n') });
+        CHECK(store.title(longOne).size() == TrackStore::MaxTextLength && store.fileName(longOne).size() == TrackStore::MaxTextLength);
+    }
+
+    // The last release removes; an update keeps the ID, handle and count
+    void countsAndUpdates() {
+        TrackStore store;
+        TrackHandle h = store.add(Track{ 7, "Old", "Abba", 100, "/a/07 - Old.mp3" });
+        TrackHandle other = store.add(Track{ 8, "Other", "Abba", 100, "/a/other.mp3" });
+        store.retain(h);
+        CHECK(store.refCount(h) == 2 && store.refCount(other) == 1);
+
+        store.update(h, Track{ 0, "New title", "Blur", 200, "/b/new.flac" });
+        CHECK(store.id(h) == 7 && store.refCount(h) == 2 && store.size() == 2);
+        CHECK(store.title(h) == "New title" && store.artistName(h) == "Blur" && store.duration(h) == 200);
+        CHECK(store.filePath(h) == "/b/new.flac");
+
+        CHECK(!store.release(h) && store.id(h) == 7);
+        CHECK(store.release(h) && store.size() == 1);
+        CHECK(store.add(Track{ 9, "Again", "Abba", 1, "/a/again.mp3" }) == h); // The freed handle, counted afresh
+        CHECK(store.refCount(h) == 1 && store.title(other) == "Other");
+    }
+
+    // Removed handles come back, and once the removed text passes the
+    // compaction threshold the survivors' text is moved without changing it
+    void removalsReuseSpace() {
+        mt19937 rng(1);
+        TrackStore store;
+        struct Expect {
+            TrackHandle handle;
+            string title, name;
+            bool live;
+        };
+        vector<Expect> tracks;
+        auto add = [&](int id) {
+            string title = "Title " + to_string(id) + string(300 + id % 200, 'x');
+            string name = "file " + to_string(id) + string(300 + id % 150, 'y') + ".mp3";
+            TrackHandle h = store.add(Track{ id, title, "A", 1, "/d/" + name });
+            tracks.push_back(Expect{ h, title, name, true });
+        };
+        for (int id = 1; id <= 6000; id++) add(id);
+        size_t handleLimit = store.handleLimit();
+
+        for (Expect& t : tracks) {
+            if (rng() % 4 != 0) {
+                store.release(t.handle);
+                t.live = false;
+            }
+        }
+        for (const Expect& t : tracks) {
+            if (!t.live) continue;
+            CHECK(store.title(t.handle) == t.title && store.fileName(t.handle) == t.name);
+        }
+
+        // New tracks take the freed handles first
+        size_t live = store.size();
+        for (int id = 6001; id <= 7000; id++) add(id);
+        CHECK(store.handleLimit() == handleLimit && store.size() == live + 1000);
+        for (const Expect& t : tracks) {
+            if (t.live) CHECK(store.id(t.handle) != 0 && store.title(t.handle) == t.title && store.fileName(t.handle) == t.name);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests({
+        { "interning", interning },
+        { "store_shares_text", storeSharesText },
+        { "counts_and_updates", countsAndUpdates },
+        { "removals_reuse_space", removalsReuseSpace },
+    }, argc, argv);
+}